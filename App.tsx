@@ -1,15 +1,35 @@
 import * as React from 'react';
 import { useState, useMemo, useCallback, useRef, useEffect } from 'react';
 import { VideoItem, SortMode } from './types';
-import { SUPPORTED_VIDEO_EXTENSIONS } from './constants';
+import { SUPPORTED_VIDEO_EXTENSIONS, PREVIEW_POOL_SIZE } from './constants';
 import { VideoCard } from './components/VideoCard';
 import { VideoPlayer } from './components/VideoPlayer';
 import { translations, Language } from './translations';
 import { thumbnailService } from './services/ThumbnailService';
+import type { LibraryDelta, LibraryFile } from './electron.d';
 
 const GRID_COLUMNS_STORAGE_KEY = 'vhub-column-count';
 const LANG_STORAGE_KEY = 'vhub-lang';
 const PAGE_SIZE = 24; 
+const RESCAN_MIN_INTERVAL_MS = 30000;
+// Paths per probe request; results are merged into the grid per chunk.
+const PROBE_CHUNK_SIZE = 200;
+
+const toLibraryItem = (entry: LibraryFile, suffix: string): VideoItem => ({
+  id: `${entry.name}-${entry.size}-${entry.lastModified}-${suffix}`,
+  path: entry.path,
+  url: entry.url,
+  name: entry.name,
+  size: entry.size,
+  lastModified: entry.lastModified
+});
+
+// Both the file URL of a picked file and a canvas-generated thumbnail are
+// blob URLs that live until revoked.
+const revokeBlobUrls = (video: VideoItem) => {
+  if (video.url.startsWith('blob:')) URL.revokeObjectURL(video.url);
+  if (video.thumbnail?.startsWith('blob:')) URL.revokeObjectURL(video.thumbnail);
+};
 
 const App: React.FC = () => {
   const [videos, setVideos] = useState<VideoItem[]>([]);
@@ -65,20 +85,86 @@ const App: React.FC = () => {
     setCurrentPage(1);
   }, [searchQuery, sortMode]);
 
+  // Pay mpv start-up for hover previews once, before the first hover.
+  useEffect(() => {
+    window.electronAPI?.mpvPreviewWarm?.(PREVIEW_POOL_SIZE);
+  }, []);
+
   const activeVideo = useMemo(() => 
     videos.find(v => v.id === activeVideoId) || null
   , [videos, activeVideoId]);
 
+  // Set once the library comes from a scanned folder, so a rescan can merge
+  // its delta into the current list.
+  const scannedLibrary = useRef(false);
+  const lastRescan = useRef(0);
+  // Bumped whenever the library is replaced, so an older probe run stops.
+  const probeGeneration = useRef(0);
+
+  // Duration and resolution straight from the container headers, so sorting
+  // by them does not wait for thumbnails.
+  const probeLibrary = useCallback(async (paths: string[]) => {
+    const api = window.electronAPI;
+    if (!api?.probeMedia || paths.length === 0) return;
+    const generation = probeGeneration.current;
+    for (let i = 0; i < paths.length; i += PROBE_CHUNK_SIZE) {
+      const result = await api.probeMedia(paths.slice(i, i + PROBE_CHUNK_SIZE));
+      if (!result.ok || !result.records || generation !== probeGeneration.current) return;
+      const found = new Map(result.records.filter(record => !record.error).map(record => [record.path, record]));
+      if (found.size === 0) continue;
+      setVideos(prev => prev.map(v => {
+        const info = v.path ? found.get(v.path) : undefined;
+        if (!info) return v;
+        return { ...v, duration: info.duration || v.duration, width: info.width || undefined, height: info.height || undefined };
+      }));
+    }
+  }, []);
+
+  // Watcher batches and focus rescans can report the same file, so merging
+  // replaces by path. Changed files get a new id so their thumbnail is
+  // regenerated.
+  const mergeDelta = useCallback(({ added = [], changed = [], removed = [] }: Partial<LibraryDelta>) => {
+    if (!scannedLibrary.current) return;
+    if (added.length === 0 && changed.length === 0 && removed.length === 0) return;
+    const fresh = [...changed, ...added];
+    const stale = new Set([...removed, ...fresh.map(file => file.path)]);
+    const stamp = `r${Date.now()}`;
+    setVideos(prev => prev
+      .filter(v => {
+        if (!v.path || !stale.has(v.path)) return true;
+        revokeBlobUrls(v);
+        return false;
+      })
+      .concat(fresh.map((entry, idx) => toLibraryItem(entry, `${stamp}-${idx}`))));
+    probeLibrary(fresh.map(file => file.path));
+  }, [probeLibrary]);
+
+  useEffect(() => window.electronAPI?.onLibraryChanges?.(mergeDelta), [mergeDelta]);
+
+  useEffect(() => {
+    const api = window.electronAPI;
+    if (!api?.rescanLibrary) return;
+    const onFocus = async () => {
+      const now = Date.now();
+      if (!scannedLibrary.current || now - lastRescan.current < RESCAN_MIN_INTERVAL_MS) return;
+      lastRescan.current = now;
+      const delta = await api.rescanLibrary!();
+      if (delta.ok) mergeDelta(delta);
+    };
+    window.addEventListener('focus', onFocus);
+    return () => window.removeEventListener('focus', onFocus);
+  }, [mergeDelta]);
+
   const clearLibrary = useCallback(() => {
     if (!isConfirmingClear) {
       setIsConfirmingClear(true);
       setTimeout(() => setIsConfirmingClear(false), 4000);
       return;
     }
-    videos.forEach(v => {
-      if (v.url.startsWith('blob:')) URL.revokeObjectURL(v.url);
-    });
+    videos.forEach(revokeBlobUrls);
     thumbnailService.clearCache();
+    scannedLibrary.current = false;
+    probeGeneration.current++;
     setVideos([]);
     setActiveVideoId(null);
     setIsConfirmingClear(false);
@@ -88,6 +174,8 @@ const App: React.FC = () => {
   const handleFiles = useCallback(async (e: React.ChangeEvent<HTMLInputElement>) => {
     const fileList = e.target.files;
     if (!fileList || fileList.length === 0) return;
+    scannedLibrary.current = false;
+    probeGeneration.current++;
 
     setIsProcessing(true);
     const newVideos: VideoItem[] = [];
@@ -114,9 +202,7 @@ const App: React.FC = () => {
     }
 
     setVideos(prev => {
-      prev.forEach(v => {
-        if (v.url.startsWith('blob:')) URL.revokeObjectURL(v.url);
-      });
+      prev.forEach(revokeBlobUrls);
       return newVideos;
     });
     setIsProcessing(false);
@@ -128,30 +214,43 @@ const App: React.FC = () => {
   const handleFolderSelect = useCallback(async () => {
     if (window.electronAPI) {
       // 如果在 Electron 环境中，使用 Electron API 选择目录
-      try {
-        const entries = await window.electronAPI.openDirectoryFiles?.(SUPPORTED_VIDEO_EXTENSIONS);
-        if (!entries || entries.length === 0) return;
-        setIsProcessing(true);
-        const newVideos: VideoItem[] = entries.map((entry, idx) => ({
-          id: `${entry.name}-${entry.size}-${entry.lastModified}-${idx}`,
-          path: entry.path,
-          url: entry.url,
-          name: entry.name,
-          size: entry.size,
-          lastModified: entry.lastModified
-        }));
+      // Scan results stream in batches, so large shares fill the grid while
+      // the walk is still running.
+      let streamed = 0;
+      const replaceLibrary = (next: VideoItem[]) => {
+        probeGeneration.current++;
         setVideos(prev => {
-          prev.forEach(v => {
-            if (v.url.startsWith('blob:')) URL.revokeObjectURL(v.url);
-          });
-          return newVideos;
+          prev.forEach(revokeBlobUrls);
+          return next;
         });
         setActiveVideoId(null);
         setCurrentPage(1);
+      };
+      const unsubscribe = window.electronAPI.onLibraryScanBatch?.((batch) => {
+        const items = batch.map((entry, idx) => toLibraryItem(entry, `${streamed + idx}`));
+        if (streamed === 0) {
+          setIsProcessing(true);
+          replaceLibrary(items);
+        } else {
+          setVideos(prev => prev.concat(items));
+        }
+        streamed += batch.length;
+      });
+      try {
+        const entries = await window.electronAPI.openDirectoryFiles?.(SUPPORTED_VIDEO_EXTENSIONS);
+        if (!entries || entries.length === 0) return;
+        scannedLibrary.current = true;
+        if (streamed !== entries.length) {
+          setIsProcessing(true);
+          replaceLibrary(entries.map((entry, idx) => toLibraryItem(entry, `${idx}`)));
+        }
         setIsProcessing(false);
+        probeLibrary(entries.map(entry => entry.path));
       } catch (error) {
         console.error('Error selecting directory:', error);
         setIsProcessing(false);
+      } finally {
+        unsubscribe?.();
       }
     } else {
       // 如果不在 Electron 环境中，触发文件选择器（保持现有行为）
@@ -165,7 +264,7 @@ const App: React.FC = () => {
       };
       fileInput.click();
     }
-  }, [handleFiles]);
+  }, [handleFiles, probeLibrary]);
 
   const filteredAndSortedVideos = useMemo(() => {
     let result = [...videos];
@@ -176,6 +275,8 @@ const App: React.FC = () => {
     switch (sortMode) {
       case SortMode.NEWEST: result.sort((a, b) => b.lastModified - a.lastModified); break;
       case SortMode.SIZE: result.sort((a, b) => b.size - a.size); break;
+      case SortMode.DURATION: result.sort((a, b) => (b.duration ?? -1) - (a.duration ?? -1)); break;
+      case SortMode.RESOLUTION: result.sort((a, b) => (b.width ?? 0) * (b.height ?? 0) - (a.width ?? 0) * (a.height ?? 0)); break;
       case SortMode.RANDOM: 
         result.sort((a, b) => {
           // Use a seeded random based on video IDs and a stable random seed
@@ -199,7 +300,7 @@ const App: React.FC = () => {
 
     setVideos(prev => {
       const target = prev.find(v => v.id === video.id);
-      if (target?.url.startsWith('blob:')) URL.revokeObjectURL(target.url);
+      if (target) revokeBlobUrls(target);
       return prev.filter(v => v.id !== video.id);
     });
 
@@ -390,6 +491,8 @@ const App: React.FC = () => {
                   >
                     <option value={SortMode.NEWEST}>{t.sortByDate}</option>
                     <option value={SortMode.SIZE}>{t.sortBySize}</option>
+                    <option value={SortMode.DURATION}>{t.sortByDuration}</option>
+                    <option value={SortMode.RESOLUTION}>{t.sortByResolution}</option>
                     <option value={SortMode.RANDOM}>{t.sortByRandom}</option>
                   </select>
                 </div>
@@ -15,27 +15,113 @@ export const VideoCard = React.memo(({ video, onClick, onMetadataLoaded }: Video
   const [showPreview, setShowPreview] = useState(false);
   const [previewReady, setPreviewReady] = useState(false);
   const [progressWidth, setProgressWidth] = useState(0);
+  const [mpvPreview, setMpvPreview] = useState(false);
   const hoverTimer = useRef<number | null>(null);
   const cardRef = useRef<HTMLDivElement>(null);
+  const previewCanvasRef = useRef<HTMLCanvasElement>(null);
+
+  // A blob thumbnail revoked by the thumbnail cache fails to load; the tile
+  // then asks for a new one.
+  const [lostThumbnail, setLostThumbnail] = useState<string | null>(null);
+  const thumbnail = video.thumbnail !== lostThumbnail ? video.thumbnail : undefined;
 
   useEffect(() => {
-    if (video.thumbnail) return;
+    if (thumbnail) return;
 
+    // Tiles on screen are extracted first and the 400px margin next; a tile
+    // that scrolls out of range before its thumbnail exists is cancelled.
+    const request = (priority: 'visible' | 'near') => {
+      thumbnailService.generate(video.url, video.id, (dataUrl, duration) => {
+        onMetadataLoaded(video.id, dataUrl, duration);
+      }, video.path, priority);
+    };
     const observer = new IntersectionObserver((entries) => {
       if (entries[0].isIntersecting) {
-        thumbnailService.generate(video.url, video.id, (dataUrl, duration) => {
-          onMetadataLoaded(video.id, dataUrl, duration);
-        }, video.path);
-        observer.disconnect();
+        request('near');
+      } else {
+        thumbnailService.cancel(video.id);
       }
     }, { 
       threshold: 0.01, 
       rootMargin: '400px'
     });
+    const visibleObserver = new IntersectionObserver((entries) => {
+      if (entries[0].isIntersecting) {
+        request('visible');
+      } else {
+        thumbnailService.setPriority(video.id, 'near');
+      }
+    }, { threshold: 0.01 });
+
+    if (cardRef.current) {
+      observer.observe(cardRef.current);
+      visibleObserver.observe(cardRef.current);
+    }
+    return () => {
+      observer.disconnect();
+      visibleObserver.disconnect();
+      thumbnailService.cancel(video.id);
+    };
+  }, [video.id, thumbnail, video.url, onMetadataLoaded]);
 
-    if (cardRef.current) observer.observe(cardRef.current);
-    return () => observer.disconnect();
-  }, [video.id, video.thumbnail, video.url, onMetadataLoaded]);
+  // Hover previews lease a warm, muted mpv player from the preview pool so they
+  // decode the same formats as the main player. Falls back to <video> when the
+  // addon is absent.
+  useEffect(() => {
+    const api = window.electronAPI;
+    if (!showPreview || !video.path || !api?.mpvPreviewAcquire || !api.mpvPlayerPresent) return;
+    const lease = api.mpvPreviewAcquire(video.id);
+    if (!lease.ok || lease.id === undefined) return;
+    const id = lease.id;
+
+    const startTime = (video.duration !== undefined && video.duration < 15) ? 1 : 10;
+    api.mpvPlayerCommand?.(id, ['set', 'start', startTime.toString()]);
+    api.mpvPlayerCommand?.(id, ['set', 'loop-file', 'inf']);
+    api.mpvPlayerCommand?.(id, ['set', 'mute', 'yes']);
+    let released = false;
+    let rafId = 0;
+    const release = () => {
+      if (released) return;
+      released = true;
+      cancelAnimationFrame(rafId);
+      api.mpvPlayerSetFrameCallback?.(id, null);
+      api.mpvPreviewRelease?.(video.id);
+    };
+    if (api.mpvPlayerLoadAsync) {
+      api.mpvPlayerLoadAsync(id, video.path).then(result => {
+        if (result.ok || released) return;
+        // Hand the tile back to the <video> fallback.
+        release();
+        setMpvPreview(false);
+      });
+    } else if (!api.mpvPlayerLoad?.(id, video.path)?.ok) {
+      release();
+      return;
+    }
+    setMpvPreview(true);
+
+    const render = () => {
+      rafId = 0;
+      if (released) return;
+      const canvas = previewCanvasRef.current;
+      if (!canvas) return;
+      const width = Math.max(1, Math.floor(canvas.clientWidth));
+      const height = Math.max(1, Math.floor(canvas.clientHeight));
+      const result = api.mpvPlayerPresent?.(id, canvas, width, height);
+      if (result?.rendered) setPreviewReady(true);
+      if (result?.pending) schedule();
+    };
+    const schedule = () => {
+      if (!rafId) rafId = requestAnimationFrame(render);
+    };
+    api.mpvPlayerSetFrameCallback?.(id, schedule);
+    schedule();
+
+    return () => {
+      release();
+      setMpvPreview(false);
+    };
+  }, [showPreview, video.id, video.path, video.duration]);
 
   const handleMouseEnter = () => {
     setIsHovered(true);
@@ -85,10 +171,11 @@ export const VideoCard = React.memo(({ video, onClick, onMetadataLoaded }: Video
       onClick={() => onClick(video)}
     >
       <div className="relative bg-black overflow-hidden" style={{ aspectRatio: '16 / 9' }}>
-        {video.thumbnail ? (
+        {thumbnail ? (
           <img 
-            src={video.thumbnail} 
+            src={thumbnail} 
             alt={video.name}
+            onError={() => { if (thumbnail.startsWith('blob:')) setLostThumbnail(thumbnail); }}
             loading="lazy"
             decoding="async"
             className={`absolute inset-0 w-full h-full object-contain transition-opacity duration-500 ${(showPreview && previewReady) ? 'opacity-30' : 'opacity-100'}`}
@@ -111,7 +198,14 @@ export const VideoCard = React.memo(({ video, onClick, onMetadataLoaded }: Video
           </div>
         )}
 
-        {isHovered && previewUrl && (
+        {mpvPreview && (
+          <canvas
+            ref={previewCanvasRef}
+            className={`absolute inset-0 w-full h-full object-contain bg-black transition-opacity duration-700 z-10 ${showPreview && previewReady ? 'opacity-100' : 'opacity-0'}`}
+          />
+        )}
+
+        {isHovered && previewUrl && !mpvPreview && (
           <video
             src={previewUrl}
             autoPlay
@@ -3,6 +3,9 @@ import React, { useEffect, useRef, useState, useMemo, useCallback } from 'react'
 import { VideoItem, SortMode, DisplaySize } from '../types';
 import { PREVIEW_DELAY } from '../constants';
 import { thumbnailService } from '../services/ThumbnailService';
+import { loadKeyframeIndex, nearestKeyframe } from '../services/KeyframeService';
+import { loadSeekPreview, seekPreviewTile, type SeekPreviewTile } from '../services/SeekPreviewService';
+import type { SeekPreview } from '../electron.d';
 import { translations, Language } from '../translations';
 
 interface VideoPlayerProps {
@@ -19,6 +22,9 @@ interface VideoPlayerProps {
 const PLAYLIST_SORT_STORAGE_KEY = 'playlist-sort-mode';
 const DISPLAY_SIZE_STORAGE_KEY = 'vhub-display-size';
 const AUTO_HIDE_TIMEOUT = 3000;
+// Lets the current video's open and first frames finish before the next one
+// starts competing for disk and decoder.
+const PRELOAD_DELAY = 1000;
 
 const PlaylistItem = React.memo(({
   v, isActive, onClick, formatDuration, onMetadataLoaded 
@@ -123,6 +129,42 @@ const PlaylistItem = React.memo(({
   );
 });
 
+// Seeks go through mpv_command_async when available so a slow seek in a large
+// file never blocks the renderer.
+const sendMpvCommand = (args: string[]) => {
+  const api = window.electronAPI;
+  if (api?.mpvCommandAsync) {
+    void api.mpvCommandAsync(args);
+    return;
+  }
+  api?.mpvCommand?.(args);
+};
+
+// Typed property writes in one addon call, falling back to `set` commands.
+const setMpvProperties = (values: Record<string, string | number | boolean>) => {
+  const api = window.electronAPI;
+  if (api?.mpvSetProperties) {
+    api.mpvSetProperties(values);
+    return;
+  }
+  for (const [name, value] of Object.entries(values)) {
+    const text = typeof value === 'boolean' ? (value ? 'yes' : 'no') : String(value);
+    api?.mpvCommand?.(['set', name, text]);
+  }
+};
+
+// UNC paths and smb/nfs URLs play from a share; those get mpv's larger,
+// seekable demuxer cache.
+const isNetworkPath = (filePath: string) =>
+  /^(\\\\|\/\/|smb:|nfs:)/i.test(filePath);
+
+// The HTML fallback has no frame stepping of its own; this is one frame at
+// 30 fps.
+const HTML_FRAME_STEP = 1 / 30;
+
+// Keys that move a focused range input.
+const SCRUB_KEYS = new Set(['ArrowLeft', 'ArrowRight', 'ArrowUp', 'ArrowDown', 'PageUp', 'PageDown', 'Home', 'End']);
+
 export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
   const { video, allVideos, lang, onClose, onSelectVideo, onMetadataLoaded, onDelete, deletedNotice } = props;
   const containerRef = useRef<HTMLDivElement>(null);
@@ -156,6 +198,37 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
   const deleteTimer = useRef<number | null>(null);
   const isDeleted = Boolean(deletedNotice);
   const canDelete = Boolean(!isDeleted && electronAPI?.trashItem && video.path);
+  const [seekPreview, setSeekPreview] = useState<SeekPreview | null>(null);
+  const [hoverPreview, setHoverPreview] = useState<{ left: number; time: number; tile: SeekPreviewTile | null } | null>(null);
+
+  // The sheet is built in the background; until it arrives the bar only
+  // shows the hovered time.
+  useEffect(() => {
+    setSeekPreview(null);
+    setHoverPreview(null);
+    if (!video.path) return;
+    let active = true;
+    loadSeekPreview(video.path).then(sheet => {
+      if (active) setSeekPreview(sheet);
+    });
+    return () => {
+      active = false;
+    };
+  }, [video.path]);
+
+  // Loaded with the video so scrub seeks can snap to keyframes.
+  const keyframes = useRef<Float64Array | null>(null);
+  useEffect(() => {
+    keyframes.current = null;
+    if (!video.path) return;
+    let active = true;
+    loadKeyframeIndex(video.path).then(index => {
+      if (active) keyframes.current = index;
+    });
+    return () => {
+      active = false;
+    };
+  }, [video.path]);
 
   const setSidebarOpen = useCallback((open: boolean) => {
     if (sidebarHideTimer.current) {
@@ -223,7 +296,7 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
     if (isDeleted) return;
     setIsPlaying(true);
     if (useMpv && mpvStatus === 'ready') {
-      window.electronAPI?.mpvCommand?.(['set', 'pause', 'no']);
+      setMpvProperties({ pause: false });
       return;
     }
     if (videoRef.current) {
@@ -248,8 +321,49 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
     }
   }, [isPlaying]);
 
+  // Playback state pushed from mpv's event thread. While observation is
+  // active the animation-frame loop below skips its GetProperty polling.
+  const mpvObserving = useRef(false);
+  useEffect(() => {
+    if (!useMpv || mpvStatus !== 'ready' || !electronAPI?.mpvSetPropertyCallback) return;
+    let time: number | null = null;
+    let duration: number | null = null;
+    const handleChanges = (changes: { name: string; value: string | number | boolean | null }[]) => {
+      for (const change of changes) {
+        if (change.name === 'time-pos' && typeof change.value === 'number') {
+          time = change.value;
+          setMpvTime(change.value);
+        } else if (change.name === 'duration' && typeof change.value === 'number') {
+          duration = change.value;
+          setMpvDuration(change.value);
+        } else if (change.name === 'pause' && typeof change.value === 'boolean') {
+          setIsPlaying(!change.value);
+        }
+      }
+      if (!isUserSeeking.current && time !== null && duration !== null && duration > 0) {
+        setDisplayProgress((time / duration) * 100);
+      }
+    };
+    if (!electronAPI.mpvSetPropertyCallback(handleChanges).ok) return;
+    const ids = [
+      electronAPI.mpvObserveProperty?.('time-pos', 'double'),
+      electronAPI.mpvObserveProperty?.('duration', 'double'),
+      electronAPI.mpvObserveProperty?.('pause', 'bool')
+    ].map(res => (res?.ok ? res.id : undefined)).filter((id): id is number => id !== undefined);
+    mpvObserving.current = ids.length === 3;
+    return () => {
+      mpvObserving.current = false;
+      ids.forEach(id => electronAPI.mpvUnobserveProperty?.(id));
+      electronAPI.mpvSetPropertyCallback?.(null);
+    };
+  }, [useMpv, mpvStatus, electronAPI]);
+
   const updateLoop = useCallback(() => {
     if (useMpv && mpvStatus === 'ready') {
+      if (mpvObserving.current) {
+        rafRef.current = requestAnimationFrame(updateLoop);
+        return;
+      }
       const timeRes = electronAPI?.mpvGetProperty?.('time-pos', 'double');
       const durRes = electronAPI?.mpvGetProperty?.('duration', 'double');
       const pauseRes = electronAPI?.mpvGetProperty?.('pause', 'bool');
@@ -315,14 +429,58 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
     }
   };
 
+  // While dragging, seeks go to the nearest keyframe, which mpv shows without
+  // decoding up to the target. Only one is in flight, the latest position
+  // wins and positions inside the same GOP send nothing. Releasing the bar
+  // then seeks exactly (commitScrub).
+  const scrubTarget = useRef<number | null>(null);
+  const scrubInFlight = useRef(false);
+  const lastScrubSeek = useRef<number | null>(null);
+
+  const sendScrubSeek = useCallback(() => {
+    const target = scrubTarget.current;
+    if (target === null || scrubInFlight.current) return;
+    scrubTarget.current = null;
+    const index = keyframes.current;
+    const snapped = index ? nearestKeyframe(index, target) : target;
+    if (snapped === lastScrubSeek.current) return;
+    lastScrubSeek.current = snapped;
+    const args = ['seek', snapped.toString(), 'absolute+keyframes'];
+    const api = window.electronAPI;
+    if (!api?.mpvCommandAsync) {
+      api?.mpvCommand?.(args);
+      return;
+    }
+    scrubInFlight.current = true;
+    void api.mpvCommandAsync(args).finally(() => {
+      scrubInFlight.current = false;
+      sendScrubSeek();
+    });
+  }, []);
+
+  const commitScrub = (val: number) => {
+    scrubTarget.current = null;
+    lastScrubSeek.current = null;
+    if (!useMpv || !mpvDuration || mpvDuration <= 0) return;
+    sendMpvCommand(['seek', ((val / 100) * mpvDuration).toString(), 'absolute+exact']);
+  };
+
+  // Every way of moving the bar (mouse, touch, pen, keys) ends here, so the
+  // last keyframe seek is always followed by an exact one.
+  const endScrub = (bar: HTMLInputElement) => {
+    isUserSeeking.current = false;
+    commitScrub(parseFloat(bar.value));
+    resetHideTimer(true);
+  };
+
   const handleProgressChange = (e: React.ChangeEvent<HTMLInputElement>) => {
     const val = parseFloat(e.target.value);
     isUserSeeking.current = true;
     setDisplayProgress(val);
     if (useMpv) {
       if (mpvDuration && mpvDuration > 0) {
-        const target = (val / 100) * mpvDuration;
-        electronAPI?.mpvCommand?.(['set', 'time-pos', target.toString()]);
+        scrubTarget.current = (val / 100) * mpvDuration;
+        sendScrubSeek();
       }
       return;
     }
@@ -340,17 +498,32 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
     if (useMpv) {
       if (mpvStatus !== 'ready') return;
       const next = !isMuted;
-      window.electronAPI?.mpvCommand?.(['set', 'mute', next ? 'yes' : 'no']);
+      setMpvProperties({ mute: next });
       setIsMuted(next);
       return;
     }
     setIsMuted(prev => !prev);
   }, [useMpv, isMuted, mpvStatus]);
 
+  // Key-repeat seeks are summed and sent once per animation frame.
+  const pendingSeek = useRef(0);
+  const seekFrame = useRef<number | null>(null);
+  useEffect(() => () => {
+    if (seekFrame.current !== null) cancelAnimationFrame(seekFrame.current);
+  }, []);
+
   const seek = useCallback((seconds: number) => {
     if (useMpv) {
       if (mpvStatus !== 'ready') return;
-      window.electronAPI?.mpvCommand?.(['seek', seconds.toString(), 'relative']);
+      pendingSeek.current += seconds;
+      if (seekFrame.current === null) {
+        seekFrame.current = requestAnimationFrame(() => {
+          seekFrame.current = null;
+          const total = pendingSeek.current;
+          pendingSeek.current = 0;
+          if (total !== 0) sendMpvCommand(['seek', total.toString(), 'relative']);
+        });
+      }
       return;
     }
     if (videoRef.current && isFinite(videoRef.current.duration)) {
@@ -358,13 +531,28 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
     }
   }, [useMpv, mpvStatus]);
 
+  // Steps pause playback. Forward steps decode just the next frame; back
+  // steps are mpv's exact seek to the previous one, fed from the demuxer's
+  // back buffer instead of the disk.
+  const stepFrame = useCallback((direction: 1 | -1) => {
+    if (useMpv) {
+      if (mpvStatus !== 'ready') return;
+      sendMpvCommand([direction > 0 ? 'frame-step' : 'frame-back-step']);
+      return;
+    }
+    const element = videoRef.current;
+    if (!element || !isFinite(element.duration)) return;
+    element.pause();
+    element.currentTime = Math.max(0, Math.min(element.duration, element.currentTime + direction * HTML_FRAME_STEP));
+  }, [useMpv, mpvStatus]);
+
   const adjustVolume = useCallback((delta: number) => {
     setVolume(prev => {
       const newVal = Math.max(0, Math.min(1, prev + delta));
       if (newVal > 0) setIsMuted(false);
       if (useMpv && mpvStatus === 'ready') {
         const mpvVolume = Math.round(newVal * 100);
-        window.electronAPI?.mpvCommand?.(['set', 'volume', mpvVolume.toString()]);
+        setMpvProperties({ volume: mpvVolume });
       }
       return newVal;
     });
@@ -436,44 +624,79 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
       return;
     }
     setUseMpv(true);
-    const initResult = electronAPI?.mpvInit?.();
-    if (!initResult?.ok) {
+    let cancelled = false;
+    const failInit = (error?: string) => {
       setUseMpv(true);
       setMpvStatus('error');
-      setMpvError(initResult?.error || 'init_failed');
+      setMpvError(error || 'init_failed');
       const debug = electronAPI?.mpvDebug?.();
       if (debug) {
         setMpvDebug(`addon=${debug.addonPath || 'none'} err=${debug.addonError || 'none'} lib=${debug.libPath || 'none'}`);
       } else {
         setMpvDebug(null);
       }
-      console.warn('[mpv] init failed', initResult, debug);
-      return;
-    }
-    const loadResult = electronAPI?.mpvLoad?.(video.path);
-    if (!loadResult?.ok) {
+      console.warn('[mpv] init failed', error, debug);
+    };
+    const failLoad = (error?: string) => {
       setUseMpv(true);
       setMpvStatus('error');
-      setMpvError(loadResult?.error || 'load_failed');
+      setMpvError(error || 'load_failed');
       const debug = electronAPI?.mpvDebug?.();
       if (debug) {
         setMpvDebug(`addon=${debug.addonPath || 'none'} err=${debug.addonError || 'none'} lib=${debug.libPath || 'none'}`);
       } else {
         setMpvDebug(null);
       }
-      console.warn('[mpv] load failed', loadResult, debug);
-      return;
+      console.warn('[mpv] load failed', error, debug);
+    };
+    const finishLoad = () => {
+      setIsMuted(false);
+      setVolume(1);
+      setMpvProperties({ volume: 100, mute: false });
+      setUseMpv(true);
+      setIsPlaying(true);
+      setMpvStatus('ready');
+      setMpvError(null);
+      setMpvDebug(null);
+    };
+    const startPlayback = (filePath: string) => {
+      electronAPI?.mpvSetCacheProfile?.(isNetworkPath(filePath) ? 'network' : 'local');
+      // Loading from a slow share can take a while; keep the UI responsive.
+      if (electronAPI?.mpvLoadAsync) {
+        electronAPI.mpvLoadAsync(filePath).then(result => {
+          if (cancelled) return;
+          if (result.ok) finishLoad();
+          else failLoad(result.error);
+        });
+        return;
+      }
+      const loadResult = electronAPI?.mpvLoad?.(filePath);
+      if (!loadResult?.ok) {
+        failLoad(loadResult?.error);
+        return;
+      }
+      finishLoad();
+    };
+    const filePath = video.path;
+    const initOptions = { gpu: true, hwdec: 'auto' } as const;
+    // The preload starts loading libmpv on a worker thread at startup;
+    // playback begins once it is available instead of blocking first paint.
+    if (electronAPI?.mpvInitAsync) {
+      electronAPI.mpvInitAsync(initOptions).then(result => {
+        if (cancelled) return;
+        if (result.ok) startPlayback(filePath);
+        else failInit(result.error);
+      });
+    } else {
+      const initResult = electronAPI?.mpvInit?.(initOptions);
+      if (!initResult?.ok) {
+        failInit(initResult?.error);
+        return;
+      }
+      startPlayback(filePath);
     }
-    setIsMuted(false);
-    setVolume(1);
-    electronAPI?.mpvCommand?.(['set', 'volume', '100']);
-    electronAPI?.mpvCommand?.(['set', 'mute', 'no']);
-    setUseMpv(true);
-    setIsPlaying(true);
-    setMpvStatus('ready');
-    setMpvError(null);
-    setMpvDebug(null);
     return () => {
+      cancelled = true;
       window.electronAPI?.mpvStop?.();
     };
   }, [video.id, video.path, preferMpv, playerMode, isDeleted]);
@@ -493,27 +716,53 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
     if (!ctx) return;
     let rafId = 0;
     let imageData: ImageData | null = null;
+    let frameDriven = false;
+
+    const schedule = () => {
+      if (!rafId) rafId = requestAnimationFrame(render);
+    };
 
     const render = () => {
+      rafId = 0;
       const rect = canvas.getBoundingClientRect();
       const width = Math.max(1, Math.floor(rect.width));
       const height = Math.max(1, Math.floor(rect.height));
-      if (canvas.width !== width) canvas.width = width;
-      if (canvas.height !== height) canvas.height = height;
+
+      // The canvas backing store follows the rendered frame, which is capped
+      // at the video's size; CSS scales it to the element.
+      if (window.electronAPI?.mpvPresentFrame) {
+        const result = window.electronAPI.mpvPresentFrame(canvas, width, height);
+        if (!frameDriven || result?.pending) schedule();
+        return;
+      }
 
       const result = window.electronAPI?.mpvRenderFrame?.(width, height);
-      if (result?.ok && result.frame && result.frame.length === width * height * 4) {
-        if (!imageData || imageData.width !== width || imageData.height !== height) {
-          imageData = new ImageData(new Uint8ClampedArray(width * height * 4), width, height);
+      const frameWidth = result?.width ?? width;
+      const frameHeight = result?.height ?? height;
+      if (result?.ok && result.frame && result.frame.length === frameWidth * frameHeight * 4) {
+        if (canvas.width !== frameWidth) canvas.width = frameWidth;
+        if (canvas.height !== frameHeight) canvas.height = frameHeight;
+        if (!imageData || imageData.width !== frameWidth || imageData.height !== frameHeight) {
+          imageData = new ImageData(new Uint8ClampedArray(frameWidth * frameHeight * 4), frameWidth, frameHeight);
         }
         imageData.data.set(result.frame);
         ctx.putImageData(imageData, 0, 0);
       }
-      rafId = requestAnimationFrame(render);
+      if (!frameDriven) schedule();
     };
 
-    rafId = requestAnimationFrame(render);
-    return () => cancelAnimationFrame(rafId);
+    // When the addon can signal new frames, only render on those signals and
+    // on canvas resizes instead of spinning every animation frame.
+    frameDriven = Boolean(window.electronAPI?.mpvSetFrameCallback?.(schedule)?.ok);
+    const resizeObserver = frameDriven ? new ResizeObserver(schedule) : null;
+    resizeObserver?.observe(canvas);
+
+    schedule();
+    return () => {
+      cancelAnimationFrame(rafId);
+      resizeObserver?.disconnect();
+      if (frameDriven) window.electronAPI?.mpvSetFrameCallback?.(null);
+    };
   }, [useMpv, isDeleted]);
 
   useEffect(() => {
@@ -521,7 +770,7 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
       if (isDeleted) return;
       if (e.target instanceof HTMLInputElement || e.target instanceof HTMLTextAreaElement) return;
 
-      const keysToHandle = [' ', 'k', 'f', 'm', 'arrowright', 'arrowleft', 'l', 'j', 'arrowup', 'arrowdown', 'escape'];
+      const keysToHandle = [' ', 'k', 'f', 'm', 'arrowright', 'arrowleft', 'l', 'j', ',', '.', 'arrowup', 'arrowdown', 'escape'];
       if (!keysToHandle.includes(e.key.toLowerCase())) return;
 
       const performAction = () => {
@@ -555,6 +804,14 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
             e.preventDefault();
             seek(-10);
             break;
+          case ',':
+            e.preventDefault();
+            stepFrame(-1);
+            break;
+          case '.':
+            e.preventDefault();
+            stepFrame(1);
+            break;
           case 'arrowup':
             e.preventDefault();
             adjustVolume(0.1);
@@ -577,7 +834,7 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
 
     window.addEventListener('keydown', handleKeyDown);
     return () => window.removeEventListener('keydown', handleKeyDown);
-  }, [togglePlay, toggleFullscreen, toggleMute, seek, adjustVolume, onClose, resetHideTimer, isDeleted]);
+  }, [togglePlay, toggleFullscreen, toggleMute, seek, stepFrame, adjustVolume, onClose, resetHideTimer, isDeleted]);
 
   const sortedPlaylist = useMemo(() => {
     const result = [...allVideos];
@@ -592,6 +849,21 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
     }
   }, [allVideos, playlistSortMode, video.id]);
 
+  // Opens the next playlist item paused in the background once the current
+  // one has started, so stepping through a folder skips open and probe.
+  useEffect(() => {
+    const api = window.electronAPI;
+    if (!useMpv || mpvStatus !== 'ready' || !api?.mpvPreload || sortedPlaylist.length < 2) return;
+    const idx = sortedPlaylist.findIndex((v: { id: any; }) => v.id === video.id);
+    const next = sortedPlaylist[(idx + 1) % sortedPlaylist.length];
+    const nextPath = next?.path;
+    if (!nextPath || next.id === video.id) return;
+    const timer = window.setTimeout(() => {
+      api.mpvPreload?.(nextPath, { cacheProfile: isNetworkPath(nextPath) ? 'network' : 'local' });
+    }, PRELOAD_DELAY);
+    return () => window.clearTimeout(timer);
+  }, [useMpv, mpvStatus, sortedPlaylist, video.id]);
+
   const handleNext = () => onSelectVideo(sortedPlaylist[(sortedPlaylist.findIndex((v: { id: any; }) => v.id === video.id) + 1) % sortedPlaylist.length]);
   const handlePrev = () => onSelectVideo(sortedPlaylist[(sortedPlaylist.findIndex((v: { id: any; }) => v.id === video.id) - 1 + sortedPlaylist.length) % sortedPlaylist.length]);
 
@@ -718,17 +990,49 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
 
         {!isDeleted && (
           <div className={`px-2 pb-2 pt-0 bg-gray-800/15 border-t border-gray-700/20 space-y-0 transition-all duration-500 absolute bottom-0 left-0 right-0 z-40 ${showControls || !isPlaying ? 'opacity-100 translate-y-0' : 'opacity-0 translate-y-full'}`}>
-            <div className="px-4">
+            <div className="px-4 relative">
+              {hoverPreview && (
+                <div
+                  className="absolute bottom-full mb-1 -translate-x-1/2 pointer-events-none flex flex-col items-center gap-1"
+                  style={{ left: hoverPreview.left }}
+                >
+                  {hoverPreview.tile && (
+                    <div
+                      className="rounded border border-white/20 shadow-lg bg-black"
+                      style={{
+                        width: hoverPreview.tile.width,
+                        height: hoverPreview.tile.height,
+                        backgroundImage: `url(${hoverPreview.tile.url})`,
+                        backgroundPosition: `-${hoverPreview.tile.x}px -${hoverPreview.tile.y}px`
+                      }}
+                    />
+                  )}
+                  <span className="text-[11px] font-bold text-white bg-black/70 rounded px-1.5 py-0.5">{formatDuration(hoverPreview.time)}</span>
+                </div>
+              )}
               <input 
                 type="range" min="0" max="100" step="0.01" 
                 value={displayProgress} 
-                onMouseDown={() => { isUserSeeking.current = true; }}
-                onMouseUp={(e) => { 
-                  isUserSeeking.current = false; 
-                  resetHideTimer(true); 
-                  (e.target as HTMLInputElement).blur();
+                onPointerDown={() => { isUserSeeking.current = true; }}
+                onPointerUp={(e) => {
+                  endScrub(e.currentTarget);
+                  e.currentTarget.blur();
+                }}
+                onPointerCancel={(e) => endScrub(e.currentTarget)}
+                onKeyUp={(e) => {
+                  if (SCRUB_KEYS.has(e.key)) endScrub(e.currentTarget);
                 }}
                 onChange={handleProgressChange}
+                onMouseMove={(e) => {
+                  const total = (useMpv ? mpvDuration : videoRef.current?.duration) || seekPreview?.duration || video.duration;
+                  if (!total || !isFinite(total)) return;
+                  const bar = e.currentTarget;
+                  const rect = bar.getBoundingClientRect();
+                  const offset = Math.max(0, Math.min(rect.width, e.clientX - rect.left));
+                  const time = (offset / rect.width) * total;
+                  setHoverPreview({ left: bar.offsetLeft + offset, time, tile: seekPreview ? seekPreviewTile(seekPreview, time) : null });
+                }}
+                onMouseLeave={() => setHoverPreview(null)}
                 className="w-full h-1.5 py-4 rounded-lg appearance-none cursor-pointer accent-white progress-range transition-all hover:h-2 outline-none focus:outline-none" 
               />
             </div>
@@ -761,8 +1065,7 @@ export const VideoPlayer: React.FC<VideoPlayerProps> = (props) => {
                       setIsMuted(false);
                       if (useMpv && mpvStatus === 'ready') {
                         const mpvVolume = Math.round(next * 100);
-                        window.electronAPI?.mpvCommand?.(['set', 'volume', mpvVolume.toString()]);
-                        window.electronAPI?.mpvCommand?.(['set', 'mute', next === 0 ? 'yes' : 'no']);
+                        setMpvProperties({ volume: mpvVolume, mute: next === 0 });
                       }
                       resetHideTimer(true);
                     }} 
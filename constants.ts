@@ -15,7 +15,9 @@ export const SUPPORTED_VIDEO_EXTENSIONS = [
 ];
 
 export const MAX_CONCURRENT_THUMBNAILS = 3;
+export const NATIVE_THUMBNAILS_IN_FLIGHT = 12; // Handed to the native scheduler, which orders them by priority
 export const THUMBNAIL_WIDTH = 320;
 export const THUMBNAIL_HEIGHT = 180;
 export const PREVIEW_DELAY = 500; // Reduced to 500ms (0.5s) per user request
+export const PREVIEW_POOL_SIZE = 3; // Warm mpv players leased to hovered tiles
 export const THUMBNAIL_GENERATOR: 'browser' | 'ffmpeg' = 'ffmpeg';
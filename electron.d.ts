@@ -1,28 +1,167 @@
 // 全局类型定义，用于 Electron API
 export {};
 
+// Property values; type 'node' reads yield objects and arrays.
+export type MpvValue = string | number | boolean | null | MpvValue[] | { [key: string]: MpvValue };
+export type MpvPropertyChange = { id: number; name: string; value: MpvValue };
+export type MpvCacheProfile = 'local' | 'network' | 'low-memory';
+export type MpvDecodeProfile = 'full' | 'preview';
+// `demuxer-cache-state` read or observed with type 'node' (mpv's key names).
+export type MpvCacheState = {
+  'cache-end'?: number;
+  'reader-pts'?: number;
+  'cache-duration'?: number;
+  'fw-bytes'?: number;
+  'total-bytes'?: number;
+  'raw-input-rate'?: number;
+  'eof'?: boolean;
+  'underrun'?: boolean;
+  'idle'?: boolean;
+  'seekable-ranges'?: { start: number; end: number }[];
+};
+export type MpvHwdecPolicy = 'auto' | 'auto-copy' | 'd3d11va' | 'videotoolbox' | 'vaapi' | 'nvdec' | 'off';
+export type ThumbnailPriority = 'visible' | 'near' | 'background';
+export type MpvFrameFormat = 'rgba' | 'bgra' | 'i420';
+export type MpvFrameTiming = { displayInterval: number; presented: number; held: number; late: number; dropped: number };
+// Latencies in milliseconds.
+export type MpvLatencySummary = { count: number; mean: number; p50: number; p90: number; p99: number; max: number };
+export type MpvStats = {
+  render: MpvLatencySummary;
+  convert: MpvLatencySummary;
+  copy: MpvLatencySummary;
+  getProperty: MpvLatencySummary;
+  command: MpvLatencySummary;
+  frames: {
+    rendered: number;
+    presented: number;
+    held: number;
+    late: number;
+    dropped: number;
+    mpvDropped: number | null;
+    mpvDelayed: number | null;
+  };
+  buffers: { allocations: number; allocatedBytes: number; poolHits: number };
+  displayInterval: number;
+};
+// Bytes held by the addon in the renderer; `trims`/`releasedBytes` are totals.
+export type MpvMemoryUsage = {
+  budget: number;
+  total: number;
+  frames: number;
+  framePool: number;
+  renderBuffers: number;
+  demuxerCache: number;
+  thumbnailIndex: number;
+  players: number;
+  idlePlayers: number;
+  trims: number;
+  releasedBytes: number;
+};
+export type MpvTrimResult = { released: number; steps: number; withinBudget: boolean };
+export type LibraryFile = {
+  path: string;
+  url: string;
+  name: string;
+  size: number;
+  lastModified: number;
+};
+export type LibraryDelta = { added: LibraryFile[]; changed: LibraryFile[]; removed: string[] };
+export type SeekPreview = {
+  ok: boolean;
+  error?: string;
+  // vhub-thumb:// URL of the cached sheet; dataUrl only when it could not be cached.
+  url?: string;
+  dataUrl?: string;
+  tiles?: number;
+  columns?: number;
+  rows?: number;
+  tileWidth?: number;
+  tileHeight?: number;
+  interval?: number;
+  duration?: number;
+};
+export type MediaInfo = {
+  path: string;
+  duration?: number;
+  width?: number;
+  height?: number;
+  fps?: number;
+  rotation?: number;
+  videoCodec?: string;
+  audioCodec?: string;
+  container?: string;
+  videoTracks?: number;
+  audioTracks?: number;
+  subtitleTracks?: number;
+  error?: string;
+};
+
 declare global {
   interface Window {
     electronAPI?: {
       openDirectory: () => Promise<string[] | null>;
-      openDirectoryFiles?: (extensions: string[]) => Promise<Array<{
-        path: string;
-        url: string;
-        name: string;
-        size: number;
-        lastModified: number;
-      }> | null>;
-      createThumbnail?: (inputPath: string, options?: { outputPath?: string; width?: number; height?: number; quality?: number }) => Promise<{ ok: boolean; error?: string; outputPath?: string; dataUrl?: string; duration?: number }>;
+      openDirectoryFiles?: (extensions: string[]) => Promise<LibraryFile[] | null>;
+      onLibraryScanBatch?: (callback: (files: LibraryFile[]) => void) => () => void;
+      onLibraryChanges?: (callback: (delta: LibraryDelta) => void) => () => void;
+      rescanLibrary?: () => Promise<{ ok: boolean; error?: string } & Partial<LibraryDelta>>;
+      probeMedia?: (paths: string[]) => Promise<{ ok: boolean; error?: string; records?: MediaInfo[] }>;
+      createThumbnail?: (inputPath: string, options?: { outputPath?: string; width?: number; height?: number; quality?: number; key?: string; priority?: ThumbnailPriority }) => Promise<{ ok: boolean; error?: string; outputPath?: string; url?: string; dataUrl?: string; duration?: number }>;
+      getSeekPreview?: (inputPath: string) => Promise<SeekPreview>;
+      getKeyframeIndex?: (inputPath: string) => Promise<{ ok: boolean; error?: string; keyframes?: Float64Array }>;
+      cancelThumbnail?: (key: string) => Promise<{ ok: boolean; error?: string }>;
+      setThumbnailPriority?: (key: string, priority: ThumbnailPriority) => Promise<{ ok: boolean; error?: string }>;
       trashItem?: (filePath: string) => Promise<{ ok: boolean; error?: string }>;
       playWithMpv?: (filePath: string) => Promise<{ ok: boolean; error?: string }>;
-      mpvInit?: () => { ok: boolean; error?: string };
+      mpvInit?: (options?: { gpu?: boolean; hwdec?: MpvHwdecPolicy; format?: MpvFrameFormat; fitToVideo?: boolean; cacheProfile?: MpvCacheProfile; decodeProfile?: MpvDecodeProfile }) => { ok: boolean; error?: string; renderApi?: 'opengl' | 'sw' | null; players?: number; previewPool?: { size: number; leased: number; hits: number; reclaims: number } | null };
+      mpvInitAsync?: (options?: { gpu?: boolean; hwdec?: MpvHwdecPolicy; format?: MpvFrameFormat; fitToVideo?: boolean; cacheProfile?: MpvCacheProfile; decodeProfile?: MpvDecodeProfile }) => Promise<{ ok: boolean; error?: string; renderApi?: 'opengl' | 'sw' | null }>;
       mpvLoad?: (filePath: string) => { ok: boolean; error?: string };
+      mpvPreload?: (filePath: string, options?: { cacheProfile?: MpvCacheProfile }) => { ok: boolean; error?: string };
+      mpvCancelPreload?: (release?: boolean) => { ok: boolean; error?: string };
       mpvStop?: () => { ok: boolean; error?: string };
       mpvCommand?: (args: string[]) => { ok: boolean; error?: string };
-      mpvGetProperty?: (name: string, type: string) => { ok: boolean; error?: string; value: string | number | boolean | null };
-      mpvRenderFrame?: (width: number, height: number) => { ok: boolean; error?: string; frame: Uint8Array | null };
+      mpvCommandBatch?: (commands: string[][]) => { ok: boolean; error?: string; results: boolean[] | null };
+      mpvSetProperties?: (values: Record<string, MpvValue>) => { ok: boolean; error?: string; results: Record<string, boolean> | null };
+      mpvGetProperty?: (name: string, type: string) => { ok: boolean; error?: string; value: MpvValue };
+      mpvRenderFrame?: (width: number, height: number) => { ok: boolean; error?: string; frame: Uint8Array | null; width?: number; height?: number };
+      mpvPresentFrame?: (canvas: HTMLCanvasElement, width: number, height: number) => { ok: boolean; error?: string; rendered?: boolean; pending?: boolean };
+      mpvGetFrameTiming?: () => { ok: boolean; error?: string; timing: MpvFrameTiming | null };
+      mpvGetStats?: () => { ok: boolean; error?: string; stats: MpvStats | null };
+      mpvResetStats?: () => { ok: boolean; error?: string };
+      mpvSetStatsCallback?: (callback: ((stats: MpvStats) => void) | null, intervalMs?: number) => { ok: boolean; error?: string };
+      mpvSetMemoryBudget?: (bytes: number) => { ok: boolean; error?: string };
+      mpvGetMemoryUsage?: () => { ok: boolean; error?: string; usage: MpvMemoryUsage | null };
+      mpvTrimMemory?: () => { ok: boolean; error?: string; result: MpvTrimResult | null };
+      onMemoryPressure?: (callback: (usage: MpvMemoryUsage) => void) => () => void;
+      mpvSetFrameFormat?: (format: MpvFrameFormat) => { ok: boolean; error?: string };
+      mpvSetHwdec?: (policy: MpvHwdecPolicy) => { ok: boolean; error?: string };
+      mpvSetCacheProfile?: (profile: MpvCacheProfile) => { ok: boolean; error?: string };
+      mpvSetDecodeProfile?: (profile: MpvDecodeProfile) => { ok: boolean; error?: string };
+      mpvGetCacheProfile?: () => { ok: boolean; error?: string; profile: MpvCacheProfile | null };
+      mpvGetDecoder?: () => { ok: boolean; error?: string; decoder: { policy: MpvHwdecPolicy; hwdec: string; current: string | null; profile: MpvDecodeProfile } | null };
+      mpvHasNewFrame?: () => boolean;
+      mpvSetFrameCallback?: (callback: (() => void) | null) => { ok: boolean; error?: string };
+      mpvObserveProperty?: (name: string, type: string) => { ok: boolean; error?: string; id?: number };
+      mpvUnobserveProperty?: (id: number) => { ok: boolean; error?: string };
+      mpvSetPropertyCallback?: (callback: ((changes: MpvPropertyChange[]) => void) | null) => { ok: boolean; error?: string };
+      mpvLoadAsync?: (filePath: string) => Promise<{ ok: boolean; error?: string; value: boolean | null }>;
+      mpvCommandAsync?: (args: string[]) => Promise<{ ok: boolean; error?: string; value: boolean | null }>;
+      mpvGetPropertyAsync?: (name: string, type: string) => Promise<{ ok: boolean; error?: string; value: MpvValue }>;
+      mpvSetPropertyAsync?: (name: string, value: string) => Promise<{ ok: boolean; error?: string; value: boolean | null }>;
       mpvDestroy?: () => { ok: boolean; error?: string };
-      mpvDebug?: () => { addonPath: string | null; addonError: string | null; libPath: string | undefined };
+      mpvPlayerCreate?: (options?: { gpu?: boolean; hwdec?: MpvHwdecPolicy; format?: MpvFrameFormat; fitToVideo?: boolean; cacheProfile?: MpvCacheProfile; decodeProfile?: MpvDecodeProfile }) => { ok: boolean; error?: string; id?: number };
+      mpvPlayerLoad?: (id: number, filePath: string) => { ok: boolean; error?: string };
+      mpvPlayerLoadAsync?: (id: number, filePath: string) => Promise<{ ok: boolean; error?: string; value: boolean | null }>;
+      mpvPlayerCommand?: (id: number, args: string[]) => { ok: boolean; error?: string };
+      mpvPlayerCommandBatch?: (id: number, commands: string[][]) => { ok: boolean; error?: string; results?: boolean[] };
+      mpvPlayerSetProperties?: (id: number, values: Record<string, MpvValue>) => { ok: boolean; error?: string; results?: Record<string, boolean> };
+      mpvPlayerGetProperty?: (id: number, name: string, type: string) => { ok: boolean; error?: string; value?: MpvValue };
+      mpvPlayerPresent?: (id: number, canvas: HTMLCanvasElement, width: number, height: number) => { ok: boolean; error?: string; rendered?: boolean; pending?: boolean };
+      mpvPlayerSetFrameCallback?: (id: number, callback: (() => void) | null) => { ok: boolean; error?: string };
+      mpvPlayerDestroy?: (id: number) => { ok: boolean; error?: string };
+      mpvPreviewWarm?: (size?: number) => Promise<{ ok: boolean; error?: string }>;
+      mpvPreviewAcquire?: (key: string) => { ok: boolean; error?: string; id?: number };
+      mpvPreviewRelease?: (key: string) => { ok: boolean; error?: string };
+      mpvDebug?: () => { addonPath: string | null; addonError: string | null; libPath: string | undefined; renderApi?: 'opengl' | 'sw' | null; players?: number; previewPool?: { size: number; leased: number; hits: number; reclaims: number } | null };
     };
   }
 }
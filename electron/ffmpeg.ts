@@ -17,8 +17,19 @@ export type ThumbnailResult = {
   ok: boolean;
   error?: string;
   outputPath?: string;
+  // Served from the thumbnail protocol once cached; a data URL otherwise.
+  url?: string;
   dataUrl?: string;
+  // Encoded image; main process only, replaced by a URL before the result
+  // goes over IPC.
+  data?: Buffer;
   duration?: number;
+  // Thumbnail size, then the source's display size and video codec.
+  width?: number;
+  height?: number;
+  videoWidth?: number;
+  videoHeight?: number;
+  codec?: string;
 };
 
 const nodeRequire = createRequire(import.meta.url);
@@ -102,6 +113,7 @@ export const createThumbnail = async (options: ThumbnailOptions): Promise<Thumbn
       child.on('error', (err) => resolve({ ok: false, error: err.message }));
       child.on('close', async (code) => {
         const duration = parseDuration(stderr);
+        const video = parseVideoStream(stderr);
         if (code !== 0) {
           console.error('[ffmpeg] failed', {
             code,
@@ -114,9 +126,8 @@ export const createThumbnail = async (options: ThumbnailOptions): Promise<Thumbn
         }
 
         try {
-          const buffer = await fs.promises.readFile(finalOutputPath);
-          const dataUrl = `data:image/jpeg;base64,${buffer.toString('base64')}`;
-          resolve({ ok: true, outputPath: finalOutputPath, dataUrl, duration });
+          const data = await fs.promises.readFile(finalOutputPath);
+          resolve({ ok: true, outputPath: finalOutputPath, data, duration, ...video });
         } catch (err) {
           resolve({ ok: false, error: err instanceof Error ? err.message : String(err) });
         }
@@ -136,3 +147,10 @@ const parseDuration = (output: string) => {
   if (!isFinite(hours) || !isFinite(minutes) || !isFinite(seconds)) return undefined;
   return hours * 3600 + minutes * 60 + seconds;
 };
+
+// First video stream line, e.g. "Stream #0:0: Video: h264 (High), yuv420p, 1920x1080".
+const parseVideoStream = (output: string) => {
+  const match = output.match(/Stream #[^\n]*?Video:\s*([\w-]+)[^\n]*?\b(\d{2,5})x(\d{2,5})\b/);
+  if (!match) return {};
+  return { codec: match[1], videoWidth: Number(match[2]), videoHeight: Number(match[3]) };
+};
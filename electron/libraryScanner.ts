@@ -0,0 +1,280 @@
+import * as fs from 'fs';
+import * as path from 'path';
+import { pathToFileURL } from 'url';
+import { loadNativeAddon } from './nativeAddon.js';
+
+export type LibraryFile = {
+  path: string;
+  url: string;
+  name: string;
+  size: number;
+  lastModified: number;
+};
+
+export type LibraryDelta = {
+  added: LibraryFile[];
+  changed: LibraryFile[];
+  removed: string[];
+};
+
+type NativeScanEntry = { path: string; name: string; size: number; mtimeMs: number };
+
+type NativeScanSummary = {
+  files: number;
+  directories: number;
+  reusedDirectories: number;
+  errors: number;
+  elapsedMs: number;
+  incremental: boolean;
+  added: NativeScanEntry[];
+  changed: NativeScanEntry[];
+  removed: string[];
+};
+
+type NativeDirectoryScanner = {
+  scan: (
+    roots: string[],
+    options: { extensions?: string[]; batchSize?: number; full?: boolean },
+    onBatch: (entries: NativeScanEntry[]) => void
+  ) => Promise<NativeScanSummary>;
+  cancel: () => boolean;
+  reset: () => boolean;
+  directories: () => string[];
+};
+
+type NativeWatchChange =
+  | { type: 'add' | 'modify'; path: string; size: number; mtimeMs: number }
+  | { type: 'remove'; path: string }
+  | { type: 'rescan' };
+
+type NativeDirectoryWatcher = {
+  watch: (
+    roots: string[],
+    options: { extensions?: string[]; debounceMs?: number; directories?: string[] },
+    onChanges: (changes: NativeWatchChange[]) => void
+  ) => boolean;
+  close: () => boolean;
+  stats: () => { watching: boolean; watches: number; batches: number; changes: number; rescans: number };
+};
+
+type ScannerAddon = {
+  DirectoryScanner: new (options?: { threads?: number }) => NativeDirectoryScanner;
+  DirectoryWatcher?: new () => NativeDirectoryWatcher;
+};
+
+// Files per IPC message while a scan streams into the renderer.
+const SCAN_BATCH_SIZE = 1000;
+// Quiet time before a changed path is reported; long enough for a copy in
+// progress to finish writing.
+const WATCH_DEBOUNCE_MS = 1000;
+
+const toLibraryFile = (entry: NativeScanEntry): LibraryFile => ({
+  path: entry.path,
+  url: pathToFileURL(entry.path).toString(),
+  name: entry.name,
+  size: entry.size,
+  lastModified: entry.mtimeMs
+});
+
+let scanner: NativeDirectoryScanner | null | undefined;
+
+const getScanner = () => {
+  if (scanner !== undefined) return scanner;
+  const addon = loadNativeAddon<ScannerAddon>();
+  try {
+    scanner = addon?.DirectoryScanner ? new addon.DirectoryScanner() : null;
+  } catch (err) {
+    console.warn('[scanner] native scanner unavailable:', err instanceof Error ? err.message : err);
+    scanner = null;
+  }
+  return scanner;
+};
+
+// Sequential fallback for builds without the addon.
+const walkDirectories = async (roots: string[], extensions: string[]) => {
+  const allowed = new Set(extensions.map((ext) => ext.toLowerCase()));
+  const files: LibraryFile[] = [];
+
+  const walk = async (dir: string) => {
+    const entries = await fs.promises.readdir(dir, { withFileTypes: true });
+    for (const entry of entries) {
+      const fullPath = path.join(dir, entry.name);
+      if (entry.isDirectory()) {
+        await walk(fullPath);
+      } else if (entry.isFile()) {
+        const ext = path.extname(entry.name).toLowerCase();
+        if (allowed.size === 0 || allowed.has(ext)) {
+          const stat = await fs.promises.stat(fullPath);
+          files.push({
+            path: fullPath,
+            url: pathToFileURL(fullPath).toString(),
+            name: entry.name,
+            size: stat.size,
+            lastModified: stat.mtimeMs
+          });
+        }
+      }
+    }
+  };
+
+  for (const dir of roots) {
+    await walk(dir);
+  }
+  return files;
+};
+
+const diffLibraries = (before: Map<string, LibraryFile>, after: LibraryFile[]): LibraryDelta => {
+  const previous = new Map(before);
+  const delta: LibraryDelta = { added: [], changed: [], removed: [] };
+  for (const file of after) {
+    const old = previous.get(file.path);
+    if (!old) {
+      delta.added.push(file);
+    } else if (old.size !== file.size || old.lastModified !== file.lastModified) {
+      delta.changed.push(file);
+    }
+    previous.delete(file.path);
+  }
+  delta.removed = [...previous.keys()];
+  return delta;
+};
+
+let lastRoots: string[] = [];
+let lastExtensions: string[] = [];
+let lastFiles = new Map<string, LibraryFile>();
+// Set once the watcher has applied changes the scanner snapshot has not seen.
+let watchedSinceScan = false;
+let rescanInFlight: Promise<LibraryDelta | null> | null = null;
+
+const indexFiles = (files: LibraryFile[]) => new Map(files.map((file) => [file.path, file]));
+
+const runScan = async (roots: string[], extensions: string[], onBatch?: (files: LibraryFile[]) => void) => {
+  const native = getScanner();
+  if (!native) {
+    const files = await walkDirectories(roots, extensions);
+    onBatch?.(files);
+    return { files, summary: null };
+  }
+
+  const files: LibraryFile[] = [];
+  const summary = await native.scan(roots, { extensions, batchSize: SCAN_BATCH_SIZE }, (entries) => {
+    const batch = entries.map(toLibraryFile);
+    files.push(...batch);
+    onBatch?.(batch);
+  });
+  console.log('[scanner] scanned', {
+    files: summary.files,
+    directories: summary.directories,
+    reused: summary.reusedDirectories,
+    errors: summary.errors,
+    ms: Math.round(summary.elapsedMs)
+  });
+  return { files, summary };
+};
+
+// Full scan of newly chosen roots. Results stream through `onBatch` in
+// discovery order; the resolved list holds the same files in the same order.
+export const scanLibrary = async (roots: string[], extensions: string[], onBatch?: (files: LibraryFile[]) => void) => {
+  scanner?.reset();
+  const { files } = await runScan(roots, extensions, onBatch);
+  lastRoots = roots;
+  lastExtensions = extensions;
+  lastFiles = indexFiles(files);
+  watchedSinceScan = false;
+  return files;
+};
+
+// Rescans the last roots. The native scanner only re-lists directories whose
+// mtime moved, re-stats the files of the rest, and reports the delta itself.
+// Concurrent callers (window focus, a watcher overflow) share one scan.
+export const rescanLibrary = (): Promise<LibraryDelta | null> => {
+  if (lastRoots.length === 0) return Promise.resolve(null);
+  if (rescanInFlight) return rescanInFlight;
+  rescanInFlight = (async () => {
+    const { files, summary } = await runScan(lastRoots, lastExtensions);
+    // The scanner diffs against its own snapshot, which misses whatever the
+    // watcher already delivered.
+    const delta = summary?.incremental && !watchedSinceScan
+      ? { added: summary.added.map(toLibraryFile), changed: summary.changed.map(toLibraryFile), removed: summary.removed }
+      : diffLibraries(lastFiles, files);
+    lastFiles = indexFiles(files);
+    watchedSinceScan = false;
+    return delta;
+  })().finally(() => {
+    rescanInFlight = null;
+  });
+  return rescanInFlight;
+};
+
+let watcher: NativeDirectoryWatcher | null | undefined;
+
+const getWatcher = () => {
+  if (watcher !== undefined) return watcher;
+  const addon = loadNativeAddon<ScannerAddon>();
+  try {
+    watcher = addon?.DirectoryWatcher ? new addon.DirectoryWatcher() : null;
+  } catch (err) {
+    console.warn('[scanner] native watcher unavailable:', err instanceof Error ? err.message : err);
+    watcher = null;
+  }
+  return watcher;
+};
+
+// A removal may name a directory; everything known below it is gone too.
+const filesAtOrBelow = (target: string) => {
+  if (lastFiles.has(target)) return [target];
+  const prefix = target.endsWith(path.sep) ? target : target + path.sep;
+  return [...lastFiles.keys()].filter((filePath) => filePath.startsWith(prefix));
+};
+
+// Folds one batch of watcher changes into the last scan result.
+const applyWatchChanges = (changes: NativeWatchChange[]): LibraryDelta => {
+  const delta: LibraryDelta = { added: [], changed: [], removed: [] };
+  for (const change of changes) {
+    if (change.type === 'rescan') continue;
+    if (change.type === 'remove') {
+      for (const filePath of filesAtOrBelow(change.path)) {
+        lastFiles.delete(filePath);
+        delta.removed.push(filePath);
+      }
+      continue;
+    }
+    const file = toLibraryFile({ ...change, name: path.basename(change.path) });
+    const known = lastFiles.get(file.path);
+    if (known && known.size === file.size && known.lastModified === file.lastModified) continue;
+    (known ? delta.changed : delta.added).push(file);
+    lastFiles.set(file.path, file);
+  }
+  if (delta.added.length || delta.changed.length || delta.removed.length) watchedSinceScan = true;
+  return delta;
+};
+
+// Watches the last scanned roots and reports what changed as library deltas.
+// Lost events fall back to an incremental rescan. Returns false when the
+// addon has no watcher, leaving callers with rescanLibrary alone.
+export const watchLibrary = (onDelta: (delta: LibraryDelta) => void) => {
+  const active = getWatcher();
+  if (!active || lastRoots.length === 0) return false;
+  const emit = (delta: LibraryDelta | null) => {
+    if (delta && (delta.added.length || delta.changed.length || delta.removed.length)) onDelta(delta);
+  };
+  try {
+    return active.watch(
+      lastRoots,
+      { extensions: lastExtensions, debounceMs: WATCH_DEBOUNCE_MS, directories: scanner?.directories() ?? [] },
+      (changes) => {
+        emit(applyWatchChanges(changes));
+        if (changes.some((change) => change.type === 'rescan')) {
+          rescanLibrary().then(emit, (err) => console.warn('[scanner] rescan after overflow failed:', err));
+        }
+      }
+    );
+  } catch (err) {
+    console.warn('[scanner] watch failed:', err instanceof Error ? err.message : err);
+    return false;
+  }
+};
+
+export const unwatchLibrary = () => {
+  watcher?.close();
+};
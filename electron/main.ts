@@ -1,9 +1,32 @@
-import { app, BrowserWindow, dialog, ipcMain, Menu, shell } from 'electron';
+import { app, BrowserWindow, dialog, ipcMain, Menu, protocol, shell } from 'electron';
 import * as path from 'path';
-import { fileURLToPath, pathToFileURL } from 'url';
+import { fileURLToPath } from 'url';
 import { spawn } from 'child_process';
 import * as fs from 'fs';
 import { createThumbnail } from './ffmpeg.js';
+import { rescanLibrary, scanLibrary, watchLibrary, type LibraryDelta } from './libraryScanner.js';
+import { probeMedia } from './mediaProber.js';
+import {
+  cancelNativeThumbnail,
+  createNativeSprite,
+  createNativeThumbnail,
+  forgetCachedThumbnail,
+  loadKeyframeIndex,
+  publishSprite,
+  publishThumbnail,
+  readCachedSprite,
+  readCachedThumbnail,
+  serveCachedImage,
+  setNativeThumbnailPriority,
+  statThumbnailSource,
+  THUMBNAIL_SCHEME,
+  type ThumbnailPriority
+} from './thumbnailer.js';
+
+// Must be registered before the app is ready.
+protocol.registerSchemesAsPrivileged([
+  { scheme: THUMBNAIL_SCHEME, privileges: { standard: true, secure: true, supportFetchAPI: true } }
+]);
 
 type LogLevel = 'log' | 'info' | 'warn' | 'error' | 'debug';
 
@@ -159,6 +182,7 @@ app.whenReady().then(() => {
       // ignore
     });
 
+  protocol.handle(THUMBNAIL_SCHEME, serveCachedImage);
   createWindow();
 
   // 移除默认菜单栏
@@ -301,7 +325,14 @@ ipcMain.handle('dialog:openDirectory', async () => {
   return null;
 });
 
-ipcMain.handle('dialog:openDirectoryFiles', async (_event, extensions: string[]) => {
+// Cache entries of removed or rewritten files are dropped as changes arrive
+// rather than swept up front.
+const forgetThumbnails = (delta: LibraryDelta) => {
+  for (const filePath of delta.removed) forgetCachedThumbnail(filePath);
+  for (const file of delta.changed) forgetCachedThumbnail(file.path);
+};
+
+ipcMain.handle('dialog:openDirectoryFiles', async (event, extensions: string[]) => {
   console.log('[dialog] openDirectoryFiles');
   if (!mainWindow) {
     console.log('[dialog] no mainWindow');
@@ -317,45 +348,43 @@ ipcMain.handle('dialog:openDirectoryFiles', async (_event, extensions: string[])
     return null;
   }
 
-  const allowed = new Set((extensions || []).map((ext) => ext.toLowerCase()));
-  const files: Array<{
-    path: string;
-    url: string;
-    name: string;
-    size: number;
-    lastModified: number;
-  }> = [];
-
-  const walk = async (dir: string) => {
-    const entries = await fs.promises.readdir(dir, { withFileTypes: true });
-    for (const entry of entries) {
-      const fullPath = path.join(dir, entry.name);
-      if (entry.isDirectory()) {
-        await walk(fullPath);
-      } else if (entry.isFile()) {
-        const ext = path.extname(entry.name).toLowerCase();
-        if (allowed.size === 0 || allowed.has(ext)) {
-          const stat = await fs.promises.stat(fullPath);
-          files.push({
-            path: fullPath,
-            url: pathToFileURL(fullPath).toString(),
-            name: entry.name,
-            size: stat.size,
-            lastModified: stat.mtimeMs
-          });
-        }
-      }
-    }
-  };
-
-  for (const dir of result.filePaths) {
-    await walk(dir);
-  }
+  // Batches reach the renderer while the scan is still running.
+  const files = await scanLibrary(result.filePaths, extensions || [], (batch) => {
+    if (!event.sender.isDestroyed()) event.sender.send('library:scanBatch', batch);
+  });
 
   console.log('[dialog] files:', files.length);
+  const sender = event.sender;
+  const watching = watchLibrary((delta) => {
+    forgetThumbnails(delta);
+    if (!sender.isDestroyed()) sender.send('library:changes', delta);
+  });
+  console.log('[dialog] watching:', watching);
   return files;
 });
 
+ipcMain.handle('library:rescan', async () => {
+  try {
+    const delta = await rescanLibrary();
+    if (delta) forgetThumbnails(delta);
+    return delta ? { ok: true, ...delta } : { ok: false, error: 'no_library' };
+  } catch (err) {
+    return { ok: false, error: err instanceof Error ? err.message : String(err) };
+  }
+});
+
+ipcMain.handle('media:probe', async (_event, paths: string[]) => {
+  if (!Array.isArray(paths) || paths.some((item) => typeof item !== 'string')) {
+    return { ok: false, error: 'missing_paths' };
+  }
+  try {
+    const records = await probeMedia(paths);
+    return records ? { ok: true, records } : { ok: false, error: 'addon_missing' };
+  } catch (err) {
+    return { ok: false, error: err instanceof Error ? err.message : String(err) };
+  }
+});
+
 ipcMain.handle('file:trash', async (_event, filePath: string) => {
   if (typeof filePath !== 'string' || !filePath.trim()) {
     return { ok: false, error: 'missing_path' };
@@ -371,8 +400,56 @@ ipcMain.handle('file:trash', async (_event, filePath: string) => {
   }
 });
 
-ipcMain.handle('ffmpeg:thumbnail', async (_event, options: { inputPath: string; outputPath?: string; width?: number; height?: number; quality?: number }) => {
-  return await createThumbnail(options);
+ipcMain.handle('ffmpeg:thumbnail', async (_event, options: { inputPath: string; outputPath?: string; width?: number; height?: number; quality?: number; key?: string; priority?: ThumbnailPriority }) => {
+  // The media worker's extractor avoids an ffmpeg spawn and temp file per
+  // video; ffmpeg remains the fallback when the addon or the file is not
+  // supported, including files that crash the worker.
+  // Both are backed by the persistent cache, so a reopened library is served
+  // without decoding anything.
+  const { key, priority, ...thumbnailOptions } = options;
+  const stamp = await statThumbnailSource(thumbnailOptions.inputPath);
+  const cached = stamp && readCachedThumbnail(thumbnailOptions.inputPath, stamp);
+  if (cached) return cached;
+
+  const native = await createNativeThumbnail(thumbnailOptions, { key, priority });
+  if (native?.error === 'cancelled') return native;
+  const result = native?.ok ? native : await createThumbnail(thumbnailOptions);
+  return publishThumbnail(thumbnailOptions.inputPath, stamp, result);
+});
+
+// Seek-preview sprite sheet for the player's scrub bar, cached like
+// thumbnails. There is no ffmpeg fallback; without the addon the bar simply
+// has no preview.
+ipcMain.handle('thumbnail:sprite', async (_event, inputPath: string) => {
+  if (typeof inputPath !== 'string' || !inputPath) return { ok: false, error: 'missing_path' };
+  const stamp = await statThumbnailSource(inputPath);
+  const cached = stamp && readCachedSprite(inputPath, stamp);
+  if (cached) return cached;
+
+  const built = await createNativeSprite(inputPath);
+  if (!built) return { ok: false, error: 'addon_missing' };
+  return publishSprite(inputPath, stamp, built);
+});
+
+// Keyframe times for the player's scrub bar; files in containers without an
+// index report an error and are scrubbed without snapping.
+ipcMain.handle('media:keyframes', async (_event, inputPath: string) => {
+  if (typeof inputPath !== 'string' || !inputPath) return { ok: false, error: 'missing_path' };
+  return loadKeyframeIndex(inputPath);
+});
+
+ipcMain.handle('thumbnail:cancel', (_event, key: string) => {
+  if (typeof key !== 'string' || !key) return { ok: false, error: 'missing_key' };
+  return { ok: cancelNativeThumbnail(key) };
+});
+
+ipcMain.handle('thumbnail:priority', (_event, key: string, priority: ThumbnailPriority) => {
+  if (typeof key !== 'string' || !key) return { ok: false, error: 'missing_key' };
+  try {
+    return { ok: setNativeThumbnailPriority(key, priority) };
+  } catch (err) {
+    return { ok: false, error: err instanceof Error ? err.message : String(err) };
+  }
 });
 
 ipcMain.handle('mpv:play', async (_event, filePath: string) => {
@@ -0,0 +1,298 @@
+import { app, utilityProcess } from 'electron';
+import * as path from 'path';
+import { fileURLToPath } from 'url';
+import type { MediaInfo } from './mediaProber.js';
+import type { ThumbnailPriority } from './thumbnailer.js';
+
+// The thumbnail scheduler, media prober and keyframe reader run in a
+// long-lived utility process, so a file that crashes them takes down that
+// process instead of the main one. Requests and replies travel in batches, one message per tick
+// each way, and the process is restarted on demand after a crash.
+
+export type WorkerFrame = {
+  width: number;
+  height: number;
+  duration: number;
+  videoWidth: number;
+  videoHeight: number;
+  codec: string;
+  // Tight BGRA; structured clone delivers it as a Uint8Array.
+  pixels: Uint8Array;
+  // Sprite sheets only.
+  tiles?: number;
+  columns?: number;
+  rows?: number;
+  tileWidth?: number;
+  tileHeight?: number;
+  interval?: number;
+};
+
+export type ThumbnailJobOptions = {
+  width?: number;
+  height?: number;
+  position?: number;
+  timeoutMs?: number;
+  priority?: ThumbnailPriority;
+  tiles?: number;
+  columns?: number;
+};
+
+type JobRequest =
+  | { id: number; op: 'thumbnail'; key: string; path: string; options: ThumbnailJobOptions }
+  | { id: number; op: 'probe'; paths: string[]; timeoutMs: number }
+  | { id: number; op: 'keyframes'; path: string };
+
+// Distributes over the union so each variant keeps its own fields.
+type NewJob<T = JobRequest> = T extends JobRequest ? Omit<T, 'id'> : never;
+
+type ControlRequest =
+  | { op: 'cancel'; key: string }
+  | { op: 'priority'; key: string; priority: ThumbnailPriority };
+
+export type MediaWorkerRequest = JobRequest | ControlRequest;
+
+export type MediaWorkerReply =
+  | { id: number; frame: WorkerFrame }
+  | { id: number; records: MediaInfo[] }
+  | { id: number; keyframes: Float64Array }
+  | { id: number; error: string };
+
+export type MediaWorkerBatch = { requests: MediaWorkerRequest[] };
+export type MediaWorkerReplyBatch = { replies: MediaWorkerReply[] };
+
+const WORKER_ENTRY = path.join(path.dirname(fileURLToPath(import.meta.url)), 'mediaWorker.js');
+
+const PRIORITIES: ThumbnailPriority[] = ['visible', 'near', 'background'];
+
+// Restarts back off from 250 ms to 10 s while the worker keeps crashing, and
+// reset once it has stayed up for 30 s.
+const RESTART_DELAY_MS = 250;
+const MAX_RESTART_DELAY_MS = 10_000;
+const STABLE_UPTIME_MS = 30_000;
+
+// Jobs in flight during a crash are resent one at a time, so a job that
+// crashes the worker again while alone is known to be the cause and fails
+// with `worker_crashed` after this many attempts.
+const MAX_ATTEMPTS = 2;
+
+// Nothing else is sent while a suspect runs alone, so one that has not
+// replied by then fails with `timeout` and the worker is restarted.
+const ISOLATED_TIMEOUT_MS = 45_000;
+
+type PendingJob = {
+  request: JobRequest;
+  sent: boolean;
+  attempts: number;
+  settle: (reply: MediaWorkerReply) => void;
+};
+
+let worker: Electron.UtilityProcess | null = null;
+let ready = false;
+let startedAt = 0;
+let restartDelay = RESTART_DELAY_MS;
+let restartTimer: NodeJS.Timeout | null = null;
+let stopped = false;
+let crashes = 0;
+
+const pending = new Map<number, PendingJob>();
+let controls: ControlRequest[] = [];
+let flushScheduled = false;
+let nextId = 1;
+// Ids waiting to be resent alone after a crash, and the one in flight.
+let suspects: number[] = [];
+let isolated: number | null = null;
+let isolatedTimer: NodeJS.Timeout | null = null;
+
+const spawnWorker = () => {
+  const child = utilityProcess.fork(WORKER_ENTRY, [], {
+    serviceName: 'Media Worker',
+    stdio: 'inherit',
+    env: { ...process.env, VHUB_RESOURCES_PATH: process.resourcesPath }
+  });
+  child.on('spawn', () => {
+    if (worker !== child) return;
+    ready = true;
+    scheduleFlush();
+  });
+  child.on('message', (message: MediaWorkerReplyBatch) => {
+    for (const reply of message.replies ?? []) {
+      const job = pending.get(reply.id);
+      if (!job) continue;
+      pending.delete(reply.id);
+      job.settle(reply);
+      if (reply.id === isolated) {
+        clearIsolated();
+        scheduleFlush();
+      }
+    }
+  });
+  child.on('exit', (code) => handleExit(child, code));
+  worker = child;
+  ready = false;
+  startedAt = Date.now();
+};
+
+const handleExit = (child: Electron.UtilityProcess, code: number) => {
+  if (worker !== child) return;
+  worker = null;
+  ready = false;
+  // Cancels and priority changes only made sense to the old process.
+  controls = [];
+  clearIsolated();
+  for (const [id, job] of pending) {
+    if (!job.sent) continue;
+    job.sent = false;
+    if (++job.attempts < MAX_ATTEMPTS) {
+      suspects.push(id);
+      continue;
+    }
+    pending.delete(id);
+    job.settle({ id, error: 'worker_crashed' });
+  }
+  if (stopped) return;
+
+  crashes += 1;
+  console.warn(`[media-worker] exited with code ${code} (${crashes} so far)`);
+  if (Date.now() - startedAt > STABLE_UPTIME_MS) restartDelay = RESTART_DELAY_MS;
+  restartTimer = setTimeout(() => {
+    restartTimer = null;
+    if (pending.size) scheduleFlush();
+  }, restartDelay);
+  restartDelay = Math.min(restartDelay * 2, MAX_RESTART_DELAY_MS);
+};
+
+const clearIsolated = () => {
+  isolated = null;
+  if (isolatedTimer) clearTimeout(isolatedTimer);
+  isolatedTimer = null;
+};
+
+const expireIsolated = (id: number) => {
+  isolatedTimer = null;
+  if (isolated !== id) return;
+  const job = pending.get(id);
+  pending.delete(id);
+  clearIsolated();
+  job?.settle({ id, error: 'timeout' });
+  console.warn(`[media-worker] resent job ${id} timed out; restarting`);
+  worker?.kill();
+};
+
+const scheduleFlush = () => {
+  if (flushScheduled) return;
+  flushScheduled = true;
+  setImmediate(flush);
+};
+
+// Everything queued since the last flush goes out as one message, except
+// while crash suspects are being resent one by one.
+const flush = () => {
+  flushScheduled = false;
+  if (stopped || restartTimer) return;
+  if (!worker) spawnWorker();
+  if (!ready) return;
+
+  const requests: MediaWorkerRequest[] = controls;
+  controls = [];
+  while (suspects.length && !pending.has(suspects[0])) suspects.shift();
+  if (suspects.length || isolated !== null) {
+    if (isolated === null) {
+      const id = suspects.shift()!;
+      const job = pending.get(id)!;
+      job.sent = true;
+      requests.push(job.request);
+      isolated = id;
+      isolatedTimer = setTimeout(() => expireIsolated(id), ISOLATED_TIMEOUT_MS);
+    }
+  } else {
+    for (const job of pending.values()) {
+      if (job.sent) continue;
+      job.sent = true;
+      requests.push(job.request);
+    }
+  }
+  if (requests.length) worker!.postMessage({ requests });
+};
+
+const submit = (request: NewJob) =>
+  new Promise<MediaWorkerReply>((settle) => {
+    if (stopped) {
+      settle({ id: 0, error: 'worker_stopped' });
+      return;
+    }
+    const id = nextId++;
+    pending.set(id, { request: { ...request, id } as JobRequest, sent: false, attempts: 0, settle });
+    scheduleFlush();
+  });
+
+const failure = (reply: MediaWorkerReply) => ('error' in reply ? reply.error : null);
+
+// Resolves null when the addon or libmpv is unavailable in the worker;
+// rejects with the extractor's error code otherwise.
+export const submitThumbnailJob = async (key: string, filePath: string, options: ThumbnailJobOptions) => {
+  const reply = await submit({ op: 'thumbnail', key, path: filePath, options });
+  const error = failure(reply);
+  if (error === 'addon_missing') return null;
+  if (error || !('frame' in reply)) throw new Error(error ?? 'invalid_reply');
+  return reply.frame;
+};
+
+export const probeInWorker = async (paths: string[], timeoutMs: number) => {
+  const reply = await submit({ op: 'probe', paths, timeoutMs });
+  const error = failure(reply);
+  if (error === 'addon_missing') return null;
+  if (error || !('records' in reply)) throw new Error(error ?? 'invalid_reply');
+  return reply.records;
+};
+
+export const readKeyframesInWorker = async (filePath: string) => {
+  const reply = await submit({ op: 'keyframes', path: filePath });
+  const error = failure(reply);
+  if (error === 'addon_missing') return null;
+  if (error || !('keyframes' in reply)) throw new Error(error ?? 'invalid_reply');
+  return reply.keyframes;
+};
+
+const thumbnailJobs = (key: string) =>
+  [...pending.entries()].filter(([, job]) => job.request.op === 'thumbnail' && job.request.key === key);
+
+// A job that has not reached the worker yet is settled here; otherwise the
+// cancel is forwarded and the worker replies `cancelled`.
+export const cancelThumbnailJob = (key: string) => {
+  const jobs = thumbnailJobs(key);
+  for (const [id, job] of jobs) {
+    if (job.sent) continue;
+    pending.delete(id);
+    job.settle({ id, error: 'cancelled' });
+  }
+  if (jobs.some(([, job]) => job.sent)) {
+    controls.push({ op: 'cancel', key });
+    scheduleFlush();
+  }
+  return jobs.length > 0;
+};
+
+export const setThumbnailJobPriority = (key: string, priority: ThumbnailPriority) => {
+  if (!PRIORITIES.includes(priority)) throw new Error('invalid_priority');
+  const jobs = thumbnailJobs(key);
+  for (const [, job] of jobs) {
+    if (job.request.op === 'thumbnail') job.request.options = { ...job.request.options, priority };
+  }
+  if (jobs.some(([, job]) => job.sent)) {
+    controls.push({ op: 'priority', key, priority });
+    scheduleFlush();
+  }
+  return jobs.length > 0;
+};
+
+app.on('will-quit', () => {
+  stopped = true;
+  if (restartTimer) clearTimeout(restartTimer);
+  restartTimer = null;
+  for (const [id, job] of pending) job.settle({ id, error: 'worker_stopped' });
+  pending.clear();
+  suspects = [];
+  clearIsolated();
+  worker?.kill();
+  worker = null;
+});
@@ -0,0 +1,46 @@
+import { probeInWorker } from './mediaHost.js';
+
+export type MediaInfo = {
+  path: string;
+  duration?: number;
+  width?: number;
+  height?: number;
+  fps?: number;
+  rotation?: number;
+  videoCodec?: string;
+  audioCodec?: string;
+  container?: string;
+  videoTracks?: number;
+  audioTracks?: number;
+  subtitleTracks?: number;
+  error?: string;
+};
+
+const PROBE_TIMEOUT_MS = 5000;
+
+// A batch that keeps crashing the media worker is halved until the file
+// responsible is alone; that one reports `worker_crashed` as its error.
+const probeBatch = async (paths: string[]): Promise<MediaInfo[] | null> => {
+  try {
+    return await probeInWorker(paths, PROBE_TIMEOUT_MS);
+  } catch (err) {
+    if (!(err instanceof Error) || err.message !== 'worker_crashed') throw err;
+    if (paths.length === 1) return [{ path: paths[0], error: 'worker_crashed' }];
+    const half = Math.ceil(paths.length / 2);
+    const head = await probeBatch(paths.slice(0, half));
+    const tail = head && (await probeBatch(paths.slice(half)));
+    return head && tail ? head.concat(tail) : null;
+  }
+};
+
+// Reads duration, size and codecs from the container headers only, in
+// parallel across the addon's threads in the media worker. Rotated videos
+// report their display size. Returns null when the addon is unavailable.
+export const probeMedia = async (paths: string[]): Promise<MediaInfo[] | null> => {
+  const records = await probeBatch(paths);
+  if (!records) return null;
+  return records.map((record) => {
+    if (record.error || !record.rotation || record.rotation % 180 === 0) return record;
+    return { ...record, width: record.height, height: record.width };
+  });
+};
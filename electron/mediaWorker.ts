@@ -0,0 +1,120 @@
+import type { MediaWorkerBatch, MediaWorkerReply, MediaWorkerRequest, ThumbnailJobOptions, WorkerFrame } from './mediaHost.js';
+import type { MediaInfo } from './mediaProber.js';
+import type { ThumbnailPriority } from './thumbnailer.js';
+import { loadNativeAddon } from './nativeAddon.js';
+
+// Utility-process entry started by mediaHost.ts. It owns everything that
+// parses or decodes media files, so a crash on a bad file ends here.
+
+type NativeThumbnailScheduler = {
+  submit: (key: string, filePath: string, options?: ThumbnailJobOptions) => Promise<WorkerFrame>;
+  cancel: (key: string) => boolean;
+  setPriority: (key: string, priority: ThumbnailPriority) => boolean;
+};
+
+type NativeMediaProber = {
+  probe: (paths: string[], options?: { timeoutMs?: number }) => Promise<MediaInfo[]>;
+};
+
+type WorkerAddon = {
+  ThumbnailScheduler?: new (options?: { threads?: number; hwdec?: string }) => NativeThumbnailScheduler;
+  MediaProber?: new (options?: { threads?: number }) => NativeMediaProber;
+  readKeyframes?: (filePath: string) => Promise<Float64Array>;
+};
+
+let scheduler: NativeThumbnailScheduler | null | undefined;
+let prober: NativeMediaProber | null | undefined;
+
+// One scheduler per process; its worker threads each own a warm mpv instance.
+const getScheduler = () => {
+  if (scheduler !== undefined) return scheduler;
+  const addon = loadNativeAddon<WorkerAddon>({ libmpv: true });
+  try {
+    scheduler = addon?.ThumbnailScheduler ? new addon.ThumbnailScheduler() : null;
+  } catch (err) {
+    console.warn('[media-worker] scheduler unavailable:', err instanceof Error ? err.message : err);
+    scheduler = null;
+  }
+  return scheduler;
+};
+
+const getProber = () => {
+  if (prober !== undefined) return prober;
+  const addon = loadNativeAddon<WorkerAddon>({ libmpv: true });
+  try {
+    prober = addon?.MediaProber ? new addon.MediaProber() : null;
+  } catch (err) {
+    console.warn('[media-worker] prober unavailable:', err instanceof Error ? err.message : err);
+    prober = null;
+  }
+  return prober;
+};
+
+const port = process.parentPort;
+
+let replies: MediaWorkerReply[] = [];
+let flushScheduled = false;
+
+// Replies finishing in the same tick share one message.
+const reply = (message: MediaWorkerReply) => {
+  replies.push(message);
+  if (flushScheduled) return;
+  flushScheduled = true;
+  setImmediate(() => {
+    flushScheduled = false;
+    const batch = replies;
+    replies = [];
+    port.postMessage({ replies: batch });
+  });
+};
+
+const errorCode = (err: unknown) => (err instanceof Error ? err.message : String(err));
+
+const run = async (request: MediaWorkerRequest) => {
+  switch (request.op) {
+    case 'cancel':
+      scheduler?.cancel(request.key);
+      return;
+    case 'priority':
+      try {
+        scheduler?.setPriority(request.key, request.priority);
+      } catch {
+        // The host validates priorities; an unknown key is not an error.
+      }
+      return;
+    case 'thumbnail': {
+      const active = getScheduler();
+      if (!active) return reply({ id: request.id, error: 'addon_missing' });
+      try {
+        reply({ id: request.id, frame: await active.submit(request.key, request.path, request.options) });
+      } catch (err) {
+        reply({ id: request.id, error: errorCode(err) });
+      }
+      return;
+    }
+    case 'probe': {
+      const active = getProber();
+      if (!active) return reply({ id: request.id, error: 'addon_missing' });
+      try {
+        reply({ id: request.id, records: await active.probe(request.paths, { timeoutMs: request.timeoutMs }) });
+      } catch (err) {
+        reply({ id: request.id, error: errorCode(err) });
+      }
+      return;
+    }
+    case 'keyframes': {
+      const addon = loadNativeAddon<WorkerAddon>();
+      if (!addon?.readKeyframes) return reply({ id: request.id, error: 'addon_missing' });
+      try {
+        reply({ id: request.id, keyframes: await addon.readKeyframes(request.path) });
+      } catch (err) {
+        reply({ id: request.id, error: errorCode(err) });
+      }
+      return;
+    }
+  }
+};
+
+port.on('message', (event: { data: MediaWorkerBatch }) => {
+  for (const request of event.data.requests ?? []) void run(request);
+});
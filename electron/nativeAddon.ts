@@ -0,0 +1,62 @@
+import { createRequire } from 'module';
+import * as fs from 'fs';
+import * as path from 'path';
+
+const nodeRequire = createRequire(import.meta.url);
+
+// The media worker also gets the resources path through the environment, in
+// case its utility process does not set process.resourcesPath.
+const resourcesPath = process.resourcesPath || process.env.VHUB_RESOURCES_PATH || '';
+
+const resolveAddonPath = () => {
+  const candidates = [
+    path.join(process.cwd(), 'native', 'mpv', 'build', 'Release', 'mpvaddon.node'),
+    path.join(resourcesPath, 'mpv', 'mpvaddon.node')
+  ];
+
+  return candidates.find(candidate => fs.existsSync(candidate));
+};
+
+const resolveLibmpvPath = () => {
+  const candidates = [
+    process.env.LIBMPV_PATH,
+    path.join(process.cwd(), 'libmpv', 'win', 'libmpv-2.dll'),
+    path.join(process.cwd(), 'libmpv', 'win', 'mpv-2.dll'),
+    path.join(process.cwd(), 'libmpv', 'mac', 'libmpv.2.dylib'),
+    path.join(process.cwd(), 'libmpv', 'mac', 'libmpv.dylib'),
+    path.join(resourcesPath, 'libmpv', 'libmpv-2.dll'),
+    path.join(resourcesPath, 'libmpv', 'mpv-2.dll'),
+    path.join(resourcesPath, 'Frameworks', 'libmpv.2.dylib'),
+    path.join(resourcesPath, 'Frameworks', 'libmpv.dylib')
+  ].filter(Boolean) as string[];
+
+  return candidates.find(candidate => fs.existsSync(candidate));
+};
+
+let addon: { init: (libPath?: string) => boolean } | null | undefined;
+let libmpvTried = false;
+
+// The addon is shared by every feature of a process. The thumbnail cache,
+// directory scanner and keyframe reader work without libmpv; only extraction
+// and probing, which run in the media worker, ask for it with
+// `{ libmpv: true }`, so the main process never loads it.
+export const loadNativeAddon = <T>(options: { libmpv?: boolean } = {}) => {
+  if (addon === undefined) {
+    try {
+      const addonPath = resolveAddonPath();
+      addon = addonPath ? nodeRequire(addonPath) : null;
+    } catch (err) {
+      console.warn('[addon] addon unavailable:', err instanceof Error ? err.message : err);
+      addon = null;
+    }
+  }
+  if (options.libmpv && addon && !libmpvTried) {
+    libmpvTried = true;
+    try {
+      addon.init(resolveLibmpvPath());
+    } catch (err) {
+      console.warn('[addon] libmpv unavailable:', err instanceof Error ? err.message : err);
+    }
+  }
+  return addon as T | null;
+};
@@ -3,14 +3,150 @@ import * as path from 'path';
 import * as fs from 'fs';
 import { createRequire } from 'module';
 
+type HwdecPolicy = 'auto' | 'auto-copy' | 'd3d11va' | 'videotoolbox' | 'vaapi' | 'nvdec' | 'off';
+type ThumbnailPriority = 'visible' | 'near' | 'background';
+type FrameFormat = 'rgba' | 'bgra' | 'i420';
+type CacheProfile = 'local' | 'network' | 'low-memory';
+type DecodeProfile = 'full' | 'preview';
+// Property values; type 'node' reads yield objects and arrays.
+type MpvValue = string | number | boolean | null | MpvValue[] | { [key: string]: MpvValue };
+type FrameTiming = { displayInterval: number; presented: number; held: number; late: number; dropped: number };
+type LatencySummary = { count: number; mean: number; p50: number; p90: number; p99: number; max: number };
+type MpvStats = {
+  render: LatencySummary;
+  convert: LatencySummary;
+  copy: LatencySummary;
+  getProperty: LatencySummary;
+  command: LatencySummary;
+  frames: {
+    rendered: number;
+    presented: number;
+    held: number;
+    late: number;
+    dropped: number;
+    mpvDropped: number | null;
+    mpvDelayed: number | null;
+  };
+  buffers: { allocations: number; allocatedBytes: number; poolHits: number };
+  displayInterval: number;
+};
+// Bytes held by the addon in this process; `trims`/`releasedBytes` are totals.
+type MpvMemoryUsage = {
+  budget: number;
+  total: number;
+  frames: number;
+  framePool: number;
+  renderBuffers: number;
+  demuxerCache: number;
+  thumbnailIndex: number;
+  players: number;
+  idlePlayers: number;
+  trims: number;
+  releasedBytes: number;
+};
+type MpvTrimResult = { released: number; steps: number; withinBudget: boolean };
+
+type LibraryFile = { path: string; url: string; name: string; size: number; lastModified: number };
+type LibraryDelta = { added: LibraryFile[]; changed: LibraryFile[]; removed: string[] };
+
+type MpvPlayerOptions = {
+  gpu?: boolean;
+  hwdec?: HwdecPolicy;
+  format?: FrameFormat;
+  fitToVideo?: boolean;
+  cacheProfile?: CacheProfile;
+  decodeProfile?: DecodeProfile;
+};
+
+// Methods shared by a Player instance and the module-level default player.
+type MpvFrameSource = {
+  renderFrameShared: (width: number, height: number, force?: boolean) => ArrayBuffer | null;
+  startRenderThread: (width: number, height: number) => boolean;
+  resizeRenderThread: (width: number, height: number) => boolean;
+  acquireFrame: () => ArrayBuffer | null;
+  setFrameFormat: (format: FrameFormat) => boolean;
+  getFrameSize: () => { width: number; height: number } | null;
+  hasNewFrame: () => boolean;
+  reportSwap: () => boolean;
+  getFrameTiming: () => FrameTiming;
+};
+
+type MpvPropertyChange = { id: number; name: string; value: MpvValue };
+
+type MpvPlayer = MpvFrameSource & {
+  loadFile: (filePath: string) => boolean;
+  stop: () => boolean;
+  command: (args: string[]) => boolean;
+  commandBatch: (commands: string[][]) => boolean[];
+  setProperties: (values: Record<string, MpvValue>) => Record<string, boolean>;
+  getProperty: (name: string, type: string) => MpvValue;
+  setFrameCallback: (callback: (() => void) | null) => boolean;
+  observeProperty: (name: string, type: string) => number;
+  unobserveProperty: (id: number) => boolean;
+  setPropertyCallback: (callback: ((changes: MpvPropertyChange[]) => void) | null) => boolean;
+  loadFileAsync: (filePath: string) => Promise<boolean>;
+  commandAsync: (args: string[]) => Promise<boolean>;
+  getPropertyAsync: (name: string, type: string) => Promise<MpvValue>;
+  setPropertyAsync: (name: string, value: string) => Promise<boolean>;
+  getRenderApi: () => 'opengl' | 'sw' | null;
+  setCacheProfile: (profile: CacheProfile) => boolean;
+  getCacheProfile: () => CacheProfile;
+  setDecodeProfile: (profile: DecodeProfile) => boolean;
+  destroy: () => boolean;
+};
+
+type MpvPlayerPool = {
+  acquire: (key: string) => { player: MpvPlayer; reclaimed: string | null } | null;
+  release: (key: string) => boolean;
+  stats: () => { size: number; leased: number; hits: number; reclaims: number };
+  destroy: () => boolean;
+};
+
 type MpvAddon = {
+  Player: new (options?: MpvPlayerOptions) => MpvPlayer;
+  PlayerPool: new (options?: MpvPlayerOptions & { size?: number }) => MpvPlayerPool;
   init: (libPath?: string) => boolean;
-  createPlayer: () => boolean;
+  initAsync: (libPaths?: string | string[]) => Promise<string>;
+  createPlayer: (options?: MpvPlayerOptions) => boolean;
+  setHwdec: (policy: HwdecPolicy) => boolean;
+  getDecoder: () => { policy: HwdecPolicy; hwdec: string; current: string | null; profile: DecodeProfile };
+  setCacheProfile: (profile: CacheProfile) => boolean;
+  getCacheProfile: () => CacheProfile;
+  setDecodeProfile: (profile: DecodeProfile) => boolean;
+  getRenderApi: () => 'opengl' | 'sw' | null;
   loadFile: (filePath: string) => boolean;
+  preloadFile: (filePath: string, options?: { cacheProfile?: CacheProfile }) => boolean;
+  cancelPreload: (release?: boolean) => boolean;
   stop: () => boolean;
   command: (args: string[]) => boolean;
-  getProperty: (name: string, type: string) => string | number | boolean | null;
-  renderFrame: (width: number, height: number) => Uint8Array;
+  commandBatch: (commands: string[][]) => boolean[];
+  setProperties: (values: Record<string, MpvValue>) => Record<string, boolean>;
+  getProperty: (name: string, type: string) => MpvValue;
+  renderFrame: (width: number, height: number, force?: boolean) => Uint8Array | null;
+  renderFrameShared: (width: number, height: number, force?: boolean) => ArrayBuffer | null;
+  hasNewFrame: () => boolean;
+  setFrameCallback: (callback: (() => void) | null) => boolean;
+  observeProperty: (name: string, type: string) => number;
+  unobserveProperty: (id: number) => boolean;
+  setPropertyCallback: (callback: ((changes: MpvPropertyChange[]) => void) | null) => boolean;
+  loadFileAsync: (filePath: string) => Promise<boolean>;
+  commandAsync: (args: string[]) => Promise<boolean>;
+  getPropertyAsync: (name: string, type: string) => Promise<MpvValue>;
+  setPropertyAsync: (name: string, value: string) => Promise<boolean>;
+  startRenderThread: (width: number, height: number) => boolean;
+  resizeRenderThread: (width: number, height: number) => boolean;
+  acquireFrame: () => ArrayBuffer | null;
+  stopRenderThread: () => boolean;
+  setFrameFormat: (format: FrameFormat) => boolean;
+  getFrameSize: () => { width: number; height: number } | null;
+  reportSwap: () => boolean;
+  getFrameTiming: () => FrameTiming;
+  getStats: () => MpvStats;
+  resetStats: () => boolean;
+  setStatsCallback: (callback: ((stats: MpvStats) => void) | null, intervalMs?: number) => boolean;
+  setMemoryBudget: (bytes: number) => MpvTrimResult;
+  getMemoryUsage: () => MpvMemoryUsage;
+  trimMemory: () => MpvTrimResult;
   destroy: () => boolean;
 };
 
@@ -52,6 +188,174 @@ const resolveLibmpvPath = () => {
   return candidates.find(candidate => fs.existsSync(candidate));
 };
 
+// ImageData views over the addon's frame ring. The ring buffers are long-lived
+// (and may be larger than the frame, since they are pooled by size class), so
+// each one is wrapped once and then drawn without any per-frame copy.
+const frameImages = new WeakMap<ArrayBuffer, ImageData>();
+
+const getFrameImage = (buffer: ArrayBuffer, width: number, height: number) => {
+  let image = frameImages.get(buffer);
+  if (!image || image.width !== width || image.height !== height) {
+    image = new ImageData(new Uint8ClampedArray(buffer, 0, width * height * 4), width, height);
+    frameImages.set(buffer, image);
+  }
+  return image;
+};
+
+// Size the native render thread is currently producing, or null when frames
+// are rendered synchronously on this thread, and the layout the addon writes.
+type RenderThreadState = {
+  renderThreadSize: { width: number; height: number } | null;
+  frameFormat?: FrameFormat;
+};
+
+const mainRenderState: RenderThreadState = { renderThreadSize: null };
+
+// RGBA draws through the ImageData cached over the frame ring, with no copy
+// per frame. BGRA and I420 are opt-in (`format`): a VideoFrame built from a
+// buffer copies it, which costs more than the swizzle it saves.
+const DEFAULT_FRAME_FORMAT: FrameFormat = 'rgba';
+const VIDEO_FRAME_FORMATS = { bgra: 'BGRX', i420: 'I420' } as const;
+
+const applyFrameFormat = (source: MpvFrameSource, state: RenderThreadState, format: FrameFormat) => {
+  if (format !== 'rgba' && typeof VideoFrame !== 'function') throw new Error('video_frame_unavailable');
+  source.setFrameFormat(format);
+  state.frameFormat = format;
+};
+
+const frameBytes = (format: FrameFormat, width: number, height: number) => {
+  if (format !== 'i420') return width * height * 4;
+  return width * height + 2 * Math.ceil(width / 2) * Math.ceil(height / 2);
+};
+
+const drawFrame = (ctx: CanvasRenderingContext2D, buffer: ArrayBuffer, format: FrameFormat, width: number, height: number) => {
+  if (format === 'rgba') {
+    ctx.putImageData(getFrameImage(buffer, width, height), 0, 0);
+    return;
+  }
+  const frame = new VideoFrame(new Uint8Array(buffer, 0, frameBytes(format, width, height)), {
+    format: VIDEO_FRAME_FORMATS[format],
+    codedWidth: width,
+    codedHeight: height,
+    timestamp: 0
+  });
+  try {
+    ctx.drawImage(frame, 0, 0);
+  } finally {
+    frame.close();
+  }
+};
+
+const nextFrame = (source: MpvFrameSource, state: RenderThreadState, width: number, height: number) => {
+  try {
+    const size = state.renderThreadSize;
+    if (!size) {
+      source.startRenderThread(width, height);
+    } else if (size.width !== width || size.height !== height) {
+      source.resizeRenderThread(width, height);
+    }
+    state.renderThreadSize = { width, height };
+    return source.acquireFrame();
+  } catch {
+    state.renderThreadSize = null;
+    return source.renderFrameShared(width, height);
+  }
+};
+
+const presentFrame = (source: MpvFrameSource, state: RenderThreadState, canvas: HTMLCanvasElement, width: number, height: number) => {
+  const ctx = canvas.getContext('2d', { willReadFrequently: true });
+  if (!ctx) return { ok: false, error: 'canvas_context_failed' };
+  if (!state.frameFormat) {
+    try {
+      applyFrameFormat(source, state, DEFAULT_FRAME_FORMAT);
+    } catch {
+      state.frameFormat = 'rgba';
+    }
+  }
+  const buffer = nextFrame(source, state, width, height);
+  // A frame that is ready but not yet due is held by the addon until the
+  // vsync nearest its target; the caller should poll again next frame.
+  if (!buffer) return { ok: true, rendered: false, pending: source.hasNewFrame() };
+  // The addon never renders larger than the video; the canvas backing store
+  // follows the frame and CSS scales it up to the requested size.
+  const size = source.getFrameSize() ?? { width, height };
+  if (canvas.width !== size.width) canvas.width = size.width;
+  if (canvas.height !== size.height) canvas.height = size.height;
+  drawFrame(ctx, buffer, state.frameFormat ?? 'rgba', size.width, size.height);
+  // The canvas goes to screen with the next composite; reporting at draw time
+  // keeps mpv's swap count in step with the vsyncs that show frames.
+  source.reportSwap();
+  return { ok: true, rendered: true };
+};
+
+// Additional players (e.g. hover previews), keyed by an id handed to the
+// renderer. Native objects cannot cross the context bridge.
+type PlayerEntry = RenderThreadState & { player: MpvPlayer; leaseKey?: string };
+
+const players = new Map<number, PlayerEntry>();
+let nextPlayerId = 1;
+
+// Warm players for grid hover previews. Leases are keyed by video id and map
+// to an entry in `players`; a reclaimed lease invalidates its id.
+const PREVIEW_POOL_OPTIONS: MpvPlayerOptions = { gpu: false, hwdec: 'auto-copy', cacheProfile: 'low-memory', decodeProfile: 'preview' };
+let previewPool: MpvPlayerPool | null = null;
+const previewLeases = new Map<string, number>();
+
+const ensurePreviewPool = (addon: MpvAddon, size?: number) => {
+  if (!previewPool) {
+    requireLibmpv(addon);
+    previewPool = new addon.PlayerPool({ ...PREVIEW_POOL_OPTIONS, size });
+  }
+  return previewPool;
+};
+
+// The addon is polled against its budget because demuxer caches grow on
+// mpv's own threads. Listeners (the renderer's thumbnail cache) hear about
+// every trim that had to evict something.
+const DEFAULT_MEMORY_BUDGET = 768 * 1024 * 1024;
+const MEMORY_TRIM_INTERVAL = 2000;
+const memoryPressureListeners = new Set<(usage: MpvMemoryUsage) => void>();
+let memoryBudget: number | null = null;
+let memoryTrimTimer: ReturnType<typeof setInterval> | null = null;
+
+const reportTrim = (addon: MpvAddon, result: MpvTrimResult) => {
+  if (result.steps === 0) return;
+  const usage = addon.getMemoryUsage();
+  memoryPressureListeners.forEach(listener => listener(usage));
+};
+
+const applyMemoryBudget = (addon: MpvAddon, bytes: number) => {
+  memoryBudget = bytes;
+  reportTrim(addon, addon.setMemoryBudget(bytes));
+  if (memoryTrimTimer) clearInterval(memoryTrimTimer);
+  memoryTrimTimer = bytes > 0 ? setInterval(() => reportTrim(addon, addon.trimMemory()), MEMORY_TRIM_INTERVAL) : null;
+};
+
+const dropPreviewLease = (key: string) => {
+  const id = previewLeases.get(key);
+  previewLeases.delete(key);
+  if (id !== undefined) players.delete(id);
+};
+
+// Wraps a promise-returning addon call in the usual { ok, error } shape.
+const settle = async <T>(run: () => Promise<T>) => {
+  try {
+    return { ok: true, value: await run() };
+  } catch (err) {
+    return { ok: false, error: err instanceof Error ? err.message : String(err), value: null };
+  }
+};
+
+const withPlayer = <T extends object>(id: number, fn: (entry: PlayerEntry) => T) => {
+  const entry = players.get(id);
+  if (!entry) return { ok: false, error: 'player_missing' };
+  try {
+    return fn(entry);
+  } catch (err) {
+    return { ok: false, error: err instanceof Error ? err.message : String(err) };
+  }
+};
+
 let mpvAddon: MpvAddon | null = null;
 let mpvAddonPath: string | null = null;
 let mpvAddonError: string | null = null;
@@ -65,6 +369,57 @@ try {
   mpvAddon = null;
 }
 
+// libmpv is loaded on the libuv thread pool as soon as the preload runs, so
+// the window paints while the library is mapped and scanned. The path that
+// loaded is remembered and tried first on the next launch.
+const LIBMPV_PATH_STORAGE_KEY = 'vhub-libmpv-path';
+let libmpvLoad: Promise<string> | null = null;
+let libmpvPath: string | null = null;
+let libmpvError: string | null = null;
+
+const readStoredLibmpvPath = () => {
+  try {
+    return window.localStorage.getItem(LIBMPV_PATH_STORAGE_KEY);
+  } catch {
+    return null;
+  }
+};
+
+const loadLibmpv = (addon: MpvAddon) => {
+  if (!libmpvLoad) {
+    const candidates = [process.env.LIBMPV_PATH, readStoredLibmpvPath(), resolveLibmpvPath()]
+      .filter((candidate, index, all): candidate is string => Boolean(candidate) && all.indexOf(candidate) === index);
+    libmpvError = null;
+    libmpvLoad = addon.initAsync(candidates).then(loaded => {
+      libmpvPath = loaded;
+      try {
+        window.localStorage.setItem(LIBMPV_PATH_STORAGE_KEY, loaded);
+      } catch {
+        // Storage is unavailable; the next launch probes again.
+      }
+      return loaded;
+    });
+    // A failed load may be retried by the next mpvInitAsync call.
+    libmpvLoad.catch((err: unknown) => {
+      libmpvLoad = null;
+      libmpvError = err instanceof Error ? err.message : String(err);
+    });
+  }
+  return libmpvLoad;
+};
+
+// Synchronous entry points never load libmpv on the renderer thread; they
+// fail with `libmpv_loading` until the background load has finished, or with
+// its error if it failed.
+const requireLibmpv = (addon: MpvAddon) => {
+  if (libmpvPath) return;
+  if (libmpvError) throw new Error(libmpvError);
+  void loadLibmpv(addon).catch(() => {});
+  throw new Error('libmpv_loading');
+};
+
+if (mpvAddon) loadLibmpv(mpvAddon);
+
 try {
   // Expose protected methods that allow the renderer process to use
   // the ipcRenderer without exposing the entire object
@@ -77,17 +432,54 @@ try {
       console.log('[preload] openDirectoryFiles', extensions);
       return ipcRenderer.invoke('dialog:openDirectoryFiles', extensions);
     },
-    createThumbnail: (inputPath: string, options?: { outputPath?: string; width?: number; height?: number; quality?: number }) => {
+    onLibraryScanBatch: (callback: (files: LibraryFile[]) => void) => {
+      const listener = (_event: unknown, files: LibraryFile[]) => callback(files);
+      ipcRenderer.on('library:scanBatch', listener);
+      return () => {
+        ipcRenderer.removeListener('library:scanBatch', listener);
+      };
+    },
+    // Pushed by the filesystem watcher after a folder has been opened.
+    onLibraryChanges: (callback: (delta: LibraryDelta) => void) => {
+      const listener = (_event: unknown, delta: LibraryDelta) => callback(delta);
+      ipcRenderer.on('library:changes', listener);
+      return () => {
+        ipcRenderer.removeListener('library:changes', listener);
+      };
+    },
+    rescanLibrary: () => ipcRenderer.invoke('library:rescan'),
+    probeMedia: (paths: string[]) => ipcRenderer.invoke('media:probe', paths),
+    createThumbnail: (inputPath: string, options?: { outputPath?: string; width?: number; height?: number; quality?: number; key?: string; priority?: ThumbnailPriority }) => {
       return ipcRenderer.invoke('ffmpeg:thumbnail', { inputPath, ...(options || {}) });
     },
+    getSeekPreview: (inputPath: string) => ipcRenderer.invoke('thumbnail:sprite', inputPath),
+    getKeyframeIndex: (inputPath: string) => ipcRenderer.invoke('media:keyframes', inputPath),
+    cancelThumbnail: (key: string) => ipcRenderer.invoke('thumbnail:cancel', key),
+    setThumbnailPriority: (key: string, priority: ThumbnailPriority) => ipcRenderer.invoke('thumbnail:priority', key, priority),
     playWithMpv: (filePath: string) => ipcRenderer.invoke('mpv:play', filePath),
-    mpvInit: () => {
+    mpvInit: (options?: MpvPlayerOptions) => {
       if (!mpvAddon) return { ok: false, error: 'addon_missing' };
       try {
-        const libPath = resolveLibmpvPath();
-        mpvAddon.init(libPath);
-        mpvAddon.createPlayer();
-        return { ok: true };
+        requireLibmpv(mpvAddon);
+        mpvAddon.createPlayer(options);
+        if (options?.format) applyFrameFormat(mpvAddon, mainRenderState, options.format);
+        if (memoryBudget === null) applyMemoryBudget(mpvAddon, DEFAULT_MEMORY_BUDGET);
+        return { ok: true, renderApi: mpvAddon.getRenderApi() };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    // mpvInit without blocking: waits for the background libmpv load, then
+    // creates the default player.
+    mpvInitAsync: async (options?: MpvPlayerOptions) => {
+      const addon = mpvAddon;
+      if (!addon) return { ok: false, error: 'addon_missing' };
+      try {
+        await loadLibmpv(addon);
+        addon.createPlayer(options);
+        if (options?.format) applyFrameFormat(addon, mainRenderState, options.format);
+        if (memoryBudget === null) applyMemoryBudget(addon, DEFAULT_MEMORY_BUDGET);
+        return { ok: true, renderApi: addon.getRenderApi() };
       } catch (err) {
         return { ok: false, error: err instanceof Error ? err.message : String(err) };
       }
@@ -101,6 +493,26 @@ try {
         return { ok: false, error: err instanceof Error ? err.message : String(err) };
       }
     },
+    // Opens the likely next video paused on a standby player; mpvLoad or
+    // mpvLoadAsync of the same path then swaps it in without reopening.
+    mpvPreload: (filePath: string, options?: { cacheProfile?: CacheProfile }) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        mpvAddon.preloadFile(filePath, options);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvCancelPreload: (release?: boolean) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        mpvAddon.cancelPreload(release);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
     mpvStop: () => {
       if (!mpvAddon) return { ok: false, error: 'addon_missing' };
       try {
@@ -119,6 +531,23 @@ try {
         return { ok: false, error: err instanceof Error ? err.message : String(err) };
       }
     },
+    // Several commands, or typed property values, in a single addon call.
+    mpvCommandBatch: (commands: string[][]) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing', results: null };
+      try {
+        return { ok: true, results: mpvAddon.commandBatch(commands) };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err), results: null };
+      }
+    },
+    mpvSetProperties: (values: Record<string, MpvValue>) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing', results: null };
+      try {
+        return { ok: true, results: mpvAddon.setProperties(values) };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err), results: null };
+      }
+    },
     mpvGetProperty: (name: string, type: string) => {
       if (!mpvAddon) return { ok: false, error: 'addon_missing', value: null };
       try {
@@ -132,24 +561,310 @@ try {
       if (!mpvAddon) return { ok: false, error: 'addon_missing', frame: null };
       try {
         const frame = mpvAddon.renderFrame(width, height);
-        return { ok: true, frame };
+        const size = frame ? mpvAddon.getFrameSize() : null;
+        return { ok: true, frame, width: size?.width ?? width, height: size?.height ?? height };
       } catch (err) {
         return { ok: false, error: err instanceof Error ? err.message : String(err), frame: null };
       }
     },
+    mpvPresentFrame: (canvas: HTMLCanvasElement, width: number, height: number) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        return presentFrame(mpvAddon, mainRenderState, canvas, width, height);
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvSetFrameFormat: (format: FrameFormat) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        applyFrameFormat(mpvAddon, mainRenderState, format);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvGetFrameTiming: () => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing', timing: null };
+      try {
+        return { ok: true, timing: mpvAddon.getFrameTiming() };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err), timing: null };
+      }
+    },
+    mpvGetStats: () => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing', stats: null };
+      try {
+        return { ok: true, stats: mpvAddon.getStats() };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err), stats: null };
+      }
+    },
+    mpvResetStats: () => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        mpvAddon.resetStats();
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvSetStatsCallback: (callback: ((stats: MpvStats) => void) | null, intervalMs?: number) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        mpvAddon.setStatsCallback(callback, intervalMs);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    // Budget in bytes for this renderer's players and buffers; 0 disables
+    // trimming. Defaults to DEFAULT_MEMORY_BUDGET from mpvInit on.
+    mpvSetMemoryBudget: (bytes: number) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        applyMemoryBudget(mpvAddon, bytes);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvGetMemoryUsage: () => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing', usage: null };
+      try {
+        return { ok: true, usage: mpvAddon.getMemoryUsage() };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err), usage: null };
+      }
+    },
+    mpvTrimMemory: () => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing', result: null };
+      try {
+        const result = mpvAddon.trimMemory();
+        reportTrim(mpvAddon, result);
+        return { ok: true, result };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err), result: null };
+      }
+    },
+    onMemoryPressure: (callback: (usage: MpvMemoryUsage) => void) => {
+      memoryPressureListeners.add(callback);
+      return () => {
+        memoryPressureListeners.delete(callback);
+      };
+    },
+    mpvSetHwdec: (policy: HwdecPolicy) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        mpvAddon.setHwdec(policy);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvSetCacheProfile: (profile: CacheProfile) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        mpvAddon.setCacheProfile(profile);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvSetDecodeProfile: (profile: DecodeProfile) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        mpvAddon.setDecodeProfile(profile);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvGetCacheProfile: () => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing', profile: null };
+      try {
+        return { ok: true, profile: mpvAddon.getCacheProfile() };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err), profile: null };
+      }
+    },
+    mpvGetDecoder: () => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing', decoder: null };
+      try {
+        return { ok: true, decoder: mpvAddon.getDecoder() };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err), decoder: null };
+      }
+    },
+    mpvHasNewFrame: () => {
+      if (!mpvAddon) return false;
+      try {
+        return mpvAddon.hasNewFrame();
+      } catch {
+        return false;
+      }
+    },
+    mpvSetFrameCallback: (callback: (() => void) | null) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        mpvAddon.setFrameCallback(callback);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvObserveProperty: (name: string, type: string) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        return { ok: true, id: mpvAddon.observeProperty(name, type) };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvUnobserveProperty: (id: number) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        mpvAddon.unobserveProperty(id);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvSetPropertyCallback: (callback: ((changes: MpvPropertyChange[]) => void) | null) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        mpvAddon.setPropertyCallback(callback);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvLoadAsync: (filePath: string) => {
+      if (!mpvAddon) return Promise.resolve({ ok: false, error: 'addon_missing', value: null });
+      const addon = mpvAddon;
+      return settle(() => addon.loadFileAsync(filePath));
+    },
+    mpvCommandAsync: (args: string[]) => {
+      if (!mpvAddon) return Promise.resolve({ ok: false, error: 'addon_missing', value: null });
+      const addon = mpvAddon;
+      return settle(() => addon.commandAsync(args));
+    },
+    mpvGetPropertyAsync: (name: string, type: string) => {
+      if (!mpvAddon) return Promise.resolve({ ok: false, error: 'addon_missing', value: null });
+      const addon = mpvAddon;
+      return settle(() => addon.getPropertyAsync(name, type));
+    },
+    mpvSetPropertyAsync: (name: string, value: string) => {
+      if (!mpvAddon) return Promise.resolve({ ok: false, error: 'addon_missing', value: null });
+      const addon = mpvAddon;
+      return settle(() => addon.setPropertyAsync(name, value));
+    },
     mpvDestroy: () => {
       if (!mpvAddon) return { ok: false, error: 'addon_missing' };
       try {
+        mainRenderState.renderThreadSize = null;
+        mainRenderState.frameFormat = undefined;
         mpvAddon.destroy();
         return { ok: true };
       } catch (err) {
         return { ok: false, error: err instanceof Error ? err.message : String(err) };
       }
     },
+    mpvPlayerCreate: (options?: MpvPlayerOptions) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        requireLibmpv(mpvAddon);
+        const id = nextPlayerId++;
+        players.set(id, { player: new mpvAddon.Player(options), renderThreadSize: null, frameFormat: options?.format });
+        return { ok: true, id };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvPlayerLoad: (id: number, filePath: string) => withPlayer(id, ({ player }) => {
+      player.loadFile(filePath);
+      return { ok: true };
+    }),
+    mpvPlayerLoadAsync: (id: number, filePath: string) => {
+      const entry = players.get(id);
+      if (!entry) return Promise.resolve({ ok: false, error: 'player_missing', value: null });
+      return settle(() => entry.player.loadFileAsync(filePath));
+    },
+    mpvPlayerCommand: (id: number, args: string[]) => withPlayer(id, ({ player }) => {
+      player.command(args);
+      return { ok: true };
+    }),
+    mpvPlayerCommandBatch: (id: number, commands: string[][]) => withPlayer(id, ({ player }) => {
+      return { ok: true, results: player.commandBatch(commands) };
+    }),
+    mpvPlayerSetProperties: (id: number, values: Record<string, MpvValue>) => withPlayer(id, ({ player }) => {
+      return { ok: true, results: player.setProperties(values) };
+    }),
+    mpvPlayerGetProperty: (id: number, name: string, type: string) => withPlayer(id, ({ player }) => {
+      return { ok: true, value: player.getProperty(name, type) };
+    }),
+    mpvPlayerPresent: (id: number, canvas: HTMLCanvasElement, width: number, height: number) => withPlayer(id, entry => {
+      return presentFrame(entry.player, entry, canvas, width, height);
+    }),
+    mpvPlayerSetFrameCallback: (id: number, callback: (() => void) | null) => withPlayer(id, ({ player }) => {
+      player.setFrameCallback(callback);
+      return { ok: true };
+    }),
+    mpvPlayerDestroy: (id: number) => withPlayer(id, ({ player, leaseKey }) => {
+      if (leaseKey !== undefined) {
+        dropPreviewLease(leaseKey);
+        previewPool?.release(leaseKey);
+        return { ok: true };
+      }
+      players.delete(id);
+      player.destroy();
+      return { ok: true };
+    }),
+    // Waits for the background libmpv load before building the pool.
+    mpvPreviewWarm: async (size?: number) => {
+      const addon = mpvAddon;
+      if (!addon) return { ok: false, error: 'addon_missing' };
+      try {
+        await loadLibmpv(addon);
+        ensurePreviewPool(addon, size);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvPreviewAcquire: (key: string) => {
+      if (!mpvAddon) return { ok: false, error: 'addon_missing' };
+      try {
+        const existing = previewLeases.get(key);
+        const lease = ensurePreviewPool(mpvAddon).acquire(key);
+        if (!lease) return { ok: false, error: 'pool_exhausted' };
+        if (lease.reclaimed !== null) dropPreviewLease(lease.reclaimed);
+        if (existing !== undefined && players.has(existing)) return { ok: true, id: existing };
+        const id = nextPlayerId++;
+        players.set(id, { player: lease.player, renderThreadSize: null, leaseKey: key });
+        previewLeases.set(key, id);
+        return { ok: true, id };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
+    mpvPreviewRelease: (key: string) => {
+      if (!previewPool) return { ok: true };
+      try {
+        dropPreviewLease(key);
+        previewPool.release(key);
+        return { ok: true };
+      } catch (err) {
+        return { ok: false, error: err instanceof Error ? err.message : String(err) };
+      }
+    },
     mpvDebug: () => ({
       addonPath: mpvAddonPath,
       addonError: mpvAddonError,
-      libPath: resolveLibmpvPath()
+      libPath: libmpvPath ?? resolveLibmpvPath(),
+      renderApi: mpvAddon ? mpvAddon.getRenderApi() : null,
+      players: players.size,
+      previewPool: previewPool ? previewPool.stats() : null
     }),
     // 可以在这里添加更多的 API
   });
@@ -0,0 +1,339 @@
+import { app, nativeImage } from 'electron';
+import * as fs from 'fs';
+import * as path from 'path';
+import type { ThumbnailOptions, ThumbnailResult } from './ffmpeg.js';
+import {
+  cancelThumbnailJob,
+  readKeyframesInWorker,
+  setThumbnailJobPriority,
+  submitThumbnailJob,
+  type WorkerFrame
+} from './mediaHost.js';
+import { loadNativeAddon } from './nativeAddon.js';
+
+type CachedThumbnail = {
+  data: Buffer;
+  width: number;
+  height: number;
+  videoWidth: number;
+  videoHeight: number;
+  duration: number;
+  codec: string;
+};
+
+type NativeThumbnailCache = {
+  get: (filePath: string, size: number, mtimeMs: number) => CachedThumbnail | null;
+  find: (filePath: string, size: number, mtimeMs: number) => (Omit<CachedThumbnail, 'data'> & { length: number }) | null;
+  put: (filePath: string, size: number, mtimeMs: number, entry: Partial<CachedThumbnail> & { data: Buffer }) => boolean;
+  remove: (filePath: string) => boolean;
+  compact: () => boolean;
+  stats: () => { entries: number; capacity: number; packBytes: number; liveBytes: number };
+  close: () => boolean;
+};
+
+export type ThumbnailPriority = 'visible' | 'near' | 'background';
+
+type ThumbnailAddon = {
+  ThumbnailCache: new (dir: string) => NativeThumbnailCache;
+};
+
+const JPEG_QUALITY = 85;
+
+// Seek-preview sheets: 100 keyframes, 10 per row, each fitted into 160x90.
+// The layout is part of the cache directory name, so changing it starts a
+// fresh cache instead of misreading old sheets.
+const SPRITE_TILES = 100;
+const SPRITE_COLUMNS = 10;
+const SPRITE_TILE_WIDTH = 160;
+const SPRITE_TILE_HEIGHT = 90;
+const SPRITE_TILE_TIMEOUT_MS = 3000;
+
+// Cached images are served as vhub-thumb://<thumb|sprite>/<size>-<mtimeMs>/<path>
+// so the renderer holds a short URL and Chromium decodes and caches the
+// bytes, instead of every thumbnail living on as a base64 string. The stamp
+// makes each URL immutable: an edited file gets a new one.
+export const THUMBNAIL_SCHEME = 'vhub-thumb';
+
+const loadAddon = () => loadNativeAddon<ThumbnailAddon>();
+
+const caches = new Map<string, NativeThumbnailCache | null>();
+
+const openCache = (name: string) => {
+  if (caches.has(name)) return caches.get(name)!;
+  const loaded = loadAddon();
+  let opened: NativeThumbnailCache | null = null;
+  try {
+    const dir = path.join(app.getPath('userData'), name);
+    fs.mkdirSync(dir, { recursive: true });
+    opened = loaded ? new loaded.ThumbnailCache(dir) : null;
+  } catch (err) {
+    console.warn(`[thumbnailer] ${name} unavailable:`, err instanceof Error ? err.message : err);
+  }
+  caches.set(name, opened);
+  return opened;
+};
+
+const getCache = () => openCache('thumbnail-cache');
+const getSpriteCache = () => openCache(`sprite-cache-${SPRITE_TILES}x${SPRITE_COLUMNS}`);
+// Keyframe indexes, stored as raw float64 seconds.
+const getKeyframeCache = () => openCache('keyframe-cache');
+
+export type ThumbnailStamp = { size: number; mtimeMs: number };
+
+type CacheKind = 'thumb' | 'sprite';
+
+const cacheFor = (kind: CacheKind) => (kind === 'sprite' ? getSpriteCache() : getCache());
+
+const cacheUrl = (kind: CacheKind, inputPath: string, stamp: ThumbnailStamp) =>
+  `${THUMBNAIL_SCHEME}://${kind}/${stamp.size}-${stamp.mtimeMs}/${encodeURIComponent(inputPath)}`;
+
+const imageType = (data: Buffer) => {
+  if (data[0] === 0xff && data[1] === 0xd8) return 'image/jpeg';
+  if (data[0] === 0x89 && data.toString('latin1', 1, 4) === 'PNG') return 'image/png';
+  if (data.toString('latin1', 0, 4) === 'RIFF' && data.toString('latin1', 8, 12) === 'WEBP') return 'image/webp';
+  return 'application/octet-stream';
+};
+
+// Only used when an image could not be cached, e.g. the file vanished.
+const inlineUrl = (data: Buffer) => `data:${imageType(data)};base64,${data.toString('base64')}`;
+
+// protocol.handle() callback for THUMBNAIL_SCHEME.
+export const serveCachedImage = (request: Request) => {
+  const url = new URL(request.url);
+  const kind: CacheKind | null = url.hostname === 'sprite' ? 'sprite' : url.hostname === 'thumb' ? 'thumb' : null;
+  const [, stampPart = '', encodedPath = ''] = url.pathname.split('/');
+  const [size, mtimeMs] = stampPart.split('-').map(Number);
+  const entry = kind && encodedPath ? cacheFor(kind)?.get(decodeURIComponent(encodedPath), size, mtimeMs) : null;
+  if (!entry) return new Response(null, { status: 404 });
+  return new Response(entry.data, {
+    headers: { 'content-type': imageType(entry.data), 'cache-control': 'max-age=31536000, immutable' }
+  });
+};
+
+export const statThumbnailSource = async (inputPath: string): Promise<ThumbnailStamp | null> => {
+  try {
+    const stat = await fs.promises.stat(inputPath);
+    return { size: stat.size, mtimeMs: Math.floor(stat.mtimeMs) };
+  } catch {
+    return null;
+  }
+};
+
+// Entries are matched on path, size and mtime, so edited files miss.
+export const readCachedThumbnail = (inputPath: string, stamp: ThumbnailStamp): ThumbnailResult | null => {
+  const entry = getCache()?.find(inputPath, stamp.size, stamp.mtimeMs);
+  if (!entry) return null;
+  return {
+    ok: true,
+    url: cacheUrl('thumb', inputPath, stamp),
+    duration: entry.duration || undefined,
+    width: entry.width,
+    height: entry.height,
+    videoWidth: entry.videoWidth || undefined,
+    videoHeight: entry.videoHeight || undefined,
+    codec: entry.codec || undefined
+  };
+};
+
+const writeCachedThumbnail = (inputPath: string, stamp: ThumbnailStamp, result: ThumbnailResult) => {
+  const active = getCache();
+  if (!active || !result.ok || !result.data) return false;
+  return active.put(inputPath, stamp.size, stamp.mtimeMs, {
+    data: result.data,
+    width: result.width,
+    height: result.height,
+    videoWidth: result.videoWidth,
+    videoHeight: result.videoHeight,
+    duration: result.duration,
+    codec: result.codec
+  });
+};
+
+// Caches a freshly made thumbnail and swaps its bytes for a URL.
+export const publishThumbnail = (inputPath: string, stamp: ThumbnailStamp | null, result: ThumbnailResult): ThumbnailResult => {
+  const { data, ...rest } = result;
+  if (!result.ok || !data) return rest;
+  if (stamp && writeCachedThumbnail(inputPath, stamp, result)) return { ...rest, url: cacheUrl('thumb', inputPath, stamp) };
+  return { ...rest, dataUrl: inlineUrl(data) };
+};
+
+// Drops the index entry only; the bytes are reclaimed by the next compaction.
+// A changed file would miss on its stamp anyway, this just stops it from
+// holding a slot.
+export const forgetCachedThumbnail = (inputPath: string) => {
+  getCache()?.remove(inputPath);
+  getSpriteCache()?.remove(inputPath);
+  getKeyframeCache()?.remove(inputPath);
+};
+
+// The frame arrives from the media worker as a Uint8Array view; nativeImage
+// wants a Buffer over the same bytes.
+const encodeJpeg = (frame: WorkerFrame) => {
+  const pixels = Buffer.from(frame.pixels.buffer, frame.pixels.byteOffset, frame.pixels.byteLength);
+  return nativeImage.createFromBitmap(pixels, { width: frame.width, height: frame.height }).toJPEG(JPEG_QUALITY);
+};
+
+let nextAnonymousKey = 1;
+
+// Extracts a frame with the addon's headless mpv in the media worker instead
+// of spawning ffmpeg. Returns null when the addon is unavailable so callers
+// can fall back; a file that crashed the worker fails with `worker_crashed`.
+export const createNativeThumbnail = async (
+  options: ThumbnailOptions,
+  job: { key?: string; priority?: ThumbnailPriority } = {}
+): Promise<ThumbnailResult | null> => {
+  const { inputPath, outputPath, width, height } = options;
+  if (!inputPath) return { ok: false, error: 'missing_path' };
+
+  const key = job.key || `anonymous:${nextAnonymousKey++}`;
+  try {
+    const frame = await submitThumbnailJob(key, inputPath, { width, height, priority: job.priority });
+    if (!frame) return null;
+    const jpeg = encodeJpeg(frame);
+    if (outputPath) {
+      await fs.promises.mkdir(path.dirname(outputPath), { recursive: true });
+      await fs.promises.writeFile(outputPath, jpeg);
+    }
+    return {
+      ok: true,
+      outputPath,
+      data: jpeg,
+      duration: frame.duration || undefined,
+      width: frame.width,
+      height: frame.height,
+      videoWidth: frame.videoWidth,
+      videoHeight: frame.videoHeight,
+      codec: frame.codec || undefined
+    };
+  } catch (err) {
+    return { ok: false, error: err instanceof Error ? err.message : String(err) };
+  }
+};
+
+export const cancelNativeThumbnail = (key: string) => cancelThumbnailJob(key);
+
+export const setNativeThumbnailPriority = (key: string, priority: ThumbnailPriority) =>
+  setThumbnailJobPriority(key, priority);
+
+export type SeekPreview = {
+  ok: boolean;
+  error?: string;
+  url?: string;
+  dataUrl?: string;
+  tiles?: number;
+  columns?: number;
+  rows?: number;
+  tileWidth?: number;
+  tileHeight?: number;
+  // Seconds between tiles; tile i shows the keyframe near (i + 0.5) * interval.
+  interval?: number;
+  duration?: number;
+};
+
+// The sheet's size and duration are all that is stored; the grid follows
+// from the fixed layout.
+export const readCachedSprite = (inputPath: string, stamp: ThumbnailStamp): SeekPreview | null => {
+  const entry = getSpriteCache()?.find(inputPath, stamp.size, stamp.mtimeMs);
+  if (!entry || !entry.duration) return null;
+  const rows = Math.ceil(SPRITE_TILES / SPRITE_COLUMNS);
+  return {
+    ok: true,
+    url: cacheUrl('sprite', inputPath, stamp),
+    tiles: SPRITE_TILES,
+    columns: SPRITE_COLUMNS,
+    rows,
+    tileWidth: entry.width / SPRITE_COLUMNS,
+    tileHeight: entry.height / rows,
+    interval: entry.duration / SPRITE_TILES,
+    duration: entry.duration
+  };
+};
+
+const writeCachedSprite = (inputPath: string, stamp: ThumbnailStamp, sheet: SeekPreview, jpeg: Buffer) => {
+  const active = getSpriteCache();
+  if (!active || !sheet.ok || !sheet.tileWidth || !sheet.tileHeight) return false;
+  return active.put(inputPath, stamp.size, stamp.mtimeMs, {
+    data: jpeg,
+    width: sheet.tileWidth * SPRITE_COLUMNS,
+    height: sheet.tileHeight * (sheet.rows ?? 1),
+    duration: sheet.duration
+  });
+};
+
+type SpriteBuild = { sheet: SeekPreview; jpeg?: Buffer };
+
+// Like publishThumbnail, for a freshly built sheet.
+export const publishSprite = (inputPath: string, stamp: ThumbnailStamp | null, built: SpriteBuild): SeekPreview => {
+  const { sheet, jpeg } = built;
+  if (!sheet.ok || !jpeg) return sheet;
+  if (stamp && writeCachedSprite(inputPath, stamp, sheet, jpeg)) return { ...sheet, url: cacheUrl('sprite', inputPath, stamp) };
+  return { ...sheet, dataUrl: inlineUrl(jpeg) };
+};
+
+// Reopening a video while its sheet is still being built joins that build.
+const spritesInFlight = new Map<string, Promise<SpriteBuild | null>>();
+
+// Builds a seek-preview sheet at background priority: one load, then a
+// keyframe-only seek per tile. Returns null when the addon is unavailable.
+export const createNativeSprite = async (inputPath: string): Promise<SpriteBuild | null> => {
+  const pending = spritesInFlight.get(inputPath);
+  if (pending) return pending;
+  const build = buildSprite(inputPath).finally(() => spritesInFlight.delete(inputPath));
+  spritesInFlight.set(inputPath, build);
+  return build;
+};
+
+const buildSprite = async (inputPath: string): Promise<SpriteBuild | null> => {
+  try {
+    const frame = await submitThumbnailJob(`sprite:${inputPath}`, inputPath, {
+      tiles: SPRITE_TILES,
+      columns: SPRITE_COLUMNS,
+      width: SPRITE_TILE_WIDTH,
+      height: SPRITE_TILE_HEIGHT,
+      timeoutMs: SPRITE_TILE_TIMEOUT_MS,
+      priority: 'background'
+    });
+    if (!frame) return null;
+    const jpeg = encodeJpeg(frame);
+    return {
+      jpeg,
+      sheet: {
+        ok: true,
+        tiles: frame.tiles,
+        columns: frame.columns,
+        rows: frame.rows,
+        tileWidth: frame.tileWidth,
+        tileHeight: frame.tileHeight,
+        interval: frame.interval,
+        duration: frame.duration
+      }
+    };
+  } catch (err) {
+    return { sheet: { ok: false, error: err instanceof Error ? err.message : String(err) } };
+  }
+};
+
+export type KeyframeIndex = { ok: boolean; error?: string; keyframes?: Float64Array };
+
+// Keyframe times of a file for snapping scrub seeks, read from the container
+// index in the media worker and cached like thumbnails. Files without an
+// index are simply asked again next time; the read is cheap.
+export const loadKeyframeIndex = async (inputPath: string): Promise<KeyframeIndex> => {
+  const stamp = await statThumbnailSource(inputPath);
+  const cached = stamp && getKeyframeCache()?.get(inputPath, stamp.size, stamp.mtimeMs);
+  // Copied out of the Buffer, whose offset need not be 8-byte aligned.
+  if (cached) return { ok: true, keyframes: new Float64Array(new Uint8Array(cached.data).buffer) };
+  try {
+    const keyframes = await readKeyframesInWorker(inputPath);
+    if (!keyframes) return { ok: false, error: 'addon_missing' };
+    if (stamp) {
+      getKeyframeCache()?.put(inputPath, stamp.size, stamp.mtimeMs, {
+        data: Buffer.from(keyframes.buffer, keyframes.byteOffset, keyframes.byteLength),
+        duration: keyframes[keyframes.length - 1]
+      });
+    }
+    return { ok: true, keyframes };
+  } catch (err) {
+    return { ok: false, error: err instanceof Error ? err.message : String(err) };
+  }
+};
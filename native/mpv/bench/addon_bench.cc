@@ -0,0 +1,505 @@
+// Standalone benchmark for the addon's hot paths: SW rendering plus the copy
+// and conversions RenderFrame performs, property polling, thumbnail
+// extraction and directory scanning. It links the same sources as the addon
+// (minus the N-API layer) and loads libmpv through LoadLibraryWithPath.
+//
+//   mpvbench [--libmpv PATH] [--media FILE] [--frames N] [--thumbs N]
+//            [--scan-dir DIR] [--only render,props,thumbs,scan] [--json]
+//
+// Without --media, rendering and polling use lavfi's testsrc2 and the
+// thumbnail pass is skipped; without --scan-dir a synthetic tree is created
+// in the temp directory and removed afterwards.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dir_walker.h"
+#include "frame_extractor.h"
+#include "mpv_api.h"
+#include "path_util.h"
+#include "pixel_kernels.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int64_t ElapsedUs(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+}
+
+struct Options {
+  std::string libmpv;
+  std::string media;
+  std::string scan_dir;
+  std::string only;
+  int frames = 300;
+  int thumbs = 20;
+  bool json = false;
+};
+
+bool Enabled(const Options& options, const char* pass) {
+  if (options.only.empty()) return true;
+  return ("," + options.only + ",").find(std::string(",") + pass + ",") != std::string::npos;
+}
+
+// Exact percentiles over the collected samples; runs are short enough that
+// keeping every sample is cheaper than being clever.
+struct Samples {
+  std::vector<int64_t> us;
+
+  void Add(int64_t value) { us.push_back(value); }
+
+  double Percentile(double q) const {
+    if (us.empty()) return 0.0;
+    std::vector<int64_t> sorted(us);
+    size_t index = std::min(sorted.size() - 1, static_cast<size_t>(q * static_cast<double>(sorted.size())));
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index] / 1000.0;
+  }
+
+  double Mean() const {
+    if (us.empty()) return 0.0;
+    double sum = 0.0;
+    for (int64_t value : us) sum += static_cast<double>(value);
+    return sum / static_cast<double>(us.size()) / 1000.0;
+  }
+};
+
+// Results are printed once at the end so --json output stays a single
+// document.
+struct Report {
+  std::vector<std::string> text;
+  std::vector<std::string> json;
+
+  void Latency(const std::string& name, const Samples& samples) {
+    char line[256];
+    std::snprintf(line, sizeof line, "  %-22s n=%-6zu mean %8.3f ms  p50 %8.3f  p99 %8.3f", name.c_str(),
+                  samples.us.size(), samples.Mean(), samples.Percentile(0.50), samples.Percentile(0.99));
+    text.push_back(line);
+    std::snprintf(line, sizeof line, "\"%s\":{\"count\":%zu,\"mean\":%.4f,\"p50\":%.4f,\"p99\":%.4f}", name.c_str(),
+                  samples.us.size(), samples.Mean(), samples.Percentile(0.50), samples.Percentile(0.99));
+    json.push_back(line);
+  }
+
+  void Rate(const std::string& name, double value, const char* unit) {
+    char line[256];
+    std::snprintf(line, sizeof line, "  %-22s %10.1f %s", name.c_str(), value, unit);
+    text.push_back(line);
+    std::snprintf(line, sizeof line, "\"%s\":%.2f", name.c_str(), value);
+    json.push_back(line);
+  }
+
+  void Section(const std::string& name) {
+    text.push_back(name);
+    json.push_back("#" + name);
+  }
+
+  void Print(bool as_json) const {
+    if (!as_json) {
+      for (const std::string& line : text) std::printf("%s\n", line.c_str());
+      return;
+    }
+    std::printf("{");
+    bool open = false;
+    bool first = true;
+    for (const std::string& entry : json) {
+      if (entry[0] == '#') {
+        std::printf("%s\"%s\":{", open ? "}," : "", entry.c_str() + 1);
+        open = true;
+        first = true;
+        continue;
+      }
+      std::printf("%s%s", first ? "" : ",", entry.c_str());
+      first = false;
+    }
+    std::printf("%s}\n", open ? "}" : "");
+  }
+};
+
+// Headless player configured like the addon's Player with the SW renderer,
+// except that `untimed` lets frames arrive as fast as they decode.
+class BenchPlayer {
+ public:
+  ~BenchPlayer() { Close(); }
+
+  bool Open(const std::string& source, bool untimed, bool paused) {
+    handle_ = g_api.mpv_create();
+    if (!handle_) return false;
+    g_api.mpv_set_option_string(handle_, "terminal", "no");
+    g_api.mpv_set_option_string(handle_, "msg-level", "all=error");
+    g_api.mpv_set_option_string(handle_, "vo", "libmpv");
+    g_api.mpv_set_option_string(handle_, "hwdec", "no");
+    g_api.mpv_set_option_string(handle_, "audio", "no");
+    g_api.mpv_set_option_string(handle_, "osd-level", "0");
+    g_api.mpv_set_option_string(handle_, "loop-file", "inf");
+    g_api.mpv_set_option_string(handle_, "load-scripts", "no");
+    g_api.mpv_set_option_string(handle_, "ytdl", "no");
+    g_api.mpv_set_option_string(handle_, "untimed", untimed ? "yes" : "no");
+    g_api.mpv_set_option_string(handle_, "pause", paused ? "yes" : "no");
+    if (g_api.mpv_initialize(handle_) < 0) return false;
+
+    mpv_render_param params[] = {
+      { MPV_RENDER_PARAM_API_TYPE, const_cast<char*>(MPV_RENDER_API_TYPE_SW) },
+      { MPV_RENDER_PARAM_INVALID, nullptr }
+    };
+    if (g_api.mpv_render_context_create(&render_ctx_, handle_, params) < 0) {
+      render_ctx_ = nullptr;
+      return false;
+    }
+    g_api.mpv_render_context_set_update_callback(render_ctx_, &BenchPlayer::OnUpdate, this);
+
+    const char* load[] = { "loadfile", source.c_str(), nullptr };
+    return g_api.mpv_command(handle_, load) >= 0;
+  }
+
+  void Close() {
+    if (render_ctx_) g_api.mpv_render_context_free(render_ctx_);
+    if (handle_) g_api.mpv_terminate_destroy(handle_);
+    render_ctx_ = nullptr;
+    handle_ = nullptr;
+  }
+
+  // Blocks until mpv has a new frame for the render context.
+  bool WaitFrame(int timeout_ms) {
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (;;) {
+      DrainEvents();
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!cv_.wait_until(lock, deadline, [this] { return pending_; })) return false;
+        pending_ = false;
+      }
+      if (g_api.mpv_render_context_update(render_ctx_) & MPV_RENDER_UPDATE_FRAME) return true;
+    }
+  }
+
+  // Waits for FILE_LOADED; used by the polling pass, which never renders.
+  bool WaitLoaded(int timeout_ms) {
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (Clock::now() < deadline) {
+      mpv_event* event = g_api.mpv_wait_event(handle_, 0.1);
+      if (event->event_id == MPV_EVENT_FILE_LOADED) return true;
+      if (event->event_id == MPV_EVENT_END_FILE) return false;
+    }
+    return false;
+  }
+
+  void Render(uint8_t* dst, int width, int height, size_t stride, const char* format) {
+    int size[2] = { width, height };
+    int block = 0;
+    mpv_render_param params[] = {
+      { MPV_RENDER_PARAM_SW_SIZE, size },
+      { MPV_RENDER_PARAM_SW_FORMAT, const_cast<char*>(format) },
+      { MPV_RENDER_PARAM_SW_STRIDE, &stride },
+      { MPV_RENDER_PARAM_SW_POINTER, dst },
+      { MPV_RENDER_PARAM_BLOCK_FOR_TARGET_TIME, &block },
+      { MPV_RENDER_PARAM_INVALID, nullptr }
+    };
+    g_api.mpv_render_context_render(render_ctx_, params);
+  }
+
+  mpv_handle* handle() const { return handle_; }
+
+ private:
+  static void OnUpdate(void* ctx) {
+    auto* self = static_cast<BenchPlayer*>(ctx);
+    {
+      std::lock_guard<std::mutex> lock(self->mutex_);
+      self->pending_ = true;
+    }
+    self->cv_.notify_one();
+  }
+
+  void DrainEvents() {
+    while (g_api.mpv_wait_event(handle_, 0)->event_id != MPV_EVENT_NONE) {
+    }
+  }
+
+  mpv_handle* handle_ = nullptr;
+  mpv_render_context* render_ctx_ = nullptr;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool pending_ = false;
+};
+
+std::string TestSource(int width, int height) {
+  return "av://lavfi:testsrc2=size=" + std::to_string(width) + "x" + std::to_string(height) + ":rate=60";
+}
+
+// One pass per output size. Each frame is rendered into a native buffer and
+// then put through what RenderFrame does afterwards: the copy into a JS
+// Buffer, and the BGRA swizzle / I420 conversion when those formats are
+// selected. Reported fps is render throughput with decoding unthrottled.
+void BenchRender(const Options& options, Report* report) {
+  struct Size { const char* name; int width; int height; };
+  const Size sizes[] = { { "720p", 1280, 720 }, { "1080p", 1920, 1080 }, { "4k", 3840, 2160 } };
+
+  for (const Size& size : sizes) {
+    BenchPlayer player;
+    std::string source = options.media.empty() ? TestSource(size.width, size.height) : options.media;
+    if (!player.Open(source, true, false) || !player.WaitFrame(10000)) {
+      std::fprintf(stderr, "render %s: no frames from %s\n", size.name, source.c_str());
+      continue;
+    }
+
+    const size_t stride = static_cast<size_t>(size.width) * 4;
+    const size_t bytes = stride * static_cast<size_t>(size.height);
+    std::unique_ptr<uint8_t[]> native(new uint8_t[bytes]);
+    std::unique_ptr<uint8_t[]> js(new uint8_t[bytes]);
+    std::unique_ptr<uint8_t[]> yuv(new uint8_t[FrameBytes(PixelFormat::kI420, size.width, size.height)]);
+    std::unique_ptr<uint8_t[]> scratch(
+        new uint8_t[FrameBytes(PixelFormat::kRgba, (size.width + 1) / 2, (size.height + 1) / 2)]);
+
+    Samples render;
+    Samples copy;
+    Samples swizzle;
+    Samples i420;
+    int rendered = 0;
+    auto start = Clock::now();
+    while (rendered < options.frames) {
+      if (rendered > 0 && !player.WaitFrame(2000)) break;
+
+      auto t = Clock::now();
+      player.Render(native.get(), size.width, size.height, stride, "rgba");
+      render.Add(ElapsedUs(t));
+      ++rendered;
+
+      t = Clock::now();
+      std::memcpy(js.get(), native.get(), bytes);
+      copy.Add(ElapsedUs(t));
+
+      t = Clock::now();
+      SwapRedBlue(js.get(), static_cast<size_t>(size.width) * size.height);
+      swizzle.Add(ElapsedUs(t));
+
+      t = Clock::now();
+      RgbaToI420(native.get(), size.width, size.height, yuv.get(), scratch.get());
+      i420.Add(ElapsedUs(t));
+    }
+    double seconds = ElapsedUs(start) / 1e6;
+
+    report->Section(std::string("render_") + size.name);
+    report->Rate("fps", seconds > 0 ? rendered / seconds : 0.0, "frames/s");
+    report->Latency("render", render);
+    report->Latency("copy", copy);
+    report->Latency("bgra_swizzle", swizzle);
+    report->Latency("i420_convert", i420);
+  }
+}
+
+// Synchronous get_property round trips, the cost every poll from the
+// renderer pays on the JS thread.
+void BenchProperties(const Options& options, Report* report) {
+  BenchPlayer player;
+  std::string source = options.media.empty() ? TestSource(640, 360) : options.media;
+  if (!player.Open(source, false, true) || !player.WaitLoaded(10000)) {
+    std::fprintf(stderr, "props: could not load %s\n", source.c_str());
+    return;
+  }
+
+  const char* names[] = { "time-pos", "duration", "pause", "percent-pos" };
+  const int kRounds = 5000;
+  Samples samples;
+  auto start = Clock::now();
+  for (int i = 0; i < kRounds; ++i) {
+    for (const char* name : names) {
+      auto t = Clock::now();
+      if (std::strcmp(name, "pause") == 0) {
+        int flag = 0;
+        g_api.mpv_get_property(player.handle(), name, MPV_FORMAT_FLAG, &flag);
+      } else {
+        double value = 0.0;
+        g_api.mpv_get_property(player.handle(), name, MPV_FORMAT_DOUBLE, &value);
+      }
+      samples.Add(ElapsedUs(t));
+    }
+  }
+  double seconds = ElapsedUs(start) / 1e6;
+
+  report->Section("properties");
+  report->Rate("reads_per_sec", seconds > 0 ? samples.us.size() / seconds : 0.0, "reads/s");
+  report->Latency("get_property", samples);
+}
+
+// FrameExtractor requests spread over the file, as the thumbnail scheduler
+// issues them for a library page.
+void BenchThumbnails(const Options& options, Report* report) {
+  if (options.media.empty()) {
+    std::fprintf(stderr, "thumbs: skipped (needs --media)\n");
+    return;
+  }
+  FrameExtractor extractor;
+  std::string err;
+  if (!extractor.Open("no", &err)) {
+    std::fprintf(stderr, "thumbs: %s\n", err.c_str());
+    return;
+  }
+
+  ThumbnailRequest request;
+  request.path = options.media;
+  request.width = 320;
+  request.height = 180;
+  ThumbnailResult probe;
+  if (!extractor.Run(request, &probe, nullptr)) {
+    std::fprintf(stderr, "thumbs: %s\n", probe.error.c_str());
+    return;
+  }
+
+  Samples samples;
+  int failed = 0;
+  auto start = Clock::now();
+  for (int i = 0; i < options.thumbs; ++i) {
+    request.position = probe.duration * (i + 0.5) / options.thumbs;
+    ThumbnailResult result;
+    auto t = Clock::now();
+    if (extractor.Run(request, &result, nullptr)) {
+      samples.Add(ElapsedUs(t));
+    } else {
+      ++failed;
+    }
+  }
+  double seconds = ElapsedUs(start) / 1e6;
+
+  report->Section("thumbnails");
+  report->Rate("per_sec", seconds > 0 ? samples.us.size() / seconds : 0.0, "thumbs/s");
+  report->Rate("failed", failed, "");
+  report->Latency("extract", samples);
+}
+
+// 8-way tree three levels deep with 24 files per directory, two thirds of
+// them media, so the extension filter and the stat calls both matter.
+std::string MakeSyntheticTree() {
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  fs::path root = fs::temp_directory_path(ec) / ("mpvbench-" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()));
+  std::deque<std::pair<fs::path, int>> queue = { { root, 0 } };
+  while (!queue.empty()) {
+    auto [dir, depth] = queue.front();
+    queue.pop_front();
+    fs::create_directories(dir, ec);
+    if (ec) return "";
+    for (int i = 0; i < 24; ++i) {
+      const char* ext = i % 3 == 0 ? ".txt" : (i % 3 == 1 ? ".mp4" : ".mkv");
+      std::FILE* file = OpenPath((dir / ("file" + std::to_string(i) + ext)).string(), "wb");
+      if (file) std::fclose(file);
+    }
+    if (depth < 3) {
+      for (int i = 0; i < 8; ++i) queue.push_back({ dir / ("dir" + std::to_string(i)), depth + 1 });
+    }
+  }
+  return root.string();
+}
+
+// Breadth-first walk with ListDirectory, the same traversal DirectoryScanner
+// runs on its worker.
+void BenchScan(const Options& options, Report* report) {
+  std::string root = options.scan_dir.empty() ? MakeSyntheticTree() : options.scan_dir;
+  if (root.empty()) {
+    std::fprintf(stderr, "scan: could not create the synthetic tree\n");
+    return;
+  }
+
+  const ExtensionSet extensions = { ".mp4", ".mkv", ".webm", ".mov", ".avi" };
+  const int kPasses = 5;
+  Samples passes;
+  uint64_t files = 0;
+  uint64_t dirs = 0;
+  for (int pass = 0; pass < kPasses; ++pass) {
+    files = 0;
+    dirs = 0;
+    std::deque<std::string> queue = { root };
+    auto t = Clock::now();
+    while (!queue.empty()) {
+      std::string dir = queue.front();
+      queue.pop_front();
+      DirListing listing;
+      if (!ListDirectory(dir, extensions, &listing)) continue;
+      ++dirs;
+      files += listing.files.size();
+      for (const std::string& sub : listing.subdirs) queue.push_back(JoinPath(dir, sub));
+    }
+    passes.Add(ElapsedUs(t));
+  }
+
+  if (options.scan_dir.empty()) {
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+  }
+
+  double mean_s = passes.Mean() / 1000.0;
+  report->Section("scan");
+  report->Rate("files", static_cast<double>(files), "files");
+  report->Rate("dirs", static_cast<double>(dirs), "dirs");
+  report->Rate("files_per_sec", mean_s > 0 ? files / mean_s : 0.0, "files/s");
+  report->Latency("pass", passes);
+}
+
+bool ParseArgs(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (arg == "--json") {
+      options->json = true;
+    } else if (value && arg == "--libmpv") {
+      options->libmpv = argv[++i];
+    } else if (value && arg == "--media") {
+      options->media = argv[++i];
+    } else if (value && arg == "--scan-dir") {
+      options->scan_dir = argv[++i];
+    } else if (value && arg == "--only") {
+      options->only = argv[++i];
+    } else if (value && arg == "--frames") {
+      options->frames = std::max(1, std::atoi(argv[++i]));
+    } else if (value && arg == "--thumbs") {
+      options->thumbs = std::max(1, std::atoi(argv[++i]));
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseArgs(argc, argv, &options)) {
+    std::fprintf(stderr,
+                 "usage: mpvbench [--libmpv PATH] [--media FILE] [--frames N] [--thumbs N]\n"
+                 "                [--scan-dir DIR] [--only render,props,thumbs,scan] [--json]\n");
+    return 2;
+  }
+
+  Report report;
+  bool needs_mpv = Enabled(options, "render") || Enabled(options, "props") || Enabled(options, "thumbs");
+  if (needs_mpv) {
+    if (options.libmpv.empty()) {
+      const char* env = std::getenv("LIBMPV_PATH");
+      if (env) options.libmpv = env;
+    }
+    std::string err;
+    bool loaded = options.libmpv.empty() ? LoadLibraryFallback(&err) : LoadLibraryWithPath(options.libmpv, &err);
+    if (!loaded) {
+      std::fprintf(stderr, "libmpv: %s\n", err.c_str());
+      return 1;
+    }
+    if (Enabled(options, "render")) BenchRender(options, &report);
+    if (Enabled(options, "props")) BenchProperties(options, &report);
+    if (Enabled(options, "thumbs")) BenchThumbnails(options, &report);
+  }
+  if (Enabled(options, "scan")) BenchScan(options, &report);
+
+  report.Print(options.json);
+  return 0;
+}
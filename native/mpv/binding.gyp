@@ -2,7 +2,7 @@
   "targets": [
     {
       "target_name": "mpvaddon",
-      "sources": [ "src/addon.cc" ],
+      "sources": [ "src/addon.cc", "src/mpv_api.cc", "src/mpv_node.cc", "src/player.cc", "src/pixel_kernels.cc", "src/perf_stats.cc", "src/memory_budget.cc", "src/player_pool.cc", "src/frame_extractor.cc", "src/thumbnailer.cc", "src/thumbnail_scheduler.cc", "src/metadata_prober.cc", "src/media_prober.cc", "src/path_util.cc", "src/dir_walker.cc", "src/dir_scanner.cc", "src/fs_watcher.cc", "src/dir_watcher.cc", "src/thumbnail_store.cc", "src/thumbnail_cache.cc", "src/keyframe_index.cc", "src/gl_context.cc" ],
       "include_dirs": [
         "<!(node -p \"require('node-addon-api').include_dir\")",
         "<!(node -p \"require('node-addon-api').include\")",
@@ -18,6 +18,24 @@
       "conditions": [
         [ "OS==\"win\"", {
           "defines": [ "_HAS_EXCEPTIONS=0" ]
+        } ],
+        [ "OS==\"mac\"", {
+          "link_settings": { "libraries": [ "-framework CoreServices" ] }
+        } ]
+      ]
+    },
+    {
+      "target_name": "mpvbench",
+      "type": "executable",
+      "sources": [ "bench/addon_bench.cc", "src/mpv_api.cc", "src/pixel_kernels.cc", "src/frame_extractor.cc", "src/dir_walker.cc", "src/path_util.cc" ],
+      "include_dirs": [
+        "include",
+        "src",
+        "../../libmpv/mac"
+      ],
+      "conditions": [
+        [ "OS==\"linux\"", {
+          "libraries": [ "-ldl", "-pthread" ]
         } ]
       ]
     }
@@ -2,107 +2,25 @@
 #include <string>
 #include <vector>
 
-#include "mpv/client.h"
-#include "mpv/render.h"
-
-#if defined(_WIN32)
-#include <windows.h>
-#else
-#include <dlfcn.h>
-#endif
+#include "addon_data.h"
+#include "memory_budget.h"
+#include "mpv_api.h"
+#include "player.h"
+#include "player_pool.h"
+#include "dir_scanner.h"
+#include "dir_watcher.h"
+#include "keyframe_index.h"
+#include "media_prober.h"
+#include "thumbnail_cache.h"
+#include "thumbnail_scheduler.h"
+#include "thumbnailer.h"
 
 namespace {
 
-struct MpvApi {
-#if defined(_WIN32)
-  HMODULE handle = nullptr;
-#else
-  void* handle = nullptr;
-#endif
-  mpv_handle* (*mpv_create)();
-  int (*mpv_initialize)(mpv_handle*);
-  int (*mpv_command)(mpv_handle*, const char**);
-  void (*mpv_terminate_destroy)(mpv_handle*);
-  int (*mpv_set_option_string)(mpv_handle*, const char*, const char*);
-  int (*mpv_get_property)(mpv_handle*, const char*, mpv_format, void*);
-  char* (*mpv_get_property_string)(mpv_handle*, const char*);
-  void (*mpv_free)(void*);
-  int (*mpv_render_context_create)(mpv_render_context **, mpv_handle *, mpv_render_param *);
-  void (*mpv_render_context_render)(mpv_render_context *, mpv_render_param *);
-  void (*mpv_render_context_free)(mpv_render_context *);
-};
-
-MpvApi g_api;
-mpv_handle* g_handle = nullptr;
-mpv_render_context* g_render_ctx = nullptr;
-std::vector<uint8_t> g_frame;
-
-bool ResolveSymbol(const char* name, void** out, std::string* err) {
-#if defined(_WIN32)
-  FARPROC sym = GetProcAddress(g_api.handle, name);
-  if (!sym) {
-    if (err) *err = "missing_symbol";
-    return false;
-  }
-  *out = reinterpret_cast<void*>(sym);
-  return true;
-#else
-  void* sym = dlsym(g_api.handle, name);
-  if (!sym) {
-    if (err) *err = "missing_symbol";
-    return false;
-  }
-  *out = sym;
-  return true;
-#endif
-}
-
-bool LoadLibraryWithPath(const std::string& path, std::string* err) {
-  if (g_api.handle) return true;
-#if defined(_WIN32)
-  g_api.handle = LoadLibraryA(path.c_str());
-#else
-  g_api.handle = dlopen(path.c_str(), RTLD_LAZY | RTLD_LOCAL);
-#endif
-  if (!g_api.handle) {
-    if (err) *err = "load_failed";
-    return false;
-  }
-
-  if (!ResolveSymbol("mpv_create", reinterpret_cast<void**>(&g_api.mpv_create), err)) return false;
-  if (!ResolveSymbol("mpv_initialize", reinterpret_cast<void**>(&g_api.mpv_initialize), err)) return false;
-  if (!ResolveSymbol("mpv_command", reinterpret_cast<void**>(&g_api.mpv_command), err)) return false;
-  if (!ResolveSymbol("mpv_terminate_destroy", reinterpret_cast<void**>(&g_api.mpv_terminate_destroy), err)) return false;
-  if (!ResolveSymbol("mpv_set_option_string", reinterpret_cast<void**>(&g_api.mpv_set_option_string), err)) return false;
-  if (!ResolveSymbol("mpv_get_property", reinterpret_cast<void**>(&g_api.mpv_get_property), err)) return false;
-  if (!ResolveSymbol("mpv_get_property_string", reinterpret_cast<void**>(&g_api.mpv_get_property_string), err)) return false;
-  if (!ResolveSymbol("mpv_free", reinterpret_cast<void**>(&g_api.mpv_free), err)) return false;
-  if (!ResolveSymbol("mpv_render_context_create", reinterpret_cast<void**>(&g_api.mpv_render_context_create), err)) return false;
-  if (!ResolveSymbol("mpv_render_context_render", reinterpret_cast<void**>(&g_api.mpv_render_context_render), err)) return false;
-  if (!ResolveSymbol("mpv_render_context_free", reinterpret_cast<void**>(&g_api.mpv_render_context_free), err)) return false;
-
-  return true;
-}
-
-bool LoadLibraryFallback(std::string* err) {
-  const char* candidates[] = {
-#if defined(_WIN32)
-    "libmpv-2.dll",
-    "mpv-2.dll",
-#elif defined(__APPLE__)
-    "libmpv.2.dylib",
-    "libmpv.dylib",
-#else
-    "libmpv.so.2",
-    "libmpv.so",
-#endif
-  };
-
-  for (const char* candidate : candidates) {
-    if (LoadLibraryWithPath(candidate, nullptr)) return true;
-  }
-  if (err) *err = "load_failed";
-  return false;
+Player* DefaultPlayer(Napi::Env env) {
+  AddonData* data = env.GetInstanceData<AddonData>();
+  if (!data || data->default_player.IsEmpty()) return nullptr;
+  return Player::Unwrap(data->default_player.Value());
 }
 
 Napi::Value InitMpv(const Napi::CallbackInfo& info) {
@@ -130,66 +48,128 @@ Napi::Value InitMpv(const Napi::CallbackInfo& info) {
   return Napi::Boolean::New(env, true);
 }
 
-Napi::Value CreatePlayer(const Napi::CallbackInfo& info) {
-  Napi::Env env = info.Env();
-  if (!g_api.handle) {
-    Napi::Error::New(env, "not_initialized").ThrowAsJavaScriptException();
-    return env.Null();
+// Loads libmpv on the libuv thread pool. The API is only published to g_api
+// in OnOK, on the JS thread, so no player can see it half resolved.
+class LoadWorker : public Napi::AsyncWorker {
+ public:
+  LoadWorker(Napi::Env env, std::vector<std::string> candidates)
+      : Napi::AsyncWorker(env),
+        deferred_(Napi::Promise::Deferred::New(env)),
+        candidates_(std::move(candidates)) {}
+
+  Napi::Promise Promise() const { return deferred_.Promise(); }
+
+ protected:
+  void Execute() override {
+    std::string err;
+    if (!LoadFirstMpvApi(candidates_, &api_, &path_, &err)) SetError(err);
   }
 
-  if (g_handle) {
-    return Napi::Boolean::New(env, true);
+  void OnOK() override {
+    // init() or an earlier initAsync() may have won the race; keep that one.
+    if (g_api.handle) {
+      UnloadMpvApi(&api_);
+    } else {
+      g_api = api_;
+      g_api_path = path_;
+    }
+    deferred_.Resolve(Napi::String::New(Env(), g_api_path));
   }
 
-  g_handle = g_api.mpv_create();
-  if (!g_handle) {
-    Napi::Error::New(env, "mpv_create_failed").ThrowAsJavaScriptException();
-    return env.Null();
+  void OnError(const Napi::Error& error) override {
+    deferred_.Reject(error.Value());
   }
 
-  g_api.mpv_set_option_string(g_handle, "terminal", "no");
-  g_api.mpv_set_option_string(g_handle, "msg-level", "all=error");
-  g_api.mpv_set_option_string(g_handle, "vo", "libmpv");
-  g_api.mpv_set_option_string(g_handle, "audio", "yes");
-  g_api.mpv_set_option_string(g_handle, "audio-device", "auto");
-  g_api.mpv_set_option_string(g_handle, "audio-exclusive", "no");
-#if defined(_WIN32)
-  g_api.mpv_set_option_string(g_handle, "ao", "wasapi");
-#elif defined(__APPLE__)
-  g_api.mpv_set_option_string(g_handle, "ao", "coreaudio");
-#else
-  g_api.mpv_set_option_string(g_handle, "ao", "auto");
-#endif
-
-  int res = g_api.mpv_initialize(g_handle);
-  if (res < 0) {
-    g_api.mpv_terminate_destroy(g_handle);
-    g_handle = nullptr;
-    Napi::Error::New(env, "mpv_initialize_failed").ThrowAsJavaScriptException();
-    return env.Null();
+ private:
+  Napi::Promise::Deferred deferred_;
+  std::vector<std::string> candidates_;
+  MpvApi api_;
+  std::string path_;
+};
+
+// initAsync(path | paths) -> Promise<string>, the path that loaded. Paths are
+// tried in order before the platform's library names; empty entries are
+// skipped. Resolves at once when libmpv is already loaded.
+Napi::Value InitMpvAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (g_api.handle) {
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    deferred.Resolve(Napi::String::New(env, g_api_path));
+    return deferred.Promise();
   }
 
-  if (!g_render_ctx) {
-    mpv_render_param params[] = {
-      { MPV_RENDER_PARAM_API_TYPE, const_cast<char*>(MPV_RENDER_API_TYPE_SW) },
-      { MPV_RENDER_PARAM_INVALID, nullptr }
-    };
-    int r = g_api.mpv_render_context_create(&g_render_ctx, g_handle, params);
-    if (r < 0) {
-      g_api.mpv_terminate_destroy(g_handle);
-      g_handle = nullptr;
-      Napi::Error::New(env, "mpv_render_init_failed").ThrowAsJavaScriptException();
-      return env.Null();
+  std::vector<std::string> candidates;
+  if (info.Length() > 0 && info[0].IsString()) {
+    candidates.push_back(info[0].As<Napi::String>().Utf8Value());
+  } else if (info.Length() > 0 && info[0].IsArray()) {
+    Napi::Array paths = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < paths.Length(); ++i) {
+      Napi::Value path = paths.Get(i);
+      if (path.IsString()) candidates.push_back(path.As<Napi::String>().Utf8Value());
     }
   }
 
+  LoadWorker* worker = new LoadWorker(env, std::move(candidates));
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+Napi::Value CreatePlayer(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!g_api.handle) {
+    Napi::Error::New(env, "not_initialized").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Player* current = DefaultPlayer(env);
+  if (current && current->IsReady()) return Napi::Boolean::New(env, true);
+
+  AddonData* data = env.GetInstanceData<AddonData>();
+  Napi::Value options = info.Length() > 0 ? info[0] : env.Undefined();
+  Napi::Object player = data->player_ctor.New({ options });
+  if (env.IsExceptionPending()) return env.Null();
+  data->default_player = Napi::Persistent(player);
+  if (options.IsObject()) {
+    data->default_options = Napi::Persistent(options.As<Napi::Object>());
+  } else {
+    data->default_options.Reset();
+  }
   return Napi::Boolean::New(env, true);
 }
 
+Player* StandbyPlayer(Napi::Env env) {
+  AddonData* data = env.GetInstanceData<AddonData>();
+  if (!data || data->standby_player.IsEmpty()) return nullptr;
+  return Player::Unwrap(data->standby_player.Value());
+}
 
-Napi::Value LoadFile(const Napi::CallbackInfo& info) {
+// Swaps in the standby player if it holds `path`. The old default becomes
+// the standby, stopped but warm for the next preloadFile().
+bool PromoteStandby(Napi::Env env, const std::string& path) {
+  AddonData* data = env.GetInstanceData<AddonData>();
+  Player* current = DefaultPlayer(env);
+  Player* standby = StandbyPlayer(env);
+  if (!current || !standby || data->standby_path != path) return false;
+  if (!current->IsReady() || !standby->IsReady()) return false;
+
+  standby->TakeOver(env, current);
+  current->Recycle();
+  Napi::Object promoted = data->standby_player.Value();
+  Napi::Object demoted = data->default_player.Value();
+  data->default_player = Napi::Persistent(promoted);
+  data->standby_player = Napi::Persistent(demoted);
+  data->standby_path.clear();
+  return true;
+}
+
+// Opens `path` paused on a hidden second player so that a later loadFile()
+// of the same path starts from an already probed, decoded first frame. One
+// preload at a time; a new path replaces the previous one.
+Napi::Value PreloadFile(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
-  if (!g_handle) {
+  AddonData* data = env.GetInstanceData<AddonData>();
+  Player* current = DefaultPlayer(env);
+  if (!current || !current->IsReady()) {
     Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
     return env.Null();
   }
@@ -197,160 +177,244 @@ Napi::Value LoadFile(const Napi::CallbackInfo& info) {
     Napi::Error::New(env, "missing_path").ThrowAsJavaScriptException();
     return env.Null();
   }
-  std::string filePath = info[0].As<Napi::String>().Utf8Value();
+  std::string path = info[0].As<Napi::String>().Utf8Value();
+  std::string cache_profile = current->cache_profile();
+  if (info.Length() > 1 && info[1].IsObject()) {
+    Napi::Value profile = info[1].As<Napi::Object>().Get("cacheProfile");
+    if (profile.IsString()) cache_profile = profile.As<Napi::String>().Utf8Value();
+  }
+  if (data->standby_path == path) return Napi::Boolean::New(env, true);
 
-  const char* cmd[] = { "loadfile", filePath.c_str(), nullptr };
-  int res = g_api.mpv_command(g_handle, cmd);
-  if (res < 0) {
-    Napi::Error::New(env, "load_failed").ThrowAsJavaScriptException();
+  if (data->standby_player.IsEmpty()) {
+    Napi::Value options = data->default_options.IsEmpty() ? env.Undefined() : data->default_options.Value();
+    Napi::Object standby = data->player_ctor.New({ options });
+    if (env.IsExceptionPending()) return env.Null();
+    data->standby_player = Napi::Persistent(standby);
+  }
+  Player* standby = StandbyPlayer(env);
+  standby->Recycle();
+  data->standby_path.clear();
+
+  std::string err;
+  if (!standby->Preload(path, cache_profile, &err)) {
+    Napi::Error::New(env, err).ThrowAsJavaScriptException();
     return env.Null();
   }
+  data->standby_path = path;
   return Napi::Boolean::New(env, true);
 }
 
-Napi::Value Stop(const Napi::CallbackInfo& info) {
+// Stops the preload. With `true`, the standby player is destroyed as well
+// instead of being kept warm.
+Napi::Value CancelPreload(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
-  if (!g_handle) return Napi::Boolean::New(env, true);
-  const char* cmd[] = { "stop", nullptr };
-  g_api.mpv_command(g_handle, cmd);
+  AddonData* data = env.GetInstanceData<AddonData>();
+  Player* standby = StandbyPlayer(env);
+  if (!standby) return Napi::Boolean::New(env, true);
+  data->standby_path.clear();
+  if (info.Length() > 0 && info[0].IsBoolean() && info[0].As<Napi::Boolean>().Value()) {
+    standby->Destroy(info);
+    data->standby_player.Reset();
+  } else {
+    standby->Recycle();
+  }
   return Napi::Boolean::New(env, true);
 }
 
-Napi::Value GetProperty(const Napi::CallbackInfo& info) {
-  Napi::Env env = info.Env();
-  if (!g_handle) {
-    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
-    return env.Null();
-  }
-  if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
-    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
-    return env.Null();
-  }
-
-  std::string name = info[0].As<Napi::String>().Utf8Value();
-  std::string type = info[1].As<Napi::String>().Utf8Value();
+// The standby counts as an idle player; under memory pressure it is shut
+// down as by cancelPreload(true).
+class StandbyMemory : public MemoryOwner {
+ public:
+  explicit StandbyMemory(AddonData* data) : data_(data) { data_->memory->Add(this); }
+  ~StandbyMemory() override { data_->memory->Remove(this); }
 
-  if (type == "string") {
-    char* value = g_api.mpv_get_property_string(g_handle, name.c_str());
-    if (!value) return env.Null();
-    Napi::String out = Napi::String::New(env, value);
-    g_api.mpv_free(value);
-    return out;
+  void ReportMemory(MemoryUsage* usage) override {
+    if (!data_->standby_player.IsEmpty()) usage->idle_players++;
   }
 
-  if (type == "bool") {
-    int flag = 0;
-    int res = g_api.mpv_get_property(g_handle, name.c_str(), MPV_FORMAT_FLAG, &flag);
-    if (res < 0) return env.Null();
-    return Napi::Boolean::New(env, flag != 0);
+  bool ReleaseMemory(Napi::Env env, EvictionStep step) override {
+    if (step != EvictionStep::kIdlePlayers || data_->standby_player.IsEmpty()) return false;
+    Player::Unwrap(data_->standby_player.Value())->Shutdown(env);
+    data_->standby_player.Reset();
+    data_->standby_path.clear();
+    return true;
   }
 
-  if (type == "int") {
-    int64_t val = 0;
-    int res = g_api.mpv_get_property(g_handle, name.c_str(), MPV_FORMAT_INT64, &val);
-    if (res < 0) return env.Null();
-    return Napi::Number::New(env, static_cast<double>(val));
-  }
+ private:
+  AddonData* data_;
+};
 
-  double val = 0.0;
-  int res = g_api.mpv_get_property(g_handle, name.c_str(), MPV_FORMAT_DOUBLE, &val);
-  if (res < 0) return env.Null();
-  return Napi::Number::New(env, val);
+Napi::Value TrimResultToJs(Napi::Env env, const TrimResult& result) {
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("released", Napi::Number::New(env, static_cast<double>(result.released)));
+  out.Set("steps", Napi::Number::New(env, result.steps));
+  out.Set("withinBudget", Napi::Boolean::New(env, result.within_budget));
+  return out;
 }
 
-Napi::Value Command(const Napi::CallbackInfo& info) {
+// setMemoryBudget(bytes); 0 removes the limit. Trims right away and returns
+// the same result as trimMemory().
+Napi::Value SetMemoryBudget(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
-  if (!g_handle) {
-    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
-    return env.Null();
-  }
-  if (info.Length() < 1 || !info[0].IsArray()) {
-    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+  if (info.Length() < 1 || !info[0].IsNumber() || info[0].As<Napi::Number>().DoubleValue() < 0) {
+    Napi::Error::New(env, "invalid_budget").ThrowAsJavaScriptException();
     return env.Null();
   }
+  MemoryBudget& memory = *env.GetInstanceData<AddonData>()->memory;
+  memory.set_limit(static_cast<uint64_t>(info[0].As<Napi::Number>().DoubleValue()));
+  return TrimResultToJs(env, memory.Trim(env));
+}
 
-  auto arr = info[0].As<Napi::Array>();
-  std::vector<std::string> args;
-  args.reserve(arr.Length());
-  for (uint32_t i = 0; i < arr.Length(); ++i) {
-    if (!arr.Get(i).IsString()) {
-      Napi::Error::New(env, "invalid_arg").ThrowAsJavaScriptException();
-      return env.Null();
-    }
-    args.push_back(arr.Get(i).As<Napi::String>().Utf8Value());
-  }
+// { budget, total, frames, framePool, renderBuffers, demuxerCache,
+// thumbnailIndex, players, idlePlayers, trims, releasedBytes }, in bytes.
+Napi::Value GetMemoryUsage(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  return env.GetInstanceData<AddonData>()->memory->UsageToJs(env);
+}
 
-  std::vector<const char*> cmd;
-  cmd.reserve(args.size() + 1);
-  for (const auto& arg : args) cmd.push_back(arg.c_str());
-  cmd.push_back(nullptr);
+// Runs the eviction steps (frame pools, idle players, demuxer caches) until
+// usage fits the budget. -> { released, steps, withinBudget }
+Napi::Value TrimMemory(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  return TrimResultToJs(env, env.GetInstanceData<AddonData>()->memory->Trim(env));
+}
 
-  int res = g_api.mpv_command(g_handle, cmd.data());
-  if (res < 0) {
-    Napi::Error::New(env, "command_failed").ThrowAsJavaScriptException();
-    return env.Null();
+Napi::Value DestroyPlayer(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  AddonData* data = env.GetInstanceData<AddonData>();
+  Player* player = DefaultPlayer(env);
+  if (player) player->Destroy(info);
+  Player* standby = StandbyPlayer(env);
+  if (standby) standby->Destroy(info);
+  if (data) {
+    data->default_player.Reset();
+    data->standby_player.Reset();
+    data->standby_path.clear();
   }
   return Napi::Boolean::New(env, true);
 }
 
-Napi::Value RenderFrame(const Napi::CallbackInfo& info) {
+// Forwards a module-level call to the default player. Without one, queries
+// report "nothing yet" (ForwardOr) and everything else throws not_ready.
+template <Napi::Value (Player::*Method)(const Napi::CallbackInfo&)>
+Napi::Value Forward(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
-  if (!g_render_ctx) {
-    Napi::Error::New(env, "render_not_ready").ThrowAsJavaScriptException();
+  Player* player = DefaultPlayer(env);
+  if (!player) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
     return env.Null();
   }
-  if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
-    Napi::Error::New(env, "missing_size").ThrowAsJavaScriptException();
-    return env.Null();
+  return (player->*Method)(info);
+}
+
+template <Napi::Value (Player::*Method)(const Napi::CallbackInfo&)>
+Napi::Value ForwardOr(const Napi::CallbackInfo& info, Napi::Value fallback) {
+  Player* player = DefaultPlayer(info.Env());
+  if (!player) return fallback;
+  return (player->*Method)(info);
+}
+
+Napi::Value LoadFile(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() > 0 && info[0].IsString() && PromoteStandby(env, info[0].As<Napi::String>().Utf8Value())) {
+    return Napi::Boolean::New(env, true);
   }
-  int width = info[0].As<Napi::Number>().Int32Value();
-  int height = info[1].As<Napi::Number>().Int32Value();
-  if (width <= 0 || height <= 0) {
-    Napi::Error::New(env, "invalid_size").ThrowAsJavaScriptException();
-    return env.Null();
+  return Forward<&Player::LoadFile>(info);
+}
+
+Napi::Value LoadFileAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() > 0 && info[0].IsString() && PromoteStandby(env, info[0].As<Napi::String>().Utf8Value())) {
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    deferred.Resolve(Napi::Boolean::New(env, true));
+    return deferred.Promise();
   }
+  return Forward<&Player::LoadFileAsync>(info);
+}
 
-  const int stride = width * 4;
-  const size_t needed = static_cast<size_t>(stride) * static_cast<size_t>(height);
-  if (g_frame.size() != needed) g_frame.assign(needed, 0);
+Napi::Value Stop(const Napi::CallbackInfo& info) {
+  return ForwardOr<&Player::Stop>(info, Napi::Boolean::New(info.Env(), true));
+}
 
-  int size[2] = { width, height };
-  int stride_local = stride;
-  const char* fmt = "rgba";
+Napi::Value HasNewFrame(const Napi::CallbackInfo& info) {
+  return ForwardOr<&Player::HasNewFrame>(info, Napi::Boolean::New(info.Env(), false));
+}
 
-  mpv_render_param params[] = {
-    { MPV_RENDER_PARAM_SW_SIZE, size },
-    { MPV_RENDER_PARAM_SW_FORMAT, const_cast<char*>(fmt) },
-    { MPV_RENDER_PARAM_SW_STRIDE, &stride_local },
-    { MPV_RENDER_PARAM_SW_POINTER, g_frame.data() },
-    { MPV_RENDER_PARAM_INVALID, nullptr }
-  };
+Napi::Value AcquireFrame(const Napi::CallbackInfo& info) {
+  return ForwardOr<&Player::AcquireFrame>(info, info.Env().Null());
+}
 
-  g_api.mpv_render_context_render(g_render_ctx, params);
-  return Napi::Buffer<uint8_t>::Copy(env, g_frame.data(), g_frame.size());
+Napi::Value StopRenderThread(const Napi::CallbackInfo& info) {
+  return ForwardOr<&Player::StopRenderThread>(info, Napi::Boolean::New(info.Env(), true));
 }
 
-Napi::Value Destroy(const Napi::CallbackInfo& info) {
-  Napi::Env env = info.Env();
-  if (g_render_ctx) {
-    g_api.mpv_render_context_free(g_render_ctx);
-    g_render_ctx = nullptr;
-  }
-  if (!g_handle) return Napi::Boolean::New(env, true);
-  g_api.mpv_terminate_destroy(g_handle);
-  g_handle = nullptr;
-  return Napi::Boolean::New(env, true);
+Napi::Value GetFrameSize(const Napi::CallbackInfo& info) {
+  return ForwardOr<&Player::GetFrameSize>(info, info.Env().Null());
+}
+
+Napi::Value GetRenderApi(const Napi::CallbackInfo& info) {
+  return ForwardOr<&Player::GetRenderApi>(info, info.Env().Null());
 }
 
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function player = Player::Define(env);
+  AddonData* data = new AddonData();
+  data->player_ctor = Napi::Persistent(player);
+  data->standby_memory.reset(new StandbyMemory(data));
+  env.SetInstanceData<AddonData>(data);
+
+  exports.Set("Player", player);
+  exports.Set("PlayerPool", PlayerPool::Define(env));
+  exports.Set("Thumbnailer", Thumbnailer::Define(env));
+  exports.Set("ThumbnailScheduler", ThumbnailScheduler::Define(env));
+  exports.Set("ThumbnailCache", ThumbnailCache::Define(env));
+  exports.Set("DirectoryScanner", DirectoryScanner::Define(env));
+  exports.Set("DirectoryWatcher", DirectoryWatcher::Define(env));
+  exports.Set("MediaProber", MediaProber::Define(env));
+  exports.Set("readKeyframes", Napi::Function::New(env, ReadKeyframes));
   exports.Set("init", Napi::Function::New(env, InitMpv));
+  exports.Set("initAsync", Napi::Function::New(env, InitMpvAsync));
   exports.Set("createPlayer", Napi::Function::New(env, CreatePlayer));
   exports.Set("loadFile", Napi::Function::New(env, LoadFile));
+  exports.Set("preloadFile", Napi::Function::New(env, PreloadFile));
+  exports.Set("cancelPreload", Napi::Function::New(env, CancelPreload));
   exports.Set("stop", Napi::Function::New(env, Stop));
-  exports.Set("getProperty", Napi::Function::New(env, GetProperty));
-  exports.Set("command", Napi::Function::New(env, Command));
-  exports.Set("renderFrame", Napi::Function::New(env, RenderFrame));
-  exports.Set("destroy", Napi::Function::New(env, Destroy));
+  exports.Set("getProperty", Napi::Function::New(env, Forward<&Player::GetProperty>));
+  exports.Set("command", Napi::Function::New(env, Forward<&Player::Command>));
+  exports.Set("commandBatch", Napi::Function::New(env, Forward<&Player::CommandBatch>));
+  exports.Set("setProperties", Napi::Function::New(env, Forward<&Player::SetProperties>));
+  exports.Set("renderFrame", Napi::Function::New(env, Forward<&Player::RenderFrame>));
+  exports.Set("renderFrameShared", Napi::Function::New(env, Forward<&Player::RenderFrameShared>));
+  exports.Set("setHwdec", Napi::Function::New(env, Forward<&Player::SetHwdec>));
+  exports.Set("getDecoder", Napi::Function::New(env, Forward<&Player::GetDecoder>));
+  exports.Set("setCacheProfile", Napi::Function::New(env, Forward<&Player::SetCacheProfile>));
+  exports.Set("getCacheProfile", Napi::Function::New(env, Forward<&Player::GetCacheProfile>));
+  exports.Set("setDecodeProfile", Napi::Function::New(env, Forward<&Player::SetDecodeProfile>));
+  exports.Set("getRenderApi", Napi::Function::New(env, GetRenderApi));
+  exports.Set("hasNewFrame", Napi::Function::New(env, HasNewFrame));
+  exports.Set("startRenderThread", Napi::Function::New(env, Forward<&Player::StartRenderThread>));
+  exports.Set("resizeRenderThread", Napi::Function::New(env, Forward<&Player::ResizeRenderThread>));
+  exports.Set("acquireFrame", Napi::Function::New(env, AcquireFrame));
+  exports.Set("stopRenderThread", Napi::Function::New(env, StopRenderThread));
+  exports.Set("setFrameFormat", Napi::Function::New(env, Forward<&Player::SetFrameFormat>));
+  exports.Set("getFrameSize", Napi::Function::New(env, GetFrameSize));
+  exports.Set("reportSwap", Napi::Function::New(env, Forward<&Player::ReportSwap>));
+  exports.Set("getFrameTiming", Napi::Function::New(env, Forward<&Player::GetFrameTiming>));
+  exports.Set("getStats", Napi::Function::New(env, Forward<&Player::GetStats>));
+  exports.Set("resetStats", Napi::Function::New(env, Forward<&Player::ResetStats>));
+  exports.Set("setStatsCallback", Napi::Function::New(env, Forward<&Player::SetStatsCallback>));
+  exports.Set("setFrameCallback", Napi::Function::New(env, Forward<&Player::SetFrameCallback>));
+  exports.Set("observeProperty", Napi::Function::New(env, Forward<&Player::ObserveProperty>));
+  exports.Set("unobserveProperty", Napi::Function::New(env, Forward<&Player::UnobserveProperty>));
+  exports.Set("setPropertyCallback", Napi::Function::New(env, Forward<&Player::SetPropertyCallback>));
+  exports.Set("loadFileAsync", Napi::Function::New(env, LoadFileAsync));
+  exports.Set("commandAsync", Napi::Function::New(env, Forward<&Player::CommandAsync>));
+  exports.Set("getPropertyAsync", Napi::Function::New(env, Forward<&Player::GetPropertyAsync>));
+  exports.Set("setPropertyAsync", Napi::Function::New(env, Forward<&Player::SetPropertyAsync>));
+  exports.Set("setMemoryBudget", Napi::Function::New(env, SetMemoryBudget));
+  exports.Set("getMemoryUsage", Napi::Function::New(env, GetMemoryUsage));
+  exports.Set("trimMemory", Napi::Function::New(env, TrimMemory));
+  exports.Set("destroy", Napi::Function::New(env, DestroyPlayer));
   return exports;
 }
 
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <napi.h>
+#include <memory>
+#include <string>
+
+#include "memory_budget.h"
+
+// Per-environment state shared by the module's classes, stored with
+// env.SetInstanceData. The module-level functions predate the Player class
+// and drive a single default instance created by createPlayer().
+struct AddonData {
+  Napi::FunctionReference player_ctor;
+  Napi::ObjectReference default_player;
+  // Options the default player was created with; preloadFile() creates its
+  // standby player from them. The standby holds `standby_path` paused until
+  // loadFile() asks for that path and the two players swap roles.
+  Napi::ObjectReference default_options;
+  Napi::ObjectReference standby_player;
+  std::string standby_path;
+  // Shared with every Player, PlayerPool and ThumbnailCache of this env.
+  std::shared_ptr<MemoryBudget> memory = std::make_shared<MemoryBudget>();
+  // Reports the standby as idle and shuts it down under memory pressure.
+  std::unique_ptr<MemoryOwner> standby_memory;
+};
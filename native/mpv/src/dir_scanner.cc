@@ -0,0 +1,345 @@
+#include "dir_scanner.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "path_util.h"
+
+namespace {
+
+constexpr unsigned kMaxScanThreads = 64;
+
+Napi::Object ScanEntryToJs(Napi::Env env, const ScanEntry& entry) {
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("path", Napi::String::New(env, entry.path));
+  out.Set("name", Napi::String::New(env, entry.file.name));
+  out.Set("size", Napi::Number::New(env, static_cast<double>(entry.file.size)));
+  out.Set("mtimeMs", Napi::Number::New(env, static_cast<double>(entry.file.mtime_ms)));
+  return out;
+}
+
+Napi::Array ScanEntriesToJs(Napi::Env env, const std::vector<ScanEntry>& entries) {
+  Napi::Array out = Napi::Array::New(env, entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) out.Set(static_cast<uint32_t>(i), ScanEntryToJs(env, entries[i]));
+  return out;
+}
+
+void FlushBatch(const std::shared_ptr<ScanJob>& job, std::vector<ScanEntry>* batch) {
+  if (batch->empty()) return;
+  auto* entries = new std::vector<ScanEntry>(std::move(*batch));
+  batch->clear();
+  napi_status status = job->tsfn.NonBlockingCall(entries, [job](Napi::Env env, Napi::Function callback, std::vector<ScanEntry>* data) {
+    std::unique_ptr<std::vector<ScanEntry>> owned(data);
+    if (job->cancelled.load()) return;
+    callback.Call({ ScanEntriesToJs(env, *owned) });
+  });
+  if (status != napi_ok) delete entries;
+}
+
+// Diff of one freshly listed directory against its previous listing.
+void DiffListing(ScanJob& job, const std::string& dir, const DirListing* old, const DirListing& listing) {
+  std::unordered_map<std::string, const ScannedFile*> before;
+  if (old) {
+    for (const ScannedFile& file : old->files) before.emplace(file.name, &file);
+  }
+  std::vector<ScanEntry> added;
+  std::vector<ScanEntry> changed;
+  for (const ScannedFile& file : listing.files) {
+    auto it = before.find(file.name);
+    if (it == before.end()) {
+      added.push_back({ JoinPath(dir, file.name), file });
+      continue;
+    }
+    if (it->second->size != file.size || it->second->mtime_ms != file.mtime_ms) {
+      changed.push_back({ JoinPath(dir, file.name), file });
+    }
+    before.erase(it);
+  }
+
+  std::lock_guard<std::mutex> lock(job.mutex);
+  for (auto& entry : added) job.added.push_back(std::move(entry));
+  for (auto& entry : changed) job.changed.push_back(std::move(entry));
+  for (const auto& gone : before) job.removed.push_back(JoinPath(dir, gone.first));
+}
+
+// Overwriting a file in place moves its own size and mtime but not its
+// directory's, so the files of a reused listing are stat'ed again; that is one
+// stat per matching file rather than a full re-list.
+void RestatListing(ScanJob& job, const std::string& dir, DirListing* listing) {
+  std::vector<ScanEntry> changed;
+  std::vector<std::string> removed;
+  std::vector<ScannedFile>& files = listing->files;
+  size_t kept = 0;
+  for (size_t i = 0; i < files.size(); ++i) {
+    ScannedFile& file = files[i];
+    std::string path = JoinPath(dir, file.name);
+    uint64_t size = 0;
+    int64_t mtime_ms = 0;
+    if (StatPath(path, &size, &mtime_ms) != PathKind::kFile) {
+      removed.push_back(std::move(path));
+      continue;
+    }
+    if (size != file.size || mtime_ms != file.mtime_ms) {
+      file.size = size;
+      file.mtime_ms = mtime_ms;
+      changed.push_back({ std::move(path), file });
+    }
+    if (kept != i) files[kept] = std::move(file);
+    kept++;
+  }
+  files.resize(kept);
+  if (changed.empty() && removed.empty()) return;
+
+  std::lock_guard<std::mutex> lock(job.mutex);
+  for (auto& entry : changed) job.changed.push_back(std::move(entry));
+  for (auto& path : removed) job.removed.push_back(std::move(path));
+}
+
+void ScanDirectory(ScanJob& job, const std::string& dir, std::vector<ScanEntry>* batch) {
+  const DirListing* old = nullptr;
+  if (job.previous) {
+    auto it = job.previous->find(dir);
+    if (it != job.previous->end()) old = &it->second;
+  }
+
+  DirListing listing;
+  bool reused = false;
+  bool failed = false;
+  int64_t mtime_ms = 0;
+  if (old && job.reuse_unchanged && DirectoryMtime(dir, &mtime_ms) && mtime_ms == old->mtime_ms) {
+    listing = *old;
+    reused = true;
+    RestatListing(job, dir, &listing);
+  } else if (!ListDirectory(dir, job.extensions, &listing)) {
+    // An unreachable share keeps its last listing instead of looking deleted.
+    failed = true;
+    if (!old) {
+      std::lock_guard<std::mutex> lock(job.mutex);
+      job.errors++;
+      return;
+    }
+    listing = *old;
+  }
+
+  for (const ScannedFile& file : listing.files) batch->push_back({ JoinPath(dir, file.name), file });
+  if (job.previous && !reused && !failed) DiffListing(job, dir, old, listing);
+
+  {
+    std::lock_guard<std::mutex> lock(job.mutex);
+    for (const std::string& sub : listing.subdirs) {
+      job.queue.push_back(JoinPath(dir, sub));
+      job.pending++;
+    }
+    job.files += listing.files.size();
+    if (reused) job.reused++;
+    if (failed) job.errors++;
+    job.next.emplace(dir, std::move(listing));
+  }
+  job.cv.notify_all();
+}
+
+// Files under directories the new scan never reached have been removed.
+void CollectRemovedDirectories(ScanJob& job) {
+  if (!job.previous) return;
+  for (const auto& dir : *job.previous) {
+    if (job.next.count(dir.first)) continue;
+    for (const ScannedFile& file : dir.second.files) job.removed.push_back(JoinPath(dir.first, file.name));
+  }
+}
+
+void Finish(const std::shared_ptr<ScanJob>& job, const std::shared_ptr<ScannerState>& state) {
+  if (!job->cancelled.load()) CollectRemovedDirectories(*job);
+  job->tsfn.NonBlockingCall([job, state](Napi::Env env, Napi::Function) {
+    for (std::thread& thread : job->threads) {
+      if (thread.joinable()) thread.join();
+    }
+    if (state->active == job) state->active.reset();
+    if (job->cancelled.load()) {
+      job->deferred.Reject(Napi::Error::New(env, "cancelled").Value());
+      return;
+    }
+
+    const bool incremental = job->previous != nullptr;
+    const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job->started).count();
+    Napi::Object out = Napi::Object::New(env);
+    out.Set("files", Napi::Number::New(env, static_cast<double>(job->files)));
+    out.Set("directories", Napi::Number::New(env, static_cast<double>(job->next.size())));
+    out.Set("reusedDirectories", Napi::Number::New(env, static_cast<double>(job->reused)));
+    out.Set("errors", Napi::Number::New(env, static_cast<double>(job->errors)));
+    out.Set("elapsedMs", Napi::Number::New(env, elapsed));
+    out.Set("incremental", Napi::Boolean::New(env, incremental));
+    out.Set("added", ScanEntriesToJs(env, job->added));
+    out.Set("changed", ScanEntriesToJs(env, job->changed));
+    Napi::Array removed = Napi::Array::New(env, job->removed.size());
+    for (size_t i = 0; i < job->removed.size(); ++i) removed.Set(static_cast<uint32_t>(i), Napi::String::New(env, job->removed[i]));
+    out.Set("removed", removed);
+
+    state->snapshot = std::make_shared<const ScanSnapshot>(std::move(job->next));
+    job->deferred.Resolve(out);
+  });
+  job->tsfn.Release();
+}
+
+void ScanWorker(std::shared_ptr<ScanJob> job, std::shared_ptr<ScannerState> state) {
+  std::vector<ScanEntry> batch;
+  for (;;) {
+    std::string dir;
+    {
+      std::unique_lock<std::mutex> lock(job->mutex);
+      job->cv.wait(lock, [&] { return job->cancelled.load() || !job->queue.empty() || job->pending == 0; });
+      if (job->cancelled.load() || job->queue.empty()) break;
+      dir = std::move(job->queue.front());
+      job->queue.pop_front();
+    }
+    ScanDirectory(*job, dir, &batch);
+    if (batch.size() >= job->batch_size) FlushBatch(job, &batch);
+    {
+      std::lock_guard<std::mutex> lock(job->mutex);
+      if (--job->pending == 0) job->cv.notify_all();
+    }
+  }
+  FlushBatch(job, &batch);
+  if (--job->live == 0) Finish(job, state);
+}
+
+} // namespace
+
+Napi::Function DirectoryScanner::Define(Napi::Env env) {
+  return DefineClass(env, "DirectoryScanner", {
+    InstanceMethod("scan", &DirectoryScanner::Scan),
+    InstanceMethod("cancel", &DirectoryScanner::Cancel),
+    InstanceMethod("reset", &DirectoryScanner::Reset),
+    InstanceMethod("directories", &DirectoryScanner::Directories),
+  });
+}
+
+// new DirectoryScanner({ threads }). Listing is I/O bound (network shares in
+// particular), so the default runs more threads than there are cores.
+DirectoryScanner::DirectoryScanner(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<DirectoryScanner>(info) {
+  Napi::Env env = info.Env();
+  env_ = env;
+  threads_ = std::max(4u, std::min(std::thread::hardware_concurrency() * 2, 16u));
+  if (info.Length() > 0 && info[0].IsObject()) {
+    Napi::Value count = info[0].As<Napi::Object>().Get("threads");
+    if (count.IsNumber()) {
+      int requested = count.As<Napi::Number>().Int32Value();
+      if (requested < 1 || requested > static_cast<int>(kMaxScanThreads)) {
+        Napi::Error::New(env, "invalid_threads").ThrowAsJavaScriptException();
+        return;
+      }
+      threads_ = static_cast<unsigned>(requested);
+    }
+  }
+  napi_add_env_cleanup_hook(env, &DirectoryScanner::OnEnvCleanup, this);
+  cleanup_hook_ = true;
+}
+
+DirectoryScanner::~DirectoryScanner() {
+  Shutdown();
+}
+
+void DirectoryScanner::OnEnvCleanup(void* ctx) {
+  auto* self = static_cast<DirectoryScanner*>(ctx);
+  self->cleanup_hook_ = false;
+  self->Shutdown();
+}
+
+void DirectoryScanner::Shutdown() {
+  if (cleanup_hook_) {
+    napi_remove_env_cleanup_hook(env_, &DirectoryScanner::OnEnvCleanup, this);
+    cleanup_hook_ = false;
+  }
+  std::shared_ptr<ScanJob> job = state_->active;
+  if (!job) return;
+  {
+    std::lock_guard<std::mutex> lock(job->mutex);
+    job->cancelled.store(true);
+  }
+  job->cv.notify_all();
+  for (std::thread& thread : job->threads) {
+    if (thread.joinable()) thread.join();
+  }
+}
+
+// scan(roots, { extensions, batchSize, full }, onBatch) -> Promise<summary>.
+// onBatch receives arrays of { path, name, size, mtimeMs }. After the first
+// scan the summary lists added/changed/removed files; `full` re-lists every
+// directory instead of trusting unchanged mtimes.
+Napi::Value DirectoryScanner::Scan(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    Napi::Error::New(env, "missing_roots").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (state_->active) {
+    Napi::Error::New(env, "scan_in_progress").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  auto job = std::make_shared<ScanJob>(env);
+  Napi::Array roots = info[0].As<Napi::Array>();
+  for (uint32_t i = 0; i < roots.Length(); ++i) {
+    Napi::Value root = roots.Get(i);
+    if (root.IsString()) job->queue.push_back(root.As<Napi::String>().Utf8Value());
+  }
+  if (info.Length() > 1 && info[1].IsObject()) {
+    Napi::Object options = info[1].As<Napi::Object>();
+    Napi::Value extensions = options.Get("extensions");
+    if (extensions.IsArray()) {
+      Napi::Array list = extensions.As<Napi::Array>();
+      for (uint32_t i = 0; i < list.Length(); ++i) {
+        Napi::Value ext = list.Get(i);
+        if (!ext.IsString()) continue;
+        std::string value = ext.As<Napi::String>().Utf8Value();
+        std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        job->extensions.insert(std::move(value));
+      }
+    }
+    Napi::Value batch = options.Get("batchSize");
+    if (batch.IsNumber()) job->batch_size = static_cast<size_t>(std::max(1, batch.As<Napi::Number>().Int32Value()));
+    Napi::Value full = options.Get("full");
+    if (full.IsBoolean()) job->reuse_unchanged = !full.As<Napi::Boolean>().Value();
+  }
+
+  Napi::Function callback = info.Length() > 2 && info[2].IsFunction()
+    ? info[2].As<Napi::Function>()
+    : Napi::Function::New(env, [](const Napi::CallbackInfo&) {});
+  job->tsfn = Napi::ThreadSafeFunction::New(env, callback, "mpvDirectoryScan", 0, 1);
+  job->previous = state_->snapshot;
+  job->pending = job->queue.size();
+  job->started = std::chrono::steady_clock::now();
+  job->live = static_cast<int>(threads_);
+  state_->active = job;
+
+  for (unsigned i = 0; i < threads_; ++i) job->threads.emplace_back(ScanWorker, job, state_);
+  return job->deferred.Promise();
+}
+
+Napi::Value DirectoryScanner::Cancel(const Napi::CallbackInfo& info) {
+  std::shared_ptr<ScanJob> job = state_->active;
+  if (!job) return Napi::Boolean::New(info.Env(), false);
+  {
+    std::lock_guard<std::mutex> lock(job->mutex);
+    job->cancelled.store(true);
+  }
+  job->cv.notify_all();
+  return Napi::Boolean::New(info.Env(), true);
+}
+
+// Drops the snapshot so the next scan starts from scratch.
+Napi::Value DirectoryScanner::Reset(const Napi::CallbackInfo& info) {
+  state_->snapshot.reset();
+  return Napi::Boolean::New(info.Env(), true);
+}
+
+// Every directory the last completed scan listed, to seed a DirectoryWatcher.
+Napi::Value DirectoryScanner::Directories(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::shared_ptr<const ScanSnapshot> snapshot = state_->snapshot;
+  Napi::Array out = Napi::Array::New(env, snapshot ? snapshot->size() : 0);
+  if (!snapshot) return out;
+  uint32_t i = 0;
+  for (const auto& dir : *snapshot) out.Set(i++, Napi::String::New(env, dir.first));
+  return out;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "dir_walker.h"
+
+// Listing of every directory seen by the last completed scan.
+using ScanSnapshot = std::unordered_map<std::string, DirListing>;
+
+struct ScanEntry {
+  std::string path;
+  ScannedFile file;
+};
+
+// One scan in flight. Workers pull directories from a shared queue and push
+// the subdirectories they find; the scan ends when nothing is queued or being
+// listed. Shared with queued JS calls so it outlives a collected scanner.
+struct ScanJob {
+  explicit ScanJob(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {}
+
+  Napi::Promise::Deferred deferred;
+  Napi::ThreadSafeFunction tsfn;
+  ExtensionSet extensions;
+  size_t batch_size = 512;
+  // Reuse the previous listing of directories whose mtime is unchanged; its
+  // files are still stat'ed to catch in-place overwrites.
+  bool reuse_unchanged = true;
+  std::shared_ptr<const ScanSnapshot> previous;
+  std::chrono::steady_clock::time_point started;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::string> queue;
+  size_t pending = 0;
+  std::atomic<bool> cancelled{false};
+  std::vector<std::thread> threads;
+  std::atomic<int> live{0};
+
+  // Merged under `mutex`.
+  ScanSnapshot next;
+  std::vector<ScanEntry> added;
+  std::vector<ScanEntry> changed;
+  std::vector<std::string> removed;
+  uint64_t files = 0;
+  uint64_t reused = 0;
+  uint64_t errors = 0;
+};
+
+// Snapshot and active job, shared with the completion call that installs the
+// new snapshot.
+struct ScannerState {
+  std::shared_ptr<const ScanSnapshot> snapshot;
+  std::shared_ptr<ScanJob> active;
+};
+
+// Multi-threaded recursive directory scan. Matching files are streamed to JS in
+// batches; a rescan compares against the previous snapshot, skips re-listing
+// directories whose mtime has not moved (re-stat'ing their files instead), and
+// reports what was added, changed or removed.
+class DirectoryScanner : public Napi::ObjectWrap<DirectoryScanner> {
+ public:
+  static Napi::Function Define(Napi::Env env);
+
+  explicit DirectoryScanner(const Napi::CallbackInfo& info);
+  ~DirectoryScanner() override;
+
+  Napi::Value Scan(const Napi::CallbackInfo& info);
+  Napi::Value Cancel(const Napi::CallbackInfo& info);
+  Napi::Value Reset(const Napi::CallbackInfo& info);
+  Napi::Value Directories(const Napi::CallbackInfo& info);
+
+ private:
+  static void OnEnvCleanup(void* ctx);
+
+  void Shutdown();
+
+  napi_env env_ = nullptr;
+  bool cleanup_hook_ = false;
+  unsigned threads_ = 4;
+  std::shared_ptr<ScannerState> state_ = std::make_shared<ScannerState>();
+};
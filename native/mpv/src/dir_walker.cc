@@ -0,0 +1,158 @@
+#include "dir_walker.h"
+
+#include <algorithm>
+#include <cctype>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "path_util.h"
+
+bool MatchesExtension(const std::string& name, const ExtensionSet& extensions) {
+  if (extensions.empty()) return true;
+  size_t dot = name.rfind('.');
+  if (dot == std::string::npos) return false;
+  std::string ext = name.substr(dot);
+  std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return extensions.count(ext) > 0;
+}
+
+namespace {
+
+#if defined(_WIN32)
+// FILETIME counts 100ns ticks since 1601.
+int64_t FiletimeToMs(const FILETIME& time) {
+  ULARGE_INTEGER ticks;
+  ticks.LowPart = time.dwLowDateTime;
+  ticks.HighPart = time.dwHighDateTime;
+  return static_cast<int64_t>((ticks.QuadPart - 116444736000000000ull) / 10000);
+}
+#else
+int64_t StatMtimeMs(const struct stat& st) {
+#if defined(__APPLE__)
+  return static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000 + st.st_mtimespec.tv_nsec / 1000000;
+#else
+  return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+#endif
+}
+#endif
+
+} // namespace
+
+#if defined(_WIN32)
+
+PathKind StatPath(const std::string& path, uint64_t* size, int64_t* mtime_ms) {
+  WIN32_FILE_ATTRIBUTE_DATA data;
+  if (!GetFileAttributesExW(Widen(path).c_str(), GetFileExInfoStandard, &data)) return PathKind::kMissing;
+  if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) return PathKind::kOther;
+  *mtime_ms = FiletimeToMs(data.ftLastWriteTime);
+  if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) return PathKind::kDirectory;
+  *size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+  return PathKind::kFile;
+}
+
+bool DirectoryMtime(const std::string& dir, int64_t* mtime_ms) {
+  WIN32_FILE_ATTRIBUTE_DATA data;
+  if (!GetFileAttributesExW(Widen(dir).c_str(), GetFileExInfoStandard, &data)) return false;
+  *mtime_ms = FiletimeToMs(data.ftLastWriteTime);
+  return true;
+}
+
+bool ListDirectory(const std::string& dir, const ExtensionSet& extensions, DirListing* out) {
+  if (!DirectoryMtime(dir, &out->mtime_ms)) return false;
+  WIN32_FIND_DATAW data;
+  HANDLE find = FindFirstFileExW(Widen(JoinPath(dir, "*")).c_str(), FindExInfoBasic, &data,
+                                 FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+  if (find == INVALID_HANDLE_VALUE) return GetLastError() == ERROR_FILE_NOT_FOUND;
+  do {
+    const wchar_t* name = data.cFileName;
+    if (name[0] == L'.' && (name[1] == 0 || (name[1] == L'.' && name[2] == 0))) continue;
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) continue;
+    std::string utf8 = Narrow(name, wcslen(name));
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+      out->subdirs.push_back(std::move(utf8));
+      continue;
+    }
+    if (!MatchesExtension(utf8, extensions)) continue;
+    ScannedFile file;
+    file.name = std::move(utf8);
+    file.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    file.mtime_ms = FiletimeToMs(data.ftLastWriteTime);
+    out->files.push_back(std::move(file));
+  } while (FindNextFileW(find, &data));
+  FindClose(find);
+  return true;
+}
+
+#else
+
+PathKind StatPath(const std::string& path, uint64_t* size, int64_t* mtime_ms) {
+  struct stat st;
+  if (lstat(path.c_str(), &st) != 0) return PathKind::kMissing;
+  *mtime_ms = StatMtimeMs(st);
+  if (S_ISDIR(st.st_mode)) return PathKind::kDirectory;
+  if (!S_ISREG(st.st_mode)) return PathKind::kOther;
+  *size = static_cast<uint64_t>(st.st_size);
+  return PathKind::kFile;
+}
+
+bool DirectoryMtime(const std::string& dir, int64_t* mtime_ms) {
+  struct stat st;
+  if (stat(dir.c_str(), &st) != 0) return false;
+  *mtime_ms = StatMtimeMs(st);
+  return true;
+}
+
+bool ListDirectory(const std::string& dir, const ExtensionSet& extensions, DirListing* out) {
+  int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  out->mtime_ms = StatMtimeMs(st);
+
+  DIR* handle = fdopendir(fd);
+  if (!handle) {
+    close(fd);
+    return false;
+  }
+  while (dirent* entry = readdir(handle)) {
+    const char* name = entry->d_name;
+    if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0))) continue;
+    unsigned char type = entry->d_type;
+    if (type == DT_LNK) continue;
+    if (type == DT_DIR) {
+      out->subdirs.emplace_back(name);
+      continue;
+    }
+    if (type != DT_REG && type != DT_UNKNOWN) continue;
+    // Directories only show up here on filesystems without d_type.
+    bool maybe_dir = type == DT_UNKNOWN;
+    if (!maybe_dir && !MatchesExtension(name, extensions)) continue;
+
+    struct stat file_st;
+    if (fstatat(fd, name, &file_st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+    if (S_ISDIR(file_st.st_mode)) {
+      out->subdirs.emplace_back(name);
+      continue;
+    }
+    if (!S_ISREG(file_st.st_mode) || !MatchesExtension(name, extensions)) continue;
+    ScannedFile file;
+    file.name = name;
+    file.size = static_cast<uint64_t>(file_st.st_size);
+    file.mtime_ms = StatMtimeMs(file_st);
+    out->files.push_back(std::move(file));
+  }
+  closedir(handle);
+  return true;
+}
+
+#endif
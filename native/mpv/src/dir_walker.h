@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+struct ScannedFile {
+  std::string name;
+  uint64_t size = 0;
+  int64_t mtime_ms = 0;
+};
+
+// One directory level: matching files plus subdirectories to descend into.
+// Symlinks are skipped, like fs.readdir's isFile()/isDirectory().
+struct DirListing {
+  int64_t mtime_ms = 0;
+  std::vector<ScannedFile> files;
+  std::vector<std::string> subdirs;
+};
+
+// Lower-cased extensions including the dot (".mp4"); empty matches all.
+using ExtensionSet = std::unordered_set<std::string>;
+
+// Lists `dir` in as few syscalls as the platform allows: FindFirstFileEx with
+// large fetch returns size and mtime with each name on Windows; elsewhere
+// readdir batches getdents and only matching files get an fstatat.
+bool ListDirectory(const std::string& dir, const ExtensionSet& extensions, DirListing* out);
+
+// Directory mtime, which changes whenever an entry is added or removed.
+bool DirectoryMtime(const std::string& dir, int64_t* mtime_ms);
+
+enum class PathKind { kMissing, kFile, kDirectory, kOther };
+
+// lstat-style: symlinks report kOther.
+PathKind StatPath(const std::string& path, uint64_t* size, int64_t* mtime_ms);
+
+bool MatchesExtension(const std::string& name, const ExtensionSet& extensions);
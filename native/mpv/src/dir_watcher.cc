@@ -0,0 +1,177 @@
+#include "dir_watcher.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+constexpr int kDefaultDebounceMs = 500;
+constexpr int kMaxDebounceMs = 60000;
+
+const char* ChangeTypeName(FsChange::Type type) {
+  switch (type) {
+    case FsChange::kAdd: return "add";
+    case FsChange::kRemove: return "remove";
+    case FsChange::kModify: return "modify";
+    case FsChange::kRescan: return "rescan";
+  }
+  return "modify";
+}
+
+Napi::Array ChangesToJs(Napi::Env env, const std::vector<FsChange>& changes) {
+  Napi::Array out = Napi::Array::New(env, changes.size());
+  for (size_t i = 0; i < changes.size(); ++i) {
+    const FsChange& change = changes[i];
+    Napi::Object item = Napi::Object::New(env);
+    item.Set("type", Napi::String::New(env, ChangeTypeName(change.type)));
+    if (change.type != FsChange::kRescan) item.Set("path", Napi::String::New(env, change.path));
+    if (change.type == FsChange::kAdd || change.type == FsChange::kModify) {
+      item.Set("size", Napi::Number::New(env, static_cast<double>(change.size)));
+      item.Set("mtimeMs", Napi::Number::New(env, static_cast<double>(change.mtime_ms)));
+    }
+    out.Set(static_cast<uint32_t>(i), item);
+  }
+  return out;
+}
+
+std::vector<std::string> StringList(Napi::Value value) {
+  std::vector<std::string> out;
+  if (!value.IsArray()) return out;
+  Napi::Array list = value.As<Napi::Array>();
+  for (uint32_t i = 0; i < list.Length(); ++i) {
+    Napi::Value item = list.Get(i);
+    if (item.IsString()) out.push_back(item.As<Napi::String>().Utf8Value());
+  }
+  return out;
+}
+
+void Deliver(const std::shared_ptr<WatchSession>& session, std::vector<FsChange> changes) {
+  if (session->closed.load()) return;
+  session->batches++;
+  session->changes += changes.size();
+  for (const FsChange& change : changes) {
+    if (change.type == FsChange::kRescan) session->rescans++;
+  }
+  auto* data = new std::vector<FsChange>(std::move(changes));
+  napi_status status = session->tsfn.NonBlockingCall(data, [session](Napi::Env env, Napi::Function callback, std::vector<FsChange>* batch) {
+    std::unique_ptr<std::vector<FsChange>> owned(batch);
+    if (session->closed.load()) return;
+    callback.Call({ ChangesToJs(env, *owned) });
+  });
+  if (status != napi_ok) delete data;
+}
+
+} // namespace
+
+Napi::Function DirectoryWatcher::Define(Napi::Env env) {
+  return DefineClass(env, "DirectoryWatcher", {
+    InstanceMethod("watch", &DirectoryWatcher::Watch),
+    InstanceMethod("close", &DirectoryWatcher::Close),
+    InstanceMethod("stats", &DirectoryWatcher::Stats),
+  });
+}
+
+DirectoryWatcher::DirectoryWatcher(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<DirectoryWatcher>(info) {
+  env_ = info.Env();
+  napi_add_env_cleanup_hook(env_, &DirectoryWatcher::OnEnvCleanup, this);
+  cleanup_hook_ = true;
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+  Shutdown();
+}
+
+void DirectoryWatcher::OnEnvCleanup(void* ctx) {
+  auto* self = static_cast<DirectoryWatcher*>(ctx);
+  self->cleanup_hook_ = false;
+  self->Shutdown();
+}
+
+void DirectoryWatcher::Shutdown() {
+  if (cleanup_hook_) {
+    napi_remove_env_cleanup_hook(env_, &DirectoryWatcher::OnEnvCleanup, this);
+    cleanup_hook_ = false;
+  }
+  StopSession();
+}
+
+// Stopping joins the flush thread, so nothing is delivered after the release.
+void DirectoryWatcher::StopSession() {
+  watcher_.Stop();
+  if (!session_) return;
+  session_->closed.store(true);
+  session_->tsfn.Release();
+  session_.reset();
+}
+
+// watch(roots, { extensions, debounceMs, directories }, onChanges) -> true.
+// Replaces any previous watch. onChanges receives arrays of
+// { type: 'add' | 'modify', path, size, mtimeMs }, { type: 'remove', path }
+// (which may name a directory) or { type: 'rescan' } after lost events.
+// `directories` is the full directory list from a scan, which spares inotify a
+// second walk of the tree.
+Napi::Value DirectoryWatcher::Watch(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    Napi::Error::New(env, "missing_roots").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 3 || !info[2].IsFunction()) {
+    Napi::Error::New(env, "missing_callback").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::vector<std::string> roots = StringList(info[0]);
+  std::vector<std::string> directories;
+  ExtensionSet extensions;
+  int debounce_ms = kDefaultDebounceMs;
+  if (info[1].IsObject()) {
+    Napi::Object options = info[1].As<Napi::Object>();
+    for (std::string ext : StringList(options.Get("extensions"))) {
+      std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+      extensions.insert(std::move(ext));
+    }
+    directories = StringList(options.Get("directories"));
+    Napi::Value debounce = options.Get("debounceMs");
+    if (debounce.IsNumber()) debounce_ms = std::clamp(debounce.As<Napi::Number>().Int32Value(), 0, kMaxDebounceMs);
+  }
+  if (roots.empty()) {
+    Napi::Error::New(env, "missing_roots").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  StopSession();
+  auto session = std::make_shared<WatchSession>();
+  session->tsfn = Napi::ThreadSafeFunction::New(env, info[2].As<Napi::Function>(), "mpvDirectoryWatch", 0, 1);
+  // A watcher alone should not keep the process alive.
+  session->tsfn.Unref(env);
+
+  std::string err;
+  auto deliver = [session](std::vector<FsChange> changes) { Deliver(session, std::move(changes)); };
+  if (!watcher_.Start(roots, directories, extensions, debounce_ms, deliver, &err)) {
+    session->closed.store(true);
+    session->tsfn.Release();
+    Napi::Error::New(env, err.empty() ? "watch_failed" : err).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  session_ = session;
+  return Napi::Boolean::New(env, true);
+}
+
+Napi::Value DirectoryWatcher::Close(const Napi::CallbackInfo& info) {
+  StopSession();
+  return Napi::Boolean::New(info.Env(), true);
+}
+
+// { watching, watches, batches, changes, rescans }
+Napi::Value DirectoryWatcher::Stats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("watching", Napi::Boolean::New(env, session_ != nullptr));
+  out.Set("watches", Napi::Number::New(env, static_cast<double>(watcher_.watch_count())));
+  out.Set("batches", Napi::Number::New(env, session_ ? static_cast<double>(session_->batches.load()) : 0.0));
+  out.Set("changes", Napi::Number::New(env, session_ ? static_cast<double>(session_->changes.load()) : 0.0));
+  out.Set("rescans", Napi::Number::New(env, session_ ? static_cast<double>(session_->rescans.load()) : 0.0));
+  return out;
+}
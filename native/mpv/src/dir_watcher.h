@@ -0,0 +1,42 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <memory>
+
+#include "fs_watcher.h"
+
+// State shared with queued change batches so they can be dropped once the
+// watcher is closed or collected.
+struct WatchSession {
+  Napi::ThreadSafeFunction tsfn;
+  std::atomic<bool> closed{false};
+  std::atomic<uint64_t> batches{0};
+  std::atomic<uint64_t> changes{0};
+  std::atomic<uint64_t> rescans{0};
+};
+
+// Keeps a library in sync without rescanning: filesystem notifications are
+// coalesced natively and delivered to JS as batches of add/remove/modify.
+class DirectoryWatcher : public Napi::ObjectWrap<DirectoryWatcher> {
+ public:
+  static Napi::Function Define(Napi::Env env);
+
+  explicit DirectoryWatcher(const Napi::CallbackInfo& info);
+  ~DirectoryWatcher() override;
+
+  Napi::Value Watch(const Napi::CallbackInfo& info);
+  Napi::Value Close(const Napi::CallbackInfo& info);
+  Napi::Value Stats(const Napi::CallbackInfo& info);
+
+ private:
+  static void OnEnvCleanup(void* ctx);
+
+  void Shutdown();
+  void StopSession();
+
+  napi_env env_ = nullptr;
+  bool cleanup_hook_ = false;
+  FsWatcher watcher_;
+  std::shared_ptr<WatchSession> session_;
+};
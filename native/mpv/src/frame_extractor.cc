@@ -0,0 +1,330 @@
+#include "frame_extractor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+double NowSeconds() {
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Keeps a sheet within a few MB of BGRA at thumbnail tile sizes.
+constexpr int kMaxSpriteTiles = 400;
+
+// Whole-sheet budget on top of the per-tile timeout, so a file that seeks
+// slowly cannot hold a worker for tiles x timeout.
+constexpr double kSpriteTimeoutSeconds = 30.0;
+
+// mpv's SW renderer prefers 64-byte aligned rows.
+size_t AlignedStride(int width) {
+  return (static_cast<size_t>(width) * 4 + 63) & ~static_cast<size_t>(63);
+}
+
+// Fits the source into the requested box, keeping the aspect ratio and never
+// upscaling; a missing dimension follows from the other one.
+void FitSize(int64_t src_w, int64_t src_h, int max_w, int max_h, int* out_w, int* out_h) {
+  double scale = 1.0;
+  if (max_w > 0 && max_h > 0) {
+    scale = std::min(static_cast<double>(max_w) / src_w, static_cast<double>(max_h) / src_h);
+  } else if (max_w > 0) {
+    scale = static_cast<double>(max_w) / src_w;
+  } else if (max_h > 0) {
+    scale = static_cast<double>(max_h) / src_h;
+  }
+  scale = std::min(scale, 1.0);
+  *out_w = std::max(1, static_cast<int>(std::lround(src_w * scale)));
+  *out_h = std::max(1, static_cast<int>(std::lround(src_h * scale)));
+}
+
+} // namespace
+
+FrameExtractor::~FrameExtractor() {
+  Close();
+}
+
+bool FrameExtractor::Open(const std::string& hwdec, std::string* err) {
+  if (handle_) return true;
+  handle_ = g_api.mpv_create();
+  if (!handle_) {
+    if (err) *err = "mpv_create_failed";
+    return false;
+  }
+
+  // Decode-only setup: paused, keyframe seeks, nothing that loads extra
+  // files or opens devices.
+  g_api.mpv_set_option_string(handle_, "terminal", "no");
+  g_api.mpv_set_option_string(handle_, "msg-level", "all=error");
+  g_api.mpv_set_option_string(handle_, "vo", "libmpv");
+  g_api.mpv_set_option_string(handle_, "audio", "no");
+  g_api.mpv_set_option_string(handle_, "sid", "no");
+  g_api.mpv_set_option_string(handle_, "pause", "yes");
+  g_api.mpv_set_option_string(handle_, "keep-open", "yes");
+  g_api.mpv_set_option_string(handle_, "hr-seek", "no");
+  g_api.mpv_set_option_string(handle_, "osd-level", "0");
+  g_api.mpv_set_option_string(handle_, "sw-fast", "yes");
+  g_api.mpv_set_option_string(handle_, "ytdl", "no");
+  g_api.mpv_set_option_string(handle_, "load-scripts", "no");
+  g_api.mpv_set_option_string(handle_, "cache", "no");
+  g_api.mpv_set_option_string(handle_, "hwdec", hwdec.c_str());
+
+  if (g_api.mpv_initialize(handle_) < 0) {
+    g_api.mpv_terminate_destroy(handle_);
+    handle_ = nullptr;
+    if (err) *err = "mpv_initialize_failed";
+    return false;
+  }
+
+  mpv_render_param params[] = {
+    { MPV_RENDER_PARAM_API_TYPE, const_cast<char*>(MPV_RENDER_API_TYPE_SW) },
+    { MPV_RENDER_PARAM_INVALID, nullptr }
+  };
+  if (g_api.mpv_render_context_create(&render_ctx_, handle_, params) < 0) {
+    render_ctx_ = nullptr;
+    g_api.mpv_terminate_destroy(handle_);
+    handle_ = nullptr;
+    if (err) *err = "mpv_render_init_failed";
+    return false;
+  }
+  g_api.mpv_render_context_set_update_callback(render_ctx_, &FrameExtractor::OnRenderUpdate, this);
+  return true;
+}
+
+void FrameExtractor::OnRenderUpdate(void* ctx) {
+  static_cast<FrameExtractor*>(ctx)->update_pending_.store(true);
+}
+
+void FrameExtractor::Close() {
+  if (render_ctx_) {
+    g_api.mpv_render_context_free(render_ctx_);
+    render_ctx_ = nullptr;
+  }
+  if (handle_) {
+    g_api.mpv_terminate_destroy(handle_);
+    handle_ = nullptr;
+  }
+}
+
+bool FrameExtractor::Run(const ThumbnailRequest& request, ThumbnailResult* result, const std::atomic<bool>* cancel) {
+  if (!handle_) {
+    result->error = "not_ready";
+    return false;
+  }
+
+  frame_ready_ = false;
+  std::string start = std::to_string(std::max(0.0, request.position));
+  g_api.mpv_set_property_string(handle_, "start", start.c_str());
+  const char* load[] = { "loadfile", request.path.c_str(), nullptr };
+  if (g_api.mpv_command(handle_, load) < 0) {
+    result->error = "load_failed";
+    return false;
+  }
+
+  double deadline = NowSeconds() + request.timeout_ms / 1000.0;
+  bool ok = WaitForFrame(deadline, cancel, &result->error) &&
+            (request.tiles > 0 ? ReadSprite(request, cancel, result) : ReadFrame(request, result));
+
+  const char* stop[] = { "stop", nullptr };
+  g_api.mpv_command(handle_, stop);
+  return ok;
+}
+
+// Waits for the first frame after the (keyframe) seek to reach the render
+// context. Events left over from the previous file precede START_FILE and
+// are ignored.
+bool FrameExtractor::WaitForFrame(double deadline, const std::atomic<bool>* cancel, std::string* error) {
+  bool started = false;
+  bool restarted = false;
+  for (;;) {
+    double remaining = deadline - NowSeconds();
+    if (remaining <= 0) {
+      *error = "timeout";
+      return false;
+    }
+    if (cancel && cancel->load()) {
+      *error = "cancelled";
+      return false;
+    }
+
+    // The render update callback cannot wake mpv_wait_event, so poll briefly.
+    mpv_event* event = g_api.mpv_wait_event(handle_, std::min(remaining, 0.02));
+    switch (event->event_id) {
+      case MPV_EVENT_START_FILE:
+        started = true;
+        break;
+      case MPV_EVENT_END_FILE:
+        if (started) {
+          *error = "decode_failed";
+          return false;
+        }
+        break;
+      case MPV_EVENT_PLAYBACK_RESTART:
+        if (started) restarted = true;
+        break;
+      case MPV_EVENT_SHUTDOWN:
+        *error = "destroyed";
+        return false;
+      default:
+        break;
+    }
+
+    if (update_pending_.exchange(false) &&
+        (g_api.mpv_render_context_update(render_ctx_) & MPV_RENDER_UPDATE_FRAME)) {
+      frame_ready_ = true;
+    }
+    if (restarted && frame_ready_) return true;
+  }
+}
+
+// Keyframe seek within the loaded file: done once playback restarts and the
+// new frame has reached the render context.
+bool FrameExtractor::WaitForSeek(double deadline, const std::atomic<bool>* cancel, std::string* error) {
+  bool restarted = false;
+  frame_ready_ = false;
+  for (;;) {
+    double remaining = deadline - NowSeconds();
+    if (remaining <= 0) {
+      *error = "timeout";
+      return false;
+    }
+    if (cancel && cancel->load()) {
+      *error = "cancelled";
+      return false;
+    }
+
+    mpv_event* event = g_api.mpv_wait_event(handle_, std::min(remaining, 0.02));
+    switch (event->event_id) {
+      case MPV_EVENT_PLAYBACK_RESTART:
+        restarted = true;
+        break;
+      case MPV_EVENT_END_FILE:
+        *error = "decode_failed";
+        return false;
+      case MPV_EVENT_SHUTDOWN:
+        *error = "destroyed";
+        return false;
+      default:
+        break;
+    }
+
+    if (update_pending_.exchange(false) &&
+        (g_api.mpv_render_context_update(render_ctx_) & MPV_RENDER_UPDATE_FRAME)) {
+      frame_ready_ = true;
+    }
+    if (restarted && frame_ready_) return true;
+  }
+}
+
+// Display size, duration and codec of the loaded file.
+bool FrameExtractor::ReadSource(ThumbnailResult* result) {
+  int64_t src_w = 0;
+  int64_t src_h = 0;
+  if (g_api.mpv_get_property(handle_, "dwidth", MPV_FORMAT_INT64, &src_w) < 0 ||
+      g_api.mpv_get_property(handle_, "dheight", MPV_FORMAT_INT64, &src_h) < 0 ||
+      src_w <= 0 || src_h <= 0) {
+    result->error = "no_video";
+    return false;
+  }
+  double duration = 0.0;
+  if (g_api.mpv_get_property(handle_, "duration", MPV_FORMAT_DOUBLE, &duration) >= 0) {
+    result->duration = duration;
+  }
+  result->video_width = static_cast<int>(src_w);
+  result->video_height = static_cast<int>(src_h);
+  if (char* codec = g_api.mpv_get_property_string(handle_, "video-format")) {
+    result->codec = codec;
+    g_api.mpv_free(codec);
+  }
+  return true;
+}
+
+// Renders the current frame into `target_`; returns its stride.
+size_t FrameExtractor::RenderCurrent(int width, int height) {
+  size_t stride = AlignedStride(width);
+  size_t needed = stride * static_cast<size_t>(height);
+  if (target_.size() < needed) target_.resize(needed);
+
+  int size[2] = { width, height };
+  const char* fmt = "bgra";
+  mpv_render_param params[] = {
+    { MPV_RENDER_PARAM_SW_SIZE, size },
+    { MPV_RENDER_PARAM_SW_FORMAT, const_cast<char*>(fmt) },
+    { MPV_RENDER_PARAM_SW_STRIDE, &stride },
+    { MPV_RENDER_PARAM_SW_POINTER, target_.data() },
+    { MPV_RENDER_PARAM_INVALID, nullptr }
+  };
+  g_api.mpv_render_context_render(render_ctx_, params);
+  return stride;
+}
+
+bool FrameExtractor::ReadFrame(const ThumbnailRequest& request, ThumbnailResult* result) {
+  if (!ReadSource(result)) return false;
+
+  int width = 0;
+  int height = 0;
+  FitSize(result->video_width, result->video_height, request.width, request.height, &width, &height);
+  size_t stride = RenderCurrent(width, height);
+
+  const size_t row = static_cast<size_t>(width) * 4;
+  result->pixels.resize(row * static_cast<size_t>(height));
+  for (int y = 0; y < height; ++y) {
+    std::copy_n(target_.data() + stride * y, row, result->pixels.data() + row * y);
+  }
+  result->width = width;
+  result->height = height;
+  return true;
+}
+
+// One load, then a keyframe seek per tile; each frame is rendered straight
+// into its cell of the sheet.
+bool FrameExtractor::ReadSprite(const ThumbnailRequest& request, const std::atomic<bool>* cancel, ThumbnailResult* result) {
+  if (!ReadSource(result)) return false;
+  if (result->duration <= 0) {
+    result->error = "no_duration";
+    return false;
+  }
+
+  const int tiles = std::min(request.tiles, kMaxSpriteTiles);
+  const int columns = std::max(1, std::min(request.columns > 0 ? request.columns : tiles, tiles));
+  const int rows = (tiles + columns - 1) / columns;
+  int tile_w = 0;
+  int tile_h = 0;
+  FitSize(result->video_width, result->video_height, request.width, request.height, &tile_w, &tile_h);
+
+  const int sheet_w = tile_w * columns;
+  const int sheet_h = tile_h * rows;
+  const size_t sheet_row = static_cast<size_t>(sheet_w) * 4;
+  const size_t tile_row = static_cast<size_t>(tile_w) * 4;
+  result->pixels.assign(sheet_row * static_cast<size_t>(sheet_h), 0);
+
+  const double interval = result->duration / tiles;
+  const double sheet_deadline = NowSeconds() + kSpriteTimeoutSeconds;
+  for (int i = 0; i < tiles; ++i) {
+    std::string target = std::to_string((i + 0.5) * interval);
+    const char* seek[] = { "seek", target.c_str(), "absolute+keyframes", nullptr };
+    if (g_api.mpv_command(handle_, seek) < 0) {
+      result->error = "seek_failed";
+      return false;
+    }
+    double deadline = std::min(NowSeconds() + request.timeout_ms / 1000.0, sheet_deadline);
+    if (!WaitForSeek(deadline, cancel, &result->error)) return false;
+
+    size_t stride = RenderCurrent(tile_w, tile_h);
+    uint8_t* cell = result->pixels.data() + sheet_row * (static_cast<size_t>(i / columns) * tile_h) + tile_row * (i % columns);
+    for (int y = 0; y < tile_h; ++y) {
+      std::copy_n(target_.data() + stride * y, tile_row, cell + sheet_row * y);
+    }
+  }
+
+  result->width = sheet_w;
+  result->height = sheet_h;
+  result->tiles = tiles;
+  result->columns = columns;
+  result->rows = rows;
+  result->tile_width = tile_w;
+  result->tile_height = tile_h;
+  result->interval = interval;
+  return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mpv_api.h"
+
+struct ThumbnailRequest {
+  std::string path;
+  int width = 0;
+  int height = 0;
+  double position = 0.0;
+  int timeout_ms = 10000;
+  // tiles > 0 asks for a sprite sheet of evenly spaced frames, `columns`
+  // wide; width/height then bound a single tile and the timeout applies per
+  // tile, within a 30 s limit for the whole sheet.
+  int tiles = 0;
+  int columns = 0;
+};
+
+// Frame as tightly packed BGRA, the layout Electron's nativeImage expects.
+struct ThumbnailResult {
+  int width = 0;
+  int height = 0;
+  double duration = 0.0;
+  // Source display size and codec, kept for the metadata cache.
+  int video_width = 0;
+  int video_height = 0;
+  std::string codec;
+  // Sprite sheets only: grid layout and the time between tiles. Tile i shows
+  // the keyframe nearest (i + 0.5) * interval.
+  int tiles = 0;
+  int columns = 0;
+  int rows = 0;
+  int tile_width = 0;
+  int tile_height = 0;
+  double interval = 0.0;
+  std::vector<uint8_t> pixels;
+  std::string error;
+};
+
+// Headless mpv instance (vo=libmpv, SW render, no audio) that extracts single
+// frames without spawning a process per file. Not thread-safe: one request at
+// a time, from any one thread.
+class FrameExtractor {
+ public:
+  FrameExtractor() = default;
+  ~FrameExtractor();
+  FrameExtractor(const FrameExtractor&) = delete;
+  FrameExtractor& operator=(const FrameExtractor&) = delete;
+
+  bool Open(const std::string& hwdec, std::string* err);
+  void Close();
+  bool IsOpen() const { return handle_ != nullptr; }
+
+  // `cancel` may be flipped from another thread to abort the wait early.
+  bool Run(const ThumbnailRequest& request, ThumbnailResult* result, const std::atomic<bool>* cancel);
+
+ private:
+  static void OnRenderUpdate(void* ctx);
+
+  bool WaitForFrame(double deadline, const std::atomic<bool>* cancel, std::string* error);
+  bool WaitForSeek(double deadline, const std::atomic<bool>* cancel, std::string* error);
+  bool ReadSource(ThumbnailResult* result);
+  size_t RenderCurrent(int width, int height);
+  bool ReadFrame(const ThumbnailRequest& request, ThumbnailResult* result);
+  bool ReadSprite(const ThumbnailRequest& request, const std::atomic<bool>* cancel, ThumbnailResult* result);
+
+  mpv_handle* handle_ = nullptr;
+  mpv_render_context* render_ctx_ = nullptr;
+  std::atomic<bool> update_pending_{false};
+  bool frame_ready_ = false;
+
+  // Render target reused across requests; it only grows.
+  std::vector<uint8_t> target_;
+};
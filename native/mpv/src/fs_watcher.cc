@@ -0,0 +1,545 @@
+#include "fs_watcher.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <CoreServices/CoreServices.h>
+#include <sys/stat.h>
+#else
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "path_util.h"
+
+namespace {
+
+// Later events refine earlier ones: a file created and then written is still
+// an add, created and removed again is nothing at all.
+bool Coalesce(FsChange::Type previous, FsWatcher::RawEvent event, FsChange::Type* out) {
+  switch (event) {
+    case FsWatcher::kCreated:
+      *out = previous == FsChange::kAdd ? FsChange::kAdd : FsChange::kModify;
+      return true;
+    case FsWatcher::kRemoved:
+      if (previous == FsChange::kAdd) return false;
+      *out = FsChange::kRemove;
+      return true;
+    case FsWatcher::kModified:
+      *out = previous == FsChange::kAdd ? FsChange::kAdd : FsChange::kModify;
+      return true;
+  }
+  return false;
+}
+
+FsChange::Type InitialType(FsWatcher::RawEvent event) {
+  switch (event) {
+    case FsWatcher::kCreated: return FsChange::kAdd;
+    case FsWatcher::kRemoved: return FsChange::kRemove;
+    case FsWatcher::kModified: return FsChange::kModify;
+  }
+  return FsChange::kModify;
+}
+
+} // namespace
+
+#if defined(__linux__)
+
+// inotify is not recursive: one watch per directory, added as directories
+// appear and dropped when they move away.
+struct FsWatcher::Backend {
+  explicit Backend(FsWatcher* owner) : owner(owner) {}
+
+  bool Start(const std::vector<std::string>& roots, const std::vector<std::string>& directories, std::string* err) {
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0 || wake < 0) {
+      if (err) *err = "watch_failed";
+      Stop();
+      return false;
+    }
+    if (directories.empty()) {
+      for (const std::string& root : roots) AddTree(root);
+    } else {
+      for (const std::string& dir : directories) AddWatch(dir);
+    }
+    if (watch_count() == 0) {
+      if (err) *err = "watch_failed";
+      Stop();
+      return false;
+    }
+    thread = std::thread(&Backend::Loop, this);
+    return true;
+  }
+
+  void Stop() {
+    if (thread.joinable()) {
+      uint64_t one = 1;
+      (void)!write(wake, &one, sizeof(one));
+      thread.join();
+    }
+    if (fd >= 0) close(fd);
+    if (wake >= 0) close(wake);
+    fd = -1;
+    wake = -1;
+    std::lock_guard<std::mutex> lock(mutex);
+    watches.clear();
+  }
+
+  void AddWatch(const std::string& dir) {
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_CLOSE_WRITE |
+                          IN_DELETE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW;
+    int wd = inotify_add_watch(fd, dir.c_str(), mask);
+    if (wd < 0) {
+      // Usually fs.inotify.max_user_watches; changes below `dir` go unseen
+      // until the next rescan.
+      if (errno == ENOSPC && !exhausted.exchange(true)) owner->RecordOverflow();
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    watches[wd] = dir;
+  }
+
+  void AddTree(const std::string& dir) {
+    AddWatch(dir);
+    // An extension no file name can end in: subdirectories only.
+    DirListing listing;
+    if (!ListDirectory(dir, ExtensionSet{ "" }, &listing)) return;
+    for (const std::string& sub : listing.subdirs) AddTree(JoinPath(dir, sub));
+  }
+
+  void DirectoryAdded(const std::string& dir) {
+    AddWatch(dir);
+  }
+
+  // A directory moved away keeps its watches under stale paths; drop them and
+  // let the destination be re-watched when it shows up.
+  void DropTree(const std::string& dir) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::string prefix = dir + '/';
+    for (auto it = watches.begin(); it != watches.end();) {
+      if (it->second == dir || it->second.compare(0, prefix.size(), prefix) == 0) {
+        inotify_rm_watch(fd, it->first);
+        it = watches.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  size_t watch_count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return watches.size();
+  }
+
+  void Loop() {
+    alignas(inotify_event) char buffer[64 * 1024];
+    pollfd fds[2] = { { fd, POLLIN, 0 }, { wake, POLLIN, 0 } };
+    for (;;) {
+      if (poll(fds, 2, -1) < 0) {
+        if (errno == EINTR) continue;
+        return;
+      }
+      if (fds[1].revents) return;
+      for (;;) {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length <= 0) break;
+        for (char* p = buffer; p < buffer + length;) {
+          auto* event = reinterpret_cast<inotify_event*>(p);
+          p += sizeof(inotify_event) + event->len;
+          Handle(*event);
+        }
+      }
+    }
+  }
+
+  void Handle(const inotify_event& event) {
+    if (event.mask & IN_Q_OVERFLOW) {
+      owner->RecordOverflow();
+      return;
+    }
+    std::string dir;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = watches.find(event.wd);
+      if (it == watches.end()) return;
+      if (event.mask & IN_IGNORED) {
+        watches.erase(it);
+        return;
+      }
+      dir = it->second;
+    }
+    if (event.len == 0) return;
+    const std::string path = JoinPath(dir, event.name);
+    if (event.mask & (IN_CREATE | IN_MOVED_TO)) owner->Record(path, kCreated);
+    if (event.mask & (IN_DELETE | IN_MOVED_FROM)) {
+      if ((event.mask & IN_ISDIR) && (event.mask & IN_MOVED_FROM)) DropTree(path);
+      owner->Record(path, kRemoved);
+    }
+    if ((event.mask & (IN_MODIFY | IN_CLOSE_WRITE)) && !(event.mask & IN_ISDIR)) owner->Record(path, kModified);
+  }
+
+  FsWatcher* owner;
+  int fd = -1;
+  int wake = -1;
+  // Set from the inotify thread and from the flush thread's DirectoryAdded.
+  std::atomic<bool> exhausted{false};
+  std::thread thread;
+  std::mutex mutex;
+  std::unordered_map<int, std::string> watches;
+};
+
+#elif defined(__APPLE__)
+
+// FSEvents is recursive; file-level events arrive on a private dispatch queue.
+struct FsWatcher::Backend {
+  explicit Backend(FsWatcher* owner) : owner(owner) {}
+
+  bool Start(const std::vector<std::string>& roots, const std::vector<std::string>&, std::string* err) {
+    CFMutableArrayRef paths = CFArrayCreateMutable(nullptr, 0, &kCFTypeArrayCallBacks);
+    for (const std::string& root : roots) {
+      CFStringRef value = CFStringCreateWithCString(nullptr, root.c_str(), kCFStringEncodingUTF8);
+      if (!value) continue;
+      CFArrayAppendValue(paths, value);
+      CFRelease(value);
+    }
+    FSEventStreamContext context = { 0, this, nullptr, nullptr, nullptr };
+    const FSEventStreamCreateFlags flags = kFSEventStreamCreateFlagFileEvents | kFSEventStreamCreateFlagNoDefer;
+    stream = FSEventStreamCreate(nullptr, &Backend::OnEvents, &context, paths, kFSEventStreamEventIdSinceNow, 0.05, flags);
+    count = static_cast<size_t>(CFArrayGetCount(paths));
+    CFRelease(paths);
+    if (!stream) {
+      if (err) *err = "watch_failed";
+      return false;
+    }
+    queue = dispatch_queue_create("vhub.fswatcher", DISPATCH_QUEUE_SERIAL);
+    FSEventStreamSetDispatchQueue(stream, queue);
+    if (!FSEventStreamStart(stream)) {
+      if (err) *err = "watch_failed";
+      Stop();
+      return false;
+    }
+    return true;
+  }
+
+  void Stop() {
+    if (stream) {
+      FSEventStreamStop(stream);
+      FSEventStreamInvalidate(stream);
+      FSEventStreamRelease(stream);
+      stream = nullptr;
+    }
+    if (queue) {
+      // Drains callbacks still queued for this stream.
+      dispatch_sync(queue, ^{});
+      dispatch_release(queue);
+      queue = nullptr;
+    }
+  }
+
+  void DirectoryAdded(const std::string&) {}
+  size_t watch_count() { return stream ? count : 0; }
+
+  static void OnEvents(ConstFSEventStreamRef, void* info, size_t count, void* paths,
+                       const FSEventStreamEventFlags flags[], const FSEventStreamEventId[]) {
+    auto* self = static_cast<Backend*>(info);
+    char** list = static_cast<char**>(paths);
+    const FSEventStreamEventFlags dropped = kFSEventStreamEventFlagMustScanSubDirs |
+                                            kFSEventStreamEventFlagUserDropped |
+                                            kFSEventStreamEventFlagKernelDropped;
+    for (size_t i = 0; i < count; ++i) {
+      if (flags[i] & dropped) {
+        self->owner->RecordOverflow();
+        continue;
+      }
+      // Flags accumulate over an item's history, so existence decides what
+      // a created/removed/renamed item means now.
+      struct stat st;
+      const bool exists = lstat(list[i], &st) == 0;
+      const FSEventStreamEventFlags change = kFSEventStreamEventFlagItemCreated |
+                                             kFSEventStreamEventFlagItemRemoved |
+                                             kFSEventStreamEventFlagItemRenamed;
+      if (flags[i] & change) {
+        self->owner->Record(list[i], exists ? kCreated : kRemoved);
+      } else if (flags[i] & (kFSEventStreamEventFlagItemModified | kFSEventStreamEventFlagItemInodeMetaMod)) {
+        self->owner->Record(list[i], kModified);
+      }
+    }
+  }
+
+  FsWatcher* owner;
+  FSEventStreamRef stream = nullptr;
+  dispatch_queue_t queue = nullptr;
+  size_t count = 0;
+};
+
+#elif defined(_WIN32)
+
+// One recursive ReadDirectoryChangesW per root, all waited on from one thread.
+struct FsWatcher::Backend {
+  struct Root {
+    std::string path;
+    HANDLE dir = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped = {};
+    std::vector<DWORD> buffer = std::vector<DWORD>(16 * 1024);
+  };
+
+  explicit Backend(FsWatcher* owner) : owner(owner) {}
+
+  bool Start(const std::vector<std::string>& paths, const std::vector<std::string>&, std::string* err) {
+    stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    // WaitForMultipleObjects takes at most 64 handles, one is the stop event.
+    for (const std::string& path : paths) {
+      if (roots.size() >= MAXIMUM_WAIT_OBJECTS - 1) break;
+      auto root = std::make_unique<Root>();
+      root->path = path;
+      root->dir = CreateFileW(Widen(path).c_str(), FILE_LIST_DIRECTORY,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+      if (root->dir == INVALID_HANDLE_VALUE) continue;
+      root->overlapped.hEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+      if (!Issue(*root)) {
+        CloseHandle(root->overlapped.hEvent);
+        CloseHandle(root->dir);
+        continue;
+      }
+      roots.push_back(std::move(root));
+    }
+    if (roots.empty()) {
+      if (err) *err = "watch_failed";
+      Stop();
+      return false;
+    }
+    thread = std::thread(&Backend::Loop, this);
+    return true;
+  }
+
+  bool Issue(Root& root) {
+    const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                         FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+    return ReadDirectoryChangesW(root.dir, root.buffer.data(), static_cast<DWORD>(root.buffer.size() * sizeof(DWORD)),
+                                 TRUE, filter, nullptr, &root.overlapped, nullptr) != 0;
+  }
+
+  void Stop() {
+    if (stop_event) SetEvent(stop_event);
+    if (thread.joinable()) thread.join();
+    for (auto& root : roots) {
+      CancelIoEx(root->dir, &root->overlapped);
+      DWORD bytes = 0;
+      GetOverlappedResult(root->dir, &root->overlapped, &bytes, TRUE);
+      CloseHandle(root->overlapped.hEvent);
+      CloseHandle(root->dir);
+    }
+    roots.clear();
+    if (stop_event) CloseHandle(stop_event);
+    stop_event = nullptr;
+  }
+
+  void DirectoryAdded(const std::string&) {}
+  size_t watch_count() { return roots.size(); }
+
+  void Loop() {
+    std::vector<HANDLE> handles = { stop_event };
+    for (auto& root : roots) handles.push_back(root->overlapped.hEvent);
+    for (;;) {
+      DWORD signaled = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, INFINITE);
+      if (signaled == WAIT_OBJECT_0 || signaled == WAIT_FAILED) return;
+      size_t index = signaled - WAIT_OBJECT_0 - 1;
+      if (index >= roots.size()) continue;
+      Root& root = *roots[index];
+      DWORD bytes = 0;
+      if (!GetOverlappedResult(root.dir, &root.overlapped, &bytes, FALSE)) continue;
+      // Zero bytes means the buffer overflowed and events were lost.
+      if (bytes == 0) {
+        owner->RecordOverflow();
+      } else {
+        Parse(root);
+      }
+      if (!Issue(root)) owner->RecordOverflow();
+    }
+  }
+
+  void Parse(const Root& root) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(root.buffer.data());
+    for (;;) {
+      auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+      const std::string path = JoinPath(root.path, Narrow(info->FileName, info->FileNameLength / sizeof(wchar_t)));
+      switch (info->Action) {
+        case FILE_ACTION_ADDED:
+        case FILE_ACTION_RENAMED_NEW_NAME:
+          owner->Record(path, kCreated);
+          break;
+        case FILE_ACTION_REMOVED:
+        case FILE_ACTION_RENAMED_OLD_NAME:
+          owner->Record(path, kRemoved);
+          break;
+        case FILE_ACTION_MODIFIED:
+          owner->Record(path, kModified);
+          break;
+      }
+      if (info->NextEntryOffset == 0) break;
+      p += info->NextEntryOffset;
+    }
+  }
+
+  FsWatcher* owner;
+  HANDLE stop_event = nullptr;
+  std::vector<std::unique_ptr<Root>> roots;
+  std::thread thread;
+};
+
+#endif
+
+FsWatcher::FsWatcher() = default;
+
+FsWatcher::~FsWatcher() {
+  Stop();
+}
+
+bool FsWatcher::Start(const std::vector<std::string>& roots, const std::vector<std::string>& directories,
+                      const ExtensionSet& extensions, int debounce_ms, Callback callback, std::string* err) {
+  Stop();
+  extensions_ = extensions;
+  debounce_ = std::chrono::milliseconds(std::max(debounce_ms, 0));
+  callback_ = std::move(callback);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = false;
+    overflow_ = false;
+    pending_.clear();
+  }
+
+  backend_ = std::make_unique<Backend>(this);
+  flush_thread_ = std::thread(&FsWatcher::FlushLoop, this);
+  if (!backend_->Start(roots, directories, err)) {
+    Stop();
+    return false;
+  }
+  return true;
+}
+
+// The flush thread goes first: it may still be adding watches for new
+// directories through the backend.
+void FsWatcher::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (flush_thread_.joinable()) flush_thread_.join();
+  if (backend_) backend_->Stop();
+  backend_.reset();
+}
+
+size_t FsWatcher::watch_count() const {
+  return backend_ ? backend_->watch_count() : 0;
+}
+
+void FsWatcher::Record(const std::string& path, RawEvent event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto now = std::chrono::steady_clock::now();
+  auto it = pending_.find(path);
+  if (it == pending_.end()) {
+    pending_.emplace(path, Pending{ InitialType(event), now });
+  } else if (Coalesce(it->second.type, event, &it->second.type)) {
+    it->second.last = now;
+  } else {
+    pending_.erase(it);
+  }
+  cv_.notify_one();
+}
+
+void FsWatcher::RecordOverflow() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  overflow_ = true;
+  cv_.notify_one();
+}
+
+void FsWatcher::EmitTree(const std::string& dir, std::vector<FsChange>* out) {
+  backend_->DirectoryAdded(dir);
+  DirListing listing;
+  if (!ListDirectory(dir, extensions_, &listing)) return;
+  for (const ScannedFile& file : listing.files) {
+    FsChange change;
+    change.type = FsChange::kAdd;
+    change.path = JoinPath(dir, file.name);
+    change.size = file.size;
+    change.mtime_ms = file.mtime_ms;
+    out->push_back(std::move(change));
+  }
+  for (const std::string& sub : listing.subdirs) EmitTree(JoinPath(dir, sub), out);
+}
+
+// Turns a settled path into a change, or nothing, based on what is on disk now.
+void FsWatcher::Emit(const std::string& path, FsChange::Type type, std::vector<FsChange>* out) {
+  FsChange change;
+  change.path = path;
+  PathKind kind = StatPath(path, &change.size, &change.mtime_ms);
+  if (kind == PathKind::kMissing) {
+    if (type == FsChange::kAdd) return;
+    change.type = FsChange::kRemove;
+    out->push_back(std::move(change));
+    return;
+  }
+  if (kind == PathKind::kDirectory) {
+    // Directory mtimes move with their contents; only a new directory matters.
+    if (type == FsChange::kAdd) EmitTree(path, out);
+    return;
+  }
+  if (kind != PathKind::kFile || !MatchesExtension(path, extensions_)) return;
+  change.type = type == FsChange::kAdd ? FsChange::kAdd : FsChange::kModify;
+  out->push_back(std::move(change));
+}
+
+void FsWatcher::FlushLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    if (pending_.empty() && !overflow_) {
+      cv_.wait(lock);
+      continue;
+    }
+
+    std::vector<FsChange> changes;
+    if (overflow_) {
+      // Everything pending is covered by the rescan.
+      overflow_ = false;
+      pending_.clear();
+      FsChange rescan;
+      rescan.type = FsChange::kRescan;
+      changes.push_back(std::move(rescan));
+    } else {
+      const auto now = std::chrono::steady_clock::now();
+      auto next = std::chrono::steady_clock::time_point::max();
+      std::vector<std::pair<std::string, FsChange::Type>> ready;
+      for (auto it = pending_.begin(); it != pending_.end();) {
+        const auto due = it->second.last + debounce_;
+        if (due <= now) {
+          ready.emplace_back(it->first, it->second.type);
+          it = pending_.erase(it);
+        } else {
+          next = std::min(next, due);
+          ++it;
+        }
+      }
+      if (ready.empty()) {
+        cv_.wait_until(lock, next);
+        continue;
+      }
+      lock.unlock();
+      for (const auto& entry : ready) Emit(entry.first, entry.second, &changes);
+      lock.lock();
+    }
+
+    if (changes.empty()) continue;
+    lock.unlock();
+    callback_(std::move(changes));
+    lock.lock();
+  }
+}
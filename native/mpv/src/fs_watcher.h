@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "dir_walker.h"
+
+struct FsChange {
+  enum Type { kAdd, kRemove, kModify, kRescan };
+
+  Type type = kModify;
+  std::string path;
+  uint64_t size = 0;
+  int64_t mtime_ms = 0;
+};
+
+// Recursive change notifications for a set of roots: inotify on Linux,
+// FSEvents on macOS and ReadDirectoryChangesW on Windows. Raw events are
+// coalesced per path and delivered once the path has been quiet for the
+// debounce interval, so a file being copied in is reported once, finished.
+//
+// Adds and modifications are verified with a stat and filtered by extension;
+// a directory that appears is walked and reported as adds for its files.
+// Removals are not filtered, since a removed path may be a directory: anything
+// at or below it is gone. When the OS drops events, a single kRescan is sent
+// instead and the caller should rescan.
+class FsWatcher {
+ public:
+  using Callback = std::function<void(std::vector<FsChange>)>;
+
+  FsWatcher();
+  ~FsWatcher();
+  FsWatcher(const FsWatcher&) = delete;
+  FsWatcher& operator=(const FsWatcher&) = delete;
+
+  // `directories` seeds non-recursive backends (inotify) so they need not walk
+  // the tree again; it may be empty. Callback runs on the flush thread.
+  bool Start(const std::vector<std::string>& roots, const std::vector<std::string>& directories,
+             const ExtensionSet& extensions, int debounce_ms, Callback callback, std::string* err);
+  void Stop();
+
+  // Number of OS watches held (one per directory for inotify, one per root
+  // otherwise).
+  size_t watch_count() const;
+
+  enum RawEvent { kCreated, kRemoved, kModified };
+  // Called by the backend from its own thread.
+  void Record(const std::string& path, RawEvent event);
+  void RecordOverflow();
+
+ private:
+  struct Pending {
+    FsChange::Type type;
+    std::chrono::steady_clock::time_point last;
+  };
+  struct Backend;
+
+  void FlushLoop();
+  void Emit(const std::string& path, FsChange::Type type, std::vector<FsChange>* out);
+  void EmitTree(const std::string& dir, std::vector<FsChange>* out);
+
+  ExtensionSet extensions_;
+  std::chrono::milliseconds debounce_{500};
+  Callback callback_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::unordered_map<std::string, Pending> pending_;
+  bool overflow_ = false;
+  bool stop_ = false;
+  std::thread flush_thread_;
+  std::unique_ptr<Backend> backend_;
+};
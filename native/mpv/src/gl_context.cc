@@ -0,0 +1,402 @@
+#include "gl_context.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace {
+
+constexpr unsigned int kGlFramebuffer = 0x8D40;
+constexpr unsigned int kGlFramebufferComplete = 0x8CD5;
+constexpr unsigned int kGlColorAttachment0 = 0x8CE0;
+constexpr unsigned int kGlTexture2d = 0x0DE1;
+constexpr unsigned int kGlTextureMinFilter = 0x2801;
+constexpr unsigned int kGlTextureMagFilter = 0x2800;
+constexpr unsigned int kGlLinear = 0x2601;
+constexpr unsigned int kGlRgba = 0x1908;
+constexpr unsigned int kGlRgba8 = 0x8058;
+constexpr unsigned int kGlUnsignedByte = 0x1401;
+constexpr unsigned int kGlPackAlignment = 0x0D05;
+
+#if defined(_WIN32)
+
+struct WglApi {
+  HMODULE handle = nullptr;
+  HGLRC (WINAPI* wglCreateContext)(HDC);
+  BOOL (WINAPI* wglDeleteContext)(HGLRC);
+  BOOL (WINAPI* wglMakeCurrent)(HDC, HGLRC);
+  PROC (WINAPI* wglGetProcAddress)(LPCSTR);
+};
+
+WglApi g_wgl;
+
+bool LoadGlLibrary(std::string* err) {
+  if (g_wgl.handle) return true;
+  HMODULE handle = LoadLibraryA("opengl32.dll");
+  if (!handle) {
+    if (err) *err = "gl_load_failed";
+    return false;
+  }
+  g_wgl.wglCreateContext = reinterpret_cast<HGLRC (WINAPI*)(HDC)>(GetProcAddress(handle, "wglCreateContext"));
+  g_wgl.wglDeleteContext = reinterpret_cast<BOOL (WINAPI*)(HGLRC)>(GetProcAddress(handle, "wglDeleteContext"));
+  g_wgl.wglMakeCurrent = reinterpret_cast<BOOL (WINAPI*)(HDC, HGLRC)>(GetProcAddress(handle, "wglMakeCurrent"));
+  g_wgl.wglGetProcAddress = reinterpret_cast<PROC (WINAPI*)(LPCSTR)>(GetProcAddress(handle, "wglGetProcAddress"));
+  if (!g_wgl.wglCreateContext || !g_wgl.wglDeleteContext || !g_wgl.wglMakeCurrent || !g_wgl.wglGetProcAddress) {
+    FreeLibrary(handle);
+    if (err) *err = "gl_missing_symbol";
+    return false;
+  }
+  g_wgl.handle = handle;
+  return true;
+}
+
+void* LookupGlSymbol(const char* name) {
+  PROC proc = g_wgl.wglGetProcAddress(name);
+  // wglGetProcAddress only knows about extension/post-1.1 entry points and
+  // signals failure with a few small sentinel values.
+  intptr_t value = reinterpret_cast<intptr_t>(proc);
+  if (value == 0 || value == 1 || value == 2 || value == 3 || value == -1) {
+    proc = GetProcAddress(g_wgl.handle, name);
+  }
+  return reinterpret_cast<void*>(proc);
+}
+
+#elif defined(__APPLE__)
+
+typedef void* CGLPixelFormatObj;
+typedef void* CGLContextObj;
+
+constexpr int kCglPfaAccelerated = 73;
+constexpr int kCglPfaAllowOfflineRenderers = 96;
+constexpr int kCglPfaOpenGlProfile = 99;
+constexpr int kCglOglpVersion32Core = 0x3200;
+
+struct CglApi {
+  void* handle = nullptr;
+  int (*CGLChoosePixelFormat)(const int*, CGLPixelFormatObj*, int*);
+  int (*CGLDestroyPixelFormat)(CGLPixelFormatObj);
+  int (*CGLCreateContext)(CGLPixelFormatObj, CGLContextObj, CGLContextObj*);
+  int (*CGLDestroyContext)(CGLContextObj);
+  int (*CGLSetCurrentContext)(CGLContextObj);
+};
+
+CglApi g_cgl;
+
+bool LoadGlLibrary(std::string* err) {
+  if (g_cgl.handle) return true;
+  void* handle = dlopen("/System/Library/Frameworks/OpenGL.framework/OpenGL", RTLD_LAZY | RTLD_LOCAL);
+  if (!handle) {
+    if (err) *err = "gl_load_failed";
+    return false;
+  }
+  g_cgl.CGLChoosePixelFormat = reinterpret_cast<int (*)(const int*, CGLPixelFormatObj*, int*)>(dlsym(handle, "CGLChoosePixelFormat"));
+  g_cgl.CGLDestroyPixelFormat = reinterpret_cast<int (*)(CGLPixelFormatObj)>(dlsym(handle, "CGLDestroyPixelFormat"));
+  g_cgl.CGLCreateContext = reinterpret_cast<int (*)(CGLPixelFormatObj, CGLContextObj, CGLContextObj*)>(dlsym(handle, "CGLCreateContext"));
+  g_cgl.CGLDestroyContext = reinterpret_cast<int (*)(CGLContextObj)>(dlsym(handle, "CGLDestroyContext"));
+  g_cgl.CGLSetCurrentContext = reinterpret_cast<int (*)(CGLContextObj)>(dlsym(handle, "CGLSetCurrentContext"));
+  if (!g_cgl.CGLChoosePixelFormat || !g_cgl.CGLDestroyPixelFormat || !g_cgl.CGLCreateContext ||
+      !g_cgl.CGLDestroyContext || !g_cgl.CGLSetCurrentContext) {
+    dlclose(handle);
+    if (err) *err = "gl_missing_symbol";
+    return false;
+  }
+  g_cgl.handle = handle;
+  return true;
+}
+
+void* LookupGlSymbol(const char* name) {
+  return dlsym(g_cgl.handle, name);
+}
+
+#else
+
+typedef void* EGLDisplay;
+typedef void* EGLConfig;
+typedef void* EGLContext;
+typedef void* EGLSurface;
+typedef int32_t EGLint;
+typedef unsigned int EGLBoolean;
+typedef unsigned int EGLenum;
+
+constexpr EGLint kEglSurfaceType = 0x3033;
+constexpr EGLint kEglPbufferBit = 0x0001;
+constexpr EGLint kEglRenderableType = 0x3040;
+constexpr EGLint kEglOpenGlBit = 0x0008;
+constexpr EGLint kEglRedSize = 0x3024;
+constexpr EGLint kEglGreenSize = 0x3023;
+constexpr EGLint kEglBlueSize = 0x3022;
+constexpr EGLint kEglAlphaSize = 0x3021;
+constexpr EGLint kEglWidth = 0x3057;
+constexpr EGLint kEglHeight = 0x3056;
+constexpr EGLint kEglNone = 0x3038;
+constexpr EGLenum kEglOpenGlApi = 0x30A2;
+
+struct EglApi {
+  void* handle = nullptr;
+  EGLDisplay (*eglGetDisplay)(void*);
+  EGLBoolean (*eglInitialize)(EGLDisplay, EGLint*, EGLint*);
+  EGLBoolean (*eglBindAPI)(EGLenum);
+  EGLBoolean (*eglChooseConfig)(EGLDisplay, const EGLint*, EGLConfig*, EGLint, EGLint*);
+  EGLContext (*eglCreateContext)(EGLDisplay, EGLConfig, EGLContext, const EGLint*);
+  EGLBoolean (*eglDestroyContext)(EGLDisplay, EGLContext);
+  EGLSurface (*eglCreatePbufferSurface)(EGLDisplay, EGLConfig, const EGLint*);
+  EGLBoolean (*eglDestroySurface)(EGLDisplay, EGLSurface);
+  EGLBoolean (*eglMakeCurrent)(EGLDisplay, EGLSurface, EGLSurface, EGLContext);
+  void* (*eglGetProcAddress)(const char*);
+};
+
+EglApi g_egl;
+
+bool LoadGlLibrary(std::string* err) {
+  if (g_egl.handle) return true;
+  void* handle = dlopen("libEGL.so.1", RTLD_LAZY | RTLD_LOCAL);
+  if (!handle) handle = dlopen("libEGL.so", RTLD_LAZY | RTLD_LOCAL);
+  if (!handle) {
+    if (err) *err = "gl_load_failed";
+    return false;
+  }
+#define VHUB_EGL_SYM(name) \
+  g_egl.name = reinterpret_cast<decltype(g_egl.name)>(dlsym(handle, #name)); \
+  if (!g_egl.name) { dlclose(handle); if (err) *err = "gl_missing_symbol"; return false; }
+  VHUB_EGL_SYM(eglGetDisplay)
+  VHUB_EGL_SYM(eglInitialize)
+  VHUB_EGL_SYM(eglBindAPI)
+  VHUB_EGL_SYM(eglChooseConfig)
+  VHUB_EGL_SYM(eglCreateContext)
+  VHUB_EGL_SYM(eglDestroyContext)
+  VHUB_EGL_SYM(eglCreatePbufferSurface)
+  VHUB_EGL_SYM(eglDestroySurface)
+  VHUB_EGL_SYM(eglMakeCurrent)
+  VHUB_EGL_SYM(eglGetProcAddress)
+#undef VHUB_EGL_SYM
+  g_egl.handle = handle;
+  return true;
+}
+
+void* LookupGlSymbol(const char* name) {
+  return g_egl.eglGetProcAddress(name);
+}
+
+#endif
+
+} // namespace
+
+GlContext::~GlContext() {
+  Destroy();
+}
+
+bool GlContext::Create(std::string* err) {
+  if (valid_) return true;
+  if (!LoadGlLibrary(err)) return false;
+
+#if defined(_WIN32)
+  static ATOM window_class = 0;
+  if (!window_class) {
+    WNDCLASSA wc = {};
+    wc.style = CS_OWNDC;
+    wc.lpfnWndProc = DefWindowProcA;
+    wc.hInstance = GetModuleHandleA(nullptr);
+    wc.lpszClassName = "vhub_mpv_gl";
+    window_class = RegisterClassA(&wc);
+  }
+  HWND hwnd = CreateWindowA("vhub_mpv_gl", "", WS_OVERLAPPEDWINDOW, 0, 0, 1, 1,
+                             nullptr, nullptr, GetModuleHandleA(nullptr), nullptr);
+  if (!hwnd) {
+    if (err) *err = "gl_window_failed";
+    return false;
+  }
+  HDC hdc = GetDC(hwnd);
+  PIXELFORMATDESCRIPTOR pfd = {};
+  pfd.nSize = sizeof(pfd);
+  pfd.nVersion = 1;
+  pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+  pfd.iPixelType = PFD_TYPE_RGBA;
+  pfd.cColorBits = 32;
+  pfd.iLayerType = PFD_MAIN_PLANE;
+  int format = ChoosePixelFormat(hdc, &pfd);
+  HGLRC ctx = nullptr;
+  if (format && SetPixelFormat(hdc, format, &pfd)) ctx = g_wgl.wglCreateContext(hdc);
+  if (!ctx) {
+    ReleaseDC(hwnd, hdc);
+    DestroyWindow(hwnd);
+    if (err) *err = "gl_context_failed";
+    return false;
+  }
+  window_ = hwnd;
+  surface_ = hdc;
+  context_ = ctx;
+#elif defined(__APPLE__)
+  const int attribs[] = {
+    kCglPfaOpenGlProfile, kCglOglpVersion32Core,
+    kCglPfaAccelerated,
+    kCglPfaAllowOfflineRenderers,
+    0
+  };
+  CGLPixelFormatObj pix = nullptr;
+  int count = 0;
+  if (g_cgl.CGLChoosePixelFormat(attribs, &pix, &count) != 0 || !pix) {
+    if (err) *err = "gl_pixel_format_failed";
+    return false;
+  }
+  CGLContextObj ctx = nullptr;
+  int res = g_cgl.CGLCreateContext(pix, nullptr, &ctx);
+  g_cgl.CGLDestroyPixelFormat(pix);
+  if (res != 0 || !ctx) {
+    if (err) *err = "gl_context_failed";
+    return false;
+  }
+  context_ = ctx;
+#else
+  EGLDisplay display = g_egl.eglGetDisplay(nullptr);
+  if (!display || !g_egl.eglInitialize(display, nullptr, nullptr)) {
+    if (err) *err = "gl_display_failed";
+    return false;
+  }
+  const EGLint config_attribs[] = {
+    kEglSurfaceType, kEglPbufferBit,
+    kEglRenderableType, kEglOpenGlBit,
+    kEglRedSize, 8, kEglGreenSize, 8, kEglBlueSize, 8, kEglAlphaSize, 8,
+    kEglNone
+  };
+  EGLConfig config = nullptr;
+  EGLint count = 0;
+  if (!g_egl.eglBindAPI(kEglOpenGlApi) ||
+      !g_egl.eglChooseConfig(display, config_attribs, &config, 1, &count) || count < 1) {
+    if (err) *err = "gl_pixel_format_failed";
+    return false;
+  }
+  const EGLint pbuffer_attribs[] = { kEglWidth, 1, kEglHeight, 1, kEglNone };
+  EGLSurface surface = g_egl.eglCreatePbufferSurface(display, config, pbuffer_attribs);
+  EGLContext ctx = g_egl.eglCreateContext(display, config, nullptr, nullptr);
+  if (!surface || !ctx) {
+    if (ctx) g_egl.eglDestroyContext(display, ctx);
+    if (surface) g_egl.eglDestroySurface(display, surface);
+    if (err) *err = "gl_context_failed";
+    return false;
+  }
+  display_ = display;
+  surface_ = surface;
+  context_ = ctx;
+#endif
+
+  valid_ = true;
+  if (!MakeCurrent() || !LoadFunctions()) {
+    if (err) *err = "gl_missing_symbol";
+    Destroy();
+    return false;
+  }
+  ReleaseCurrent();
+  return true;
+}
+
+void GlContext::Destroy() {
+  if (!valid_) return;
+  if (fbo_ || texture_) {
+    if (MakeCurrent()) {
+      if (fbo_) glDeleteFramebuffers_(1, &fbo_);
+      if (texture_) glDeleteTextures_(1, &texture_);
+    }
+    fbo_ = 0;
+    texture_ = 0;
+    fbo_width_ = 0;
+    fbo_height_ = 0;
+  }
+  ReleaseCurrent();
+#if defined(_WIN32)
+  g_wgl.wglDeleteContext(static_cast<HGLRC>(context_));
+  ReleaseDC(static_cast<HWND>(window_), static_cast<HDC>(surface_));
+  DestroyWindow(static_cast<HWND>(window_));
+#elif defined(__APPLE__)
+  g_cgl.CGLDestroyContext(context_);
+#else
+  g_egl.eglDestroyContext(display_, context_);
+  g_egl.eglDestroySurface(display_, surface_);
+#endif
+  context_ = nullptr;
+  surface_ = nullptr;
+  display_ = nullptr;
+  window_ = nullptr;
+  valid_ = false;
+}
+
+bool GlContext::MakeCurrent() {
+  if (!valid_) return false;
+#if defined(_WIN32)
+  return g_wgl.wglMakeCurrent(static_cast<HDC>(surface_), static_cast<HGLRC>(context_)) != FALSE;
+#elif defined(__APPLE__)
+  return g_cgl.CGLSetCurrentContext(context_) == 0;
+#else
+  return g_egl.eglMakeCurrent(display_, surface_, surface_, context_) != 0;
+#endif
+}
+
+void GlContext::ReleaseCurrent() {
+  if (!valid_) return;
+#if defined(_WIN32)
+  g_wgl.wglMakeCurrent(nullptr, nullptr);
+#elif defined(__APPLE__)
+  g_cgl.CGLSetCurrentContext(nullptr);
+#else
+  g_egl.eglMakeCurrent(display_, nullptr, nullptr, nullptr);
+#endif
+}
+
+void* GlContext::GetProcAddress(void*, const char* name) {
+  return LookupGlSymbol(name);
+}
+
+bool GlContext::LoadFunctions() {
+#define VHUB_GL_SYM(name) \
+  name##_ = reinterpret_cast<decltype(name##_)>(LookupGlSymbol(#name)); \
+  if (!name##_) return false;
+  VHUB_GL_SYM(glGenFramebuffers)
+  VHUB_GL_SYM(glDeleteFramebuffers)
+  VHUB_GL_SYM(glBindFramebuffer)
+  VHUB_GL_SYM(glFramebufferTexture2D)
+  VHUB_GL_SYM(glCheckFramebufferStatus)
+  VHUB_GL_SYM(glGenTextures)
+  VHUB_GL_SYM(glDeleteTextures)
+  VHUB_GL_SYM(glBindTexture)
+  VHUB_GL_SYM(glTexImage2D)
+  VHUB_GL_SYM(glTexParameteri)
+  VHUB_GL_SYM(glPixelStorei)
+  VHUB_GL_SYM(glReadPixels)
+#undef VHUB_GL_SYM
+  return true;
+}
+
+bool GlContext::EnsureFramebuffer(int width, int height, int* fbo) {
+  if (!valid_) return false;
+  if (fbo_ && fbo_width_ == width && fbo_height_ == height) {
+    *fbo = static_cast<int>(fbo_);
+    return true;
+  }
+  if (!texture_) glGenTextures_(1, &texture_);
+  if (!fbo_) glGenFramebuffers_(1, &fbo_);
+
+  glBindTexture_(kGlTexture2d, texture_);
+  glTexParameteri_(kGlTexture2d, kGlTextureMinFilter, static_cast<int>(kGlLinear));
+  glTexParameteri_(kGlTexture2d, kGlTextureMagFilter, static_cast<int>(kGlLinear));
+  glTexImage2D_(kGlTexture2d, 0, static_cast<int>(kGlRgba8), width, height, 0, kGlRgba, kGlUnsignedByte, nullptr);
+  glBindTexture_(kGlTexture2d, 0);
+
+  glBindFramebuffer_(kGlFramebuffer, fbo_);
+  glFramebufferTexture2D_(kGlFramebuffer, kGlColorAttachment0, kGlTexture2d, texture_, 0);
+  bool complete = glCheckFramebufferStatus_(kGlFramebuffer) == kGlFramebufferComplete;
+  glBindFramebuffer_(kGlFramebuffer, 0);
+  if (!complete) return false;
+
+  fbo_width_ = width;
+  fbo_height_ = height;
+  *fbo = static_cast<int>(fbo_);
+  return true;
+}
+
+void GlContext::ReadPixels(uint8_t* dst, int width, int height) {
+  glBindFramebuffer_(kGlFramebuffer, fbo_);
+  glPixelStorei_(kGlPackAlignment, 1);
+  glReadPixels_(0, 0, width, height, kGlRgba, kGlUnsignedByte, dst);
+  glBindFramebuffer_(kGlFramebuffer, 0);
+}
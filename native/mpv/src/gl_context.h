@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Offscreen OpenGL context used by the GPU render path. The system GL library
+// is loaded dynamically (like libmpv), so the addon still loads on machines
+// without a usable driver and simply falls back to the SW renderer.
+//
+// A context is current on at most one thread at a time: callers make it
+// current around mpv_render_* calls and release it before another thread
+// (e.g. the render worker) takes over.
+class GlContext {
+ public:
+  GlContext() = default;
+  ~GlContext();
+  GlContext(const GlContext&) = delete;
+  GlContext& operator=(const GlContext&) = delete;
+
+  bool Create(std::string* err);
+  void Destroy();
+  bool IsValid() const { return valid_; }
+
+  bool MakeCurrent();
+  void ReleaseCurrent();
+
+  // Matches mpv_opengl_init_params::get_proc_address.
+  static void* GetProcAddress(void* ctx, const char* name);
+
+  // Ensures a color-renderable FBO of the given size exists and returns its
+  // name. Requires the context to be current.
+  bool EnsureFramebuffer(int width, int height, int* fbo);
+  // Reads the FBO back as tightly packed top-down RGBA. mpv renders unflipped
+  // into FBOs, so GL's bottom-up row order already matches the SW layout.
+  void ReadPixels(uint8_t* dst, int width, int height);
+
+ private:
+  bool LoadFunctions();
+
+  bool valid_ = false;
+  void* context_ = nullptr;
+  void* surface_ = nullptr;
+  void* display_ = nullptr;
+  void* window_ = nullptr;
+
+  unsigned int fbo_ = 0;
+  unsigned int texture_ = 0;
+  int fbo_width_ = 0;
+  int fbo_height_ = 0;
+
+  void (*glGenFramebuffers_)(int, unsigned int*) = nullptr;
+  void (*glDeleteFramebuffers_)(int, const unsigned int*) = nullptr;
+  void (*glBindFramebuffer_)(unsigned int, unsigned int) = nullptr;
+  void (*glFramebufferTexture2D_)(unsigned int, unsigned int, unsigned int, unsigned int, int) = nullptr;
+  unsigned int (*glCheckFramebufferStatus_)(unsigned int) = nullptr;
+  void (*glGenTextures_)(int, unsigned int*) = nullptr;
+  void (*glDeleteTextures_)(int, const unsigned int*) = nullptr;
+  void (*glBindTexture_)(unsigned int, unsigned int) = nullptr;
+  void (*glTexImage2D_)(unsigned int, int, int, int, int, int, unsigned int, unsigned int, const void*) = nullptr;
+  void (*glTexParameteri_)(unsigned int, unsigned int, int) = nullptr;
+  void (*glPixelStorei_)(unsigned int, int) = nullptr;
+  void (*glReadPixels_)(int, int, int, int, unsigned int, unsigned int, void*) = nullptr;
+};
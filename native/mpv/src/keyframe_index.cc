@@ -0,0 +1,572 @@
+#include "keyframe_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "path_util.h"
+
+namespace {
+
+// Index boxes and elements are read whole; anything larger is not a sane
+// index for one file.
+constexpr uint64_t kMaxIndexBytes = 256ull << 20;
+
+struct Span {
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+};
+
+uint32_t ReadBe32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+uint64_t ReadBe64(const uint8_t* p) {
+  return (static_cast<uint64_t>(ReadBe32(p)) << 32) | ReadBe32(p + 4);
+}
+
+class FileReader {
+ public:
+  explicit FileReader(const std::string& path) : file_(OpenPath(path, "rb")) {
+    if (file_) size_ = FileSize(file_);
+  }
+  ~FileReader() {
+    if (file_) std::fclose(file_);
+  }
+  FileReader(const FileReader&) = delete;
+  FileReader& operator=(const FileReader&) = delete;
+
+  bool IsOpen() const { return file_ != nullptr; }
+  uint64_t size() const { return size_; }
+
+  bool Read(uint64_t offset, uint8_t* out, size_t length) {
+    if (offset > size_ || length > size_ - offset) return false;
+    return SeekTo(file_, offset) && std::fread(out, 1, length, file_) == length;
+  }
+
+  bool Read(uint64_t offset, uint64_t length, std::vector<uint8_t>* out) {
+    if (length > kMaxIndexBytes) return false;
+    out->resize(static_cast<size_t>(length));
+    return length == 0 || Read(offset, out->data(), out->size());
+  }
+
+ private:
+  std::FILE* file_;
+  uint64_t size_ = 0;
+};
+
+void SortTimes(std::vector<double>* times) {
+  std::sort(times->begin(), times->end());
+  times->erase(std::unique(times->begin(), times->end()), times->end());
+}
+
+// --- MP4 / MOV -------------------------------------------------------------
+
+constexpr uint32_t Fourcc(const char (&name)[5]) {
+  return (static_cast<uint32_t>(static_cast<uint8_t>(name[0])) << 24) |
+         (static_cast<uint32_t>(static_cast<uint8_t>(name[1])) << 16) |
+         (static_cast<uint32_t>(static_cast<uint8_t>(name[2])) << 8) |
+         static_cast<uint32_t>(static_cast<uint8_t>(name[3]));
+}
+
+// Takes the next box off `rest`; false at the end or on a box that overruns.
+bool NextBox(Span* rest, uint32_t* type, Span* body) {
+  if (rest->size < 8) return false;
+  uint64_t size = ReadBe32(rest->data);
+  size_t header = 8;
+  if (size == 1) {
+    if (rest->size < 16) return false;
+    size = ReadBe64(rest->data + 8);
+    header = 16;
+  } else if (size == 0) {
+    size = rest->size;
+  }
+  if (size < header || size > rest->size) return false;
+  *type = ReadBe32(rest->data + 4);
+  body->data = rest->data + header;
+  body->size = static_cast<size_t>(size) - header;
+  rest->data += size;
+  rest->size -= static_cast<size_t>(size);
+  return true;
+}
+
+bool FindBox(Span span, uint32_t wanted, Span* body) {
+  uint32_t type = 0;
+  while (NextBox(&span, &type, body)) {
+    if (type == wanted) return true;
+  }
+  return false;
+}
+
+// A full box's table: version/flags, entry count, then fixed-size entries.
+struct Table {
+  const uint8_t* entries = nullptr;
+  uint32_t count = 0;
+};
+
+bool ReadTable(Span box, size_t entry_size, Table* table) {
+  if (box.size < 8) return false;
+  table->count = ReadBe32(box.data + 4);
+  table->entries = box.data + 8;
+  return static_cast<uint64_t>(table->count) * entry_size <= box.size - 8;
+}
+
+struct Mp4Track {
+  uint32_t timescale = 0;
+  // Media time of the first edit; B-frame streams start their composition
+  // times at the reorder delay and the edit list takes it back out.
+  int64_t media_start = 0;
+  Span stts;
+  Span stss;
+  Span ctts;
+  bool has_stss = false;
+  bool has_ctts = false;
+};
+
+int64_t FirstEditMediaTime(Span elst) {
+  if (elst.size < 8) return 0;
+  const bool wide = elst.data[0] == 1;
+  const size_t entry_size = wide ? 20 : 12;
+  Table table;
+  if (!ReadTable(elst, entry_size, &table)) return 0;
+  for (uint32_t i = 0; i < table.count; ++i) {
+    const uint8_t* entry = table.entries + i * entry_size;
+    const int64_t media_time = wide ? static_cast<int64_t>(ReadBe64(entry + 8))
+                                    : static_cast<int32_t>(ReadBe32(entry + 4));
+    // -1 marks an empty edit.
+    if (media_time >= 0) return media_time;
+  }
+  return 0;
+}
+
+bool FindVideoTrack(Span moov, Mp4Track* track) {
+  uint32_t type = 0;
+  Span trak;
+  while (NextBox(&moov, &type, &trak)) {
+    if (type != Fourcc("trak")) continue;
+    Span mdia, hdlr, mdhd, minf, stbl;
+    if (!FindBox(trak, Fourcc("mdia"), &mdia)) continue;
+    if (!FindBox(mdia, Fourcc("hdlr"), &hdlr) || hdlr.size < 12) continue;
+    if (ReadBe32(hdlr.data + 8) != Fourcc("vide")) continue;
+    if (!FindBox(mdia, Fourcc("mdhd"), &mdhd) || mdhd.size < 24) continue;
+    // Version 1 widens creation and modification time to 64 bits.
+    const bool wide = mdhd.data[0] == 1;
+    if (wide && mdhd.size < 32) continue;
+    track->timescale = ReadBe32(mdhd.data + (wide ? 20 : 12));
+    if (!FindBox(mdia, Fourcc("minf"), &minf) || !FindBox(minf, Fourcc("stbl"), &stbl)) continue;
+    if (!FindBox(stbl, Fourcc("stts"), &track->stts)) continue;
+    track->has_stss = FindBox(stbl, Fourcc("stss"), &track->stss);
+    track->has_ctts = FindBox(stbl, Fourcc("ctts"), &track->ctts);
+    Span edts, elst;
+    track->media_start = FindBox(trak, Fourcc("edts"), &edts) && FindBox(edts, Fourcc("elst"), &elst)
+                             ? FirstEditMediaTime(elst)
+                             : 0;
+    return track->timescale > 0;
+  }
+  return false;
+}
+
+// Walks the sync sample numbers in order while advancing cursors through the
+// decode-time runs (`stts`) and composition offsets (`ctts`), so the whole
+// index is one linear pass.
+bool Mp4TrackKeyframes(const Mp4Track& track, std::vector<double>* times, std::string* error) {
+  if (!track.has_stss) {
+    *error = "all_keyframes";
+    return false;
+  }
+  Table stts, stss, ctts;
+  if (!ReadTable(track.stts, 8, &stts) || !ReadTable(track.stss, 4, &stss) ||
+      (track.has_ctts && !ReadTable(track.ctts, 8, &ctts))) {
+    *error = "invalid_index";
+    return false;
+  }
+
+  std::vector<uint32_t> sync(stss.count);
+  for (uint32_t i = 0; i < stss.count; ++i) sync[i] = ReadBe32(stss.entries + i * 4);
+  std::sort(sync.begin(), sync.end());
+
+  uint32_t run = 0;
+  uint64_t run_first = 1;
+  int64_t run_dts = 0;
+  uint32_t offset_run = 0;
+  uint64_t offset_first = 1;
+
+  times->clear();
+  times->reserve(sync.size());
+  for (uint32_t sample : sync) {
+    if (sample == 0) continue;
+    while (run < stts.count) {
+      const uint32_t count = ReadBe32(stts.entries + run * 8);
+      if (sample < run_first + count) break;
+      run_dts += static_cast<int64_t>(count) * ReadBe32(stts.entries + run * 8 + 4);
+      run_first += count;
+      ++run;
+    }
+    if (run == stts.count) break;
+    int64_t pts = run_dts + static_cast<int64_t>(sample - run_first) * ReadBe32(stts.entries + run * 8 + 4);
+
+    while (offset_run < ctts.count) {
+      const uint32_t count = ReadBe32(ctts.entries + offset_run * 8);
+      if (sample < offset_first + count) break;
+      offset_first += count;
+      ++offset_run;
+    }
+    // Version 0 offsets are nominally unsigned, but muxers write negative
+    // ones there too; both read fine as signed.
+    if (offset_run < ctts.count) pts += static_cast<int32_t>(ReadBe32(ctts.entries + offset_run * 8 + 4));
+
+    pts -= track.media_start;
+    times->push_back(static_cast<double>(pts < 0 ? 0 : pts) / track.timescale);
+  }
+  SortTimes(times);
+  if (times->empty()) {
+    *error = "no_index";
+    return false;
+  }
+  return true;
+}
+
+bool Mp4Keyframes(FileReader* file, std::vector<double>* times, std::string* error) {
+  // Top-level boxes are walked on disk; only `moov` is read into memory.
+  uint64_t offset = 0;
+  while (offset + 8 <= file->size()) {
+    uint8_t header[16];
+    const size_t header_bytes = file->size() - offset >= 16 ? 16 : 8;
+    if (!file->Read(offset, header, header_bytes)) break;
+    uint64_t size = ReadBe32(header);
+    uint64_t header_size = 8;
+    if (size == 1) {
+      if (header_bytes < 16) break;
+      size = ReadBe64(header + 8);
+      header_size = 16;
+    } else if (size == 0) {
+      size = file->size() - offset;
+    }
+    if (size < header_size || size > file->size() - offset) break;
+
+    if (ReadBe32(header + 4) == Fourcc("moov")) {
+      std::vector<uint8_t> moov;
+      Mp4Track track;
+      if (!file->Read(offset + header_size, size - header_size, &moov) ||
+          !FindVideoTrack(Span{moov.data(), moov.size()}, &track)) {
+        *error = "invalid_index";
+        return false;
+      }
+      return Mp4TrackKeyframes(track, times, error);
+    }
+    offset += size;
+  }
+  *error = "no_index";
+  return false;
+}
+
+// --- Matroska / WebM -------------------------------------------------------
+
+constexpr uint32_t kEbmlHeader = 0x1A45DFA3;
+constexpr uint32_t kSegment = 0x18538067;
+constexpr uint32_t kSeekHead = 0x114D9B74;
+constexpr uint32_t kSeek = 0x4DBB;
+constexpr uint32_t kSeekId = 0x53AB;
+constexpr uint32_t kSeekPosition = 0x53AC;
+constexpr uint32_t kInfo = 0x1549A966;
+constexpr uint32_t kTimecodeScale = 0x2AD7B1;
+constexpr uint32_t kTracks = 0x1654AE6B;
+constexpr uint32_t kTrackEntry = 0xAE;
+constexpr uint32_t kTrackNumber = 0xD7;
+constexpr uint32_t kTrackType = 0x83;
+constexpr uint32_t kCues = 0x1C53BB6B;
+constexpr uint32_t kCuePoint = 0xBB;
+constexpr uint32_t kCueTime = 0xB3;
+constexpr uint32_t kCueTrackPositions = 0xB7;
+constexpr uint32_t kCueTrack = 0xF7;
+constexpr uint32_t kCluster = 0x1F43B675;
+
+constexpr uint64_t kUnknownSize = ~0ull;
+constexpr uint64_t kVideoTrackType = 1;
+
+// EBML variable-length integer: the count of leading zero bits gives the
+// length. IDs keep the marker bit, sizes drop it; an all-ones size means
+// "unknown".
+bool ParseVint(const uint8_t* data, size_t available, bool is_id, uint64_t* value, size_t* length) {
+  if (available == 0 || data[0] == 0) return false;
+  size_t bytes = 1;
+  while (bytes <= 8 && !(data[0] & (0x80 >> (bytes - 1)))) ++bytes;
+  if (bytes > (is_id ? 4u : 8u) || bytes > available) return false;
+  uint64_t out = is_id ? data[0] : data[0] & (0xFFu >> bytes);
+  bool all_ones = out == (0xFFu >> bytes);
+  for (size_t i = 1; i < bytes; ++i) {
+    out = (out << 8) | data[i];
+    all_ones = all_ones && data[i] == 0xFF;
+  }
+  *value = !is_id && all_ones ? kUnknownSize : out;
+  *length = bytes;
+  return true;
+}
+
+bool ParseElementHeader(const uint8_t* data, size_t available, uint32_t* id, uint64_t* size, size_t* header) {
+  uint64_t raw_id = 0;
+  size_t id_length = 0, size_length = 0;
+  if (!ParseVint(data, available, true, &raw_id, &id_length)) return false;
+  if (!ParseVint(data + id_length, available - id_length, false, size, &size_length)) return false;
+  *id = static_cast<uint32_t>(raw_id);
+  *header = id_length + size_length;
+  return true;
+}
+
+// Takes the next child off a master element's body.
+bool NextElement(Span* rest, uint32_t* id, Span* body) {
+  uint64_t size = 0;
+  size_t header = 0;
+  if (!ParseElementHeader(rest->data, rest->size, id, &size, &header)) return false;
+  if (size == kUnknownSize || size > rest->size - header) return false;
+  body->data = rest->data + header;
+  body->size = static_cast<size_t>(size);
+  rest->data += header + body->size;
+  rest->size -= header + body->size;
+  return true;
+}
+
+uint64_t ReadUnsigned(Span body) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < body.size && i < 8; ++i) value = (value << 8) | body.data[i];
+  return value;
+}
+
+uint64_t TimecodeScale(Span info) {
+  uint32_t id = 0;
+  Span body;
+  while (NextElement(&info, &id, &body)) {
+    if (id == kTimecodeScale) return ReadUnsigned(body);
+  }
+  return 1000000;
+}
+
+uint64_t FirstVideoTrack(Span tracks) {
+  uint32_t id = 0;
+  Span entry;
+  while (NextElement(&tracks, &id, &entry)) {
+    if (id != kTrackEntry) continue;
+    uint64_t number = 0, type = 0;
+    Span field;
+    while (NextElement(&entry, &id, &field)) {
+      if (id == kTrackNumber) number = ReadUnsigned(field);
+      if (id == kTrackType) type = ReadUnsigned(field);
+    }
+    if (type == kVideoTrackType && number != 0) return number;
+  }
+  return 0;
+}
+
+// With no known video track, every cue point counts.
+void CueTimes(Span cues, uint64_t track, uint64_t scale, std::vector<double>* times) {
+  uint32_t id = 0;
+  Span point;
+  while (NextElement(&cues, &id, &point)) {
+    if (id != kCuePoint) continue;
+    uint64_t time = 0;
+    bool has_time = false, matches = track == 0;
+    Span field;
+    while (NextElement(&point, &id, &field)) {
+      if (id == kCueTime) {
+        time = ReadUnsigned(field);
+        has_time = true;
+      } else if (id == kCueTrackPositions && !matches) {
+        Span position;
+        uint32_t child = 0;
+        while (NextElement(&field, &child, &position)) {
+          if (child == kCueTrack && ReadUnsigned(position) == track) matches = true;
+        }
+      }
+    }
+    if (has_time && matches) times->push_back(static_cast<double>(time) * static_cast<double>(scale) / 1e9);
+  }
+}
+
+class MatroskaReader {
+ public:
+  explicit MatroskaReader(FileReader* file) : file_(file) {}
+
+  bool Keyframes(std::vector<double>* times, std::string* error) {
+    uint32_t id = 0;
+    uint64_t size = 0, header = 0;
+    if (!ReadHeader(0, &id, &size, &header) || id != kEbmlHeader || size == kUnknownSize) {
+      *error = "invalid_index";
+      return false;
+    }
+    const uint64_t segment = header + size;
+    if (!ReadHeader(segment, &id, &size, &header) || id != kSegment) {
+      *error = "invalid_index";
+      return false;
+    }
+    segment_data_ = segment + header;
+    segment_end_ = size == kUnknownSize || size > file_->size() - segment_data_ ? file_->size() : segment_data_ + size;
+
+    ScanTopLevel();
+    for (const auto& seek : seeks_) {
+      if (seek.first == kInfo && info_.empty()) ReadElementAt(segment_data_ + seek.second, kInfo, &info_);
+      if (seek.first == kTracks && tracks_.empty()) ReadElementAt(segment_data_ + seek.second, kTracks, &tracks_);
+      if (seek.first == kCues && cues_.empty()) ReadElementAt(segment_data_ + seek.second, kCues, &cues_);
+    }
+    if (cues_.empty()) {
+      *error = "no_index";
+      return false;
+    }
+
+    const uint64_t scale = info_.empty() ? 1000000 : TimecodeScale(Span{info_.data(), info_.size()});
+    const uint64_t track = tracks_.empty() ? 0 : FirstVideoTrack(Span{tracks_.data(), tracks_.size()});
+    times->clear();
+    CueTimes(Span{cues_.data(), cues_.size()}, track, scale, times);
+    SortTimes(times);
+    if (times->empty()) {
+      *error = "no_index";
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  bool ReadHeader(uint64_t offset, uint32_t* id, uint64_t* size, uint64_t* header) {
+    uint8_t bytes[12];
+    const uint64_t left = offset < file_->size() ? file_->size() - offset : 0;
+    const size_t length = left < sizeof(bytes) ? static_cast<size_t>(left) : sizeof(bytes);
+    size_t parsed = 0;
+    if (length == 0 || !file_->Read(offset, bytes, length)) return false;
+    if (!ParseElementHeader(bytes, length, id, size, &parsed)) return false;
+    *header = parsed;
+    return true;
+  }
+
+  bool ReadElementAt(uint64_t offset, uint32_t wanted, std::vector<uint8_t>* out) {
+    uint32_t id = 0;
+    uint64_t size = 0, header = 0;
+    if (!ReadHeader(offset, &id, &size, &header) || id != wanted || size == kUnknownSize) return false;
+    if (!file_->Read(offset + header, size, out)) {
+      out->clear();
+      return false;
+    }
+    return true;
+  }
+
+  // Reads the Segment's children up to the first Cluster. Writers usually
+  // put Info and Tracks there and the Cues at the end, reachable through the
+  // SeekHead.
+  void ScanTopLevel() {
+    uint64_t offset = segment_data_;
+    while (offset < segment_end_) {
+      uint32_t id = 0;
+      uint64_t size = 0, header = 0;
+      if (!ReadHeader(offset, &id, &size, &header) || id == kCluster || size == kUnknownSize) return;
+      if (id == kSeekHead) {
+        std::vector<uint8_t> body;
+        if (ReadElementAt(offset, kSeekHead, &body)) ParseSeekHead(Span{body.data(), body.size()});
+      } else if (id == kInfo) {
+        ReadElementAt(offset, kInfo, &info_);
+      } else if (id == kTracks) {
+        ReadElementAt(offset, kTracks, &tracks_);
+      } else if (id == kCues) {
+        ReadElementAt(offset, kCues, &cues_);
+      }
+      if (header > segment_end_ - offset || size > segment_end_ - offset - header) return;
+      offset += header + size;
+    }
+  }
+
+  void ParseSeekHead(Span head) {
+    uint32_t id = 0;
+    Span seek;
+    while (NextElement(&head, &id, &seek)) {
+      if (id != kSeek) continue;
+      uint64_t target = 0, position = 0;
+      bool has_position = false;
+      Span field;
+      while (NextElement(&seek, &id, &field)) {
+        if (id == kSeekId) target = ReadUnsigned(field);
+        if (id == kSeekPosition) {
+          position = ReadUnsigned(field);
+          has_position = true;
+        }
+      }
+      if (target != 0 && has_position) seeks_.emplace_back(static_cast<uint32_t>(target), position);
+    }
+  }
+
+  FileReader* file_;
+  uint64_t segment_data_ = 0;
+  uint64_t segment_end_ = 0;
+  std::vector<std::pair<uint32_t, uint64_t>> seeks_;
+  std::vector<uint8_t> info_;
+  std::vector<uint8_t> tracks_;
+  std::vector<uint8_t> cues_;
+};
+
+class KeyframeWorker : public Napi::AsyncWorker {
+ public:
+  KeyframeWorker(Napi::Env env, std::string path)
+      : Napi::AsyncWorker(env),
+        deferred_(Napi::Promise::Deferred::New(env)),
+        path_(std::move(path)) {}
+
+  Napi::Promise Promise() const { return deferred_.Promise(); }
+
+ protected:
+  void Execute() override {
+    std::string err;
+    if (!ReadKeyframeIndex(path_, &times_, &err)) SetError(err);
+  }
+
+  void OnOK() override {
+    Napi::Float64Array out = Napi::Float64Array::New(Env(), times_.size());
+    std::copy(times_.begin(), times_.end(), out.Data());
+    deferred_.Resolve(out);
+  }
+
+  void OnError(const Napi::Error& error) override {
+    deferred_.Reject(error.Value());
+  }
+
+ private:
+  Napi::Promise::Deferred deferred_;
+  std::string path_;
+  std::vector<double> times_;
+};
+
+} // namespace
+
+bool ReadKeyframeIndex(const std::string& path, std::vector<double>* times, std::string* error) {
+  FileReader file(path);
+  if (!file.IsOpen()) {
+    *error = "open_failed";
+    return false;
+  }
+  uint8_t magic[8];
+  if (!file.Read(0, magic, sizeof(magic))) {
+    *error = "unsupported_container";
+    return false;
+  }
+  if (ReadBe32(magic) == kEbmlHeader) {
+    MatroskaReader reader(&file);
+    return reader.Keyframes(times, error);
+  }
+  const uint32_t first_box = ReadBe32(magic + 4);
+  if (first_box == Fourcc("ftyp") || first_box == Fourcc("moov") || first_box == Fourcc("mdat") ||
+      first_box == Fourcc("free") || first_box == Fourcc("wide") || first_box == Fourcc("skip")) {
+    return Mp4Keyframes(&file, times, error);
+  }
+  *error = "unsupported_container";
+  return false;
+}
+
+Napi::Value ReadKeyframes(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_path").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  KeyframeWorker* worker = new KeyframeWorker(env, info[0].As<Napi::String>().Utf8Value());
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <napi.h>
+#include <string>
+#include <vector>
+
+// Presentation times, in seconds and ascending, of the keyframes of a file's
+// first video track. They come from the container's own index: `stss`, `stts`
+// and `ctts` plus the first edit in MP4 and MOV, `Cues` in Matroska and WebM.
+// Nothing is demuxed or decoded, so a 2-hour file costs a few reads. Fails
+// with `unsupported_container`, `no_index` (e.g. fragmented MP4, Matroska
+// without cues), `all_keyframes` (an MP4 track without `stss`) or
+// `invalid_index`.
+bool ReadKeyframeIndex(const std::string& path, std::vector<double>* times, std::string* error);
+
+// readKeyframes(path) -> Promise<Float64Array>, read on the libuv pool.
+Napi::Value ReadKeyframes(const Napi::CallbackInfo& info);
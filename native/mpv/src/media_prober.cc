@@ -0,0 +1,248 @@
+#include "media_prober.h"
+
+#include <algorithm>
+
+namespace {
+
+// Probing is mostly waiting on file opens, but each worker still holds an
+// mpv instance.
+constexpr unsigned kMaxProbeWorkers = 16;
+constexpr int kMaxProbeTimeoutMs = 60000;
+
+Napi::Object MediaInfoToJs(Napi::Env env, const std::string& path, const MediaInfo& info) {
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("path", Napi::String::New(env, path));
+  if (!info.error.empty()) {
+    out.Set("error", Napi::String::New(env, info.error));
+    return out;
+  }
+  out.Set("duration", Napi::Number::New(env, info.duration));
+  out.Set("width", Napi::Number::New(env, info.width));
+  out.Set("height", Napi::Number::New(env, info.height));
+  out.Set("fps", Napi::Number::New(env, info.fps));
+  out.Set("rotation", Napi::Number::New(env, info.rotation));
+  out.Set("videoCodec", Napi::String::New(env, info.video_codec));
+  out.Set("audioCodec", Napi::String::New(env, info.audio_codec));
+  out.Set("container", Napi::String::New(env, info.container));
+  out.Set("videoTracks", Napi::Number::New(env, info.video_tracks));
+  out.Set("audioTracks", Napi::Number::New(env, info.audio_tracks));
+  out.Set("subtitleTracks", Napi::Number::New(env, info.subtitle_tracks));
+  return out;
+}
+
+} // namespace
+
+Napi::Function MediaProber::Define(Napi::Env env) {
+  return DefineClass(env, "MediaProber", {
+    InstanceMethod("probe", &MediaProber::Probe),
+    InstanceMethod("cancel", &MediaProber::Cancel),
+    InstanceMethod("stats", &MediaProber::Stats),
+    InstanceMethod("destroy", &MediaProber::Destroy),
+  });
+}
+
+// new MediaProber({ threads }); threads defaults to the core count, at least 2.
+MediaProber::MediaProber(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<MediaProber>(info) {
+  Napi::Env env = info.Env();
+  env_ = env;
+  if (!g_api.handle) {
+    Napi::Error::New(env, "not_initialized").ThrowAsJavaScriptException();
+    return;
+  }
+
+  unsigned threads = std::max(2u, std::min(std::thread::hardware_concurrency(), kMaxProbeWorkers));
+  if (info.Length() > 0 && info[0].IsObject()) {
+    Napi::Value count = info[0].As<Napi::Object>().Get("threads");
+    if (count.IsNumber()) {
+      int requested = count.As<Napi::Number>().Int32Value();
+      if (requested < 1 || requested > static_cast<int>(kMaxProbeWorkers)) {
+        Napi::Error::New(env, "invalid_threads").ThrowAsJavaScriptException();
+        return;
+      }
+      threads = static_cast<unsigned>(requested);
+    }
+  }
+
+  done_tsfn_ = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}), "mpvProbeDone", 0, 1);
+  done_tsfn_.Unref(env);
+  for (unsigned i = 0; i < threads; ++i) workers_.emplace_back(&MediaProber::WorkerMain, this);
+
+  napi_add_env_cleanup_hook(env, &MediaProber::OnEnvCleanup, this);
+  cleanup_hook_ = true;
+}
+
+MediaProber::~MediaProber() {
+  Shutdown();
+}
+
+void MediaProber::OnEnvCleanup(void* ctx) {
+  auto* self = static_cast<MediaProber*>(ctx);
+  self->cleanup_hook_ = false;
+  self->Shutdown();
+}
+
+void MediaProber::Shutdown() {
+  if (cleanup_hook_) {
+    napi_remove_env_cleanup_hook(env_, &MediaProber::OnEnvCleanup, this);
+    cleanup_hook_ = false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& entry : table_->entries) entry.second.batch->cancelled.store(true);
+  for (std::thread& worker : workers_) {
+    if (worker.joinable()) worker.join();
+  }
+  workers_.clear();
+  if (done_tsfn_) {
+    done_tsfn_.Release();
+    done_tsfn_ = Napi::ThreadSafeFunction();
+  }
+}
+
+void MediaProber::WorkerMain() {
+  MetadataProber prober;
+  std::string open_error;
+  bool opened = prober.Open(&open_error);
+  for (;;) {
+    size_t index = 0;
+    std::shared_ptr<ProbeBatch> batch = Take(&index);
+    if (!batch) return;
+    MediaInfo& info = batch->results[index];
+    running_++;
+    if (!opened) {
+      info.error = open_error;
+    } else if (!prober.Probe(batch->paths[index], batch->timeout_ms, &info, &batch->cancelled) && info.error.empty()) {
+      info.error = "probe_failed";
+    }
+    running_--;
+    if (info.error.empty()) {
+      probed_++;
+    } else {
+      failed_++;
+    }
+    if (--batch->remaining == 0) Deliver(batch);
+  }
+}
+
+// Hands out the next file of the oldest batch; exhausted or cancelled
+// batches leave the queue.
+std::shared_ptr<ProbeBatch> MediaProber::Take(size_t* index) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    if (stop_) return nullptr;
+    while (!queue_.empty()) {
+      std::shared_ptr<ProbeBatch> batch = queue_.front();
+      if (!batch->cancelled.load()) {
+        size_t claimed = batch->next.fetch_add(1);
+        if (claimed < batch->paths.size()) {
+          *index = claimed;
+          return batch;
+        }
+      }
+      queue_.pop_front();
+    }
+    cv_.wait(lock);
+  }
+}
+
+// Runs on a worker thread; the promise is settled on the JS thread.
+void MediaProber::Deliver(const std::shared_ptr<ProbeBatch>& batch) {
+  std::shared_ptr<ProbeBatchTable> table = table_;
+  done_tsfn_.NonBlockingCall([batch, table](Napi::Env env, Napi::Function) {
+    auto it = table->entries.find(batch->id);
+    // Already rejected by cancel() or destroy().
+    if (it == table->entries.end()) return;
+    Napi::Promise::Deferred deferred = it->second.deferred;
+    table->entries.erase(it);
+    Napi::Array out = Napi::Array::New(env, batch->paths.size());
+    for (size_t i = 0; i < batch->paths.size(); ++i) {
+      out.Set(static_cast<uint32_t>(i), MediaInfoToJs(env, batch->paths[i], batch->results[i]));
+    }
+    deferred.Resolve(out);
+  });
+}
+
+// probe(paths, { timeoutMs }) -> Promise<Array<{ path, duration, width,
+// height, fps, rotation, videoCodec, audioCodec, container, videoTracks,
+// audioTracks, subtitleTracks } | { path, error }>>, in input order. A file
+// that cannot be opened gets an error entry instead of failing the batch.
+// width/height are the stored size; rotation is in degrees.
+Napi::Value MediaProber::Probe(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (workers_.empty()) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    Napi::Error::New(env, "missing_paths").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  auto batch = std::make_shared<ProbeBatch>();
+  Napi::Array paths = info[0].As<Napi::Array>();
+  for (uint32_t i = 0; i < paths.Length(); ++i) {
+    Napi::Value path = paths.Get(i);
+    if (!path.IsString()) {
+      Napi::Error::New(env, "invalid_path").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    batch->paths.push_back(path.As<Napi::String>().Utf8Value());
+  }
+  if (info.Length() > 1 && info[1].IsObject()) {
+    Napi::Value timeout = info[1].As<Napi::Object>().Get("timeoutMs");
+    if (timeout.IsNumber()) batch->timeout_ms = std::clamp(timeout.As<Napi::Number>().Int32Value(), 1, kMaxProbeTimeoutMs);
+  }
+
+  Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+  if (batch->paths.empty()) {
+    deferred.Resolve(Napi::Array::New(env, 0));
+    return deferred.Promise();
+  }
+  batch->results.resize(batch->paths.size());
+  batch->remaining.store(batch->paths.size());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch->id = next_id_++;
+    queue_.push_back(batch);
+  }
+  table_->entries.emplace(batch->id, ProbeBatchTable::Entry{ batch, deferred });
+  cv_.notify_all();
+  return deferred.Promise();
+}
+
+// Rejects every batch in flight with `cancelled`; running probes abort.
+Napi::Value MediaProber::Cancel(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  bool any = !table_->entries.empty();
+  for (auto& entry : table_->entries) {
+    entry.second.batch->cancelled.store(true);
+    entry.second.deferred.Reject(Napi::Error::New(env, "cancelled").Value());
+  }
+  table_->entries.clear();
+  return Napi::Boolean::New(env, any);
+}
+
+Napi::Value MediaProber::Stats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("threads", Napi::Number::New(env, static_cast<double>(workers_.size())));
+  out.Set("batches", Napi::Number::New(env, static_cast<double>(table_->entries.size())));
+  out.Set("running", Napi::Number::New(env, running_.load()));
+  out.Set("probed", Napi::Number::New(env, static_cast<double>(probed_.load())));
+  out.Set("failed", Napi::Number::New(env, static_cast<double>(failed_.load())));
+  return out;
+}
+
+Napi::Value MediaProber::Destroy(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Shutdown();
+  for (auto& entry : table_->entries) {
+    entry.second.deferred.Reject(Napi::Error::New(env, "destroyed").Value());
+  }
+  table_->entries.clear();
+  return Napi::Boolean::New(env, true);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "metadata_prober.h"
+
+// One probe(paths) call. Workers claim indices from `next`; whoever finishes
+// the last file settles the promise.
+struct ProbeBatch {
+  uint64_t id = 0;
+  std::vector<std::string> paths;
+  std::vector<MediaInfo> results;
+  int timeout_ms = 5000;
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> remaining{0};
+  std::atomic<bool> cancelled{false};
+};
+
+// Promises of batches still in flight. JS thread only; shared with queued
+// completion calls.
+struct ProbeBatchTable {
+  struct Entry {
+    std::shared_ptr<ProbeBatch> batch;
+    Napi::Promise::Deferred deferred;
+  };
+  std::unordered_map<uint64_t, Entry> entries;
+};
+
+// Parallel metadata probing on worker threads that each keep a demux-only mpv
+// instance warm. A batch is spread across all workers, so one large library
+// listing is probed as fast as the storage allows.
+class MediaProber : public Napi::ObjectWrap<MediaProber> {
+ public:
+  static Napi::Function Define(Napi::Env env);
+
+  explicit MediaProber(const Napi::CallbackInfo& info);
+  ~MediaProber() override;
+
+  Napi::Value Probe(const Napi::CallbackInfo& info);
+  Napi::Value Cancel(const Napi::CallbackInfo& info);
+  Napi::Value Stats(const Napi::CallbackInfo& info);
+  Napi::Value Destroy(const Napi::CallbackInfo& info);
+
+ private:
+  static void OnEnvCleanup(void* ctx);
+
+  void WorkerMain();
+  std::shared_ptr<ProbeBatch> Take(size_t* index);
+  void Deliver(const std::shared_ptr<ProbeBatch>& batch);
+  void Shutdown();
+
+  napi_env env_ = nullptr;
+  bool cleanup_hook_ = false;
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::shared_ptr<ProbeBatch>> queue_;
+  bool stop_ = false;
+  uint64_t next_id_ = 1;
+
+  Napi::ThreadSafeFunction done_tsfn_;
+  std::shared_ptr<ProbeBatchTable> table_ = std::make_shared<ProbeBatchTable>();
+
+  std::atomic<uint64_t> probed_{0};
+  std::atomic<uint64_t> failed_{0};
+  std::atomic<int> running_{0};
+};
@@ -0,0 +1,83 @@
+#include "memory_budget.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr EvictionStep kSteps[] = {
+  EvictionStep::kFramePool,
+  EvictionStep::kIdlePlayers,
+  EvictionStep::kDemuxerCache,
+};
+
+} // namespace
+
+uint64_t MemoryUsage::Total() const {
+  return frames + frame_pool + render_buffers + demuxer_cache + thumbnail_index;
+}
+
+void MemoryBudget::Add(MemoryOwner* owner) {
+  owners_.push_back(owner);
+}
+
+void MemoryBudget::Remove(MemoryOwner* owner) {
+  auto it = std::find(owners_.begin(), owners_.end(), owner);
+  if (it == owners_.end()) return;
+  if (trimming_) {
+    *it = nullptr;
+  } else {
+    owners_.erase(it);
+  }
+}
+
+MemoryUsage MemoryBudget::Usage() const {
+  MemoryUsage usage;
+  for (MemoryOwner* owner : owners_) {
+    if (owner) owner->ReportMemory(&usage);
+  }
+  return usage;
+}
+
+TrimResult MemoryBudget::Trim(Napi::Env env) {
+  TrimResult result;
+  uint64_t total = Usage().Total();
+  if (limit_ == 0 || total <= limit_) return result;
+
+  const uint64_t before = total;
+  trimming_ = true;
+  for (EvictionStep step : kSteps) {
+    bool acted = false;
+    for (size_t i = 0; i < owners_.size(); ++i) {
+      if (owners_[i] && owners_[i]->ReleaseMemory(env, step)) acted = true;
+    }
+    if (!acted) continue;
+    result.steps++;
+    total = Usage().Total();
+    if (total <= limit_) break;
+  }
+  trimming_ = false;
+  owners_.erase(std::remove(owners_.begin(), owners_.end(), nullptr), owners_.end());
+
+  result.released = before > total ? before - total : 0;
+  result.within_budget = total <= limit_;
+  trims_++;
+  released_bytes_ += result.released;
+  return result;
+}
+
+Napi::Object MemoryBudget::UsageToJs(Napi::Env env) const {
+  const MemoryUsage usage = Usage();
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("budget", Napi::Number::New(env, static_cast<double>(limit_)));
+  out.Set("total", Napi::Number::New(env, static_cast<double>(usage.Total())));
+  out.Set("frames", Napi::Number::New(env, static_cast<double>(usage.frames)));
+  out.Set("framePool", Napi::Number::New(env, static_cast<double>(usage.frame_pool)));
+  out.Set("renderBuffers", Napi::Number::New(env, static_cast<double>(usage.render_buffers)));
+  out.Set("demuxerCache", Napi::Number::New(env, static_cast<double>(usage.demuxer_cache)));
+  out.Set("thumbnailIndex", Napi::Number::New(env, static_cast<double>(usage.thumbnail_index)));
+  out.Set("players", Napi::Number::New(env, usage.players));
+  out.Set("idlePlayers", Napi::Number::New(env, usage.idle_players));
+  out.Set("trims", Napi::Number::New(env, static_cast<double>(trims_)));
+  out.Set("releasedBytes", Napi::Number::New(env, static_cast<double>(released_bytes_)));
+  return out;
+}
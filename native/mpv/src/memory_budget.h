@@ -0,0 +1,67 @@
+#pragma once
+
+#include <napi.h>
+#include <cstdint>
+#include <vector>
+
+// Addon-owned memory in one environment, by kind. Bytes are what the addon
+// allocated or mpv reports; mpv's decoder and VO state are not included.
+struct MemoryUsage {
+  uint64_t frames = 0;          // frame slots handed to JS (ring and render thread)
+  uint64_t frame_pool = 0;      // slots parked by resizes for reuse
+  uint64_t render_buffers = 0;  // native staging and conversion buffers
+  uint64_t demuxer_cache = 0;   // demuxer-cache-state total-bytes
+  uint64_t thumbnail_index = 0; // mapped thumbnail cache indexes
+  uint32_t players = 0;
+  uint32_t idle_players = 0;    // unleased preview players and the standby
+
+  uint64_t Total() const;
+};
+
+// Eviction steps, in the order they run: cheapest to undo first.
+enum class EvictionStep {
+  kFramePool,     // drop parked frame buffers
+  kIdlePlayers,   // shut down unleased preview players and the standby
+  kDemuxerCache,  // switch players to the low-memory cache profile
+};
+
+// Anything that holds addon memory. Only called on the JS thread.
+class MemoryOwner {
+ public:
+  virtual ~MemoryOwner() = default;
+  virtual void ReportMemory(MemoryUsage* usage) = 0;
+  // Returns true when the step freed (or will free) something.
+  virtual bool ReleaseMemory(Napi::Env env, EvictionStep step) = 0;
+};
+
+struct TrimResult {
+  uint64_t released = 0;
+  uint32_t steps = 0;
+  bool within_budget = true;
+};
+
+// Per-environment registry of MemoryOwners with an optional byte limit.
+// Trim() runs the eviction steps in order until usage fits the limit. The
+// budget is shared with its owners so either side may be destroyed first.
+class MemoryBudget {
+ public:
+  void Add(MemoryOwner* owner);
+  void Remove(MemoryOwner* owner);
+
+  // 0 means unlimited.
+  void set_limit(uint64_t bytes) { limit_ = bytes; }
+  uint64_t limit() const { return limit_; }
+
+  MemoryUsage Usage() const;
+  TrimResult Trim(Napi::Env env);
+  Napi::Object UsageToJs(Napi::Env env) const;
+
+ private:
+  std::vector<MemoryOwner*> owners_;
+  // Owners removed during Trim() (a finalizer can run while players shut
+  // down) are nulled and compacted afterwards.
+  bool trimming_ = false;
+  uint64_t limit_ = 0;
+  uint64_t trims_ = 0;
+  uint64_t released_bytes_ = 0;
+};
@@ -0,0 +1,180 @@
+#include "metadata_prober.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+double NowSeconds() {
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+std::string GetString(mpv_handle* handle, const std::string& name) {
+  std::string out;
+  if (char* value = g_api.mpv_get_property_string(handle, name.c_str())) {
+    out = value;
+    g_api.mpv_free(value);
+  }
+  return out;
+}
+
+int64_t GetInt(mpv_handle* handle, const std::string& name) {
+  int64_t value = 0;
+  if (g_api.mpv_get_property(handle, name.c_str(), MPV_FORMAT_INT64, &value) < 0) return 0;
+  return value;
+}
+
+double GetDouble(mpv_handle* handle, const std::string& name) {
+  double value = 0.0;
+  if (g_api.mpv_get_property(handle, name.c_str(), MPV_FORMAT_DOUBLE, &value) < 0) return 0.0;
+  return value;
+}
+
+bool GetFlag(mpv_handle* handle, const std::string& name) {
+  int value = 0;
+  if (g_api.mpv_get_property(handle, name.c_str(), MPV_FORMAT_FLAG, &value) < 0) return false;
+  return value != 0;
+}
+
+} // namespace
+
+MetadataProber::~MetadataProber() {
+  Close();
+}
+
+bool MetadataProber::Open(std::string* err) {
+  if (handle_) return true;
+  handle_ = g_api.mpv_create();
+  if (!handle_) {
+    if (err) *err = "mpv_create_failed";
+    return false;
+  }
+
+  // Demux-only setup: no tracks selected, no outputs, no readahead beyond the
+  // headers, nothing that loads extra files.
+  g_api.mpv_set_option_string(handle_, "terminal", "no");
+  g_api.mpv_set_option_string(handle_, "msg-level", "all=error");
+  g_api.mpv_set_option_string(handle_, "vo", "null");
+  g_api.mpv_set_option_string(handle_, "ao", "null");
+  g_api.mpv_set_option_string(handle_, "vid", "no");
+  g_api.mpv_set_option_string(handle_, "aid", "no");
+  g_api.mpv_set_option_string(handle_, "sid", "no");
+  g_api.mpv_set_option_string(handle_, "pause", "yes");
+  g_api.mpv_set_option_string(handle_, "idle", "yes");
+  g_api.mpv_set_option_string(handle_, "cache", "no");
+  g_api.mpv_set_option_string(handle_, "demuxer-readahead-secs", "0");
+  g_api.mpv_set_option_string(handle_, "ytdl", "no");
+  g_api.mpv_set_option_string(handle_, "load-scripts", "no");
+  g_api.mpv_set_option_string(handle_, "autoload-files", "no");
+  g_api.mpv_set_option_string(handle_, "sub-auto", "no");
+  g_api.mpv_set_option_string(handle_, "audio-file-auto", "no");
+
+  if (g_api.mpv_initialize(handle_) < 0) {
+    g_api.mpv_terminate_destroy(handle_);
+    handle_ = nullptr;
+    if (err) *err = "mpv_initialize_failed";
+    return false;
+  }
+  return true;
+}
+
+void MetadataProber::Close() {
+  if (handle_) {
+    g_api.mpv_terminate_destroy(handle_);
+    handle_ = nullptr;
+  }
+}
+
+bool MetadataProber::Probe(const std::string& path, int timeout_ms, MediaInfo* info, const std::atomic<bool>* cancel) {
+  if (!handle_) {
+    info->error = "not_ready";
+    return false;
+  }
+
+  const char* load[] = { "loadfile", path.c_str(), nullptr };
+  if (g_api.mpv_command(handle_, load) < 0) {
+    info->error = "load_failed";
+    return false;
+  }
+
+  double deadline = NowSeconds() + timeout_ms / 1000.0;
+  bool ok = WaitForLoad(deadline, cancel, &info->error);
+  if (ok) ReadInfo(info);
+
+  const char* stop[] = { "stop", nullptr };
+  g_api.mpv_command(handle_, stop);
+  return ok;
+}
+
+// FILE_LOADED arrives once the demuxer has opened the file and the track
+// list is populated. Events from the previous file precede START_FILE.
+bool MetadataProber::WaitForLoad(double deadline, const std::atomic<bool>* cancel, std::string* error) {
+  bool started = false;
+  for (;;) {
+    double remaining = deadline - NowSeconds();
+    if (remaining <= 0) {
+      *error = "timeout";
+      return false;
+    }
+    if (cancel && cancel->load()) {
+      *error = "cancelled";
+      return false;
+    }
+
+    // Short waits keep cancellation responsive.
+    mpv_event* event = g_api.mpv_wait_event(handle_, std::min(remaining, 0.05));
+    switch (event->event_id) {
+      case MPV_EVENT_START_FILE:
+        started = true;
+        break;
+      case MPV_EVENT_FILE_LOADED:
+        if (started) return true;
+        break;
+      case MPV_EVENT_END_FILE:
+        if (started) {
+          *error = "open_failed";
+          return false;
+        }
+        break;
+      case MPV_EVENT_SHUTDOWN:
+        *error = "destroyed";
+        return false;
+      default:
+        break;
+    }
+  }
+}
+
+void MetadataProber::ReadInfo(MediaInfo* info) {
+  info->duration = GetDouble(handle_, "duration");
+  info->container = GetString(handle_, "file-format");
+
+  // The first real video track (not embedded cover art) and the first audio
+  // track describe the file.
+  bool have_video = false;
+  bool have_audio = false;
+  const int64_t count = GetInt(handle_, "track-list/count");
+  for (int64_t i = 0; i < count; ++i) {
+    const std::string prefix = "track-list/" + std::to_string(i) + "/";
+    const std::string type = GetString(handle_, prefix + "type");
+    if (type == "video") {
+      if (GetFlag(handle_, prefix + "albumart")) continue;
+      info->video_tracks++;
+      if (have_video) continue;
+      have_video = true;
+      info->video_codec = GetString(handle_, prefix + "codec");
+      info->width = static_cast<int>(GetInt(handle_, prefix + "demux-w"));
+      info->height = static_cast<int>(GetInt(handle_, prefix + "demux-h"));
+      info->fps = GetDouble(handle_, prefix + "demux-fps");
+      info->rotation = static_cast<int>(GetInt(handle_, prefix + "demux-rotation"));
+    } else if (type == "audio") {
+      info->audio_tracks++;
+      if (have_audio) continue;
+      have_audio = true;
+      info->audio_codec = GetString(handle_, prefix + "codec");
+    } else if (type == "sub") {
+      info->subtitle_tracks++;
+    }
+  }
+}
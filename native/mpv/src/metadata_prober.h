@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "mpv_api.h"
+
+// Container-level metadata, read from the demuxer without decoding.
+struct MediaInfo {
+  double duration = 0.0;
+  int width = 0;
+  int height = 0;
+  double fps = 0.0;
+  int rotation = 0;
+  std::string video_codec;
+  std::string audio_codec;
+  std::string container;
+  int video_tracks = 0;
+  int audio_tracks = 0;
+  int subtitle_tracks = 0;
+  std::string error;
+};
+
+// Headless mpv with every track deselected (vid/aid/sid=no, vo/ao=null): a
+// load opens the container, reads the headers and stops, so no decoder is
+// ever created. Size, codec and frame rate come from the track list's demuxer
+// fields. Not thread-safe: one probe at a time.
+class MetadataProber {
+ public:
+  MetadataProber() = default;
+  ~MetadataProber();
+  MetadataProber(const MetadataProber&) = delete;
+  MetadataProber& operator=(const MetadataProber&) = delete;
+
+  bool Open(std::string* err);
+  void Close();
+  bool IsOpen() const { return handle_ != nullptr; }
+
+  // `cancel` may be flipped from another thread to abort the wait early.
+  bool Probe(const std::string& path, int timeout_ms, MediaInfo* info, const std::atomic<bool>* cancel);
+
+ private:
+  bool WaitForLoad(double deadline, const std::atomic<bool>* cancel, std::string* error);
+  void ReadInfo(MediaInfo* info);
+
+  mpv_handle* handle_ = nullptr;
+};
@@ -0,0 +1,142 @@
+#include "mpv_api.h"
+
+#if !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+MpvApi g_api;
+std::string g_api_path;
+
+namespace {
+
+bool ResolveSymbol(const MpvApi& api, const char* name, void** out, std::string* err) {
+#if defined(_WIN32)
+  FARPROC sym = GetProcAddress(api.handle, name);
+  if (!sym) {
+    if (err) *err = "missing_symbol";
+    return false;
+  }
+  *out = reinterpret_cast<void*>(sym);
+  return true;
+#else
+  void* sym = dlsym(api.handle, name);
+  if (!sym) {
+    if (err) *err = "missing_symbol";
+    return false;
+  }
+  *out = sym;
+  return true;
+#endif
+}
+
+const char* const kFallbackNames[] = {
+#if defined(_WIN32)
+  "libmpv-2.dll",
+  "mpv-2.dll",
+#elif defined(__APPLE__)
+  "libmpv.2.dylib",
+  "libmpv.dylib",
+#else
+  "libmpv.so.2",
+  "libmpv.so",
+#endif
+};
+
+bool ResolveSymbols(MpvApi* api, std::string* err) {
+  if (!ResolveSymbol(*api, "mpv_create", reinterpret_cast<void**>(&api->mpv_create), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_initialize", reinterpret_cast<void**>(&api->mpv_initialize), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_command", reinterpret_cast<void**>(&api->mpv_command), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_command_async", reinterpret_cast<void**>(&api->mpv_command_async), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_terminate_destroy", reinterpret_cast<void**>(&api->mpv_terminate_destroy), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_set_option_string", reinterpret_cast<void**>(&api->mpv_set_option_string), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_set_property_string", reinterpret_cast<void**>(&api->mpv_set_property_string), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_get_property", reinterpret_cast<void**>(&api->mpv_get_property), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_set_property", reinterpret_cast<void**>(&api->mpv_set_property), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_get_property_async", reinterpret_cast<void**>(&api->mpv_get_property_async), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_set_property_async", reinterpret_cast<void**>(&api->mpv_set_property_async), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_get_property_string", reinterpret_cast<void**>(&api->mpv_get_property_string), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_free", reinterpret_cast<void**>(&api->mpv_free), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_free_node_contents", reinterpret_cast<void**>(&api->mpv_free_node_contents), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_observe_property", reinterpret_cast<void**>(&api->mpv_observe_property), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_unobserve_property", reinterpret_cast<void**>(&api->mpv_unobserve_property), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_wait_event", reinterpret_cast<void**>(&api->mpv_wait_event), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_wakeup", reinterpret_cast<void**>(&api->mpv_wakeup), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_get_time_us", reinterpret_cast<void**>(&api->mpv_get_time_us), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_render_context_create", reinterpret_cast<void**>(&api->mpv_render_context_create), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_render_context_render", reinterpret_cast<void**>(&api->mpv_render_context_render), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_render_context_set_update_callback", reinterpret_cast<void**>(&api->mpv_render_context_set_update_callback), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_render_context_update", reinterpret_cast<void**>(&api->mpv_render_context_update), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_render_context_get_info", reinterpret_cast<void**>(&api->mpv_render_context_get_info), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_render_context_report_swap", reinterpret_cast<void**>(&api->mpv_render_context_report_swap), err)) return false;
+  if (!ResolveSymbol(*api, "mpv_render_context_free", reinterpret_cast<void**>(&api->mpv_render_context_free), err)) return false;
+
+  return true;
+}
+
+} // namespace
+
+bool LoadMpvApi(const std::string& path, MpvApi* api, std::string* err) {
+  *api = MpvApi();
+#if defined(_WIN32)
+  api->handle = LoadLibraryA(path.c_str());
+#else
+  api->handle = dlopen(path.c_str(), RTLD_LAZY | RTLD_LOCAL);
+#endif
+  if (!api->handle) {
+    if (err) *err = "load_failed";
+    return false;
+  }
+  if (!ResolveSymbols(api, err)) {
+    UnloadMpvApi(api);
+    return false;
+  }
+  return true;
+}
+
+void UnloadMpvApi(MpvApi* api) {
+  if (!api->handle) return;
+#if defined(_WIN32)
+  FreeLibrary(api->handle);
+#else
+  dlclose(api->handle);
+#endif
+  *api = MpvApi();
+}
+
+bool LoadFirstMpvApi(const std::vector<std::string>& candidates, MpvApi* api, std::string* loaded, std::string* err) {
+  std::string last_err = "load_failed";
+  for (const std::string& candidate : candidates) {
+    if (candidate.empty()) continue;
+    if (LoadMpvApi(candidate, api, &last_err)) {
+      *loaded = candidate;
+      return true;
+    }
+  }
+  for (const char* name : kFallbackNames) {
+    if (LoadMpvApi(name, api, &last_err)) {
+      *loaded = name;
+      return true;
+    }
+  }
+  if (err) *err = last_err;
+  return false;
+}
+
+bool LoadLibraryWithPath(const std::string& path, std::string* err) {
+  if (g_api.handle) return true;
+  MpvApi api;
+  if (!LoadMpvApi(path, &api, err)) return false;
+  g_api = api;
+  g_api_path = path;
+  return true;
+}
+
+bool LoadLibraryFallback(std::string* err) {
+  if (g_api.handle) return true;
+  MpvApi api;
+  std::string loaded;
+  if (!LoadFirstMpvApi({}, &api, &loaded, err)) return false;
+  g_api = api;
+  g_api_path = loaded;
+  return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mpv/client.h"
+#include "mpv/render.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+// libmpv entry points, resolved at runtime from the library passed to init().
+struct MpvApi {
+#if defined(_WIN32)
+  HMODULE handle = nullptr;
+#else
+  void* handle = nullptr;
+#endif
+  mpv_handle* (*mpv_create)();
+  int (*mpv_initialize)(mpv_handle*);
+  int (*mpv_command)(mpv_handle*, const char**);
+  int (*mpv_command_async)(mpv_handle*, uint64_t, const char**);
+  void (*mpv_terminate_destroy)(mpv_handle*);
+  int (*mpv_set_option_string)(mpv_handle*, const char*, const char*);
+  int (*mpv_set_property_string)(mpv_handle*, const char*, const char*);
+  int (*mpv_get_property)(mpv_handle*, const char*, mpv_format, void*);
+  int (*mpv_set_property)(mpv_handle*, const char*, mpv_format, void*);
+  int (*mpv_get_property_async)(mpv_handle*, uint64_t, const char*, mpv_format);
+  int (*mpv_set_property_async)(mpv_handle*, uint64_t, const char*, mpv_format, void*);
+  char* (*mpv_get_property_string)(mpv_handle*, const char*);
+  void (*mpv_free)(void*);
+  void (*mpv_free_node_contents)(mpv_node*);
+  int (*mpv_observe_property)(mpv_handle*, uint64_t, const char*, mpv_format);
+  int (*mpv_unobserve_property)(mpv_handle*, uint64_t);
+  mpv_event* (*mpv_wait_event)(mpv_handle*, double);
+  void (*mpv_wakeup)(mpv_handle*);
+  int64_t (*mpv_get_time_us)(mpv_handle*);
+  int (*mpv_render_context_create)(mpv_render_context **, mpv_handle *, mpv_render_param *);
+  void (*mpv_render_context_render)(mpv_render_context *, mpv_render_param *);
+  void (*mpv_render_context_set_update_callback)(mpv_render_context *, mpv_render_update_fn, void *);
+  uint64_t (*mpv_render_context_update)(mpv_render_context *);
+  int (*mpv_render_context_get_info)(mpv_render_context *, mpv_render_param);
+  void (*mpv_render_context_report_swap)(mpv_render_context *);
+  void (*mpv_render_context_free)(mpv_render_context *);
+};
+
+extern MpvApi g_api;
+// Path or name g_api was loaded from.
+extern std::string g_api_path;
+
+// Load into `api` without touching g_api, so they can run on any thread; the
+// result is published by assigning g_api on the JS thread. A library missing
+// a symbol is closed again.
+bool LoadMpvApi(const std::string& path, MpvApi* api, std::string* err);
+void UnloadMpvApi(MpvApi* api);
+// Tries `candidates` in order, then the platform's library names.
+bool LoadFirstMpvApi(const std::vector<std::string>& candidates, MpvApi* api, std::string* loaded, std::string* err);
+
+bool LoadLibraryWithPath(const std::string& path, std::string* err);
+bool LoadLibraryFallback(std::string* err);
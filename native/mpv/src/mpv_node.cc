@@ -0,0 +1,126 @@
+#include "mpv_node.h"
+
+#include <cmath>
+
+void CopyNode(const mpv_node& node, NodeValue* out) {
+  out->format = node.format;
+  switch (node.format) {
+    case MPV_FORMAT_STRING:
+      out->text = node.u.string ? node.u.string : "";
+      break;
+    case MPV_FORMAT_FLAG:
+      out->flag = node.u.flag != 0;
+      break;
+    case MPV_FORMAT_INT64:
+      out->number = static_cast<double>(node.u.int64);
+      break;
+    case MPV_FORMAT_DOUBLE:
+      out->number = node.u.double_;
+      break;
+    case MPV_FORMAT_NODE_ARRAY:
+    case MPV_FORMAT_NODE_MAP: {
+      const mpv_node_list* list = node.u.list;
+      if (!list) break;
+      out->children.resize(list->num);
+      if (node.format == MPV_FORMAT_NODE_MAP) out->keys.reserve(list->num);
+      for (int i = 0; i < list->num; ++i) {
+        if (node.format == MPV_FORMAT_NODE_MAP) out->keys.push_back(list->keys[i]);
+        CopyNode(list->values[i], &out->children[i]);
+      }
+      break;
+    }
+    default:
+      out->format = MPV_FORMAT_NONE;
+      break;
+  }
+}
+
+Napi::Value NodeToJs(Napi::Env env, const NodeValue& node) {
+  switch (node.format) {
+    case MPV_FORMAT_STRING: return Napi::String::New(env, node.text);
+    case MPV_FORMAT_FLAG: return Napi::Boolean::New(env, node.flag);
+    case MPV_FORMAT_INT64:
+    case MPV_FORMAT_DOUBLE: return Napi::Number::New(env, node.number);
+    case MPV_FORMAT_NODE_ARRAY: {
+      Napi::Array out = Napi::Array::New(env, node.children.size());
+      for (size_t i = 0; i < node.children.size(); ++i) {
+        out.Set(static_cast<uint32_t>(i), NodeToJs(env, node.children[i]));
+      }
+      return out;
+    }
+    case MPV_FORMAT_NODE_MAP: {
+      Napi::Object out = Napi::Object::New(env);
+      for (size_t i = 0; i < node.children.size(); ++i) {
+        out.Set(node.keys[i], NodeToJs(env, node.children[i]));
+      }
+      return out;
+    }
+    default: return env.Null();
+  }
+}
+
+bool NodeArena::FromJs(Napi::Value value, mpv_node* out) {
+  return Convert(value, out, 0);
+}
+
+bool NodeArena::Convert(Napi::Value value, mpv_node* out, int depth) {
+  if (depth > kMaxDepth) return false;
+  if (value.IsBoolean()) {
+    out->format = MPV_FORMAT_FLAG;
+    out->u.flag = value.As<Napi::Boolean>().Value() ? 1 : 0;
+    return true;
+  }
+  if (value.IsNumber()) {
+    // Integer options reject doubles, while double options take int64.
+    double number = value.As<Napi::Number>().DoubleValue();
+    if (std::isfinite(number) && std::trunc(number) == number && std::fabs(number) < 9007199254740992.0) {
+      out->format = MPV_FORMAT_INT64;
+      out->u.int64 = static_cast<int64_t>(number);
+    } else {
+      out->format = MPV_FORMAT_DOUBLE;
+      out->u.double_ = number;
+    }
+    return true;
+  }
+  if (value.IsString()) {
+    strings_.push_back(value.As<Napi::String>().Utf8Value());
+    out->format = MPV_FORMAT_STRING;
+    out->u.string = &strings_.back()[0];
+    return true;
+  }
+  if (!value.IsObject() || value.IsFunction()) return false;
+
+  bool is_array = value.IsArray();
+  Napi::Object object = value.As<Napi::Object>();
+  Napi::Array names = is_array ? Napi::Array() : object.GetPropertyNames();
+  uint32_t count = is_array ? value.As<Napi::Array>().Length() : names.Length();
+
+  values_.emplace_back(count);
+  std::vector<mpv_node>& children = values_.back();
+  std::vector<char*>* keys = nullptr;
+  if (!is_array) {
+    keys_.emplace_back(count);
+    keys = &keys_.back();
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    Napi::Value child;
+    if (is_array) {
+      child = object.Get(i);
+    } else {
+      Napi::Value key = names.Get(i);
+      strings_.push_back(key.As<Napi::String>().Utf8Value());
+      (*keys)[i] = &strings_.back()[0];
+      child = object.Get(key);
+    }
+    if (!Convert(child, &children[i], depth + 1)) return false;
+  }
+
+  lists_.push_back(mpv_node_list{});
+  mpv_node_list& list = lists_.back();
+  list.num = static_cast<int>(count);
+  list.values = children.data();
+  list.keys = keys ? keys->data() : nullptr;
+  out->format = is_array ? MPV_FORMAT_NODE_ARRAY : MPV_FORMAT_NODE_MAP;
+  out->u.list = &list;
+  return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <napi.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "mpv_api.h"
+
+// Owned copy of an mpv_node tree (a `node` property read or observation).
+// mpv's own node is only valid until it frees it, often on another thread
+// than the one that converts the value for JS.
+struct NodeValue {
+  mpv_format format = MPV_FORMAT_NONE;
+  std::string text;
+  double number = 0.0;
+  bool flag = false;
+  // Maps fill `keys` in step with `children`; arrays leave it empty.
+  std::vector<std::string> keys;
+  std::vector<NodeValue> children;
+};
+
+void CopyNode(const mpv_node& node, NodeValue* out);
+
+// Maps become objects and arrays arrays; byte arrays and unset nodes are null.
+Napi::Value NodeToJs(Napi::Env env, const NodeValue& node);
+
+// Builds mpv_node trees from JS values for MPV_FORMAT_NODE calls. Booleans
+// become flags, integral numbers int64, other numbers doubles, and arrays and
+// plain objects nested lists. The arena owns every string and list the nodes
+// point into, so it must outlive the mpv call that reads them.
+class NodeArena {
+ public:
+  // False for values with no node form (null, undefined, functions) or trees
+  // nested deeper than kMaxDepth.
+  bool FromJs(Napi::Value value, mpv_node* out);
+
+ private:
+  static constexpr int kMaxDepth = 16;
+
+  bool Convert(Napi::Value value, mpv_node* out, int depth);
+
+  std::deque<std::string> strings_;
+  std::deque<mpv_node_list> lists_;
+  std::deque<std::vector<mpv_node>> values_;
+  std::deque<std::vector<char*>> keys_;
+};
@@ -0,0 +1,73 @@
+#include "path_util.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/types.h>
+#endif
+
+#if defined(_WIN32)
+std::wstring Widen(const std::string& text) {
+  int length = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, nullptr, 0);
+  std::wstring out(length > 0 ? length - 1 : 0, L'\0');
+  if (length > 1) MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, &out[0], length);
+  return out;
+}
+
+std::string Narrow(const wchar_t* text, size_t length) {
+  int bytes = WideCharToMultiByte(CP_UTF8, 0, text, static_cast<int>(length), nullptr, 0, nullptr, nullptr);
+  std::string out(bytes > 0 ? bytes : 0, '\0');
+  if (bytes > 0) WideCharToMultiByte(CP_UTF8, 0, text, static_cast<int>(length), &out[0], bytes, nullptr, nullptr);
+  return out;
+}
+#endif
+
+std::string JoinPath(const std::string& dir, const std::string& name) {
+  if (dir.empty()) return name;
+  char last = dir.back();
+  if (last == '/' || last == kPathSeparator) return dir + name;
+  return dir + kPathSeparator + name;
+}
+
+std::FILE* OpenPath(const std::string& path, const char* mode) {
+#if defined(_WIN32)
+  return _wfopen(Widen(path).c_str(), Widen(mode).c_str());
+#else
+  return std::fopen(path.c_str(), mode);
+#endif
+}
+
+bool SeekTo(std::FILE* file, uint64_t offset) {
+#if defined(_WIN32)
+  return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+  return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+uint64_t FileSize(std::FILE* file) {
+#if defined(_WIN32)
+  if (_fseeki64(file, 0, SEEK_END) != 0) return 0;
+  __int64 size = _ftelli64(file);
+#else
+  if (fseeko(file, 0, SEEK_END) != 0) return 0;
+  off_t size = ftello(file);
+#endif
+  return size > 0 ? static_cast<uint64_t>(size) : 0;
+}
+
+bool RenamePath(const std::string& from, const std::string& to) {
+#if defined(_WIN32)
+  return MoveFileExW(Widen(from).c_str(), Widen(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+bool RemovePath(const std::string& path) {
+#if defined(_WIN32)
+  return DeleteFileW(Widen(path).c_str()) != 0;
+#else
+  return std::remove(path.c_str()) == 0;
+#endif
+}
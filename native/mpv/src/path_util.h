@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Paths cross the JS boundary as UTF-8; Windows file APIs want UTF-16.
+#if defined(_WIN32)
+std::wstring Widen(const std::string& text);
+std::string Narrow(const wchar_t* text, size_t length);
+#endif
+
+constexpr char kPathSeparator =
+#if defined(_WIN32)
+  '\\';
+#else
+  '/';
+#endif
+
+std::string JoinPath(const std::string& dir, const std::string& name);
+std::FILE* OpenPath(const std::string& path, const char* mode);
+// 64-bit offsets on every platform.
+bool SeekTo(std::FILE* file, uint64_t offset);
+// Leaves the file positioned at its end.
+uint64_t FileSize(std::FILE* file);
+bool RenamePath(const std::string& from, const std::string& to);
+bool RemovePath(const std::string& path);
@@ -0,0 +1,84 @@
+#include "perf_stats.h"
+
+namespace {
+
+int BucketFor(uint64_t us) {
+  int bucket = 0;
+  while (us > 0 && bucket < LatencyHistogram::kBuckets - 1) {
+    us >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+// Interpolates within the bucket holding the q-th sample; the top bucket is
+// bounded by the recorded maximum.
+double Percentile(const uint64_t* buckets, uint64_t count, uint64_t max_us, double q) {
+  const double rank = q * static_cast<double>(count);
+  uint64_t seen = 0;
+  for (int i = 0; i < LatencyHistogram::kBuckets; ++i) {
+    if (buckets[i] == 0) continue;
+    if (static_cast<double>(seen + buckets[i]) >= rank) {
+      const double lower = i == 0 ? 0.0 : static_cast<double>(1ull << (i - 1));
+      double upper = static_cast<double>(1ull << i);
+      if (upper > static_cast<double>(max_us)) upper = static_cast<double>(max_us);
+      if (upper < lower) upper = lower;
+      const double within = (rank - static_cast<double>(seen)) / static_cast<double>(buckets[i]);
+      return (lower + (upper - lower) * within) / 1000.0;
+    }
+    seen += buckets[i];
+  }
+  return static_cast<double>(max_us) / 1000.0;
+}
+
+} // namespace
+
+void LatencyHistogram::Record(int64_t us) {
+  const uint64_t value = us > 0 ? static_cast<uint64_t>(us) : 0;
+  buckets_[BucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+  sum_us_.fetch_add(value, std::memory_order_relaxed);
+  uint64_t max = max_us_.load(std::memory_order_relaxed);
+  while (value > max && !max_us_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+HistogramSummary LatencyHistogram::Summarize() const {
+  uint64_t buckets[kBuckets];
+  uint64_t count = 0;
+  for (int i = 0; i < kBuckets; ++i) {
+    buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    count += buckets[i];
+  }
+  HistogramSummary out;
+  if (count == 0) return out;
+  const uint64_t max_us = max_us_.load(std::memory_order_relaxed);
+  out.count = count;
+  out.mean_ms = static_cast<double>(sum_us_.load(std::memory_order_relaxed)) / static_cast<double>(count) / 1000.0;
+  out.p50_ms = Percentile(buckets, count, max_us, 0.50);
+  out.p90_ms = Percentile(buckets, count, max_us, 0.90);
+  out.p99_ms = Percentile(buckets, count, max_us, 0.99);
+  out.max_ms = static_cast<double>(max_us) / 1000.0;
+  return out;
+}
+
+void LatencyHistogram::Reset() {
+  for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+  sum_us_.store(0, std::memory_order_relaxed);
+  max_us_.store(0, std::memory_order_relaxed);
+}
+
+ScopedTimer::~ScopedTimer() {
+  auto elapsed = std::chrono::steady_clock::now() - start_;
+  histogram_->Record(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+Napi::Object HistogramToJs(Napi::Env env, const HistogramSummary& summary) {
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("count", Napi::Number::New(env, static_cast<double>(summary.count)));
+  out.Set("mean", Napi::Number::New(env, summary.mean_ms));
+  out.Set("p50", Napi::Number::New(env, summary.p50_ms));
+  out.Set("p90", Napi::Number::New(env, summary.p90_ms));
+  out.Set("p99", Napi::Number::New(env, summary.p99_ms));
+  out.Set("max", Napi::Number::New(env, summary.max_ms));
+  return out;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+struct HistogramSummary {
+  uint64_t count = 0;
+  double mean_ms = 0.0;
+  double p50_ms = 0.0;
+  double p90_ms = 0.0;
+  double p99_ms = 0.0;
+  double max_ms = 0.0;
+};
+
+// Latency histogram with power-of-two microsecond buckets. Recording is a
+// handful of relaxed atomic adds, so any thread can write while another
+// summarizes; a summary taken mid-write may be off by that one sample.
+class LatencyHistogram {
+ public:
+  // Bucket 0 holds samples under 1 us; bucket i holds [2^(i-1), 2^i) us, and
+  // the last one everything above ~8 s.
+  static constexpr int kBuckets = 24;
+
+  void Record(int64_t us);
+  HistogramSummary Summarize() const;
+  void Reset();
+
+ private:
+  std::atomic<uint64_t> buckets_[kBuckets] = {};
+  std::atomic<uint64_t> sum_us_{0};
+  std::atomic<uint64_t> max_us_{0};
+};
+
+// Records the lifetime of the scope into a histogram.
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(LatencyHistogram* histogram)
+      : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer();
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  LatencyHistogram* histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+Napi::Object HistogramToJs(Napi::Env env, const HistogramSummary& summary);
@@ -0,0 +1,225 @@
+#include "pixel_kernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VHUB_PIXEL_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define VHUB_PIXEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// BT.709 limited-range coefficients in 8.8 fixed point. Each chroma row sums
+// to zero so gray stays at 128.
+constexpr int kYr = 47, kYg = 157, kYb = 16;
+constexpr int kUr = -26, kUg = -86, kUb = 112;
+constexpr int kVr = 112, kVg = -102, kVb = -10;
+
+inline uint8_t Luma(const uint8_t* p) {
+  return static_cast<uint8_t>(((kYr * p[0] + kYg * p[1] + kYb * p[2] + 128) >> 8) + 16);
+}
+
+inline uint8_t Chroma(const uint8_t* p, int r, int g, int b) {
+  return static_cast<uint8_t>(((r * p[0] + g * p[1] + b * p[2] + 128) >> 8) + 128);
+}
+
+inline uint8_t Average(uint8_t a, uint8_t b) {
+  return static_cast<uint8_t>((a + b + 1) >> 1);
+}
+
+#if defined(VHUB_PIXEL_SSE2)
+// Splits 8 RGBA pixels into 16-bit R, G and B lanes.
+inline void LoadChannels(const uint8_t* px, __m128i* r, __m128i* g, __m128i* b) {
+  const __m128i mask = _mm_set1_epi32(0xFF);
+  __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px));
+  __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px + 16));
+  *r = _mm_packs_epi32(_mm_and_si128(lo, mask), _mm_and_si128(hi, mask));
+  *g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 8), mask),
+                       _mm_and_si128(_mm_srli_epi32(hi, 8), mask));
+  *b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 16), mask),
+                       _mm_and_si128(_mm_srli_epi32(hi, 16), mask));
+}
+
+// The luma sum stays below 2^16, so it is computed unsigned; chroma sums fit
+// in signed 16 bits.
+inline void Luma8(const uint8_t* px, uint8_t* out) {
+  __m128i r, g, b;
+  LoadChannels(px, &r, &g, &b);
+  __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(kYr)),
+                                            _mm_mullo_epi16(g, _mm_set1_epi16(kYg))),
+                              _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(kYb)),
+                                            _mm_set1_epi16(128)));
+  __m128i y = _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(y, y));
+}
+
+inline __m128i Chroma8(__m128i r, __m128i g, __m128i b, int cr, int cg, int cb) {
+  __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(static_cast<short>(cr))),
+                                            _mm_mullo_epi16(g, _mm_set1_epi16(static_cast<short>(cg)))),
+                              _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(static_cast<short>(cb))),
+                                            _mm_set1_epi16(128)));
+  __m128i c = _mm_add_epi16(_mm_srai_epi16(sum, 8), _mm_set1_epi16(128));
+  return _mm_packus_epi16(c, c);
+}
+#elif defined(VHUB_PIXEL_NEON)
+inline void Luma8(const uint8_t* px, uint8_t* out) {
+  uint8x8x4_t p = vld4_u8(px);
+  uint16x8_t sum = vmull_u8(p.val[0], vdup_n_u8(kYr));
+  sum = vmlal_u8(sum, p.val[1], vdup_n_u8(kYg));
+  sum = vmlal_u8(sum, p.val[2], vdup_n_u8(kYb));
+  sum = vaddq_u16(sum, vdupq_n_u16(128));
+  vst1_u8(out, vadd_u8(vshrn_n_u16(sum, 8), vdup_n_u8(16)));
+}
+
+inline uint8x8_t Chroma8(int16x8_t r, int16x8_t g, int16x8_t b, int cr, int cg, int cb) {
+  int16x8_t sum = vmulq_n_s16(r, static_cast<int16_t>(cr));
+  sum = vmlaq_n_s16(sum, g, static_cast<int16_t>(cg));
+  sum = vmlaq_n_s16(sum, b, static_cast<int16_t>(cb));
+  sum = vaddq_s16(sum, vdupq_n_s16(128));
+  return vqmovun_s16(vaddq_s16(vshrq_n_s16(sum, 8), vdupq_n_s16(128)));
+}
+#endif
+
+} // namespace
+
+bool ParsePixelFormat(const std::string& name, PixelFormat* format) {
+  if (name == "rgba") {
+    *format = PixelFormat::kRgba;
+  } else if (name == "bgra") {
+    *format = PixelFormat::kBgra;
+  } else if (name == "i420" || name == "yuv420p") {
+    *format = PixelFormat::kI420;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char* PixelFormatName(PixelFormat format) {
+  switch (format) {
+    case PixelFormat::kBgra: return "bgra";
+    case PixelFormat::kI420: return "i420";
+    default: return "rgba";
+  }
+}
+
+size_t FrameBytes(PixelFormat format, int width, int height) {
+  const size_t w = static_cast<size_t>(width);
+  const size_t h = static_cast<size_t>(height);
+  if (format != PixelFormat::kI420) return w * h * 4;
+  return w * h + 2 * ((w + 1) / 2) * ((h + 1) / 2);
+}
+
+void SwapRedBlue(uint8_t* data, size_t pixels) {
+  size_t i = 0;
+#if defined(VHUB_PIXEL_SSE2)
+  const __m128i rb = _mm_set1_epi32(0x00FF00FF);
+  for (; i + 4 <= pixels; i += 4) {
+    __m128i* at = reinterpret_cast<__m128i*>(data + i * 4);
+    __m128i p = _mm_loadu_si128(at);
+    __m128i swapped = _mm_and_si128(p, rb);
+    swapped = _mm_or_si128(_mm_srli_epi32(swapped, 16), _mm_slli_epi32(swapped, 16));
+    _mm_storeu_si128(at, _mm_or_si128(swapped, _mm_andnot_si128(rb, p)));
+  }
+#elif defined(VHUB_PIXEL_NEON)
+  for (; i + 16 <= pixels; i += 16) {
+    uint8x16x4_t p = vld4q_u8(data + i * 4);
+    uint8x16_t r = p.val[0];
+    p.val[0] = p.val[2];
+    p.val[2] = r;
+    vst4q_u8(data + i * 4, p);
+  }
+#endif
+  for (; i < pixels; ++i) {
+    uint8_t* p = data + i * 4;
+    uint8_t r = p[0];
+    p[0] = p[2];
+    p[2] = r;
+  }
+}
+
+void DownscaleHalf(const uint8_t* src, size_t src_stride, int width, int height,
+                   uint8_t* dst, size_t dst_stride) {
+  const int out_w = (width + 1) / 2;
+  const int out_h = (height + 1) / 2;
+  for (int oy = 0; oy < out_h; ++oy) {
+    const uint8_t* row0 = src + static_cast<size_t>(oy) * 2 * src_stride;
+    const uint8_t* row1 = oy * 2 + 1 < height ? row0 + src_stride : row0;
+    uint8_t* out = dst + static_cast<size_t>(oy) * dst_stride;
+    int ox = 0;
+#if defined(VHUB_PIXEL_SSE2)
+    // Average the two rows, then pair even and odd pixels: 8 in, 4 out.
+    for (; ox * 2 + 8 <= width; ox += 4) {
+      const __m128i* a = reinterpret_cast<const __m128i*>(row0 + ox * 8);
+      const __m128i* b = reinterpret_cast<const __m128i*>(row1 + ox * 8);
+      __m128i v0 = _mm_avg_epu8(_mm_loadu_si128(a), _mm_loadu_si128(b));
+      __m128i v1 = _mm_avg_epu8(_mm_loadu_si128(a + 1), _mm_loadu_si128(b + 1));
+      v0 = _mm_shuffle_epi32(v0, _MM_SHUFFLE(3, 1, 2, 0));
+      v1 = _mm_shuffle_epi32(v1, _MM_SHUFFLE(3, 1, 2, 0));
+      __m128i even = _mm_unpacklo_epi64(v0, v1);
+      __m128i odd = _mm_unpackhi_epi64(v0, v1);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + ox * 4), _mm_avg_epu8(even, odd));
+    }
+#elif defined(VHUB_PIXEL_NEON)
+    for (; ox * 2 + 8 <= width; ox += 4) {
+      const uint8_t* a = row0 + ox * 8;
+      const uint8_t* b = row1 + ox * 8;
+      uint32x4_t v0 = vreinterpretq_u32_u8(vrhaddq_u8(vld1q_u8(a), vld1q_u8(b)));
+      uint32x4_t v1 = vreinterpretq_u32_u8(vrhaddq_u8(vld1q_u8(a + 16), vld1q_u8(b + 16)));
+      uint32x4x2_t pairs = vuzpq_u32(v0, v1);
+      vst1q_u8(out + ox * 4, vrhaddq_u8(vreinterpretq_u8_u32(pairs.val[0]),
+                                        vreinterpretq_u8_u32(pairs.val[1])));
+    }
+#endif
+    for (; ox < out_w; ++ox) {
+      const int x0 = ox * 2;
+      const int x1 = x0 + 1 < width ? x0 + 1 : x0;
+      for (int c = 0; c < 4; ++c) {
+        uint8_t left = Average(row0[x0 * 4 + c], row1[x0 * 4 + c]);
+        uint8_t right = Average(row0[x1 * 4 + c], row1[x1 * 4 + c]);
+        out[ox * 4 + c] = Average(left, right);
+      }
+    }
+  }
+}
+
+void RgbaToI420(const uint8_t* src, int width, int height, uint8_t* dst, uint8_t* scratch) {
+  const size_t luma = static_cast<size_t>(width) * static_cast<size_t>(height);
+  size_t i = 0;
+#if defined(VHUB_PIXEL_SSE2) || defined(VHUB_PIXEL_NEON)
+  for (; i + 8 <= luma; i += 8) Luma8(src + i * 4, dst + i);
+#endif
+  for (; i < luma; ++i) dst[i] = Luma(src + i * 4);
+
+  // Chroma is sampled from the 2x2 box average of each block.
+  const int chroma_w = (width + 1) / 2;
+  const int chroma_h = (height + 1) / 2;
+  const size_t chroma = static_cast<size_t>(chroma_w) * static_cast<size_t>(chroma_h);
+  DownscaleHalf(src, static_cast<size_t>(width) * 4, width, height, scratch,
+                static_cast<size_t>(chroma_w) * 4);
+  uint8_t* u = dst + luma;
+  uint8_t* v = u + chroma;
+  i = 0;
+#if defined(VHUB_PIXEL_SSE2)
+  for (; i + 8 <= chroma; i += 8) {
+    __m128i r, g, b;
+    LoadChannels(scratch + i * 4, &r, &g, &b);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(u + i), Chroma8(r, g, b, kUr, kUg, kUb));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(v + i), Chroma8(r, g, b, kVr, kVg, kVb));
+  }
+#elif defined(VHUB_PIXEL_NEON)
+  for (; i + 8 <= chroma; i += 8) {
+    uint8x8x4_t p = vld4_u8(scratch + i * 4);
+    int16x8_t r = vreinterpretq_s16_u16(vmovl_u8(p.val[0]));
+    int16x8_t g = vreinterpretq_s16_u16(vmovl_u8(p.val[1]));
+    int16x8_t b = vreinterpretq_s16_u16(vmovl_u8(p.val[2]));
+    vst1_u8(u + i, Chroma8(r, g, b, kUr, kUg, kUb));
+    vst1_u8(v + i, Chroma8(r, g, b, kVr, kVg, kVb));
+  }
+#endif
+  for (; i < chroma; ++i) {
+    u[i] = Chroma(scratch + i * 4, kUr, kUg, kUb);
+    v[i] = Chroma(scratch + i * 4, kVr, kVg, kVb);
+  }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Layout of the frames handed to JS. RGBA feeds ImageData; BGRA matches the
+// canvas backing store (and VideoFrame's BGRX), so the browser skips its
+// swizzle; I420 is three consecutive planes (Y, then U and V at half size in
+// both directions) for a WebGL or VideoFrame YUV path. Video is opaque, so
+// the premultiplied and straight variants are identical.
+enum class PixelFormat { kRgba, kBgra, kI420 };
+
+bool ParsePixelFormat(const std::string& name, PixelFormat* format);
+const char* PixelFormatName(PixelFormat format);
+size_t FrameBytes(PixelFormat format, int width, int height);
+
+// Swaps the first and third byte of each 4-byte pixel (RGBA <-> BGRA).
+void SwapRedBlue(uint8_t* data, size_t pixels);
+
+// 2:1 box filter of packed RGBA. The destination is (width+1)/2 by
+// (height+1)/2; an odd last row or column is averaged with itself.
+void DownscaleHalf(const uint8_t* src, size_t src_stride, int width, int height,
+                   uint8_t* dst, size_t dst_stride);
+
+// Converts tightly packed RGBA to I420 (BT.709, limited range) laid out as in
+// FrameBytes. `scratch` must hold FrameBytes(kRgba, (width+1)/2, (height+1)/2).
+void RgbaToI420(const uint8_t* src, int width, int height, uint8_t* dst, uint8_t* scratch);
@@ -0,0 +1,1995 @@
+#include "player.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "addon_data.h"
+#include "mpv/render_gl.h"
+
+namespace {
+
+// Internal observations of the video's display size, kept clear of the ids
+// handed out to JS observers.
+constexpr uint64_t kVideoWidthId = UINT64_MAX;
+constexpr uint64_t kVideoHeightId = UINT64_MAX - 1;
+
+// Bounds for the measured display interval (250 Hz to 20 Hz), the number of
+// swaps it is measured over, and the longest the render thread sleeps ahead
+// of a frame.
+constexpr int64_t kMinDisplayIntervalUs = 4000;
+constexpr int64_t kMaxDisplayIntervalUs = 50000;
+constexpr int kDisplayIntervalWindow = 32;
+constexpr int64_t kMaxFrameWaitUs = 250000;
+
+// Bounds for the periodic stats snapshot interval.
+constexpr int kMinStatsIntervalMs = 100;
+constexpr int kMaxStatsIntervalMs = 60000;
+
+int64_t ReadInt64Property(mpv_handle* handle, const char* name) {
+  int64_t value = 0;
+  if (g_api.mpv_get_property(handle, name, MPV_FORMAT_INT64, &value) < 0) return -1;
+  return value;
+}
+
+Napi::Value OptionalCount(Napi::Env env, int64_t value) {
+  if (value < 0) return env.Null();
+  return Napi::Number::New(env, static_cast<double>(value));
+}
+
+Napi::Object StatsToJs(Napi::Env env, const StatsSnapshot& stats) {
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("render", HistogramToJs(env, stats.render));
+  out.Set("convert", HistogramToJs(env, stats.convert));
+  out.Set("copy", HistogramToJs(env, stats.copy));
+  out.Set("getProperty", HistogramToJs(env, stats.get_property));
+  out.Set("command", HistogramToJs(env, stats.command));
+
+  Napi::Object frames = Napi::Object::New(env);
+  frames.Set("rendered", Napi::Number::New(env, static_cast<double>(stats.frames_rendered)));
+  frames.Set("presented", Napi::Number::New(env, static_cast<double>(stats.frames_presented)));
+  frames.Set("held", Napi::Number::New(env, static_cast<double>(stats.frames_held)));
+  frames.Set("late", Napi::Number::New(env, static_cast<double>(stats.frames_late)));
+  frames.Set("dropped", Napi::Number::New(env, static_cast<double>(stats.frames_dropped)));
+  frames.Set("mpvDropped", OptionalCount(env, stats.mpv_frame_drops));
+  frames.Set("mpvDelayed", OptionalCount(env, stats.mpv_delayed_frames));
+  out.Set("frames", frames);
+
+  Napi::Object buffers = Napi::Object::New(env);
+  buffers.Set("allocations", Napi::Number::New(env, static_cast<double>(stats.allocations)));
+  buffers.Set("allocatedBytes", Napi::Number::New(env, static_cast<double>(stats.allocated_bytes)));
+  buffers.Set("poolHits", Napi::Number::New(env, static_cast<double>(stats.pool_hits)));
+  out.Set("buffers", buffers);
+
+  out.Set("displayInterval", Napi::Number::New(env, stats.display_interval_ms));
+  return out;
+}
+
+// Size classes with eight or more steps per power of two (at least 64 KiB),
+// so a window dragged a few pixels keeps the buffer it has.
+size_t BucketBytes(size_t bytes) {
+  size_t step = 64 * 1024;
+  while (step * 16 <= bytes) step *= 2;
+  return (bytes + step - 1) / step * step;
+}
+
+// A buffer is reused while it holds the frame and is not more than twice its
+// size, so shrinking the window eventually releases memory too.
+bool FitsBucket(size_t capacity, size_t bytes) {
+  return capacity >= bytes && capacity / 2 <= bytes;
+}
+
+// V8-owned backing store: external buffers are rejected by Electron's memory
+// cage, and this keeps the pointer stable for the slot's lifetime.
+void AllocateSlot(Napi::Env env, FrameSlot& slot, size_t bytes) {
+  Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, bytes);
+  slot.buffer.Reset();
+  slot.buffer = Napi::Persistent(buffer.As<Napi::Object>());
+  slot.buffer.SuppressDestruct();
+  slot.data = static_cast<uint8_t*>(buffer.Data());
+  slot.bytes = bytes;
+}
+
+void ResetSlot(FrameSlot& slot) {
+  slot.buffer.Reset();
+  slot.data = nullptr;
+  slot.bytes = 0;
+}
+
+void MoveSlot(FrameSlot& from, FrameSlot& to) {
+  to.buffer = std::move(from.buffer);
+  to.data = from.data;
+  to.bytes = from.bytes;
+  to.width = from.width;
+  to.height = from.height;
+  from.data = nullptr;
+  from.bytes = 0;
+}
+
+bool ReadRenderSize(const Napi::CallbackInfo& info, int* width, int* height) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
+    Napi::Error::New(env, "missing_size").ThrowAsJavaScriptException();
+    return false;
+  }
+  *width = info[0].As<Napi::Number>().Int32Value();
+  *height = info[1].As<Napi::Number>().Int32Value();
+  if (*width <= 0 || *height <= 0) {
+    Napi::Error::New(env, "invalid_size").ThrowAsJavaScriptException();
+    return false;
+  }
+  return true;
+}
+
+// Maps a policy to an mpv `hwdec` priority list. mpv tries the entries in
+// order and decodes in software once the list is exhausted. The SW renderer
+// can only consume frames in system memory, so it is limited to -copy modes;
+// the GL renderer can use interop modes directly.
+bool HwdecValueFor(const std::string& policy, bool gl, std::string* out) {
+  if (policy == "off" || policy == "no") {
+    *out = "no";
+  } else if (policy == "auto") {
+#if defined(_WIN32)
+    *out = gl ? "auto-safe,d3d11va-copy,auto-copy" : "d3d11va-copy,dxva2-copy,auto-copy";
+#elif defined(__APPLE__)
+    *out = gl ? "videotoolbox,videotoolbox-copy,auto-copy" : "videotoolbox-copy,auto-copy";
+#else
+    *out = gl ? "auto-safe,vaapi-copy,auto-copy" : "vaapi-copy,nvdec-copy,auto-copy";
+#endif
+  } else if (policy == "auto-copy") {
+    *out = "auto-copy";
+  } else if (policy == "d3d11va" || policy == "videotoolbox" || policy == "vaapi" || policy == "nvdec") {
+    *out = gl ? policy + "," + policy + "-copy,auto-copy" : policy + "-copy,auto-copy";
+  } else {
+    return false;
+  }
+  return true;
+}
+
+struct OptionValue {
+  const char* name;
+  const char* value;
+};
+
+// Demuxer buffering per storage class. Network shares keep a large forward
+// buffer and a seekable back buffer, so seeks inside what was already read
+// are served from memory instead of waiting on the share; low-memory is for
+// preview players and many concurrent instances.
+bool CacheOptionsFor(const std::string& profile, std::vector<OptionValue>* out) {
+  if (profile == "local") {
+    *out = { { "cache", "auto" }, { "cache-secs", "10" }, { "demuxer-readahead-secs", "1" },
+             { "demuxer-max-bytes", "64MiB" }, { "demuxer-max-back-bytes", "32MiB" },
+             { "demuxer-seekable-cache", "auto" } };
+  } else if (profile == "network") {
+    *out = { { "cache", "yes" }, { "cache-secs", "120" }, { "demuxer-readahead-secs", "20" },
+             { "demuxer-max-bytes", "256MiB" }, { "demuxer-max-back-bytes", "128MiB" },
+             { "demuxer-seekable-cache", "yes" } };
+  } else if (profile == "low-memory") {
+    *out = { { "cache", "no" }, { "cache-secs", "5" }, { "demuxer-readahead-secs", "1" },
+             { "demuxer-max-bytes", "16MiB" }, { "demuxer-max-back-bytes", "4MiB" },
+             { "demuxer-seekable-cache", "no" } };
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Decoder settings per use. "preview" is for grid tiles and hover players:
+// non-reference frames and the loop filter are skipped, lavc decodes at half
+// resolution where the codec supports it, scaling takes the fast path and
+// audio is off, so several instances can animate at once. "full" restores
+// mpv's defaults. Decoder options take effect from the next file.
+bool DecodeOptionsFor(const std::string& profile, std::vector<OptionValue>* out) {
+  if (profile == "full") {
+    *out = { { "vd-lavc-skipframe", "default" }, { "vd-lavc-skiploopfilter", "default" },
+             { "vd-lavc-lowres", "0" }, { "vd-lavc-fast", "no" }, { "sw-fast", "no" },
+             { "framedrop", "vo" }, { "aid", "auto" } };
+  } else if (profile == "preview") {
+    *out = { { "vd-lavc-skipframe", "nonref" }, { "vd-lavc-skiploopfilter", "all" },
+             { "vd-lavc-lowres", "1" }, { "vd-lavc-fast", "yes" }, { "sw-fast", "yes" },
+             { "framedrop", "decoder+vo" }, { "aid", "no" } };
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void ApplyOptions(mpv_handle* handle, const std::vector<OptionValue>& options) {
+  for (const OptionValue& option : options) {
+    g_api.mpv_set_property_string(handle, option.name, option.value);
+  }
+}
+
+// total-bytes of demuxer-cache-state; 0 while nothing is cached.
+uint64_t DemuxerCacheBytes(mpv_handle* handle) {
+  mpv_node node;
+  if (g_api.mpv_get_property(handle, "demuxer-cache-state", MPV_FORMAT_NODE, &node) < 0) return 0;
+  uint64_t bytes = 0;
+  if (node.format == MPV_FORMAT_NODE_MAP) {
+    for (int i = 0; i < node.u.list->num; ++i) {
+      if (std::strcmp(node.u.list->keys[i], "total-bytes") != 0) continue;
+      const mpv_node& value = node.u.list->values[i];
+      if (value.format == MPV_FORMAT_INT64 && value.u.int64 > 0) bytes = static_cast<uint64_t>(value.u.int64);
+    }
+  }
+  g_api.mpv_free_node_contents(&node);
+  return bytes;
+}
+
+// Same type names as getProperty(); anything else reads as a double.
+mpv_format FormatForType(const std::string& type) {
+  if (type == "node") return MPV_FORMAT_NODE;
+  if (type == "string") return MPV_FORMAT_STRING;
+  if (type == "bool") return MPV_FORMAT_FLAG;
+  if (type == "int") return MPV_FORMAT_INT64;
+  return MPV_FORMAT_DOUBLE;
+}
+
+Napi::Value ChangeValue(Napi::Env env, const PropertyChange& change) {
+  switch (change.format) {
+    case MPV_FORMAT_STRING: return Napi::String::New(env, change.text);
+    case MPV_FORMAT_FLAG: return Napi::Boolean::New(env, change.flag);
+    case MPV_FORMAT_INT64:
+    case MPV_FORMAT_DOUBLE: return Napi::Number::New(env, change.number);
+    case MPV_FORMAT_NODE: return NodeToJs(env, change.node);
+    default: return env.Null();
+  }
+}
+
+bool ReadCommandArgs(const Napi::CallbackInfo& info, std::vector<std::string>* args) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return false;
+  }
+  auto arr = info[0].As<Napi::Array>();
+  args->reserve(arr.Length());
+  for (uint32_t i = 0; i < arr.Length(); ++i) {
+    if (!arr.Get(i).IsString()) {
+      Napi::Error::New(env, "invalid_arg").ThrowAsJavaScriptException();
+      return false;
+    }
+    args->push_back(arr.Get(i).As<Napi::String>().Utf8Value());
+  }
+  return true;
+}
+
+// argvs of a command batch packed into one allocation: every string is
+// copied in place with its terminator, and `argv` holds the pointers with a
+// null after each command, which starts at `starts[i]`.
+struct CommandArena {
+  std::vector<char> bytes;
+  std::vector<const char*> argv;
+  std::vector<size_t> starts;
+};
+
+bool ReadCommandBatch(const Napi::CallbackInfo& info, CommandArena* arena) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return false;
+  }
+  // First pass validates and sizes, keeping the handles for the copy.
+  Napi::Array batch = info[0].As<Napi::Array>();
+  std::vector<napi_value> strings;
+  std::vector<size_t> lengths;
+  std::vector<uint32_t> counts;
+  size_t total = 0;
+  for (uint32_t i = 0; i < batch.Length(); ++i) {
+    Napi::Value command = batch.Get(i);
+    if (!command.IsArray() || command.As<Napi::Array>().Length() == 0) {
+      Napi::Error::New(env, "invalid_arg").ThrowAsJavaScriptException();
+      return false;
+    }
+    Napi::Array args = command.As<Napi::Array>();
+    for (uint32_t j = 0; j < args.Length(); ++j) {
+      Napi::Value arg = args.Get(j);
+      size_t length = 0;
+      if (!arg.IsString() || napi_get_value_string_utf8(env, arg, nullptr, 0, &length) != napi_ok) {
+        Napi::Error::New(env, "invalid_arg").ThrowAsJavaScriptException();
+        return false;
+      }
+      strings.push_back(arg);
+      lengths.push_back(length);
+      total += length + 1;
+    }
+    counts.push_back(args.Length());
+  }
+
+  arena->bytes.resize(total);
+  arena->argv.reserve(strings.size() + counts.size());
+  arena->starts.reserve(counts.size());
+  char* cursor = arena->bytes.data();
+  size_t next = 0;
+  for (uint32_t count : counts) {
+    arena->starts.push_back(arena->argv.size());
+    for (uint32_t j = 0; j < count; ++j, ++next) {
+      size_t copied = 0;
+      napi_get_value_string_utf8(env, strings[next], cursor, lengths[next] + 1, &copied);
+      arena->argv.push_back(cursor);
+      cursor += lengths[next] + 1;
+    }
+    arena->argv.push_back(nullptr);
+  }
+  return true;
+}
+
+// Copies an event's property payload; value pointers are only valid until
+// the next mpv_wait_event call.
+void ReadEventProperty(const mpv_event_property* prop, PropertyChange* change) {
+  change->name = prop->name;
+  change->format = prop->format;
+  if (prop->format == MPV_FORMAT_STRING) {
+    change->text = *static_cast<char**>(prop->data);
+  } else if (prop->format == MPV_FORMAT_FLAG) {
+    change->flag = *static_cast<int*>(prop->data) != 0;
+  } else if (prop->format == MPV_FORMAT_INT64) {
+    change->number = static_cast<double>(*static_cast<int64_t*>(prop->data));
+  } else if (prop->format == MPV_FORMAT_DOUBLE) {
+    change->number = *static_cast<double*>(prop->data);
+  } else if (prop->format == MPV_FORMAT_NODE) {
+    CopyNode(*static_cast<mpv_node*>(prop->data), &change->node);
+  }
+}
+
+} // namespace
+
+uint8_t* PixelBuffer::Reserve(size_t bytes) {
+  if (!data || !FitsBucket(capacity, bytes)) {
+    capacity = BucketBytes(bytes);
+    data.reset(new uint8_t[capacity]);
+  }
+  return data.get();
+}
+
+void PixelBuffer::Release() {
+  data.reset();
+  capacity = 0;
+}
+
+Napi::Function Player::Define(Napi::Env env) {
+  return DefineClass(env, "Player", {
+    InstanceMethod("loadFile", &Player::LoadFile),
+    InstanceMethod("stop", &Player::Stop),
+    InstanceMethod("getProperty", &Player::GetProperty),
+    InstanceMethod("command", &Player::Command),
+    InstanceMethod("commandBatch", &Player::CommandBatch),
+    InstanceMethod("setProperties", &Player::SetProperties),
+    InstanceMethod("renderFrame", &Player::RenderFrame),
+    InstanceMethod("renderFrameShared", &Player::RenderFrameShared),
+    InstanceMethod("hasNewFrame", &Player::HasNewFrame),
+    InstanceMethod("setFrameCallback", &Player::SetFrameCallback),
+    InstanceMethod("startRenderThread", &Player::StartRenderThread),
+    InstanceMethod("resizeRenderThread", &Player::ResizeRenderThread),
+    InstanceMethod("acquireFrame", &Player::AcquireFrame),
+    InstanceMethod("stopRenderThread", &Player::StopRenderThread),
+    InstanceMethod("setFrameFormat", &Player::SetFrameFormat),
+    InstanceMethod("getFrameSize", &Player::GetFrameSize),
+    InstanceMethod("reportSwap", &Player::ReportSwap),
+    InstanceMethod("getFrameTiming", &Player::GetFrameTiming),
+    InstanceMethod("getStats", &Player::GetStats),
+    InstanceMethod("resetStats", &Player::ResetStats),
+    InstanceMethod("setStatsCallback", &Player::SetStatsCallback),
+    InstanceMethod("setHwdec", &Player::SetHwdec),
+    InstanceMethod("getDecoder", &Player::GetDecoder),
+    InstanceMethod("setCacheProfile", &Player::SetCacheProfile),
+    InstanceMethod("setDecodeProfile", &Player::SetDecodeProfile),
+    InstanceMethod("getCacheProfile", &Player::GetCacheProfile),
+    InstanceMethod("getRenderApi", &Player::GetRenderApi),
+    InstanceMethod("observeProperty", &Player::ObserveProperty),
+    InstanceMethod("unobserveProperty", &Player::UnobserveProperty),
+    InstanceMethod("setPropertyCallback", &Player::SetPropertyCallback),
+    InstanceMethod("loadFileAsync", &Player::LoadFileAsync),
+    InstanceMethod("commandAsync", &Player::CommandAsync),
+    InstanceMethod("getPropertyAsync", &Player::GetPropertyAsync),
+    InstanceMethod("setPropertyAsync", &Player::SetPropertyAsync),
+    InstanceMethod("destroy", &Player::Destroy),
+  });
+}
+
+Player::Player(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Player>(info) {
+  Napi::Env env = info.Env();
+  env_ = env;
+  AddonData* data = env.GetInstanceData<AddonData>();
+  if (data) {
+    memory_ = data->memory;
+    memory_->Add(this);
+  }
+  if (!g_api.handle) {
+    Napi::Error::New(env, "not_initialized").ThrowAsJavaScriptException();
+    return;
+  }
+
+  bool gpu = false;
+  std::string hwdec = "auto";
+  std::string format = "rgba";
+  std::string cache_profile = cache_profile_;
+  std::string decode_profile = decode_profile_;
+  if (info.Length() > 0 && info[0].IsObject()) {
+    Napi::Object options = info[0].As<Napi::Object>();
+    Napi::Value opt = options.Get("gpu");
+    gpu = opt.IsBoolean() && opt.As<Napi::Boolean>().Value();
+    Napi::Value hw = options.Get("hwdec");
+    if (hw.IsString()) hwdec = hw.As<Napi::String>().Utf8Value();
+    Napi::Value fmt = options.Get("format");
+    if (fmt.IsString()) format = fmt.As<Napi::String>().Utf8Value();
+    Napi::Value fit = options.Get("fitToVideo");
+    if (fit.IsBoolean()) fit_to_video_ = fit.As<Napi::Boolean>().Value();
+    Napi::Value cache = options.Get("cacheProfile");
+    if (cache.IsString()) cache_profile = cache.As<Napi::String>().Utf8Value();
+    Napi::Value decode = options.Get("decodeProfile");
+    if (decode.IsString()) decode_profile = decode.As<Napi::String>().Utf8Value();
+  }
+  std::string unused;
+  if (!HwdecValueFor(hwdec, false, &unused)) {
+    Napi::Error::New(env, "invalid_hwdec").ThrowAsJavaScriptException();
+    return;
+  }
+  std::vector<OptionValue> cache_options;
+  if (!CacheOptionsFor(cache_profile, &cache_options)) {
+    Napi::Error::New(env, "invalid_cache_profile").ThrowAsJavaScriptException();
+    return;
+  }
+  std::vector<OptionValue> decode_options;
+  if (!DecodeOptionsFor(decode_profile, &decode_options)) {
+    Napi::Error::New(env, "invalid_decode_profile").ThrowAsJavaScriptException();
+    return;
+  }
+  if (!ParsePixelFormat(format, &frame_format_)) {
+    Napi::Error::New(env, "invalid_format").ThrowAsJavaScriptException();
+    return;
+  }
+
+  handle_ = g_api.mpv_create();
+  if (!handle_) {
+    Napi::Error::New(env, "mpv_create_failed").ThrowAsJavaScriptException();
+    return;
+  }
+
+  g_api.mpv_set_option_string(handle_, "terminal", "no");
+  g_api.mpv_set_option_string(handle_, "msg-level", "all=error");
+  g_api.mpv_set_option_string(handle_, "vo", "libmpv");
+  g_api.mpv_set_option_string(handle_, "audio", "yes");
+  g_api.mpv_set_option_string(handle_, "audio-device", "auto");
+  g_api.mpv_set_option_string(handle_, "audio-exclusive", "no");
+#if defined(_WIN32)
+  g_api.mpv_set_option_string(handle_, "ao", "wasapi");
+#elif defined(__APPLE__)
+  g_api.mpv_set_option_string(handle_, "ao", "coreaudio");
+#else
+  g_api.mpv_set_option_string(handle_, "ao", "auto");
+#endif
+
+  int res = g_api.mpv_initialize(handle_);
+  if (res < 0) {
+    g_api.mpv_terminate_destroy(handle_);
+    handle_ = nullptr;
+    Napi::Error::New(env, "mpv_initialize_failed").ThrowAsJavaScriptException();
+    return;
+  }
+
+  int r = CreateRenderContext(gpu);
+  if (r < 0) {
+    render_ctx_ = nullptr;
+    g_api.mpv_terminate_destroy(handle_);
+    handle_ = nullptr;
+    Napi::Error::New(env, "mpv_render_init_failed").ThrowAsJavaScriptException();
+    return;
+  }
+  g_api.mpv_render_context_set_update_callback(render_ctx_, &Player::OnRenderUpdate, this);
+
+  // Depends on the render API, so it is applied once the context exists.
+  if (!ApplyHwdec(hwdec)) ApplyHwdec("off");
+  ApplyCacheProfile(cache_profile);
+  ApplyDecodeProfile(decode_profile);
+
+  g_api.mpv_observe_property(handle_, kVideoWidthId, "dwidth", MPV_FORMAT_INT64);
+  g_api.mpv_observe_property(handle_, kVideoHeightId, "dheight", MPV_FORMAT_INT64);
+
+  reply_tsfn_ = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}), "mpvAsyncReply", 0, 1);
+  reply_tsfn_.Unref(env);
+  event_thread_ = std::thread(&Player::EventThreadMain, this);
+
+  napi_add_env_cleanup_hook(env, &Player::OnEnvCleanup, this);
+  cleanup_hook_ = true;
+}
+
+Player::~Player() {
+  Teardown();
+  if (memory_) memory_->Remove(this);
+}
+
+void Player::OnEnvCleanup(void* ctx) {
+  Player* self = static_cast<Player*>(ctx);
+  self->cleanup_hook_ = false;
+  self->Teardown();
+}
+
+void Player::Teardown() {
+  if (cleanup_hook_) {
+    napi_remove_env_cleanup_hook(env_, &Player::OnEnvCleanup, this);
+    cleanup_hook_ = false;
+  }
+  StopEventThread();
+  StopRenderWorker();
+  ResetFrameRing();
+  for (auto& slot : frame_pool_) ResetSlot(slot);
+  frame_pool_.clear();
+  frame_.Release();
+  convert_.Release();
+  {
+    std::lock_guard<std::mutex> lock(tsfn_mutex_);
+    if (frame_tsfn_) {
+      frame_tsfn_.Release();
+      frame_tsfn_ = Napi::ThreadSafeFunction();
+    }
+    notify_queued_ = std::make_shared<std::atomic<bool>>(false);
+  }
+  {
+    std::lock_guard<std::mutex> lock(prop_mutex_);
+    if (prop_tsfn_) {
+      prop_tsfn_.Release();
+      prop_tsfn_ = Napi::ThreadSafeFunction();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if (stats_tsfn_) {
+      stats_tsfn_.Release();
+      stats_tsfn_ = Napi::ThreadSafeFunction();
+    }
+    stats_interval_ms_.store(0);
+  }
+  observed_.clear();
+  if (reply_tsfn_) {
+    reply_tsfn_.Release();
+    reply_tsfn_ = Napi::ThreadSafeFunction();
+  }
+  pending_->requests.clear();
+  if (render_ctx_) {
+    AcquireRenderContext();
+    g_api.mpv_render_context_free(render_ctx_);
+    ReleaseRenderContext();
+    render_ctx_ = nullptr;
+  }
+  gl_.Destroy();
+  use_gl_ = false;
+  update_pending_.store(false);
+  frame_dirty_ = false;
+  if (handle_) {
+    g_api.mpv_terminate_destroy(handle_);
+    handle_ = nullptr;
+  }
+}
+
+void Player::Recycle() {
+  StopRenderWorker();
+  {
+    std::lock_guard<std::mutex> lock(tsfn_mutex_);
+    if (frame_tsfn_) {
+      frame_tsfn_.Release();
+      frame_tsfn_ = Napi::ThreadSafeFunction();
+    }
+    notify_queued_ = std::make_shared<std::atomic<bool>>(false);
+  }
+  ClearObservers();
+  {
+    std::lock_guard<std::mutex> lock(prop_mutex_);
+    if (prop_tsfn_) {
+      prop_tsfn_.Release();
+      prop_tsfn_ = Napi::ThreadSafeFunction();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if (stats_tsfn_) {
+      stats_tsfn_.Release();
+      stats_tsfn_ = Napi::ThreadSafeFunction();
+    }
+    stats_interval_ms_.store(0);
+  }
+  if (handle_) {
+    const char* cmd[] = { "stop", nullptr };
+    g_api.mpv_command(handle_, cmd);
+  }
+  frame_dirty_ = false;
+  last_width_ = 0;
+  last_height_ = 0;
+}
+
+bool Player::Preload(const std::string& path, const std::string& cache_profile, std::string* err) {
+  if (!handle_) {
+    *err = "not_ready";
+    return false;
+  }
+  if (!cache_profile.empty() && !ApplyCacheProfile(cache_profile)) {
+    *err = "invalid_cache_profile";
+    return false;
+  }
+  g_api.mpv_set_property_string(handle_, "pause", "yes");
+  const char* cmd[] = { "loadfile", path.c_str(), nullptr };
+  if (g_api.mpv_command(handle_, cmd) < 0) {
+    *err = "load_failed";
+    return false;
+  }
+  return true;
+}
+
+void Player::TakeOver(Napi::Env env, Player* from) {
+  // The user's playback settings, so switching files behaves like loadfile
+  // on the old instance would have.
+  const char* carried[] = { "volume", "mute", "speed", "pause" };
+  for (const char* name : carried) {
+    char* value = g_api.mpv_get_property_string(from->handle_, name);
+    if (!value) continue;
+    g_api.mpv_set_property_string(handle_, name, value);
+    g_api.mpv_free(value);
+  }
+  frame_format_ = from->frame_format_;
+  fit_to_video_ = from->fit_to_video_;
+  display_interval_us_.store(from->display_interval_us_.load());
+
+  {
+    std::lock_guard<std::mutex> lock(tsfn_mutex_);
+    std::lock_guard<std::mutex> other(from->tsfn_mutex_);
+    if (frame_tsfn_) frame_tsfn_.Release();
+    frame_tsfn_ = from->frame_tsfn_;
+    from->frame_tsfn_ = Napi::ThreadSafeFunction();
+    // A call already queued on the TSFN clears the flag that travels with it.
+    notify_queued_ = from->notify_queued_;
+    from->notify_queued_ = std::make_shared<std::atomic<bool>>(false);
+  }
+  {
+    std::lock_guard<std::mutex> lock(prop_mutex_);
+    std::lock_guard<std::mutex> other(from->prop_mutex_);
+    if (prop_tsfn_) prop_tsfn_.Release();
+    prop_tsfn_ = from->prop_tsfn_;
+    from->prop_tsfn_ = Napi::ThreadSafeFunction();
+  }
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    std::lock_guard<std::mutex> other(from->stats_mutex_);
+    if (stats_tsfn_) stats_tsfn_.Release();
+    stats_tsfn_ = from->stats_tsfn_;
+    stats_interval_ms_.store(from->stats_interval_ms_.load());
+    stats_due_ = from->stats_due_;
+    from->stats_tsfn_ = Napi::ThreadSafeFunction();
+    from->stats_interval_ms_.store(0);
+  }
+  g_api.mpv_wakeup(handle_);
+
+  // Observing again under the same ids makes mpv report every current value
+  // once, so JS sees the new file's state straight away.
+  ClearObservers();
+  for (const auto& entry : from->observed_) {
+    g_api.mpv_unobserve_property(from->handle_, entry.first);
+    if (g_api.mpv_observe_property(handle_, entry.first, entry.second.name.c_str(), entry.second.format) >= 0) {
+      observed_.insert(entry);
+    }
+  }
+  from->observed_.clear();
+  next_observe_id_ = std::max(next_observe_id_, from->next_observe_id_);
+  from->next_observe_id_ = next_observe_id_;
+
+  // The preloaded first frame may already be queued; render it regardless.
+  if (from->worker_.active) {
+    int width = from->worker_.requested_width;
+    int height = from->worker_.requested_height;
+    from->StopRenderWorker();
+    StartRenderWorker(env, width, height);
+    {
+      std::lock_guard<std::mutex> lock(worker_.mutex);
+      worker_.redraw = true;
+    }
+    worker_.cv.notify_one();
+  } else {
+    frame_dirty_ = true;
+  }
+  NotifyFrameReady();
+}
+
+void Player::NotifyFrameReady() {
+  std::lock_guard<std::mutex> lock(tsfn_mutex_);
+  if (!frame_tsfn_) return;
+  // Coalesce bursts into a single pending JS call.
+  std::shared_ptr<std::atomic<bool>> queued = notify_queued_;
+  if (queued->exchange(true)) return;
+  napi_status status = frame_tsfn_.NonBlockingCall([queued](Napi::Env, Napi::Function callback) {
+    queued->store(false);
+    callback.Call({});
+  });
+  if (status != napi_ok) queued->store(false);
+}
+
+void Player::OnRenderUpdate(void* ctx) {
+  Player* self = static_cast<Player*>(ctx);
+  self->update_pending_.store(true);
+  {
+    std::lock_guard<std::mutex> lock(self->worker_.mutex);
+    if (self->worker_.active) {
+      self->worker_.wake = true;
+      self->worker_.cv.notify_one();
+      return;
+    }
+  }
+  self->NotifyFrameReady();
+}
+
+// The GL context is only current around mpv_render_* calls so it can move
+// between the JS thread and the render worker.
+bool Player::AcquireRenderContext() {
+  return !use_gl_ || gl_.MakeCurrent();
+}
+
+void Player::ReleaseRenderContext() {
+  if (use_gl_) gl_.ReleaseCurrent();
+}
+
+uint64_t Player::UpdateRenderContext() {
+  if (!update_pending_.exchange(false)) return 0;
+  if (!AcquireRenderContext()) return 0;
+  uint64_t flags = g_api.mpv_render_context_update(render_ctx_);
+  ReleaseRenderContext();
+  return flags;
+}
+
+void Player::ReportSwaps(int count) {
+  if (count <= 0 || !AcquireRenderContext()) return;
+  for (int i = 0; i < count; ++i) g_api.mpv_render_context_report_swap(render_ctx_);
+  ReleaseRenderContext();
+}
+
+// Renders the current frame into dst, tightly packed in `format`. mpv only
+// outputs packed RGB, so I420 is rendered as RGBA into `scratch` and
+// converted afterwards.
+bool Player::RenderInto(uint8_t* dst, int width, int height, PixelFormat format, PixelBuffer* scratch) {
+  uint8_t* out = dst;
+  const size_t rgba_bytes = FrameBytes(PixelFormat::kRgba, width, height);
+  if (format == PixelFormat::kI420) {
+    const uint8_t* previous = scratch->data.get();
+    out = scratch->Reserve(rgba_bytes + FrameBytes(PixelFormat::kRgba, (width + 1) / 2, (height + 1) / 2));
+    if (out != previous) {
+      stats_.allocations++;
+      stats_.allocated_bytes += scratch->capacity;
+    }
+  }
+  if (!AcquireRenderContext()) return false;
+  bool ok = true;
+  auto render_start = std::chrono::steady_clock::now();
+  if (use_gl_) {
+    int fbo = 0;
+    ok = gl_.EnsureFramebuffer(width, height, &fbo);
+    if (ok) {
+      mpv_opengl_fbo target = { fbo, width, height, 0 };
+      int flip = 0;
+      int block = 0;
+      mpv_render_param params[] = {
+        { MPV_RENDER_PARAM_OPENGL_FBO, &target },
+        { MPV_RENDER_PARAM_FLIP_Y, &flip },
+        { MPV_RENDER_PARAM_BLOCK_FOR_TARGET_TIME, &block },
+        { MPV_RENDER_PARAM_INVALID, nullptr }
+      };
+      g_api.mpv_render_context_render(render_ctx_, params);
+      gl_.ReadPixels(out, width, height);
+    }
+  } else {
+    int size[2] = { width, height };
+    size_t stride = static_cast<size_t>(width) * 4;
+    // The SW renderer writes BGRA directly, so only the GL readback swizzles.
+    const char* fmt = format == PixelFormat::kBgra ? "bgra" : "rgba";
+    int block = 0;
+    mpv_render_param params[] = {
+      { MPV_RENDER_PARAM_SW_SIZE, size },
+      { MPV_RENDER_PARAM_SW_FORMAT, const_cast<char*>(fmt) },
+      { MPV_RENDER_PARAM_SW_STRIDE, &stride },
+      { MPV_RENDER_PARAM_SW_POINTER, out },
+      { MPV_RENDER_PARAM_BLOCK_FOR_TARGET_TIME, &block },
+      { MPV_RENDER_PARAM_INVALID, nullptr }
+    };
+    g_api.mpv_render_context_render(render_ctx_, params);
+  }
+  ReleaseRenderContext();
+  if (!ok) return false;
+  stats_.render.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - render_start).count());
+  stats_.frames_rendered++;
+  if (use_gl_ && format == PixelFormat::kBgra) {
+    ScopedTimer timer(&stats_.convert);
+    SwapRedBlue(out, static_cast<size_t>(width) * static_cast<size_t>(height));
+  } else if (format == PixelFormat::kI420) {
+    ScopedTimer timer(&stats_.convert);
+    RgbaToI420(out, width, height, dst, out + rgba_bytes);
+  }
+  return true;
+}
+
+int Player::CreateRenderContext(bool gpu) {
+  if (gpu && gl_.Create(nullptr) && gl_.MakeCurrent()) {
+    mpv_opengl_init_params gl_init = { GlContext::GetProcAddress, &gl_ };
+    mpv_render_param params[] = {
+      { MPV_RENDER_PARAM_API_TYPE, const_cast<char*>(MPV_RENDER_API_TYPE_OPENGL) },
+      { MPV_RENDER_PARAM_OPENGL_INIT_PARAMS, &gl_init },
+      { MPV_RENDER_PARAM_INVALID, nullptr }
+    };
+    int r = g_api.mpv_render_context_create(&render_ctx_, handle_, params);
+    gl_.ReleaseCurrent();
+    if (r >= 0) {
+      use_gl_ = true;
+      return r;
+    }
+    gl_.Destroy();
+  }
+
+  use_gl_ = false;
+  mpv_render_param params[] = {
+    { MPV_RENDER_PARAM_API_TYPE, const_cast<char*>(MPV_RENDER_API_TYPE_SW) },
+    { MPV_RENDER_PARAM_INVALID, nullptr }
+  };
+  return g_api.mpv_render_context_create(&render_ctx_, handle_, params);
+}
+
+bool Player::ApplyHwdec(const std::string& policy) {
+  std::string value;
+  if (!HwdecValueFor(policy, use_gl_, &value)) return false;
+  if (g_api.mpv_set_property_string(handle_, "hwdec", value.c_str()) < 0) return false;
+  hwdec_policy_ = policy;
+  hwdec_value_ = value;
+  return true;
+}
+
+// The options are runtime-settable; a change reaches the file being played
+// on its next demuxer refill and fully applies from the next load.
+bool Player::ApplyCacheProfile(const std::string& profile) {
+  std::vector<OptionValue> options;
+  if (!CacheOptionsFor(profile, &options)) return false;
+  ApplyOptions(handle_, options);
+  cache_profile_ = profile;
+  return true;
+}
+
+bool Player::ApplyDecodeProfile(const std::string& profile) {
+  std::vector<OptionValue> options;
+  if (!DecodeOptionsFor(profile, &options)) return false;
+  ApplyOptions(handle_, options);
+  decode_profile_ = profile;
+  return true;
+}
+
+// Drains pending update callbacks and reports whether mpv has a frame that
+// has not been rendered yet.
+bool Player::PollFrameUpdate() {
+  if (!render_ctx_) return false;
+  if (UpdateRenderContext() & MPV_RENDER_UPDATE_FRAME) frame_dirty_ = true;
+  return frame_dirty_;
+}
+
+// Target display time of the queued frame. False for redraws, untimed frames
+// or when nothing is queued.
+bool Player::NextFrameTarget(int64_t* target) {
+  mpv_render_frame_info frame = { 0, 0 };
+  mpv_render_param param = { MPV_RENDER_PARAM_NEXT_FRAME_INFO, &frame };
+  if (!AcquireRenderContext()) return false;
+  const int status = g_api.mpv_render_context_get_info(render_ctx_, param);
+  ReleaseRenderContext();
+  if (status < 0) return false;
+  if (!(frame.flags & MPV_RENDER_FRAME_INFO_PRESENT) || (frame.flags & MPV_RENDER_FRAME_INFO_REDRAW)) return false;
+  if (frame.target_time <= 0) return false;
+  *target = frame.target_time;
+  return true;
+}
+
+// Synchronous paths: leaves a frame queued while it is due more than half a
+// display interval from now, so it is drawn on the vsync nearest its target.
+bool Player::HoldEarlyFrame() {
+  int64_t target = 0;
+  if (!NextFrameTarget(&target)) return false;
+  const int64_t interval = display_interval_us_.load();
+  const int64_t lead = target - g_api.mpv_get_time_us(handle_);
+  if (lead > interval / 2) {
+    frame_dirty_ = true;
+    stats_.frames_held++;
+    return true;
+  }
+  if (-lead > interval) stats_.frames_late++;
+  return false;
+}
+
+bool Player::ShouldRender(int width, int height, bool force) {
+  bool dirty = PollFrameUpdate();
+  if (force || dirty || width != last_width_ || height != last_height_) {
+    frame_dirty_ = false;
+    last_width_ = width;
+    last_height_ = height;
+    return true;
+  }
+  return false;
+}
+
+Napi::Value Player::LoadFile(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_path").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  std::string filePath = info[0].As<Napi::String>().Utf8Value();
+
+  const char* cmd[] = { "loadfile", filePath.c_str(), nullptr };
+  int res = g_api.mpv_command(handle_, cmd);
+  if (res < 0) {
+    Napi::Error::New(env, "load_failed").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Napi::Boolean::New(env, true);
+}
+
+Napi::Value Player::Stop(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) return Napi::Boolean::New(env, true);
+  const char* cmd[] = { "stop", nullptr };
+  g_api.mpv_command(handle_, cmd);
+  return Napi::Boolean::New(env, true);
+}
+
+Napi::Value Player::GetProperty(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::string name = info[0].As<Napi::String>().Utf8Value();
+  std::string type = info[1].As<Napi::String>().Utf8Value();
+  ScopedTimer timer(&stats_.get_property);
+
+  if (type == "string") {
+    char* value = g_api.mpv_get_property_string(handle_, name.c_str());
+    if (!value) return env.Null();
+    Napi::String out = Napi::String::New(env, value);
+    g_api.mpv_free(value);
+    return out;
+  }
+
+  if (type == "bool") {
+    int flag = 0;
+    int res = g_api.mpv_get_property(handle_, name.c_str(), MPV_FORMAT_FLAG, &flag);
+    if (res < 0) return env.Null();
+    return Napi::Boolean::New(env, flag != 0);
+  }
+
+  if (type == "int") {
+    int64_t val = 0;
+    int res = g_api.mpv_get_property(handle_, name.c_str(), MPV_FORMAT_INT64, &val);
+    if (res < 0) return env.Null();
+    return Napi::Number::New(env, static_cast<double>(val));
+  }
+
+  if (type == "node") {
+    mpv_node node;
+    if (g_api.mpv_get_property(handle_, name.c_str(), MPV_FORMAT_NODE, &node) < 0) return env.Null();
+    NodeValue value;
+    CopyNode(node, &value);
+    g_api.mpv_free_node_contents(&node);
+    return NodeToJs(env, value);
+  }
+
+  double val = 0.0;
+  int res = g_api.mpv_get_property(handle_, name.c_str(), MPV_FORMAT_DOUBLE, &val);
+  if (res < 0) return env.Null();
+  return Napi::Number::New(env, val);
+}
+
+Napi::Value Player::Command(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  std::vector<std::string> args;
+  if (!ReadCommandArgs(info, &args)) return env.Null();
+
+  std::vector<const char*> cmd;
+  cmd.reserve(args.size() + 1);
+  for (const auto& arg : args) cmd.push_back(arg.c_str());
+  cmd.push_back(nullptr);
+
+  int res = 0;
+  {
+    ScopedTimer timer(&stats_.command);
+    res = g_api.mpv_command(handle_, cmd.data());
+  }
+  if (res < 0) {
+    Napi::Error::New(env, "command_failed").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Napi::Boolean::New(env, true);
+}
+
+// Runs several commands in one call, e.g. [['seek', '5'], ['set', 'pause',
+// 'no']]. Every command runs even if an earlier one fails; the result holds
+// one boolean per command.
+Napi::Value Player::CommandBatch(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  CommandArena arena;
+  if (!ReadCommandBatch(info, &arena)) return env.Null();
+
+  Napi::Array out = Napi::Array::New(env, arena.starts.size());
+  for (size_t i = 0; i < arena.starts.size(); ++i) {
+    int res = 0;
+    {
+      ScopedTimer timer(&stats_.command);
+      res = g_api.mpv_command(handle_, arena.argv.data() + arena.starts[i]);
+    }
+    out.Set(static_cast<uint32_t>(i), Napi::Boolean::New(env, res >= 0));
+  }
+  return out;
+}
+
+// Sets { name: value } pairs as typed MPV_FORMAT_NODE values (see
+// NodeArena), skipping the string round trip of `set` commands. The result
+// maps each name to whether mpv accepted it.
+Napi::Value Player::SetProperties(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 1 || !info[0].IsObject() || info[0].IsArray()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Object values = info[0].As<Napi::Object>();
+  Napi::Array names = values.GetPropertyNames();
+  Napi::Object out = Napi::Object::New(env);
+  NodeArena arena;
+  for (uint32_t i = 0; i < names.Length(); ++i) {
+    Napi::Value key = names.Get(i);
+    std::string name = key.As<Napi::String>().Utf8Value();
+    mpv_node node;
+    bool ok = arena.FromJs(values.Get(key), &node);
+    if (ok) {
+      ScopedTimer timer(&stats_.command);
+      ok = g_api.mpv_set_property(handle_, name.c_str(), MPV_FORMAT_NODE, &node) >= 0;
+    }
+    out.Set(name, Napi::Boolean::New(env, ok));
+  }
+  return out;
+}
+
+Napi::Value Player::RenderFrame(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!render_ctx_) {
+    Napi::Error::New(env, "render_not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (worker_.active) {
+    Napi::Error::New(env, "render_thread_active").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int width = 0;
+  int height = 0;
+  if (!ReadRenderSize(info, &width, &height)) return env.Null();
+  bool force = info.Length() > 2 && info[2].IsBoolean() && info[2].As<Napi::Boolean>().Value();
+  FitToVideo(&width, &height);
+  if (!ShouldRender(width, height, force)) return env.Null();
+  if (!force && HoldEarlyFrame()) return env.Null();
+
+  const size_t needed = FrameBytes(frame_format_, width, height);
+  const uint8_t* previous = frame_.data.get();
+  uint8_t* dst = frame_.Reserve(needed);
+  if (dst != previous) {
+    stats_.allocations++;
+    stats_.allocated_bytes += frame_.capacity;
+  }
+  if (!RenderInto(dst, width, height, frame_format_, &convert_)) {
+    Napi::Error::New(env, "render_failed").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  frame_width_ = width;
+  frame_height_ = height;
+  stats_.frames_presented++;
+  ScopedTimer timer(&stats_.copy);
+  return Napi::Buffer<uint8_t>::Copy(env, dst, needed);
+}
+
+void Player::ResetFrameRing() {
+  for (auto& slot : ring_) ResetSlot(slot);
+  ring_next_ = 0;
+}
+
+void Player::RenderThreadMain() {
+  RenderWorker& w = worker_;
+  for (;;) {
+    uint8_t* target = nullptr;
+    uint64_t generation = 0;
+    int width = 0;
+    int height = 0;
+    PixelFormat format = PixelFormat::kRgba;
+    bool redraw = false;
+    int swaps = 0;
+    {
+      std::unique_lock<std::mutex> lock(w.mutex);
+      w.cv.wait(lock, [&] { return w.stop || w.wake || w.redraw; });
+      if (w.stop) return;
+      w.wake = false;
+      redraw = w.redraw;
+      w.redraw = false;
+      swaps = w.pending_swaps;
+      w.pending_swaps = 0;
+      target = w.slots[w.back].data;
+      generation = w.generation;
+      width = w.width;
+      height = w.height;
+      format = w.format;
+      w.rendering = true;
+    }
+
+    bool rendered = false;
+    int64_t target_time = 0;
+    ReportSwaps(swaps);
+    uint64_t flags = UpdateRenderContext();
+    if (target && ((flags & MPV_RENDER_UPDATE_FRAME) || redraw)) {
+      // Render ahead: sleep until one display interval before the frame is
+      // due, so it is parked in `ready` by the vsync that should show it.
+      if (NextFrameTarget(&target_time)) {
+        const int64_t wait_us = target_time - display_interval_us_.load() - g_api.mpv_get_time_us(handle_);
+        if (wait_us > 0) {
+          std::unique_lock<std::mutex> lock(w.mutex);
+          w.cv.wait_for(lock, std::chrono::microseconds(std::min(wait_us, kMaxFrameWaitUs)), [&] { return w.stop; });
+          if (w.stop) {
+            w.rendering = false;
+            return;
+          }
+        }
+      }
+      rendered = RenderInto(target, width, height, format, &w.scratch);
+    }
+
+    bool swapped = false;
+    {
+      std::lock_guard<std::mutex> lock(w.mutex);
+      w.rendering = false;
+      if (rendered && generation == w.generation) {
+        // A frame JS never picked up is replaced; count it as dropped.
+        if (w.ready_fresh) stats_.frames_dropped++;
+        std::swap(w.back, w.ready);
+        w.ready_fresh = true;
+        w.ready_target = target_time;
+        swapped = true;
+      } else if (rendered) {
+        // The target was resized mid-render; draw again at the new size.
+        w.redraw = true;
+      }
+    }
+    if (swapped) NotifyFrameReady();
+  }
+}
+
+// Sizes the slots for the requested size fitted to the video, in the given
+// layout. Slots keep their buffer when it still fits; the one being rendered
+// is retired until the thread is done with it. Must run on the JS thread.
+void Player::ResizeRenderWorker(Napi::Env env, int width, int height, PixelFormat format) {
+  RenderWorker& w = worker_;
+  int fitted_width = width;
+  int fitted_height = height;
+  FitToVideo(&fitted_width, &fitted_height);
+  const size_t bytes = FrameBytes(format, fitted_width, fitted_height);
+
+  std::lock_guard<std::mutex> lock(w.mutex);
+  for (int i = 0; i < 3; ++i) {
+    if (w.rendering && i == w.back) {
+      w.retired.emplace_back();
+      MoveSlot(w.slots[i], w.retired.back());
+    }
+    EnsureSlot(env, w.slots[i], bytes);
+    w.slots[i].width = fitted_width;
+    w.slots[i].height = fitted_height;
+  }
+  w.generation++;
+  w.requested_width = width;
+  w.requested_height = height;
+  w.width = fitted_width;
+  w.height = fitted_height;
+  w.format = format;
+  w.ready_fresh = false;
+  w.redraw = true;
+  w.cv.notify_one();
+}
+
+void Player::StopRenderWorker() {
+  RenderWorker& w = worker_;
+  {
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (!w.active) return;
+    w.stop = true;
+    w.cv.notify_one();
+  }
+  if (w.thread.joinable()) w.thread.join();
+  std::lock_guard<std::mutex> lock(w.mutex);
+  w.active = false;
+  w.stop = false;
+  w.wake = false;
+  w.redraw = false;
+  w.ready_fresh = false;
+  w.pending_swaps = 0;
+  w.width = 0;
+  w.height = 0;
+  w.requested_width = 0;
+  w.requested_height = 0;
+  for (auto& slot : w.slots) ReleaseToPool(slot);
+  for (auto& slot : w.retired) ReleaseToPool(slot);
+  w.retired.clear();
+  w.scratch.Release();
+}
+
+Napi::Value Player::StartRenderThread(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!render_ctx_) {
+    Napi::Error::New(env, "render_not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int width = 0;
+  int height = 0;
+  if (!ReadRenderSize(info, &width, &height)) return env.Null();
+
+  StartRenderWorker(env, width, height);
+  return Napi::Boolean::New(env, true);
+}
+
+void Player::StartRenderWorker(Napi::Env env, int width, int height) {
+  RenderWorker& w = worker_;
+  if (w.active) {
+    if (w.requested_width != width || w.requested_height != height) {
+      ResizeRenderWorker(env, width, height, frame_format_);
+    }
+    return;
+  }
+
+  // The synchronous ring is idle while the thread runs; its buffers seed the
+  // worker's slots.
+  for (auto& slot : ring_) ReleaseToPool(slot);
+  ring_next_ = 0;
+  ResizeRenderWorker(env, width, height, frame_format_);
+  {
+    std::lock_guard<std::mutex> lock(w.mutex);
+    w.active = true;
+    w.back = 0;
+    w.ready = 1;
+    w.front = 2;
+  }
+  w.thread = std::thread(&Player::RenderThreadMain, this);
+}
+
+Napi::Value Player::ResizeRenderThread(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!worker_.active) {
+    Napi::Error::New(env, "render_thread_not_running").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int width = 0;
+  int height = 0;
+  if (!ReadRenderSize(info, &width, &height)) return env.Null();
+  if (worker_.requested_width != width || worker_.requested_height != height) {
+    ResizeRenderWorker(env, width, height, frame_format_);
+  }
+  return Napi::Boolean::New(env, true);
+}
+
+// Swaps the newest finished frame into the front slot and returns it, or null
+// when the render thread has not produced anything since the last call. A
+// change of video size since the slots were sized resizes them first.
+Napi::Value Player::AcquireFrame(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  RenderWorker& w = worker_;
+  if (w.active) {
+    int width = w.requested_width;
+    int height = w.requested_height;
+    FitToVideo(&width, &height);
+    if (width != w.width || height != w.height) {
+      ResizeRenderWorker(env, w.requested_width, w.requested_height, w.format);
+    }
+  }
+  std::lock_guard<std::mutex> lock(w.mutex);
+  if (!w.rendering && !w.retired.empty()) {
+    for (auto& slot : w.retired) ReleaseToPool(slot);
+    w.retired.clear();
+  }
+  if (!w.active || !w.ready_fresh) return env.Null();
+  // An early frame stays in `ready` (hasNewFrame stays true) until the vsync
+  // nearest its target.
+  if (w.ready_target > 0) {
+    const int64_t interval = display_interval_us_.load();
+    const int64_t lead = w.ready_target - g_api.mpv_get_time_us(handle_);
+    if (lead > interval / 2) {
+      stats_.frames_held++;
+      return env.Null();
+    }
+    if (-lead > interval) stats_.frames_late++;
+  }
+  std::swap(w.front, w.ready);
+  w.ready_fresh = false;
+  stats_.frames_presented++;
+  const FrameSlot& slot = w.slots[w.front];
+  frame_width_ = slot.width;
+  frame_height_ = slot.height;
+  return slot.buffer.Value();
+}
+
+Napi::Value Player::StopRenderThread(const Napi::CallbackInfo& info) {
+  StopRenderWorker();
+  return Napi::Boolean::New(info.Env(), true);
+}
+
+Napi::Value Player::RenderFrameShared(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!render_ctx_) {
+    Napi::Error::New(env, "render_not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (worker_.active) {
+    Napi::Error::New(env, "render_thread_active").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int width = 0;
+  int height = 0;
+  if (!ReadRenderSize(info, &width, &height)) return env.Null();
+  bool force = info.Length() > 2 && info[2].IsBoolean() && info[2].As<Napi::Boolean>().Value();
+  FitToVideo(&width, &height);
+  if (!ShouldRender(width, height, force)) return env.Null();
+  if (!force && HoldEarlyFrame()) return env.Null();
+
+  const size_t needed = FrameBytes(frame_format_, width, height);
+
+  FrameSlot& slot = ring_[ring_next_];
+  ring_next_ = (ring_next_ + 1) % kFrameRingSize;
+  EnsureSlot(env, slot, needed);
+
+  if (!RenderInto(slot.data, width, height, frame_format_, &convert_)) {
+    Napi::Error::New(env, "render_failed").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  slot.width = width;
+  slot.height = height;
+  frame_width_ = width;
+  frame_height_ = height;
+  stats_.frames_presented++;
+  return slot.buffer.Value();
+}
+
+// Switches the layout of subsequent frames. A running render thread gets a
+// fresh set of slots sized for the new layout.
+Napi::Value Player::SetFrameFormat(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  PixelFormat format = PixelFormat::kRgba;
+  if (!ParsePixelFormat(info[0].As<Napi::String>().Utf8Value(), &format)) {
+    Napi::Error::New(env, "invalid_format").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (format == frame_format_) return Napi::Boolean::New(env, true);
+  frame_format_ = format;
+  frame_dirty_ = true;
+  if (worker_.active) ResizeRenderWorker(env, worker_.requested_width, worker_.requested_height, format);
+  return Napi::Boolean::New(env, true);
+}
+
+// Size of the frame last returned by renderFrame, renderFrameShared or
+// acquireFrame, which may be smaller than requested (see fitToVideo).
+Napi::Value Player::GetFrameSize(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (frame_width_ <= 0 || frame_height_ <= 0) return env.Null();
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("width", Napi::Number::New(env, frame_width_));
+  out.Set("height", Napi::Number::New(env, frame_height_));
+  return out;
+}
+
+// Called by JS right after it draws a frame. mpv paces display-sync and frame
+// drops on the swap cadence, so this must follow every presented frame. With
+// the render thread running the swap is queued for it, since that thread may
+// be inside another mpv_render_* call.
+Napi::Value Player::ReportSwap(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!render_ctx_) {
+    Napi::Error::New(env, "render_not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  bool deferred = false;
+  {
+    std::lock_guard<std::mutex> lock(worker_.mutex);
+    if (worker_.active) {
+      worker_.pending_swaps++;
+      deferred = true;
+    }
+  }
+  if (!deferred) ReportSwaps(1);
+
+  const int64_t now = g_api.mpv_get_time_us(handle_);
+  const int64_t gap = last_swap_us_ > 0 ? now - last_swap_us_ : 0;
+  last_swap_us_ = now;
+  if (gap >= kMinDisplayIntervalUs && gap <= kMaxDisplayIntervalUs) {
+    if (window_swaps_ == 0 || gap < window_min_us_) window_min_us_ = gap;
+    if (++window_swaps_ >= kDisplayIntervalWindow) {
+      display_interval_us_.store(window_min_us_);
+      window_swaps_ = 0;
+    }
+  }
+  return Napi::Boolean::New(env, true);
+}
+
+Napi::Value Player::GetFrameTiming(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("displayInterval", Napi::Number::New(env, static_cast<double>(display_interval_us_.load()) / 1000.0));
+  out.Set("presented", Napi::Number::New(env, static_cast<double>(stats_.frames_presented.load())));
+  out.Set("held", Napi::Number::New(env, static_cast<double>(stats_.frames_held.load())));
+  out.Set("late", Napi::Number::New(env, static_cast<double>(stats_.frames_late.load())));
+  out.Set("dropped", Napi::Number::New(env, static_cast<double>(stats_.frames_dropped.load())));
+  return out;
+}
+
+// Scales a request down so it is no larger than the video in either
+// direction, keeping its aspect ratio so letterboxing does not change.
+void Player::FitToVideo(int* width, int* height) const {
+  if (!fit_to_video_) return;
+  const int video_width = video_width_.load();
+  const int video_height = video_height_.load();
+  if (video_width <= 0 || video_height <= 0) return;
+  const double scale = std::min(static_cast<double>(*width) / video_width,
+                                static_cast<double>(*height) / video_height);
+  if (scale <= 1.0) return;
+  *width = std::max(1, static_cast<int>(std::lround(*width / scale)));
+  *height = std::max(1, static_cast<int>(std::lround(*height / scale)));
+}
+
+// Gives `slot` a buffer of at least `bytes`: its own if it still fits, else
+// the smallest fitting pooled one, else a fresh size-class allocation.
+void Player::EnsureSlot(Napi::Env env, FrameSlot& slot, size_t bytes) {
+  if (slot.data && FitsBucket(slot.bytes, bytes)) return;
+  size_t best = frame_pool_.size();
+  for (size_t i = 0; i < frame_pool_.size(); ++i) {
+    if (!FitsBucket(frame_pool_[i].bytes, bytes)) continue;
+    if (best == frame_pool_.size() || frame_pool_[i].bytes < frame_pool_[best].bytes) best = i;
+  }
+  FrameSlot reused;
+  if (best < frame_pool_.size()) {
+    MoveSlot(frame_pool_[best], reused);
+    frame_pool_.erase(frame_pool_.begin() + static_cast<std::ptrdiff_t>(best));
+  }
+  ReleaseToPool(slot);
+  if (reused.data) {
+    MoveSlot(reused, slot);
+    stats_.pool_hits++;
+  } else {
+    AllocateSlot(env, slot, BucketBytes(bytes));
+    stats_.allocations++;
+    stats_.allocated_bytes += slot.bytes;
+  }
+}
+
+void Player::ReleaseToPool(FrameSlot& slot) {
+  if (!slot.data) return;
+  frame_pool_.emplace_back();
+  MoveSlot(slot, frame_pool_.back());
+  if (frame_pool_.size() > kFramePoolSize) {
+    ResetSlot(frame_pool_.front());
+    frame_pool_.erase(frame_pool_.begin());
+  }
+}
+
+Napi::Value Player::HasNewFrame(const Napi::CallbackInfo& info) {
+  if (worker_.active) {
+    std::lock_guard<std::mutex> lock(worker_.mutex);
+    return Napi::Boolean::New(info.Env(), worker_.ready_fresh);
+  }
+  return Napi::Boolean::New(info.Env(), PollFrameUpdate());
+}
+
+Napi::Value Player::SetFrameCallback(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::lock_guard<std::mutex> lock(tsfn_mutex_);
+  if (frame_tsfn_) {
+    frame_tsfn_.Release();
+    frame_tsfn_ = Napi::ThreadSafeFunction();
+  }
+  notify_queued_ = std::make_shared<std::atomic<bool>>(false);
+  if (info.Length() < 1 || !info[0].IsFunction()) return Napi::Boolean::New(env, true);
+
+  frame_tsfn_ = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "mpvFrameReady", 0, 1);
+  frame_tsfn_.Unref(env);
+  return Napi::Boolean::New(env, true);
+}
+
+Napi::Value Player::SetHwdec(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (!ApplyHwdec(info[0].As<Napi::String>().Utf8Value())) {
+    Napi::Error::New(env, "invalid_hwdec").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Napi::Boolean::New(env, true);
+}
+
+// Profiles: "local" (default), "network" (SMB/NFS shares) and "low-memory".
+// Fill state is the `demuxer-cache-state` property, observed or read as type
+// "node".
+Napi::Value Player::SetCacheProfile(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (!ApplyCacheProfile(info[0].As<Napi::String>().Utf8Value())) {
+    Napi::Error::New(env, "invalid_cache_profile").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Napi::Boolean::New(env, true);
+}
+
+Napi::Value Player::GetCacheProfile(const Napi::CallbackInfo& info) {
+  return Napi::String::New(info.Env(), cache_profile_);
+}
+
+// "full" (default) or "preview"; see DecodeOptionsFor. getDecoder() reports
+// the active profile.
+Napi::Value Player::SetDecodeProfile(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (!ApplyDecodeProfile(info[0].As<Napi::String>().Utf8Value())) {
+    Napi::Error::New(env, "invalid_decode_profile").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Napi::Boolean::New(env, true);
+}
+
+// `current` is mpv's hwdec-current: the interop actually in use for the
+// loaded file, or "no" when it fell back to software decoding.
+Napi::Value Player::GetDecoder(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("policy", Napi::String::New(env, hwdec_policy_));
+  out.Set("hwdec", Napi::String::New(env, hwdec_value_));
+  out.Set("profile", Napi::String::New(env, decode_profile_));
+  char* current = g_api.mpv_get_property_string(handle_, "hwdec-current");
+  if (current) {
+    out.Set("current", Napi::String::New(env, current));
+    g_api.mpv_free(current);
+  } else {
+    out.Set("current", env.Null());
+  }
+  return out;
+}
+
+Napi::Value Player::GetRenderApi(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!render_ctx_) return env.Null();
+  return Napi::String::New(env, use_gl_ ? MPV_RENDER_API_TYPE_OPENGL : MPV_RENDER_API_TYPE_SW);
+}
+
+void Player::Shutdown(Napi::Env env) {
+  RejectPending(env, "destroyed");
+  Teardown();
+}
+
+Napi::Value Player::Destroy(const Napi::CallbackInfo& info) {
+  Shutdown(info.Env());
+  return Napi::Boolean::New(info.Env(), true);
+}
+
+void Player::ReportMemory(MemoryUsage* usage) {
+  if (!handle_) return;
+  usage->players++;
+  for (const auto& slot : ring_) usage->frames += slot.bytes;
+  for (const auto& slot : frame_pool_) usage->frame_pool += slot.bytes;
+  usage->render_buffers += frame_.capacity + convert_.capacity;
+  {
+    RenderWorker& w = worker_;
+    std::lock_guard<std::mutex> lock(w.mutex);
+    for (const auto& slot : w.slots) usage->frames += slot.bytes;
+    for (const auto& slot : w.retired) usage->frames += slot.bytes;
+    // The render thread sizes its I420 staging buffer without the lock, so
+    // it is counted from the frame size instead of read.
+    if (w.active && w.format == PixelFormat::kI420) {
+      usage->render_buffers += BucketBytes(FrameBytes(PixelFormat::kRgba, w.width, w.height) +
+                                           FrameBytes(PixelFormat::kRgba, (w.width + 1) / 2, (w.height + 1) / 2));
+    }
+  }
+  usage->demuxer_cache += DemuxerCacheBytes(handle_);
+}
+
+// Parked buffers go first; JS may still hold views on them, so V8 frees the
+// memory on its next collection. Dropping to the low-memory cache profile is
+// the last step and shows up in getCacheProfile().
+bool Player::ReleaseMemory(Napi::Env, EvictionStep step) {
+  if (!handle_) return false;
+  if (step == EvictionStep::kFramePool) {
+    if (frame_pool_.empty()) return false;
+    for (auto& slot : frame_pool_) ResetSlot(slot);
+    frame_pool_.clear();
+    return true;
+  }
+  if (step == EvictionStep::kDemuxerCache && cache_profile_ != "low-memory") {
+    return ApplyCacheProfile("low-memory");
+  }
+  return false;
+}
+
+// Blocks in mpv_wait_event, then drains whatever else is queued so that every
+// property change from one wakeup reaches JS in a single call. mpv already
+// collapses repeated changes of a property while the queue is non-empty.
+void Player::EventThreadMain() {
+  while (!event_stop_.load()) {
+    std::vector<PropertyChange>* batch = nullptr;
+    std::vector<AsyncReply>* replies = nullptr;
+    mpv_event* event = g_api.mpv_wait_event(handle_, EventWaitSeconds());
+    while (event && event->event_id != MPV_EVENT_NONE) {
+      if (event->event_id == MPV_EVENT_SHUTDOWN) {
+        event_stop_.store(true);
+        break;
+      }
+      if (event->event_id == MPV_EVENT_PROPERTY_CHANGE &&
+          (event->reply_userdata == kVideoWidthId || event->reply_userdata == kVideoHeightId)) {
+        const mpv_event_property* prop = static_cast<mpv_event_property*>(event->data);
+        int value = prop->format == MPV_FORMAT_INT64 ? static_cast<int>(*static_cast<int64_t*>(prop->data)) : 0;
+        (event->reply_userdata == kVideoWidthId ? video_width_ : video_height_).store(value);
+      } else if (event->event_id == MPV_EVENT_PROPERTY_CHANGE) {
+        PropertyChange change;
+        change.id = event->reply_userdata;
+        ReadEventProperty(static_cast<mpv_event_property*>(event->data), &change);
+        if (!batch) batch = new std::vector<PropertyChange>();
+        batch->push_back(std::move(change));
+      } else if (event->event_id == MPV_EVENT_COMMAND_REPLY ||
+                 event->event_id == MPV_EVENT_SET_PROPERTY_REPLY ||
+                 event->event_id == MPV_EVENT_GET_PROPERTY_REPLY) {
+        AsyncReply reply;
+        reply.id = event->reply_userdata;
+        reply.error = event->error;
+        if (event->event_id == MPV_EVENT_GET_PROPERTY_REPLY && event->error >= 0) {
+          ReadEventProperty(static_cast<mpv_event_property*>(event->data), &reply.value);
+        }
+        if (!replies) replies = new std::vector<AsyncReply>();
+        replies->push_back(std::move(reply));
+      }
+      event = g_api.mpv_wait_event(handle_, 0);
+    }
+    if (replies) DeliverReplies(replies);
+    MaybeEmitStats();
+    if (!batch) continue;
+
+    std::lock_guard<std::mutex> lock(prop_mutex_);
+    napi_status status = napi_closing;
+    if (prop_tsfn_) {
+      status = prop_tsfn_.NonBlockingCall([batch](Napi::Env env, Napi::Function callback) {
+        Napi::Array out = Napi::Array::New(env, batch->size());
+        for (size_t i = 0; i < batch->size(); ++i) {
+          const PropertyChange& change = (*batch)[i];
+          Napi::Object item = Napi::Object::New(env);
+          item.Set("id", Napi::Number::New(env, static_cast<double>(change.id)));
+          item.Set("name", Napi::String::New(env, change.name));
+          item.Set("value", ChangeValue(env, change));
+          out.Set(static_cast<uint32_t>(i), item);
+        }
+        delete batch;
+        callback.Call({ out });
+      });
+    }
+    if (status != napi_ok) delete batch;
+  }
+}
+
+// Runs on the event thread. Promises are settled on the JS thread through
+// the shared pending table, never through `this`.
+void Player::DeliverReplies(std::vector<AsyncReply>* replies) {
+  std::shared_ptr<PendingRequests> pending = pending_;
+  napi_status status = reply_tsfn_.NonBlockingCall([replies, pending](Napi::Env env, Napi::Function) {
+    for (const AsyncReply& reply : *replies) {
+      auto it = pending->requests.find(reply.id);
+      if (it == pending->requests.end()) continue;
+      const PendingRequest& request = it->second;
+      if (reply.error >= 0) {
+        bool is_read = request.error == nullptr;
+        request.deferred.Resolve(is_read ? ChangeValue(env, reply.value) : Napi::Boolean::New(env, true));
+      } else if (request.error) {
+        request.deferred.Reject(Napi::Error::New(env, request.error).Value());
+      } else {
+        request.deferred.Resolve(env.Null());
+      }
+      pending->requests.erase(it);
+    }
+    delete replies;
+  });
+  if (status != napi_ok) delete replies;
+}
+
+void Player::RejectPending(Napi::Env env, const char* code) {
+  for (auto& entry : pending_->requests) {
+    entry.second.deferred.Reject(Napi::Error::New(env, code).Value());
+  }
+  pending_->requests.clear();
+}
+
+// The event thread blocks indefinitely unless a stats callback is set, in
+// which case the wait ends when the next snapshot is due.
+double Player::EventWaitSeconds() {
+  if (stats_interval_ms_.load() <= 0) return -1;
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  auto remaining = stats_due_ - std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(remaining).count();
+  return seconds > 0 ? seconds : 0;
+}
+
+// Runs on the event thread.
+void Player::MaybeEmitStats() {
+  if (stats_interval_ms_.load() <= 0) return;
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  if (!stats_tsfn_) return;
+  auto now = std::chrono::steady_clock::now();
+  if (now < stats_due_) return;
+  stats_due_ = now + std::chrono::milliseconds(stats_interval_ms_.load());
+
+  StatsSnapshot* snapshot = new StatsSnapshot();
+  TakeStats(snapshot);
+  napi_status status = stats_tsfn_.NonBlockingCall([snapshot](Napi::Env env, Napi::Function callback) {
+    Napi::Object out = StatsToJs(env, *snapshot);
+    delete snapshot;
+    callback.Call({ out });
+  });
+  if (status != napi_ok) delete snapshot;
+}
+
+void Player::TakeStats(StatsSnapshot* out) {
+  out->render = stats_.render.Summarize();
+  out->convert = stats_.convert.Summarize();
+  out->copy = stats_.copy.Summarize();
+  out->get_property = stats_.get_property.Summarize();
+  out->command = stats_.command.Summarize();
+  out->frames_rendered = stats_.frames_rendered.load();
+  out->frames_presented = stats_.frames_presented.load();
+  out->frames_held = stats_.frames_held.load();
+  out->frames_late = stats_.frames_late.load();
+  out->frames_dropped = stats_.frames_dropped.load();
+  out->allocations = stats_.allocations.load();
+  out->allocated_bytes = stats_.allocated_bytes.load();
+  out->pool_hits = stats_.pool_hits.load();
+  if (handle_) {
+    out->mpv_frame_drops = ReadInt64Property(handle_, "frame-drop-count");
+    out->mpv_delayed_frames = ReadInt64Property(handle_, "vo-delayed-frame-count");
+  }
+  out->display_interval_ms = static_cast<double>(display_interval_us_.load()) / 1000.0;
+}
+
+Napi::Value Player::GetStats(const Napi::CallbackInfo& info) {
+  StatsSnapshot snapshot;
+  TakeStats(&snapshot);
+  return StatsToJs(info.Env(), snapshot);
+}
+
+Napi::Value Player::ResetStats(const Napi::CallbackInfo& info) {
+  stats_.render.Reset();
+  stats_.convert.Reset();
+  stats_.copy.Reset();
+  stats_.get_property.Reset();
+  stats_.command.Reset();
+  for (auto* counter : { &stats_.frames_rendered, &stats_.frames_presented, &stats_.frames_held,
+                         &stats_.frames_late, &stats_.frames_dropped, &stats_.allocations,
+                         &stats_.allocated_bytes, &stats_.pool_hits }) {
+    counter->store(0);
+  }
+  return Napi::Boolean::New(info.Env(), true);
+}
+
+// Delivers a getStats() snapshot every `intervalMs` (default 1000) until
+// called with null.
+Napi::Value Player::SetStatsCallback(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  if (stats_tsfn_) {
+    stats_tsfn_.Release();
+    stats_tsfn_ = Napi::ThreadSafeFunction();
+  }
+  stats_interval_ms_.store(0);
+  if (info.Length() < 1 || !info[0].IsFunction()) return Napi::Boolean::New(env, true);
+
+  int interval = 1000;
+  if (info.Length() > 1 && info[1].IsNumber()) interval = info[1].As<Napi::Number>().Int32Value();
+  interval = std::max(kMinStatsIntervalMs, std::min(interval, kMaxStatsIntervalMs));
+
+  stats_tsfn_ = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "mpvStats", 0, 1);
+  stats_tsfn_.Unref(env);
+  stats_due_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(interval);
+  stats_interval_ms_.store(interval);
+  if (handle_) g_api.mpv_wakeup(handle_);
+  return Napi::Boolean::New(env, true);
+}
+
+void Player::StopEventThread() {
+  if (!event_thread_.joinable()) return;
+  event_stop_.store(true);
+  g_api.mpv_wakeup(handle_);
+  event_thread_.join();
+  event_stop_.store(false);
+}
+
+void Player::ClearObservers() {
+  if (handle_) {
+    for (const auto& entry : observed_) g_api.mpv_unobserve_property(handle_, entry.first);
+  }
+  observed_.clear();
+}
+
+// Returns an id for unobserveProperty(). Changes arrive through the property
+// callback as [{ id, name, value }], with value null while unavailable.
+Napi::Value Player::ObserveProperty(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  std::string name = info[0].As<Napi::String>().Utf8Value();
+  mpv_format format = FormatForType(info[1].As<Napi::String>().Utf8Value());
+
+  uint64_t id = next_observe_id_++;
+  if (g_api.mpv_observe_property(handle_, id, name.c_str(), format) < 0) {
+    Napi::Error::New(env, "observe_failed").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  observed_[id] = { name, format };
+  return Napi::Number::New(env, static_cast<double>(id));
+}
+
+Napi::Value Player::UnobserveProperty(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsNumber()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  uint64_t id = static_cast<uint64_t>(info[0].As<Napi::Number>().Int64Value());
+  if (!handle_ || observed_.erase(id) == 0) return Napi::Boolean::New(env, false);
+  g_api.mpv_unobserve_property(handle_, id);
+  return Napi::Boolean::New(env, true);
+}
+
+Napi::Value Player::SetPropertyCallback(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::lock_guard<std::mutex> lock(prop_mutex_);
+  if (prop_tsfn_) {
+    prop_tsfn_.Release();
+    prop_tsfn_ = Napi::ThreadSafeFunction();
+  }
+  if (info.Length() < 1 || !info[0].IsFunction()) return Napi::Boolean::New(env, true);
+
+  prop_tsfn_ = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "mpvPropertyChange", 0, 1);
+  prop_tsfn_.Unref(env);
+  return Napi::Boolean::New(env, true);
+}
+
+Napi::Value Player::StartCommand(Napi::Env env, const std::vector<std::string>& args, const char* error_code) {
+  std::vector<const char*> cmd;
+  cmd.reserve(args.size() + 1);
+  for (const auto& arg : args) cmd.push_back(arg.c_str());
+  cmd.push_back(nullptr);
+
+  uint64_t id = next_request_id_++;
+  auto inserted = pending_->requests.emplace(id, PendingRequest(env, error_code));
+  Napi::Promise promise = inserted.first->second.deferred.Promise();
+  if (g_api.mpv_command_async(handle_, id, cmd.data()) < 0) {
+    inserted.first->second.deferred.Reject(Napi::Error::New(env, error_code).Value());
+    pending_->requests.erase(inserted.first);
+  }
+  return promise;
+}
+
+Napi::Value Player::LoadFileAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_path").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return StartCommand(env, { "loadfile", info[0].As<Napi::String>().Utf8Value() }, "load_failed");
+}
+
+Napi::Value Player::CommandAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  std::vector<std::string> args;
+  if (!ReadCommandArgs(info, &args)) return env.Null();
+  return StartCommand(env, args, "command_failed");
+}
+
+// Resolves with the value, or null when the property is unavailable, like
+// getProperty().
+Napi::Value Player::GetPropertyAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  std::string name = info[0].As<Napi::String>().Utf8Value();
+  mpv_format format = FormatForType(info[1].As<Napi::String>().Utf8Value());
+
+  uint64_t id = next_request_id_++;
+  auto inserted = pending_->requests.emplace(id, PendingRequest(env, nullptr));
+  Napi::Promise promise = inserted.first->second.deferred.Promise();
+  if (g_api.mpv_get_property_async(handle_, id, name.c_str(), format) < 0) {
+    inserted.first->second.deferred.Resolve(env.Null());
+    pending_->requests.erase(inserted.first);
+  }
+  return promise;
+}
+
+// Values are passed as strings and parsed by mpv, as with `set` commands.
+Napi::Value Player::SetPropertyAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handle_) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  std::string name = info[0].As<Napi::String>().Utf8Value();
+  std::string value = info[1].As<Napi::String>().Utf8Value();
+  const char* data = value.c_str();
+
+  uint64_t id = next_request_id_++;
+  auto inserted = pending_->requests.emplace(id, PendingRequest(env, "set_property_failed"));
+  Napi::Promise promise = inserted.first->second.deferred.Promise();
+  if (g_api.mpv_set_property_async(handle_, id, name.c_str(), MPV_FORMAT_STRING, &data) < 0) {
+    inserted.first->second.deferred.Reject(Napi::Error::New(env, "set_property_failed").Value());
+    pending_->requests.erase(inserted.first);
+  }
+  return promise;
+}
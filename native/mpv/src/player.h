@@ -0,0 +1,354 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "mpv_api.h"
+#include "mpv_node.h"
+#include "gl_context.h"
+#include "memory_budget.h"
+#include "perf_stats.h"
+#include "pixel_kernels.h"
+
+// Long-lived ArrayBuffer that mpv renders into directly. JS keeps views on it
+// across calls. `bytes` is the bucketed capacity, so a slot is only
+// reallocated when the frame outgrows it or shrinks well below it; `width`
+// and `height` describe the frame last rendered into it.
+struct FrameSlot {
+  Napi::ObjectReference buffer;
+  uint8_t* data = nullptr;
+  size_t bytes = 0;
+  int width = 0;
+  int height = 0;
+};
+
+// Native-only pixel storage that grows by size class and is never
+// zero-filled; every byte is overwritten by the next render.
+struct PixelBuffer {
+  uint8_t* Reserve(size_t bytes);
+  void Release();
+
+  std::unique_ptr<uint8_t[]> data;
+  size_t capacity = 0;
+};
+
+// Native render thread. It renders into `back` while JS reads `front`;
+// finished frames are parked in `ready` until JS swaps them in. Slots are
+// allocated on the JS thread; a resize retires the old generation, which is
+// only released once the thread is no longer writing into it.
+struct RenderWorker {
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool active = false;
+  bool stop = false;
+  bool wake = false;
+  bool redraw = false;
+  bool rendering = false;
+  bool ready_fresh = false;
+  // Swaps reported by JS while the thread runs. mpv allows one mpv_render_*
+  // call at a time, so the thread passes them on before its next update.
+  int pending_swaps = 0;
+  // mpv clock time (us) at which the frame in `ready` should be on screen, or
+  // 0 for redraws and untimed frames.
+  int64_t ready_target = 0;
+  uint64_t generation = 0;
+  int width = 0;
+  int height = 0;
+  PixelFormat format = PixelFormat::kRgba;
+  // Size requested by JS; the slots hold that size fitted to the video.
+  int requested_width = 0;
+  int requested_height = 0;
+  // RGBA staging for converted formats; only touched by the render thread.
+  PixelBuffer scratch;
+  FrameSlot slots[3];
+  int back = 0;
+  int ready = 1;
+  int front = 2;
+  std::vector<FrameSlot> retired;
+};
+
+// Timings and counters for one player. Written from the JS, render and event
+// threads without locks; read by getStats() and the periodic snapshot.
+struct PlayerStats {
+  LatencyHistogram render;        // mpv_render_context_render plus GL readback
+  LatencyHistogram convert;       // BGRA swizzle / I420 conversion
+  LatencyHistogram copy;          // renderFrame's copy into a JS Buffer
+  LatencyHistogram get_property;  // synchronous getProperty
+  LatencyHistogram command;       // synchronous command
+  std::atomic<uint64_t> frames_rendered{0};
+  std::atomic<uint64_t> frames_presented{0};
+  std::atomic<uint64_t> frames_held{0};
+  std::atomic<uint64_t> frames_late{0};
+  std::atomic<uint64_t> frames_dropped{0};
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> allocated_bytes{0};
+  std::atomic<uint64_t> pool_hits{0};
+};
+
+// Point-in-time copy of PlayerStats plus mpv's own drop counters, built on
+// whichever thread asks and converted to JS on the JS thread.
+struct StatsSnapshot {
+  HistogramSummary render;
+  HistogramSummary convert;
+  HistogramSummary copy;
+  HistogramSummary get_property;
+  HistogramSummary command;
+  uint64_t frames_rendered = 0;
+  uint64_t frames_presented = 0;
+  uint64_t frames_held = 0;
+  uint64_t frames_late = 0;
+  uint64_t frames_dropped = 0;
+  uint64_t allocations = 0;
+  uint64_t allocated_bytes = 0;
+  uint64_t pool_hits = 0;
+  // -1 when mpv has no video to report on.
+  int64_t mpv_frame_drops = -1;
+  int64_t mpv_delayed_frames = -1;
+  double display_interval_ms = 0.0;
+};
+
+// Value of an observed property as read on the event thread; converted to a
+// JS value once the batch reaches the JS thread.
+struct PropertyChange {
+  uint64_t id = 0;
+  std::string name;
+  mpv_format format = MPV_FORMAT_NONE;
+  std::string text;
+  double number = 0.0;
+  bool flag = false;
+  NodeValue node;
+};
+
+// Property registered through observeProperty(), kept so a standby player
+// taking over can register it again under the same id.
+struct ObservedProperty {
+  std::string name;
+  mpv_format format = MPV_FORMAT_NONE;
+};
+
+// Completion of an async request, matched to its promise by reply_userdata.
+struct AsyncReply {
+  uint64_t id = 0;
+  int error = 0;
+  PropertyChange value;
+};
+
+// In-flight async requests. Shared with queued reply calls so those stay
+// valid even if the player is collected before they run.
+struct PendingRequest {
+  explicit PendingRequest(Napi::Env env, const char* error_code)
+      : deferred(Napi::Promise::Deferred::New(env)), error(error_code) {}
+  Napi::Promise::Deferred deferred;
+  // Rejection code, or null to resolve with null on failure (property reads).
+  const char* error;
+};
+
+struct PendingRequests {
+  std::unordered_map<uint64_t, PendingRequest> requests;
+};
+
+// One mpv instance with its own render context and frame buffers. Exposed to
+// JS as `Player`; the module-level functions drive a default instance.
+class Player : public Napi::ObjectWrap<Player>, public MemoryOwner {
+ public:
+  static Napi::Function Define(Napi::Env env);
+
+  explicit Player(const Napi::CallbackInfo& info);
+  ~Player() override;
+
+  bool IsReady() const { return handle_ != nullptr; }
+  // Stops playback and frame delivery but keeps mpv and the render context
+  // alive, so a pooled player can be handed to the next lease.
+  void Recycle();
+
+  // Playlist prefetch (module-level preloadFile): opens `path` paused on this
+  // standby player, optionally with a different cache profile.
+  bool Preload(const std::string& path, const std::string& cache_profile, std::string* err);
+  // Makes this standby the one JS is driving: callbacks, observers (under
+  // the same ids), frame layout, render thread size and playback state move
+  // over from `from`, which is left with just its mpv instance.
+  void TakeOver(Napi::Env env, Player* from);
+  // destroy() without a JS call: rejects pending requests and frees mpv.
+  void Shutdown(Napi::Env env);
+  const std::string& cache_profile() const { return cache_profile_; }
+
+  // Frame slots, parked buffers, staging buffers and the demuxer cache. The
+  // frame pool and, as a last resort, the cache profile are given up.
+  void ReportMemory(MemoryUsage* usage) override;
+  bool ReleaseMemory(Napi::Env env, EvictionStep step) override;
+
+  Napi::Value LoadFile(const Napi::CallbackInfo& info);
+  Napi::Value Stop(const Napi::CallbackInfo& info);
+  Napi::Value GetProperty(const Napi::CallbackInfo& info);
+  Napi::Value Command(const Napi::CallbackInfo& info);
+  Napi::Value CommandBatch(const Napi::CallbackInfo& info);
+  Napi::Value SetProperties(const Napi::CallbackInfo& info);
+  Napi::Value RenderFrame(const Napi::CallbackInfo& info);
+  Napi::Value RenderFrameShared(const Napi::CallbackInfo& info);
+  Napi::Value HasNewFrame(const Napi::CallbackInfo& info);
+  Napi::Value SetFrameCallback(const Napi::CallbackInfo& info);
+  Napi::Value StartRenderThread(const Napi::CallbackInfo& info);
+  Napi::Value ResizeRenderThread(const Napi::CallbackInfo& info);
+  Napi::Value AcquireFrame(const Napi::CallbackInfo& info);
+  Napi::Value StopRenderThread(const Napi::CallbackInfo& info);
+  Napi::Value SetFrameFormat(const Napi::CallbackInfo& info);
+  Napi::Value GetFrameSize(const Napi::CallbackInfo& info);
+  Napi::Value ReportSwap(const Napi::CallbackInfo& info);
+  Napi::Value GetFrameTiming(const Napi::CallbackInfo& info);
+  Napi::Value GetStats(const Napi::CallbackInfo& info);
+  Napi::Value ResetStats(const Napi::CallbackInfo& info);
+  Napi::Value SetStatsCallback(const Napi::CallbackInfo& info);
+  Napi::Value SetHwdec(const Napi::CallbackInfo& info);
+  Napi::Value SetCacheProfile(const Napi::CallbackInfo& info);
+  Napi::Value SetDecodeProfile(const Napi::CallbackInfo& info);
+  Napi::Value GetCacheProfile(const Napi::CallbackInfo& info);
+  Napi::Value GetDecoder(const Napi::CallbackInfo& info);
+  Napi::Value GetRenderApi(const Napi::CallbackInfo& info);
+  Napi::Value ObserveProperty(const Napi::CallbackInfo& info);
+  Napi::Value UnobserveProperty(const Napi::CallbackInfo& info);
+  Napi::Value SetPropertyCallback(const Napi::CallbackInfo& info);
+  Napi::Value LoadFileAsync(const Napi::CallbackInfo& info);
+  Napi::Value CommandAsync(const Napi::CallbackInfo& info);
+  Napi::Value GetPropertyAsync(const Napi::CallbackInfo& info);
+  Napi::Value SetPropertyAsync(const Napi::CallbackInfo& info);
+  Napi::Value Destroy(const Napi::CallbackInfo& info);
+
+ private:
+  static void OnRenderUpdate(void* ctx);
+  static void OnEnvCleanup(void* ctx);
+
+  void Teardown();
+  void NotifyFrameReady();
+  bool AcquireRenderContext();
+  void ReleaseRenderContext();
+  uint64_t UpdateRenderContext();
+  void ReportSwaps(int count);
+  bool PollFrameUpdate();
+  bool ShouldRender(int width, int height, bool force);
+  bool NextFrameTarget(int64_t* target);
+  bool HoldEarlyFrame();
+  bool RenderInto(uint8_t* dst, int width, int height, PixelFormat format, PixelBuffer* scratch);
+  void FitToVideo(int* width, int* height) const;
+  void EnsureSlot(Napi::Env env, FrameSlot& slot, size_t bytes);
+  void ReleaseToPool(FrameSlot& slot);
+  int CreateRenderContext(bool gpu);
+  bool ApplyHwdec(const std::string& policy);
+  bool ApplyCacheProfile(const std::string& profile);
+  bool ApplyDecodeProfile(const std::string& profile);
+  void ResetFrameRing();
+  void RenderThreadMain();
+  void StartRenderWorker(Napi::Env env, int width, int height);
+  void ResizeRenderWorker(Napi::Env env, int width, int height, PixelFormat format);
+  void StopRenderWorker();
+  void EventThreadMain();
+  double EventWaitSeconds();
+  void MaybeEmitStats();
+  void TakeStats(StatsSnapshot* out);
+  void StopEventThread();
+  void ClearObservers();
+  void DeliverReplies(std::vector<AsyncReply>* replies);
+  void RejectPending(Napi::Env env, const char* code);
+  Napi::Value StartCommand(Napi::Env env, const std::vector<std::string>& args, const char* error_code);
+
+  napi_env env_ = nullptr;
+  bool cleanup_hook_ = false;
+  std::shared_ptr<MemoryBudget> memory_;
+
+  mpv_handle* handle_ = nullptr;
+  mpv_render_context* render_ctx_ = nullptr;
+  PixelBuffer frame_;
+  // Layout of frames handed to JS, and the RGBA staging buffer used on the JS
+  // thread when that layout needs a conversion.
+  PixelFormat frame_format_ = PixelFormat::kRgba;
+  PixelBuffer convert_;
+  // Size of the frame most recently handed to JS.
+  int frame_width_ = 0;
+  int frame_height_ = 0;
+
+  // Display size of the current video from the event thread (0 when none).
+  // Requests larger than it are rendered at the video's size and scaled up by
+  // the canvas.
+  bool fit_to_video_ = true;
+  std::atomic<int> video_width_{0};
+  std::atomic<int> video_height_{0};
+
+  // GPU path: mpv renders into an FBO of an offscreen GL context and the
+  // result is read back into the same RGBA slots the SW path fills.
+  GlContext gl_;
+  bool use_gl_ = false;
+
+  // Hardware decoding policy requested from JS and the mpv `hwdec` list it
+  // maps to for the active render API.
+  std::string hwdec_policy_ = "auto";
+  std::string hwdec_value_;
+
+  // Demuxer cache profile (cacheProfile option / setCacheProfile).
+  std::string cache_profile_ = "local";
+  // Decoder profile (decodeProfile option / setDecodeProfile).
+  std::string decode_profile_ = "full";
+
+  // Set from mpv's update callback (any thread); consumed on whichever thread
+  // currently owns rendering, the only place mpv_render_context_update runs.
+  std::atomic<bool> update_pending_{false};
+  // Set while a frame_tsfn_ call is queued. Shared with that call, which may
+  // still run after Release() or after TakeOver hands the TSFN on; it moves
+  // with the TSFN and is replaced whenever the TSFN is.
+  std::shared_ptr<std::atomic<bool>> notify_queued_ = std::make_shared<std::atomic<bool>>(false);
+  bool frame_dirty_ = false;
+  int last_width_ = 0;
+  int last_height_ = 0;
+  std::mutex tsfn_mutex_;
+  Napi::ThreadSafeFunction frame_tsfn_;
+
+  static constexpr size_t kFrameRingSize = 3;
+  FrameSlot ring_[kFrameRingSize];
+  size_t ring_next_ = 0;
+
+  // Buffers released by resizes, reused by whichever slot next fits them so a
+  // window-resize storm settles into a few size classes. JS thread only.
+  static constexpr size_t kFramePoolSize = 4;
+  std::vector<FrameSlot> frame_pool_;
+
+  RenderWorker worker_;
+
+  // Presentation timing. mpv is told not to block on a frame's target time;
+  // frames are rendered one display interval ahead and handed to JS on the
+  // vsync closest to their target, and JS reports each swap back. The
+  // interval is the shortest gap between reported swaps over a window, since
+  // low frame rate content only swaps every few vsyncs.
+  std::atomic<int64_t> display_interval_us_{16667};
+  int64_t last_swap_us_ = 0;
+  int64_t window_min_us_ = 0;
+  int window_swaps_ = 0;
+
+  PlayerStats stats_;
+  // Periodic snapshot delivery, driven by the event thread's wait timeout.
+  std::mutex stats_mutex_;
+  Napi::ThreadSafeFunction stats_tsfn_;
+  std::atomic<int> stats_interval_ms_{0};
+  std::chrono::steady_clock::time_point stats_due_;
+
+  // Sole consumer of mpv_wait_event. Property changes drained in one wakeup
+  // are delivered to JS as a single batch.
+  std::thread event_thread_;
+  std::atomic<bool> event_stop_{false};
+  std::mutex prop_mutex_;
+  Napi::ThreadSafeFunction prop_tsfn_;
+  std::unordered_map<uint64_t, ObservedProperty> observed_;
+  uint64_t next_observe_id_ = 1;
+
+  // Async command/property replies from the event thread. The function is
+  // internal; results settle the promises in pending_.
+  Napi::ThreadSafeFunction reply_tsfn_;
+  std::shared_ptr<PendingRequests> pending_ = std::make_shared<PendingRequests>();
+  uint64_t next_request_id_ = 1;
+};
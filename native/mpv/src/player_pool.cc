@@ -0,0 +1,180 @@
+#include "player_pool.h"
+
+#include "addon_data.h"
+#include "player.h"
+
+namespace {
+
+constexpr int kDefaultPoolSize = 2;
+constexpr int kMaxPoolSize = 8;
+
+} // namespace
+
+Napi::Function PlayerPool::Define(Napi::Env env) {
+  return DefineClass(env, "PlayerPool", {
+    InstanceMethod("acquire", &PlayerPool::Acquire),
+    InstanceMethod("release", &PlayerPool::Release),
+    InstanceMethod("stats", &PlayerPool::Stats),
+    InstanceMethod("destroy", &PlayerPool::Destroy),
+  });
+}
+
+// Options are forwarded to every Player ({ gpu, hwdec }) plus `size`, the
+// number of players kept warm.
+PlayerPool::PlayerPool(const Napi::CallbackInfo& info) : Napi::ObjectWrap<PlayerPool>(info) {
+  Napi::Env env = info.Env();
+  memory_ = env.GetInstanceData<AddonData>()->memory;
+  memory_->Add(this);
+  Napi::Object options = info.Length() > 0 && info[0].IsObject() ? info[0].As<Napi::Object>() : Napi::Object::New(env);
+  options_ = Napi::Persistent(options);
+
+  int size = kDefaultPoolSize;
+  Napi::Value opt = options.Get("size");
+  if (opt.IsNumber()) size = opt.As<Napi::Number>().Int32Value();
+  if (size < 1 || size > kMaxPoolSize) {
+    Napi::Error::New(env, "invalid_pool_size").ThrowAsJavaScriptException();
+    return;
+  }
+
+  slots_.resize(static_cast<size_t>(size));
+  for (auto& slot : slots_) {
+    if (!CreateSlotPlayer(env, slot)) {
+      slots_.clear();
+      return;
+    }
+  }
+}
+
+PlayerPool::~PlayerPool() {
+  memory_->Remove(this);
+}
+
+bool PlayerPool::CreateSlotPlayer(Napi::Env env, Slot& slot) {
+  AddonData* data = env.GetInstanceData<AddonData>();
+  Napi::Object player = data->player_ctor.New({ options_.Value() });
+  if (env.IsExceptionPending()) return false;
+  slot.player = Napi::Persistent(player);
+  return true;
+}
+
+// First idle slot, otherwise the least recently acquired lease.
+size_t PlayerPool::PickSlot() const {
+  size_t pick = 0;
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    if (!slots_[i].leased) return i;
+    if (slots_[i].last_used < slots_[pick].last_used) pick = i;
+  }
+  return pick;
+}
+
+// Returns { player, reclaimed }, where `reclaimed` is the key whose lease was
+// taken over (its player has been stopped) or null.
+Napi::Value PlayerPool::Acquire(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (slots_.empty()) {
+    Napi::Error::New(env, "pool_destroyed").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_key").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  std::string key = info[0].As<Napi::String>().Utf8Value();
+
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("reclaimed", env.Null());
+
+  auto it = leases_.find(key);
+  if (it != leases_.end()) {
+    Slot& slot = slots_[it->second];
+    slot.last_used = ++clock_;
+    hits_++;
+    out.Set("player", slot.player.Value());
+    return out;
+  }
+
+  size_t index = PickSlot();
+  Slot& slot = slots_[index];
+  if (slot.leased) {
+    out.Set("reclaimed", Napi::String::New(env, slot.key));
+    leases_.erase(slot.key);
+    reclaims_++;
+  }
+
+  Player* player = Player::Unwrap(slot.player.Value());
+  if (player->IsReady()) {
+    player->Recycle();
+  } else if (!CreateSlotPlayer(env, slot)) {
+    // Destroyed from JS and could not be replaced; leave the slot idle.
+    slot.leased = false;
+    slot.key.clear();
+    return env.Null();
+  }
+
+  slot.leased = true;
+  slot.key = key;
+  slot.last_used = ++clock_;
+  leases_[key] = index;
+  out.Set("player", slot.player.Value());
+  return out;
+}
+
+Napi::Value PlayerPool::Release(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_key").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  auto it = leases_.find(info[0].As<Napi::String>().Utf8Value());
+  if (it == leases_.end()) return Napi::Boolean::New(env, false);
+
+  Slot& slot = slots_[it->second];
+  Player* player = Player::Unwrap(slot.player.Value());
+  if (player->IsReady()) player->Recycle();
+  slot.leased = false;
+  slot.key.clear();
+  leases_.erase(it);
+  return Napi::Boolean::New(env, true);
+}
+
+Napi::Value PlayerPool::Stats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("size", Napi::Number::New(env, static_cast<double>(slots_.size())));
+  out.Set("leased", Napi::Number::New(env, static_cast<double>(leases_.size())));
+  out.Set("hits", Napi::Number::New(env, static_cast<double>(hits_)));
+  out.Set("reclaims", Napi::Number::New(env, static_cast<double>(reclaims_)));
+  return out;
+}
+
+Napi::Value PlayerPool::Destroy(const Napi::CallbackInfo& info) {
+  for (auto& slot : slots_) {
+    if (slot.player.IsEmpty()) continue;
+    Player::Unwrap(slot.player.Value())->Shutdown(info.Env());
+    slot.player.Reset();
+  }
+  slots_.clear();
+  leases_.clear();
+  return Napi::Boolean::New(info.Env(), true);
+}
+
+// Pooled players report their own buffers; the pool adds which are idle.
+void PlayerPool::ReportMemory(MemoryUsage* usage) {
+  for (const auto& slot : slots_) {
+    if (slot.leased || slot.player.IsEmpty()) continue;
+    if (Player::Unwrap(slot.player.Value())->IsReady()) usage->idle_players++;
+  }
+}
+
+bool PlayerPool::ReleaseMemory(Napi::Env env, EvictionStep step) {
+  if (step != EvictionStep::kIdlePlayers) return false;
+  bool released = false;
+  for (auto& slot : slots_) {
+    if (slot.leased || slot.player.IsEmpty()) continue;
+    Player* player = Player::Unwrap(slot.player.Value());
+    if (!player->IsReady()) continue;
+    player->Shutdown(env);
+    released = true;
+  }
+  return released;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <napi.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "memory_budget.h"
+
+// Fixed set of warm players (mpv initialized, render context created) leased
+// out by key, e.g. one per hovered grid tile. When every player is leased the
+// least recently acquired lease is reclaimed for the new key. Under memory
+// pressure idle players are shut down and recreated on their next lease.
+class PlayerPool : public Napi::ObjectWrap<PlayerPool>, public MemoryOwner {
+ public:
+  static Napi::Function Define(Napi::Env env);
+
+  explicit PlayerPool(const Napi::CallbackInfo& info);
+  ~PlayerPool() override;
+
+  Napi::Value Acquire(const Napi::CallbackInfo& info);
+  Napi::Value Release(const Napi::CallbackInfo& info);
+  Napi::Value Stats(const Napi::CallbackInfo& info);
+  Napi::Value Destroy(const Napi::CallbackInfo& info);
+
+  void ReportMemory(MemoryUsage* usage) override;
+  bool ReleaseMemory(Napi::Env env, EvictionStep step) override;
+
+ private:
+  struct Slot {
+    Napi::ObjectReference player;
+    std::string key;
+    bool leased = false;
+    uint64_t last_used = 0;
+  };
+
+  bool CreateSlotPlayer(Napi::Env env, Slot& slot);
+  size_t PickSlot() const;
+
+  std::shared_ptr<MemoryBudget> memory_;
+  Napi::ObjectReference options_;
+  std::vector<Slot> slots_;
+  std::unordered_map<std::string, size_t> leases_;
+  uint64_t clock_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t reclaims_ = 0;
+};
@@ -0,0 +1,174 @@
+#include "thumbnail_cache.h"
+
+#include "addon_data.h"
+
+namespace {
+
+// (path, size, mtimeMs) identify one version of a file.
+bool ReadKey(const Napi::CallbackInfo& info, std::string* path, uint64_t* size, int64_t* mtime_ms) {
+  if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsNumber()) return false;
+  *path = info[0].As<Napi::String>().Utf8Value();
+  *size = static_cast<uint64_t>(info[1].As<Napi::Number>().Int64Value());
+  *mtime_ms = info[2].As<Napi::Number>().Int64Value();
+  return true;
+}
+
+Napi::Object RecordToJs(Napi::Env env, const ThumbnailRecord& record) {
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("width", Napi::Number::New(env, record.width));
+  out.Set("height", Napi::Number::New(env, record.height));
+  out.Set("videoWidth", Napi::Number::New(env, record.video_width));
+  out.Set("videoHeight", Napi::Number::New(env, record.video_height));
+  out.Set("duration", Napi::Number::New(env, record.duration));
+  out.Set("codec", Napi::String::New(env, record.codec));
+  return out;
+}
+
+uint32_t ReadDimension(Napi::Object object, const char* name) {
+  Napi::Value value = object.Get(name);
+  if (!value.IsNumber()) return 0;
+  int64_t number = value.As<Napi::Number>().Int64Value();
+  return number > 0 ? static_cast<uint32_t>(number) : 0;
+}
+
+} // namespace
+
+Napi::Function ThumbnailCache::Define(Napi::Env env) {
+  return DefineClass(env, "ThumbnailCache", {
+    InstanceMethod("get", &ThumbnailCache::Get),
+    InstanceMethod("find", &ThumbnailCache::Find),
+    InstanceMethod("put", &ThumbnailCache::Put),
+    InstanceMethod("remove", &ThumbnailCache::Remove),
+    InstanceMethod("compact", &ThumbnailCache::Compact),
+    InstanceMethod("stats", &ThumbnailCache::Stats),
+    InstanceMethod("close", &ThumbnailCache::Close),
+  });
+}
+
+// new ThumbnailCache(dir); the directory must exist.
+ThumbnailCache::ThumbnailCache(const Napi::CallbackInfo& info) : Napi::ObjectWrap<ThumbnailCache>(info) {
+  Napi::Env env = info.Env();
+  memory_ = env.GetInstanceData<AddonData>()->memory;
+  memory_->Add(this);
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_dir").ThrowAsJavaScriptException();
+    return;
+  }
+  std::string err;
+  if (!store_.Open(info[0].As<Napi::String>().Utf8Value(), &err)) {
+    Napi::Error::New(env, err).ThrowAsJavaScriptException();
+  }
+}
+
+ThumbnailCache::~ThumbnailCache() {
+  memory_->Remove(this);
+}
+
+// get(path, size, mtimeMs) -> { data, width, height, videoWidth, videoHeight,
+// duration, codec } or null when missing or stale.
+Napi::Value ThumbnailCache::Get(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::string path;
+  uint64_t size = 0;
+  int64_t mtime_ms = 0;
+  if (!ReadKey(info, &path, &size, &mtime_ms)) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  ThumbnailRecord record;
+  if (!store_.Find(path, size, mtime_ms, &record)) return env.Null();
+  Napi::Buffer<uint8_t> data = Napi::Buffer<uint8_t>::New(env, record.length);
+  if (!store_.Read(record, data.Data())) return env.Null();
+
+  Napi::Object out = RecordToJs(env, record);
+  out.Set("data", data);
+  return out;
+}
+
+// find(path, size, mtimeMs) -> get() without `data` plus its `length`; the
+// pack is not read, so callers can hand out a URL for the bytes instead.
+Napi::Value ThumbnailCache::Find(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::string path;
+  uint64_t size = 0;
+  int64_t mtime_ms = 0;
+  if (!ReadKey(info, &path, &size, &mtime_ms)) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  ThumbnailRecord record;
+  if (!store_.Find(path, size, mtime_ms, &record)) return env.Null();
+  Napi::Object out = RecordToJs(env, record);
+  out.Set("length", Napi::Number::New(env, record.length));
+  return out;
+}
+
+// put(path, size, mtimeMs, { data, width, height, videoWidth, videoHeight,
+// duration, codec }); a newer entry for the same path replaces the old one.
+Napi::Value ThumbnailCache::Put(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::string path;
+  uint64_t size = 0;
+  int64_t mtime_ms = 0;
+  if (!ReadKey(info, &path, &size, &mtime_ms) || info.Length() < 4 || !info[3].IsObject()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Object entry = info[3].As<Napi::Object>();
+  Napi::Value data = entry.Get("data");
+  if (!data.IsBuffer()) {
+    Napi::Error::New(env, "invalid_data").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  ThumbnailRecord record;
+  record.width = ReadDimension(entry, "width");
+  record.height = ReadDimension(entry, "height");
+  record.video_width = ReadDimension(entry, "videoWidth");
+  record.video_height = ReadDimension(entry, "videoHeight");
+  Napi::Value duration = entry.Get("duration");
+  if (duration.IsNumber()) record.duration = duration.As<Napi::Number>().DoubleValue();
+  Napi::Value codec = entry.Get("codec");
+  if (codec.IsString()) record.codec = codec.As<Napi::String>().Utf8Value();
+
+  Napi::Buffer<uint8_t> bytes = data.As<Napi::Buffer<uint8_t>>();
+  return Napi::Boolean::New(env, store_.Put(path, size, mtime_ms, record, bytes.Data(), bytes.Length()));
+}
+
+Napi::Value ThumbnailCache::Remove(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_path").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Napi::Boolean::New(env, store_.Remove(info[0].As<Napi::String>().Utf8Value()));
+}
+
+Napi::Value ThumbnailCache::Compact(const Napi::CallbackInfo& info) {
+  return Napi::Boolean::New(info.Env(), store_.Compact());
+}
+
+Napi::Value ThumbnailCache::Stats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("entries", Napi::Number::New(env, store_.count()));
+  out.Set("capacity", Napi::Number::New(env, store_.capacity()));
+  out.Set("packBytes", Napi::Number::New(env, static_cast<double>(store_.pack_bytes())));
+  out.Set("liveBytes", Napi::Number::New(env, static_cast<double>(store_.live_bytes())));
+  return out;
+}
+
+Napi::Value ThumbnailCache::Close(const Napi::CallbackInfo& info) {
+  store_.Close();
+  return Napi::Boolean::New(info.Env(), true);
+}
+
+void ThumbnailCache::ReportMemory(MemoryUsage* usage) {
+  usage->thumbnail_index += store_.mapped_bytes();
+}
+
+bool ThumbnailCache::ReleaseMemory(Napi::Env, EvictionStep) {
+  return false;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <napi.h>
+#include <memory>
+
+#include "memory_budget.h"
+#include "thumbnail_store.h"
+
+// JS wrapper around a ThumbnailStore. Lookups are a slot probe in the mapped
+// index plus one read from the pack, cheap enough to run on the JS thread.
+// The mapped index counts towards the memory budget but is never evicted.
+class ThumbnailCache : public Napi::ObjectWrap<ThumbnailCache>, public MemoryOwner {
+ public:
+  static Napi::Function Define(Napi::Env env);
+
+  explicit ThumbnailCache(const Napi::CallbackInfo& info);
+  ~ThumbnailCache() override;
+
+  Napi::Value Get(const Napi::CallbackInfo& info);
+  Napi::Value Find(const Napi::CallbackInfo& info);
+  Napi::Value Put(const Napi::CallbackInfo& info);
+  Napi::Value Remove(const Napi::CallbackInfo& info);
+  Napi::Value Compact(const Napi::CallbackInfo& info);
+  Napi::Value Stats(const Napi::CallbackInfo& info);
+  Napi::Value Close(const Napi::CallbackInfo& info);
+
+  void ReportMemory(MemoryUsage* usage) override;
+  bool ReleaseMemory(Napi::Env env, EvictionStep step) override;
+
+ private:
+  std::shared_ptr<MemoryBudget> memory_;
+  ThumbnailStore store_;
+};
@@ -0,0 +1,318 @@
+#include "thumbnail_scheduler.h"
+
+#include <algorithm>
+
+#include "thumbnailer.h"
+
+namespace {
+
+// Each worker holds a full mpv instance, so stay well below huge core counts.
+constexpr unsigned kMaxWorkers = 8;
+
+bool ParsePriority(const Napi::Value& value, int* out) {
+  if (!value.IsString()) return false;
+  std::string name = value.As<Napi::String>().Utf8Value();
+  if (name == "visible") {
+    *out = kPriorityVisible;
+  } else if (name == "near") {
+    *out = kPriorityNear;
+  } else if (name == "background") {
+    *out = kPriorityBackground;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+Napi::Function ThumbnailScheduler::Define(Napi::Env env) {
+  return DefineClass(env, "ThumbnailScheduler", {
+    InstanceMethod("submit", &ThumbnailScheduler::Submit),
+    InstanceMethod("cancel", &ThumbnailScheduler::Cancel),
+    InstanceMethod("setPriority", &ThumbnailScheduler::SetPriority),
+    InstanceMethod("stats", &ThumbnailScheduler::Stats),
+    InstanceMethod("destroy", &ThumbnailScheduler::Destroy),
+  });
+}
+
+// new ThumbnailScheduler({ threads, hwdec }); threads defaults to the core
+// count. Worker mpv instances are opened on their own threads.
+ThumbnailScheduler::ThumbnailScheduler(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<ThumbnailScheduler>(info) {
+  Napi::Env env = info.Env();
+  env_ = env;
+  if (!g_api.handle) {
+    Napi::Error::New(env, "not_initialized").ThrowAsJavaScriptException();
+    return;
+  }
+
+  unsigned threads = std::max(1u, std::min(std::thread::hardware_concurrency(), kMaxWorkers));
+  if (info.Length() > 0 && info[0].IsObject()) {
+    Napi::Object options = info[0].As<Napi::Object>();
+    Napi::Value count = options.Get("threads");
+    if (count.IsNumber()) {
+      int requested = count.As<Napi::Number>().Int32Value();
+      if (requested < 1 || requested > static_cast<int>(kMaxWorkers)) {
+        Napi::Error::New(env, "invalid_threads").ThrowAsJavaScriptException();
+        return;
+      }
+      threads = static_cast<unsigned>(requested);
+    }
+    Napi::Value hw = options.Get("hwdec");
+    if (hw.IsString()) hwdec_ = hw.As<Napi::String>().Utf8Value();
+  }
+
+  done_tsfn_ = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}), "mpvThumbnailDone", 0, 1);
+  done_tsfn_.Unref(env);
+
+  for (unsigned i = 0; i < threads; ++i) workers_.push_back(std::make_unique<Worker>());
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->thread = std::thread(&ThumbnailScheduler::WorkerMain, this, i);
+  }
+
+  napi_add_env_cleanup_hook(env, &ThumbnailScheduler::OnEnvCleanup, this);
+  cleanup_hook_ = true;
+}
+
+ThumbnailScheduler::~ThumbnailScheduler() {
+  Shutdown();
+}
+
+void ThumbnailScheduler::OnEnvCleanup(void* ctx) {
+  auto* self = static_cast<ThumbnailScheduler*>(ctx);
+  self->cleanup_hook_ = false;
+  self->Shutdown();
+}
+
+void ThumbnailScheduler::Shutdown() {
+  if (cleanup_hook_) {
+    napi_remove_env_cleanup_hook(env_, &ThumbnailScheduler::OnEnvCleanup, this);
+    cleanup_hook_ = false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    stop_ = true;
+  }
+  wake_cv_.notify_all();
+  // Abort in-flight extractions instead of waiting out their timeouts.
+  for (auto& entry : table_->entries) entry.second.job->cancelled.store(true);
+  for (auto& worker : workers_) {
+    if (worker->thread.joinable()) worker->thread.join();
+  }
+  workers_.clear();
+  if (done_tsfn_) {
+    done_tsfn_.Release();
+    done_tsfn_ = Napi::ThreadSafeFunction();
+  }
+}
+
+void ThumbnailScheduler::WorkerMain(size_t index) {
+  FrameExtractor extractor;
+  std::string open_error;
+  bool opened = extractor.Open(hwdec_, &open_error);
+  for (;;) {
+    std::shared_ptr<ThumbnailJob> job = Take(index);
+    if (!job) return;
+    running_++;
+    if (!opened) {
+      job->result.error = open_error;
+    } else if (!extractor.Run(job->request, &job->result, &job->cancelled) && job->result.error.empty()) {
+      job->result.error = "extract_failed";
+    }
+    running_--;
+    job->state.store(ThumbnailJob::kDone);
+    Deliver(job);
+  }
+}
+
+// Blocks until a job is available or the scheduler stops. `submitted_` is
+// bumped after every push, so a push that races the scan still wakes us.
+std::shared_ptr<ThumbnailJob> ThumbnailScheduler::Take(size_t index) {
+  for (;;) {
+    uint64_t seen = 0;
+    {
+      std::lock_guard<std::mutex> lock(wake_mutex_);
+      if (stop_) return nullptr;
+      seen = submitted_;
+    }
+    if (auto job = FindJob(index)) return job;
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_cv_.wait(lock, [&] { return stop_ || submitted_ != seen; });
+  }
+}
+
+// Highest priority first; within a level, own queue (FIFO) before stealing
+// from the back of the others.
+std::shared_ptr<ThumbnailJob> ThumbnailScheduler::FindJob(size_t index) {
+  const size_t count = workers_.size();
+  for (int level = 0; level < kPriorityLevels; ++level) {
+    {
+      Worker& own = *workers_[index];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      auto& queue = own.levels[level];
+      while (!queue.empty()) {
+        QueueEntry entry = std::move(queue.front());
+        queue.pop_front();
+        if (Claim(entry)) return entry.job;
+      }
+    }
+    for (size_t offset = 1; offset < count; ++offset) {
+      Worker& victim = *workers_[(index + offset) % count];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      auto& queue = victim.levels[level];
+      while (!queue.empty()) {
+        QueueEntry entry = std::move(queue.back());
+        queue.pop_back();
+        if (Claim(entry)) {
+          steals_++;
+          return entry.job;
+        }
+      }
+    }
+  }
+  return nullptr;
+}
+
+// Stale entries (re-prioritised, cancelled or already taken) are dropped.
+bool ThumbnailScheduler::Claim(const QueueEntry& entry) {
+  if (entry.job->priority.load() != entry.level) return false;
+  int expected = ThumbnailJob::kQueued;
+  return entry.job->state.compare_exchange_strong(expected, ThumbnailJob::kRunning);
+}
+
+void ThumbnailScheduler::Enqueue(const std::shared_ptr<ThumbnailJob>& job, int level) {
+  Worker& worker = *workers_[next_worker_];
+  next_worker_ = (next_worker_ + 1) % workers_.size();
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.levels[level].push_back({ job, level });
+  }
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    submitted_++;
+  }
+  wake_cv_.notify_one();
+}
+
+// Runs on a worker thread; the promise is settled on the JS thread.
+void ThumbnailScheduler::Deliver(const std::shared_ptr<ThumbnailJob>& job) {
+  std::shared_ptr<ThumbnailJobTable> table = table_;
+  if (job->cancelled.load()) {
+    cancelled_++;
+  } else {
+    completed_++;
+  }
+  done_tsfn_.NonBlockingCall([job, table](Napi::Env env, Napi::Function) {
+    auto it = table->entries.find(job->key);
+    // The key may have been cancelled and resubmitted in the meantime.
+    if (it == table->entries.end() || it->second.job != job) return;
+    Napi::Promise::Deferred deferred = it->second.deferred;
+    table->entries.erase(it);
+    if (job->result.error.empty()) {
+      deferred.Resolve(ThumbnailResultToJs(env, job->result));
+    } else {
+      deferred.Reject(Napi::Error::New(env, job->result.error).Value());
+    }
+  });
+}
+
+// submit(key, path, { width, height, position, timeoutMs, priority })
+// returns a promise for { width, height, duration, pixels }.
+Napi::Value ThumbnailScheduler::Submit(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (workers_.empty()) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+    Napi::Error::New(env, "missing_args").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  std::string key = info[0].As<Napi::String>().Utf8Value();
+  if (table_->entries.count(key)) {
+    Napi::Error::New(env, "job_exists").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  auto job = std::make_shared<ThumbnailJob>();
+  job->key = key;
+  job->request.path = info[1].As<Napi::String>().Utf8Value();
+  int priority = kPriorityBackground;
+  if (info.Length() > 2 && info[2].IsObject()) {
+    Napi::Object options = info[2].As<Napi::Object>();
+    ReadThumbnailOptions(options, &job->request);
+    Napi::Value value = options.Get("priority");
+    if (!value.IsUndefined() && !ParsePriority(value, &priority)) {
+      Napi::Error::New(env, "invalid_priority").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+  }
+  job->priority.store(priority);
+
+  Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+  table_->entries.emplace(key, ThumbnailJobTable::Entry{ job, deferred });
+  Enqueue(job, priority);
+  return deferred.Promise();
+}
+
+// Queued jobs are rejected with `cancelled` right away; a running job is
+// aborted and rejected once its worker notices.
+Napi::Value ThumbnailScheduler::Cancel(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_key").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  auto it = table_->entries.find(info[0].As<Napi::String>().Utf8Value());
+  if (it == table_->entries.end()) return Napi::Boolean::New(env, false);
+
+  std::shared_ptr<ThumbnailJob> job = it->second.job;
+  job->cancelled.store(true);
+  int expected = ThumbnailJob::kQueued;
+  if (job->state.compare_exchange_strong(expected, ThumbnailJob::kDone)) {
+    cancelled_++;
+    Napi::Promise::Deferred deferred = it->second.deferred;
+    table_->entries.erase(it);
+    deferred.Reject(Napi::Error::New(env, "cancelled").Value());
+  }
+  return Napi::Boolean::New(env, true);
+}
+
+Napi::Value ThumbnailScheduler::SetPriority(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  int priority = kPriorityBackground;
+  if (info.Length() < 2 || !info[0].IsString() || !ParsePriority(info[1], &priority)) {
+    Napi::Error::New(env, "invalid_priority").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  auto it = table_->entries.find(info[0].As<Napi::String>().Utf8Value());
+  if (it == table_->entries.end()) return Napi::Boolean::New(env, false);
+
+  std::shared_ptr<ThumbnailJob> job = it->second.job;
+  if (job->state.load() != ThumbnailJob::kQueued) return Napi::Boolean::New(env, false);
+  if (job->priority.exchange(priority) != priority) Enqueue(job, priority);
+  return Napi::Boolean::New(env, true);
+}
+
+Napi::Value ThumbnailScheduler::Stats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("threads", Napi::Number::New(env, static_cast<double>(workers_.size())));
+  out.Set("pending", Napi::Number::New(env, static_cast<double>(table_->entries.size())));
+  out.Set("running", Napi::Number::New(env, running_.load()));
+  out.Set("completed", Napi::Number::New(env, static_cast<double>(completed_.load())));
+  out.Set("cancelled", Napi::Number::New(env, static_cast<double>(cancelled_.load())));
+  out.Set("steals", Napi::Number::New(env, static_cast<double>(steals_.load())));
+  return out;
+}
+
+Napi::Value ThumbnailScheduler::Destroy(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Shutdown();
+  for (auto& entry : table_->entries) {
+    entry.second.deferred.Reject(Napi::Error::New(env, "destroyed").Value());
+  }
+  table_->entries.clear();
+  return Napi::Boolean::New(env, true);
+}
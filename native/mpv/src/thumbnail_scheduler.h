@@ -0,0 +1,100 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "frame_extractor.h"
+
+enum ThumbnailPriority { kPriorityVisible = 0, kPriorityNear = 1, kPriorityBackground = 2, kPriorityLevels = 3 };
+
+struct ThumbnailJob {
+  enum State { kQueued, kRunning, kDone };
+
+  std::string key;
+  ThumbnailRequest request;
+  std::atomic<int> priority{kPriorityBackground};
+  std::atomic<int> state{kQueued};
+  std::atomic<bool> cancelled{false};
+  ThumbnailResult result;
+};
+
+// Promise and job per key. Only touched on the JS thread; shared with queued
+// completion calls so they stay valid after the scheduler is collected.
+struct ThumbnailJobTable {
+  struct Entry {
+    std::shared_ptr<ThumbnailJob> job;
+    Napi::Promise::Deferred deferred;
+  };
+  std::unordered_map<std::string, Entry> entries;
+};
+
+// Thumbnail extraction on a fixed set of worker threads, each owning its own
+// mpv instance. Every worker has a deque per priority level; a worker takes
+// the most important job it can find, from the front of its own deque or the
+// back of another worker's, so visible tiles never wait behind prefetch work.
+//
+// Priority changes push a fresh entry at the new level and leave the old one
+// behind; entries whose level no longer matches the job are skipped.
+class ThumbnailScheduler : public Napi::ObjectWrap<ThumbnailScheduler> {
+ public:
+  static Napi::Function Define(Napi::Env env);
+
+  explicit ThumbnailScheduler(const Napi::CallbackInfo& info);
+  ~ThumbnailScheduler() override;
+
+  Napi::Value Submit(const Napi::CallbackInfo& info);
+  Napi::Value Cancel(const Napi::CallbackInfo& info);
+  Napi::Value SetPriority(const Napi::CallbackInfo& info);
+  Napi::Value Stats(const Napi::CallbackInfo& info);
+  Napi::Value Destroy(const Napi::CallbackInfo& info);
+
+ private:
+  struct QueueEntry {
+    std::shared_ptr<ThumbnailJob> job;
+    int level;
+  };
+
+  struct Worker {
+    std::thread thread;
+    std::mutex mutex;
+    std::deque<QueueEntry> levels[kPriorityLevels];
+  };
+
+  static void OnEnvCleanup(void* ctx);
+
+  void WorkerMain(size_t index);
+  std::shared_ptr<ThumbnailJob> Take(size_t index);
+  std::shared_ptr<ThumbnailJob> FindJob(size_t index);
+  bool Claim(const QueueEntry& entry);
+  void Enqueue(const std::shared_ptr<ThumbnailJob>& job, int level);
+  void Deliver(const std::shared_ptr<ThumbnailJob>& job);
+  void Shutdown();
+
+  napi_env env_ = nullptr;
+  bool cleanup_hook_ = false;
+  std::string hwdec_ = "no";
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  size_t next_worker_ = 0;
+
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cv_;
+  uint64_t submitted_ = 0;
+  bool stop_ = false;
+
+  Napi::ThreadSafeFunction done_tsfn_;
+  std::shared_ptr<ThumbnailJobTable> table_ = std::make_shared<ThumbnailJobTable>();
+
+  std::atomic<uint64_t> completed_{0};
+  std::atomic<uint64_t> cancelled_{0};
+  std::atomic<uint64_t> steals_{0};
+  std::atomic<int> running_{0};
+};
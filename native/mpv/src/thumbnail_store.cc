@@ -0,0 +1,444 @@
+#include "thumbnail_store.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "path_util.h"
+
+namespace {
+
+constexpr uint32_t kMagic = 0x43544856;  // "VHTC"
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kInitialCapacity = 4096;
+constexpr size_t kCodecLength = 24;
+
+enum SlotState : uint32_t { kSlotEmpty = 0, kSlotLive = 1, kSlotDeleted = 2 };
+
+// FNV-1a; the second seed gives an independent check value so two paths that
+// collide on the slot hash are still told apart.
+uint64_t HashPath(const std::string& path, uint64_t seed) {
+  uint64_t hash = seed;
+  for (unsigned char c : path) {
+    hash ^= c;
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+constexpr uint64_t kHashSeed = 0xcbf29ce484222325ull;
+constexpr uint64_t kCheckSeed = 0x84222325cbf29ce4ull;
+
+} // namespace
+
+struct ThumbnailIndexHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t capacity;
+  uint32_t count;
+  uint32_t tombstones;
+  // Set while slots are rewritten; an index left dirty by a crash is reset.
+  uint32_t dirty;
+  uint64_t live_bytes;
+};
+
+struct ThumbnailIndexSlot {
+  uint64_t hash;
+  uint64_t check;
+  uint64_t file_size;
+  int64_t mtime_ms;
+  uint64_t offset;
+  uint32_t length;
+  uint32_t state;
+  uint32_t width;
+  uint32_t height;
+  uint32_t video_width;
+  uint32_t video_height;
+  double duration;
+  char codec[kCodecLength];
+};
+
+namespace {
+
+size_t IndexBytes(uint32_t capacity) {
+  return sizeof(ThumbnailIndexHeader) + static_cast<size_t>(capacity) * sizeof(ThumbnailIndexSlot);
+}
+
+} // namespace
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+bool MappedFile::Open(const std::string& path, size_t min_size, bool* locked) {
+  Close();
+  if (locked) *locked = false;
+#if defined(_WIN32)
+  // The share mode already keeps a second writer out.
+  HANDLE file = CreateFileW(Widen(path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                            nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    if (locked) *locked = GetLastError() == ERROR_SHARING_VIOLATION;
+    return false;
+  }
+  file_ = file;
+  LARGE_INTEGER current = {};
+  GetFileSizeEx(file, &current);
+  size_t size = static_cast<size_t>(current.QuadPart);
+#else
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd_ < 0) return false;
+  // MAP_SHARED writers in two processes would overwrite each other's slots.
+  if (flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+    if (locked) *locked = errno == EWOULDBLOCK;
+    Close();
+    return false;
+  }
+  struct stat st = {};
+  if (fstat(fd_, &st) != 0) {
+    Close();
+    return false;
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+#endif
+  if (!Map(std::max(size, min_size))) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool MappedFile::Map(size_t size) {
+#if defined(_WIN32)
+  // Creating a mapping larger than the file extends it (zero-filled).
+  LARGE_INTEGER length;
+  length.QuadPart = static_cast<LONGLONG>(size);
+  mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READWRITE, length.HighPart, length.LowPart, nullptr);
+  if (!mapping_) return false;
+  data_ = static_cast<uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size));
+  if (!data_) {
+    CloseHandle(mapping_);
+    mapping_ = nullptr;
+    return false;
+  }
+#else
+  struct stat st = {};
+  if (fstat(fd_, &st) != 0) return false;
+  if (static_cast<size_t>(st.st_size) < size && ftruncate(fd_, static_cast<off_t>(size)) != 0) return false;
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) return false;
+  data_ = static_cast<uint8_t*>(data);
+#endif
+  size_ = size;
+  return true;
+}
+
+void MappedFile::Unmap() {
+  if (!data_) return;
+#if defined(_WIN32)
+  UnmapViewOfFile(data_);
+  CloseHandle(mapping_);
+  mapping_ = nullptr;
+#else
+  munmap(data_, size_);
+#endif
+  data_ = nullptr;
+  size_ = 0;
+}
+
+bool MappedFile::Resize(size_t size) {
+  if (size <= size_) return true;
+  Unmap();
+  return Map(size);
+}
+
+void MappedFile::Flush() {
+  if (!data_) return;
+#if defined(_WIN32)
+  FlushViewOfFile(data_, 0);
+#else
+  msync(data_, size_, MS_ASYNC);
+#endif
+}
+
+void MappedFile::Close() {
+  Flush();
+  Unmap();
+#if defined(_WIN32)
+  if (file_) CloseHandle(file_);
+  file_ = nullptr;
+#else
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+#endif
+}
+
+ThumbnailStore::~ThumbnailStore() {
+  Close();
+}
+
+ThumbnailIndexHeader* ThumbnailStore::header() const {
+  return reinterpret_cast<ThumbnailIndexHeader*>(index_.data());
+}
+
+ThumbnailIndexSlot* ThumbnailStore::slots() const {
+  return reinterpret_cast<ThumbnailIndexSlot*>(index_.data() + sizeof(ThumbnailIndexHeader));
+}
+
+uint32_t ThumbnailStore::count() const {
+  return IsOpen() ? header()->count : 0;
+}
+
+uint32_t ThumbnailStore::capacity() const {
+  return IsOpen() ? header()->capacity : 0;
+}
+
+uint64_t ThumbnailStore::live_bytes() const {
+  return IsOpen() ? header()->live_bytes : 0;
+}
+
+bool ThumbnailStore::Open(const std::string& dir, std::string* err) {
+  Close();
+  dir_ = dir;
+  bool locked = false;
+  if (!index_.Open(JoinPath(dir_, "thumbs.idx"), IndexBytes(kInitialCapacity), &locked)) {
+    if (err) *err = locked ? "cache_locked" : "index_open_failed";
+    return false;
+  }
+  pack_ = OpenPath(JoinPath(dir_, "thumbs.pack"), "r+b");
+  if (!pack_) pack_ = OpenPath(JoinPath(dir_, "thumbs.pack"), "w+b");
+  if (!pack_) {
+    index_.Close();
+    if (err) *err = "pack_open_failed";
+    return false;
+  }
+  pack_bytes_ = FileSize(pack_);
+
+  const ThumbnailIndexHeader* h = header();
+  bool valid = h->magic == kMagic && h->version == kVersion && h->dirty == 0 &&
+               h->capacity >= kInitialCapacity && (h->capacity & (h->capacity - 1)) == 0 &&
+               IndexBytes(h->capacity) <= index_.size() && h->live_bytes <= pack_bytes_;
+  if (!valid && !Reset()) {
+    Close();
+    if (err) *err = "index_reset_failed";
+    return false;
+  }
+
+  // Reclaim space from overwritten thumbnails once most of the pack is dead.
+  constexpr uint64_t kCompactSlack = 16ull << 20;
+  if (pack_bytes_ > header()->live_bytes * 2 + kCompactSlack) Compact();
+  return true;
+}
+
+void ThumbnailStore::Close() {
+  index_.Close();
+  if (pack_) std::fclose(pack_);
+  pack_ = nullptr;
+  pack_bytes_ = 0;
+}
+
+// Starts over with an empty index and pack; used for foreign or damaged files.
+bool ThumbnailStore::Reset() {
+  std::memset(index_.data(), 0, index_.size());
+  uint32_t capacity = kInitialCapacity;
+  while (IndexBytes(capacity * 2) <= index_.size()) capacity *= 2;
+  ThumbnailIndexHeader* h = header();
+  h->magic = kMagic;
+  h->version = kVersion;
+  h->capacity = capacity;
+  std::fclose(pack_);
+  pack_ = OpenPath(JoinPath(dir_, "thumbs.pack"), "w+b");
+  pack_bytes_ = 0;
+  index_.Flush();
+  return pack_ != nullptr;
+}
+
+ThumbnailIndexSlot* ThumbnailStore::Lookup(uint64_t hash, uint64_t check, bool insert) {
+  const uint32_t capacity = header()->capacity;
+  ThumbnailIndexSlot* table = slots();
+  ThumbnailIndexSlot* reusable = nullptr;
+  for (uint32_t probe = 0; probe < capacity; ++probe) {
+    ThumbnailIndexSlot* slot = &table[(hash + probe) & (capacity - 1)];
+    if (slot->state == kSlotEmpty) return insert ? (reusable ? reusable : slot) : nullptr;
+    if (slot->state == kSlotDeleted) {
+      if (!reusable) reusable = slot;
+      continue;
+    }
+    if (slot->hash == hash && slot->check == check) return slot;
+  }
+  return insert ? reusable : nullptr;
+}
+
+bool ThumbnailStore::Grow() {
+  std::vector<ThumbnailIndexSlot> live;
+  live.reserve(header()->count);
+  for (uint32_t i = 0; i < header()->capacity; ++i) {
+    if (slots()[i].state == kSlotLive) live.push_back(slots()[i]);
+  }
+
+  const uint32_t capacity = header()->capacity * 2;
+  header()->dirty = 1;
+  if (!index_.Resize(IndexBytes(capacity))) {
+    // The dirty index is discarded on the next open.
+    Close();
+    return false;
+  }
+  // The mapping may have moved; re-read the header through it.
+  ThumbnailIndexHeader* h = header();
+  std::memset(slots(), 0, static_cast<size_t>(capacity) * sizeof(ThumbnailIndexSlot));
+  h->capacity = capacity;
+  h->tombstones = 0;
+  for (const ThumbnailIndexSlot& slot : live) *Lookup(slot.hash, slot.check, true) = slot;
+  h->dirty = 0;
+  index_.Flush();
+  return true;
+}
+
+bool ThumbnailStore::Append(const uint8_t* data, size_t length, uint64_t* offset) {
+  if (!SeekTo(pack_, pack_bytes_)) return false;
+  if (std::fwrite(data, 1, length, pack_) != length || std::fflush(pack_) != 0) {
+    // Leave the append position where the last complete write ended.
+    return false;
+  }
+  *offset = pack_bytes_;
+  pack_bytes_ += length;
+  return true;
+}
+
+bool ThumbnailStore::Find(const std::string& path, uint64_t file_size, int64_t mtime_ms, ThumbnailRecord* record) {
+  if (!IsOpen()) return false;
+  const ThumbnailIndexSlot* slot = Lookup(HashPath(path, kHashSeed), HashPath(path, kCheckSeed), false);
+  if (!slot || slot->file_size != file_size || slot->mtime_ms != mtime_ms) return false;
+  if (slot->offset + slot->length > pack_bytes_) return false;
+
+  record->width = slot->width;
+  record->height = slot->height;
+  record->video_width = slot->video_width;
+  record->video_height = slot->video_height;
+  record->duration = slot->duration;
+  record->codec.assign(slot->codec, strnlen(slot->codec, kCodecLength));
+  record->offset = slot->offset;
+  record->length = slot->length;
+  return true;
+}
+
+bool ThumbnailStore::Read(const ThumbnailRecord& record, uint8_t* out) {
+  if (!IsOpen() || record.offset + record.length > pack_bytes_) return false;
+  if (!SeekTo(pack_, record.offset)) return false;
+  return std::fread(out, 1, record.length, pack_) == record.length;
+}
+
+bool ThumbnailStore::Put(const std::string& path, uint64_t file_size, int64_t mtime_ms,
+                         const ThumbnailRecord& record, const uint8_t* data, size_t length) {
+  if (!IsOpen() || length > UINT32_MAX) return false;
+  ThumbnailIndexHeader* h = header();
+  if ((static_cast<uint64_t>(h->count) + h->tombstones + 1) * 10 > static_cast<uint64_t>(h->capacity) * 7) {
+    if (!Grow()) return false;
+    h = header();
+  }
+
+  // Bytes land in the pack before the slot points at them, so a crash in
+  // between only leaks space.
+  uint64_t offset = 0;
+  if (!Append(data, length, &offset)) return false;
+
+  const uint64_t hash = HashPath(path, kHashSeed);
+  const uint64_t check = HashPath(path, kCheckSeed);
+  ThumbnailIndexSlot* slot = Lookup(hash, check, true);
+  if (!slot) return false;
+  if (slot->state == kSlotLive) {
+    h->live_bytes -= slot->length;
+  } else {
+    if (slot->state == kSlotDeleted) h->tombstones--;
+    h->count++;
+  }
+
+  slot->hash = hash;
+  slot->check = check;
+  slot->file_size = file_size;
+  slot->mtime_ms = mtime_ms;
+  slot->offset = offset;
+  slot->length = static_cast<uint32_t>(length);
+  slot->width = record.width;
+  slot->height = record.height;
+  slot->video_width = record.video_width;
+  slot->video_height = record.video_height;
+  slot->duration = record.duration;
+  std::memset(slot->codec, 0, kCodecLength);
+  std::memcpy(slot->codec, record.codec.data(), std::min(record.codec.size(), kCodecLength - 1));
+  slot->state = kSlotLive;
+  h->live_bytes += length;
+  return true;
+}
+
+bool ThumbnailStore::Remove(const std::string& path) {
+  if (!IsOpen()) return false;
+  ThumbnailIndexSlot* slot = Lookup(HashPath(path, kHashSeed), HashPath(path, kCheckSeed), false);
+  if (!slot) return false;
+  ThumbnailIndexHeader* h = header();
+  h->live_bytes -= slot->length;
+  h->count--;
+  h->tombstones++;
+  slot->state = kSlotDeleted;
+  return true;
+}
+
+bool ThumbnailStore::Compact() {
+  if (!IsOpen()) return false;
+  const std::string pack_path = JoinPath(dir_, "thumbs.pack");
+  const std::string temp_path = pack_path + ".tmp";
+  std::FILE* temp = OpenPath(temp_path, "w+b");
+  if (!temp) return false;
+
+  // New offsets are staged and only applied once the new pack is in place.
+  std::vector<std::pair<ThumbnailIndexSlot*, uint64_t>> moved;
+  std::vector<uint8_t> buffer;
+  uint64_t written = 0;
+  bool ok = true;
+  for (uint32_t i = 0; ok && i < header()->capacity; ++i) {
+    ThumbnailIndexSlot* slot = &slots()[i];
+    if (slot->state != kSlotLive) continue;
+    buffer.resize(slot->length);
+    ok = SeekTo(pack_, slot->offset) &&
+         std::fread(buffer.data(), 1, slot->length, pack_) == slot->length &&
+         std::fwrite(buffer.data(), 1, slot->length, temp) == slot->length;
+    moved.emplace_back(slot, written);
+    written += slot->length;
+  }
+  ok = ok && std::fflush(temp) == 0;
+  std::fclose(temp);
+  if (!ok) {
+    RemovePath(temp_path);
+    return false;
+  }
+
+  header()->dirty = 1;
+  index_.Flush();
+  std::fclose(pack_);
+  pack_ = nullptr;
+  if (!RenamePath(temp_path, pack_path)) {
+    // Old pack is untouched; reopen it and keep the current offsets.
+    pack_ = OpenPath(pack_path, "r+b");
+    header()->dirty = 0;
+    return false;
+  }
+  pack_ = OpenPath(pack_path, "r+b");
+  if (!pack_) return false;
+  for (auto& entry : moved) entry.first->offset = entry.second;
+  pack_bytes_ = written;
+  header()->live_bytes = written;
+  header()->dirty = 0;
+  index_.Flush();
+  return true;
+}
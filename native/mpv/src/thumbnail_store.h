@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Metadata kept next to the thumbnail bytes of one video file.
+struct ThumbnailRecord {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t video_width = 0;
+  uint32_t video_height = 0;
+  double duration = 0.0;
+  std::string codec;
+  // Location in the pack; filled by Find.
+  uint64_t offset = 0;
+  uint32_t length = 0;
+};
+
+// Read/write file mapping; the size can only grow. The file is held
+// exclusively while open, so a second process fails with `locked` set.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool Open(const std::string& path, size_t min_size, bool* locked = nullptr);
+  bool Resize(size_t size);
+  void Close();
+  void Flush();
+
+  uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  bool Map(size_t size);
+  void Unmap();
+
+#if defined(_WIN32)
+  void* file_ = nullptr;
+  void* mapping_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+  uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+struct ThumbnailIndexHeader;
+struct ThumbnailIndexSlot;
+
+// Persistent thumbnail cache in one directory:
+//   thumbs.idx   header plus an open-addressed slot table, memory mapped
+//   thumbs.pack  image bytes, append-only
+// Entries are keyed by path and only match while the file's size and mtime
+// are unchanged, so edited or replaced videos miss instead of going stale.
+// A damaged or foreign index is discarded on open. Not thread-safe; another
+// process holding the directory makes Open fail with `cache_locked`.
+class ThumbnailStore {
+ public:
+  ThumbnailStore() = default;
+  ~ThumbnailStore();
+  ThumbnailStore(const ThumbnailStore&) = delete;
+  ThumbnailStore& operator=(const ThumbnailStore&) = delete;
+
+  bool Open(const std::string& dir, std::string* err);
+  void Close();
+  bool IsOpen() const { return pack_ != nullptr && index_.data() != nullptr; }
+
+  // Fills `record` on a hit; `Read` then copies `record.length` bytes.
+  bool Find(const std::string& path, uint64_t file_size, int64_t mtime_ms, ThumbnailRecord* record);
+  bool Read(const ThumbnailRecord& record, uint8_t* out);
+  bool Put(const std::string& path, uint64_t file_size, int64_t mtime_ms,
+           const ThumbnailRecord& record, const uint8_t* data, size_t length);
+  bool Remove(const std::string& path);
+  // Rewrites the pack with live records only.
+  bool Compact();
+
+  uint32_t count() const;
+  uint32_t capacity() const;
+  uint64_t pack_bytes() const { return pack_bytes_; }
+  uint64_t live_bytes() const;
+  // Size of the mapped index; the pack is read with stdio and never mapped.
+  uint64_t mapped_bytes() const { return index_.size(); }
+
+ private:
+  ThumbnailIndexHeader* header() const;
+  ThumbnailIndexSlot* slots() const;
+  bool Reset();
+  bool Grow();
+  ThumbnailIndexSlot* Lookup(uint64_t hash, uint64_t check, bool insert);
+  bool Append(const uint8_t* data, size_t length, uint64_t* offset);
+
+  std::string dir_;
+  MappedFile index_;
+  std::FILE* pack_ = nullptr;
+  uint64_t pack_bytes_ = 0;
+};
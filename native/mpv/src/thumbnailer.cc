@@ -0,0 +1,150 @@
+#include "thumbnailer.h"
+
+#include <algorithm>
+
+namespace {
+
+class ExtractWorker : public Napi::AsyncWorker {
+ public:
+  ExtractWorker(Napi::Env env, Thumbnailer* owner, Napi::Object owner_ref, ThumbnailRequest request)
+      : Napi::AsyncWorker(env),
+        deferred_(Napi::Promise::Deferred::New(env)),
+        owner_(owner),
+        request_(std::move(request)) {
+    owner_ref_ = Napi::Persistent(owner_ref);
+  }
+
+  Napi::Promise Promise() const { return deferred_.Promise(); }
+
+ protected:
+  void Execute() override {
+    if (!owner_->Run(request_, &result_)) SetError(result_.error);
+  }
+
+  void OnOK() override {
+    deferred_.Resolve(ThumbnailResultToJs(Env(), result_));
+  }
+
+  void OnError(const Napi::Error& error) override {
+    deferred_.Reject(error.Value());
+  }
+
+ private:
+  Napi::Promise::Deferred deferred_;
+  Thumbnailer* owner_;
+  // Keeps the thumbnailer alive while the request is in flight.
+  Napi::ObjectReference owner_ref_;
+  ThumbnailRequest request_;
+  ThumbnailResult result_;
+};
+
+} // namespace
+
+Napi::Function Thumbnailer::Define(Napi::Env env) {
+  return DefineClass(env, "Thumbnailer", {
+    InstanceMethod("extract", &Thumbnailer::Extract),
+    InstanceMethod("destroy", &Thumbnailer::Destroy),
+  });
+}
+
+Thumbnailer::Thumbnailer(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Thumbnailer>(info) {
+  Napi::Env env = info.Env();
+  if (!g_api.handle) {
+    Napi::Error::New(env, "not_initialized").ThrowAsJavaScriptException();
+    return;
+  }
+
+  std::string hwdec = "no";
+  if (info.Length() > 0 && info[0].IsObject()) {
+    Napi::Value hw = info[0].As<Napi::Object>().Get("hwdec");
+    if (hw.IsString()) hwdec = hw.As<Napi::String>().Utf8Value();
+  }
+
+  std::string err;
+  if (!extractor_.Open(hwdec, &err)) {
+    Napi::Error::New(env, err).ThrowAsJavaScriptException();
+    return;
+  }
+}
+
+Thumbnailer::~Thumbnailer() {
+  Close();
+}
+
+void Thumbnailer::Close() {
+  closing_.store(true);
+  std::lock_guard<std::mutex> lock(mutex_);
+  extractor_.Close();
+}
+
+// extract(path, { width, height, position, timeoutMs }) resolves with
+// { width, height, duration, pixels } (BGRA).
+Napi::Value Thumbnailer::Extract(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!extractor_.IsOpen() || closing_.load()) {
+    Napi::Error::New(env, "not_ready").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "missing_path").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  ThumbnailRequest request;
+  request.path = info[0].As<Napi::String>().Utf8Value();
+  if (info.Length() > 1 && info[1].IsObject()) ReadThumbnailOptions(info[1].As<Napi::Object>(), &request);
+
+  auto* worker = new ExtractWorker(env, this, Value(), std::move(request));
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+Napi::Value Thumbnailer::Destroy(const Napi::CallbackInfo& info) {
+  Close();
+  return Napi::Boolean::New(info.Env(), true);
+}
+
+bool Thumbnailer::Run(const ThumbnailRequest& request, ThumbnailResult* result) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (closing_.load()) {
+    result->error = "destroyed";
+    return false;
+  }
+  return extractor_.Run(request, result, &closing_);
+}
+
+void ReadThumbnailOptions(Napi::Object options, ThumbnailRequest* request) {
+  Napi::Value width = options.Get("width");
+  Napi::Value height = options.Get("height");
+  Napi::Value position = options.Get("position");
+  Napi::Value timeout = options.Get("timeoutMs");
+  Napi::Value tiles = options.Get("tiles");
+  Napi::Value columns = options.Get("columns");
+  if (width.IsNumber()) request->width = width.As<Napi::Number>().Int32Value();
+  if (height.IsNumber()) request->height = height.As<Napi::Number>().Int32Value();
+  if (position.IsNumber()) request->position = position.As<Napi::Number>().DoubleValue();
+  if (timeout.IsNumber()) request->timeout_ms = timeout.As<Napi::Number>().Int32Value();
+  if (tiles.IsNumber()) request->tiles = std::max(0, tiles.As<Napi::Number>().Int32Value());
+  if (columns.IsNumber()) request->columns = std::max(0, columns.As<Napi::Number>().Int32Value());
+}
+
+Napi::Object ThumbnailResultToJs(Napi::Env env, const ThumbnailResult& result) {
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("width", Napi::Number::New(env, result.width));
+  out.Set("height", Napi::Number::New(env, result.height));
+  out.Set("duration", Napi::Number::New(env, result.duration));
+  out.Set("videoWidth", Napi::Number::New(env, result.video_width));
+  out.Set("videoHeight", Napi::Number::New(env, result.video_height));
+  out.Set("codec", Napi::String::New(env, result.codec));
+  if (result.tiles > 0) {
+    out.Set("tiles", Napi::Number::New(env, result.tiles));
+    out.Set("columns", Napi::Number::New(env, result.columns));
+    out.Set("rows", Napi::Number::New(env, result.rows));
+    out.Set("tileWidth", Napi::Number::New(env, result.tile_width));
+    out.Set("tileHeight", Napi::Number::New(env, result.tile_height));
+    out.Set("interval", Napi::Number::New(env, result.interval));
+  }
+  out.Set("pixels", Napi::Buffer<uint8_t>::Copy(env, result.pixels.data(), result.pixels.size()));
+  return out;
+}
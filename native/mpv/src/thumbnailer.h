@@ -0,0 +1,37 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <mutex>
+
+#include "frame_extractor.h"
+
+// JS wrapper around a FrameExtractor. Requests run on the libuv thread pool;
+// an instance serves one request at a time, so callers create one per desired
+// level of parallelism (or use ThumbnailScheduler).
+class Thumbnailer : public Napi::ObjectWrap<Thumbnailer> {
+ public:
+  static Napi::Function Define(Napi::Env env);
+
+  explicit Thumbnailer(const Napi::CallbackInfo& info);
+  ~Thumbnailer() override;
+
+  Napi::Value Extract(const Napi::CallbackInfo& info);
+  Napi::Value Destroy(const Napi::CallbackInfo& info);
+
+  // Runs on a worker thread.
+  bool Run(const ThumbnailRequest& request, ThumbnailResult* result);
+
+ private:
+  void Close();
+
+  std::mutex mutex_;
+  std::atomic<bool> closing_{false};
+  FrameExtractor extractor_;
+};
+
+// Reads { width, height, position, timeoutMs } into a request.
+void ReadThumbnailOptions(Napi::Object options, ThumbnailRequest* request);
+// { width, height, duration, videoWidth, videoHeight, codec, pixels } with
+// pixels copied into a Buffer.
+Napi::Object ThumbnailResultToJs(Napi::Env env, const ThumbnailResult& result);
@@ -0,0 +1,40 @@
+// Keyframe indexes of recently opened videos; the main process keeps the rest
+// on disk.
+const MAX_INDEXES = 8;
+const indexes = new Map<string, Promise<Float64Array | null>>();
+
+// Fetches the ascending keyframe times of a file. Resolves null when the
+// container has no usable index, in which case scrubbing does not snap.
+export const loadKeyframeIndex = (filePath: string): Promise<Float64Array | null> => {
+  const api = window.electronAPI;
+  if (!api?.getKeyframeIndex) return Promise.resolve(null);
+  const known = indexes.get(filePath);
+  if (known) {
+    indexes.delete(filePath);
+    indexes.set(filePath, known);
+    return known;
+  }
+  const request = api.getKeyframeIndex(filePath)
+    .then(result => (result.ok && result.keyframes?.length ? result.keyframes : null))
+    .catch(() => null)
+    .then(keyframes => {
+      if (!keyframes) indexes.delete(filePath);
+      return keyframes;
+    });
+  indexes.set(filePath, request);
+  while (indexes.size > MAX_INDEXES) indexes.delete(indexes.keys().next().value as string);
+  return request;
+};
+
+// Keyframe closest to `time`, by binary search.
+export const nearestKeyframe = (keyframes: Float64Array, time: number) => {
+  let low = 0;
+  let high = keyframes.length - 1;
+  while (low < high) {
+    const mid = (low + high) >> 1;
+    if (keyframes[mid] < time) low = mid + 1;
+    else high = mid;
+  }
+  if (low > 0 && time - keyframes[low - 1] <= keyframes[low] - time) return keyframes[low - 1];
+  return keyframes[low];
+};
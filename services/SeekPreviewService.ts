@@ -0,0 +1,51 @@
+import type { SeekPreview } from '../electron.d';
+
+export type SeekPreviewTile = {
+  url: string;
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+};
+
+// Sheets of recently opened videos; the main process keeps the rest on disk.
+const MAX_SHEETS = 8;
+const sheets = new Map<string, Promise<SeekPreview | null>>();
+
+// Fetches (building it in the background on first use) the sprite sheet for
+// a file. Resolves null when no preview can be made.
+export const loadSeekPreview = (filePath: string): Promise<SeekPreview | null> => {
+  const api = window.electronAPI;
+  if (!api?.getSeekPreview) return Promise.resolve(null);
+  const known = sheets.get(filePath);
+  if (known) {
+    sheets.delete(filePath);
+    sheets.set(filePath, known);
+    return known;
+  }
+  const request = api.getSeekPreview(filePath)
+    .then(sheet => (sheet.ok && (sheet.url || sheet.dataUrl) ? sheet : null))
+    .catch(() => null)
+    .then(sheet => {
+      if (!sheet) sheets.delete(filePath);
+      return sheet;
+    });
+  sheets.set(filePath, request);
+  while (sheets.size > MAX_SHEETS) sheets.delete(sheets.keys().next().value as string);
+  return request;
+};
+
+// Tile for a timestamp, as a region of the sheet image.
+export const seekPreviewTile = (sheet: SeekPreview, time: number): SeekPreviewTile | null => {
+  const { tiles, columns, tileWidth, tileHeight, interval } = sheet;
+  const url = sheet.url || sheet.dataUrl;
+  if (!url || !tiles || !columns || !tileWidth || !tileHeight || !interval) return null;
+  const index = Math.max(0, Math.min(tiles - 1, Math.floor(time / interval)));
+  return {
+    url,
+    x: (index % columns) * tileWidth,
+    y: Math.floor(index / columns) * tileHeight,
+    width: tileWidth,
+    height: tileHeight
+  };
+};
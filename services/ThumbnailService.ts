@@ -1,30 +1,47 @@
-import { MAX_CONCURRENT_THUMBNAILS, THUMBNAIL_GENERATOR } from '../constants';
+import { MAX_CONCURRENT_THUMBNAILS, NATIVE_THUMBNAILS_IN_FLIGHT, THUMBNAIL_GENERATOR } from '../constants';
 
-type ThumbnailCallback = (dataUrl: string, duration: number) => void;
+export type ThumbnailPriority = 'visible' | 'near' | 'background';
+
+// `src` is a vhub-thumb:// URL, a blob URL or, uncached, a data URL.
+type ThumbnailCallback = (src: string, duration: number) => void;
 
 type ThumbnailTask = {
   url: string;
   fileKey: string;
   filePath?: string;
+  priority: ThumbnailPriority;
+  cancelled?: boolean;
   callback: ThumbnailCallback;
 };
 
+const PRIORITY_RANK: Record<ThumbnailPriority, number> = { visible: 0, near: 1, background: 2 };
+
+class CancelledError extends Error {
+  constructor() {
+    super('cancelled');
+  }
+}
+
 class ThumbnailService {
   private queue: ThumbnailTask[] = [];
+  private active = new Map<string, ThumbnailTask>();
   private activeCount = 0;
-  private cache = new Map<string, { dataUrl: string; duration: number }>();
+  private cache = new Map<string, { src: string; duration: number }>();
   private pendingKeys = new Set<string>();
   private readonly MAX_CACHE_SIZE = 500;
   private readonly TARGET_HEIGHT = 360;
 
-  async generate(url: string, fileKey: string, callback: ThumbnailCallback, filePath?: string) {
+  async generate(url: string, fileKey: string, callback: ThumbnailCallback, filePath?: string, priority: ThumbnailPriority = 'visible') {
     if (this.cache.has(fileKey)) {
       const cached = this.cache.get(fileKey)!;
-      callback(cached.dataUrl, cached.duration);
+      callback(cached.src, cached.duration);
       return;
     }
 
     if (this.pendingKeys.has(fileKey)) {
+      // A repeated request can only raise the priority; lowering is explicit.
+      const current = this.queue.find(task => task.fileKey === fileKey) || this.active.get(fileKey);
+      if (current && PRIORITY_RANK[priority] < PRIORITY_RANK[current.priority]) this.setPriority(fileKey, priority);
       return;
     }
 
@@ -33,13 +50,16 @@ class ThumbnailService {
       url,
       fileKey,
       filePath,
+      priority,
       callback: (data, dur) => {
         if (this.cache.size >= this.MAX_CACHE_SIZE) {
           const firstKey = this.cache.keys().next().value;
-          if (firstKey) this.cache.delete(firstKey);
+          if (firstKey) this.forget(firstKey);
         }
 
-        this.cache.set(fileKey, { dataUrl: data, duration: dur });
+        const previous = this.cache.get(fileKey);
+        if (previous && previous.src !== data) this.forget(fileKey);
+        this.cache.set(fileKey, { src: data, duration: dur });
         this.pendingKeys.delete(fileKey);
         callback(data, dur);
       }
@@ -47,50 +67,105 @@ class ThumbnailService {
     this.processQueue();
   }
 
+  // Drops a request whose tile scrolled away. Queued tasks are removed here;
+  // in-flight native extractions are cancelled in the main process.
+  cancel(fileKey: string) {
+    if (!this.pendingKeys.has(fileKey)) return;
+    this.pendingKeys.delete(fileKey);
+
+    const index = this.queue.findIndex(task => task.fileKey === fileKey);
+    if (index !== -1) {
+      this.queue.splice(index, 1);
+      return;
+    }
+
+    const task = this.active.get(fileKey);
+    if (!task) return;
+    task.cancelled = true;
+    window.electronAPI?.cancelThumbnail?.(fileKey);
+  }
+
+  setPriority(fileKey: string, priority: ThumbnailPriority) {
+    const queued = this.queue.find(task => task.fileKey === fileKey);
+    if (queued) {
+      queued.priority = priority;
+      return;
+    }
+
+    const task = this.active.get(fileKey);
+    if (!task || task.priority === priority) return;
+    task.priority = priority;
+    window.electronAPI?.setThumbnailPriority?.(fileKey, priority);
+  }
+
+  // The native scheduler orders its own queue by priority, so more requests
+  // are handed to it at once than to the ffmpeg/browser paths.
+  private get concurrency() {
+    return window.electronAPI?.cancelThumbnail ? NATIVE_THUMBNAILS_IN_FLIGHT : MAX_CONCURRENT_THUMBNAILS;
+  }
+
+  private takeNext() {
+    let best = -1;
+    for (let i = 0; i < this.queue.length; i++) {
+      if (best === -1 || PRIORITY_RANK[this.queue[i].priority] < PRIORITY_RANK[this.queue[best].priority]) best = i;
+    }
+    return best === -1 ? undefined : this.queue.splice(best, 1)[0];
+  }
+
   private async processQueue() {
-    if (this.activeCount >= MAX_CONCURRENT_THUMBNAILS || this.queue.length === 0) return;
+    if (this.activeCount >= this.concurrency || this.queue.length === 0) return;
 
-    const task = this.queue.shift();
+    const task = this.takeNext();
     if (!task) return;
 
     this.activeCount++;
+    this.active.set(task.fileKey, task);
 
     try {
-      const result = await this.createThumbnail(task.url, task.filePath);
-      task.callback(result.dataUrl, result.duration);
+      const result = await this.createThumbnail(task);
+      task.callback(result.src, result.duration);
     } catch (err) {
-      console.warn(`Thumbnail failed: ${task.fileKey}`, err instanceof Error ? err.message : err);
-      task.callback('', 0);
+      if (!task.cancelled && !(err instanceof CancelledError)) {
+        console.warn(`Thumbnail failed: ${task.fileKey}`, err instanceof Error ? err.message : err);
+        task.callback('', 0);
+      }
     } finally {
       this.activeCount--;
+      if (this.active.get(task.fileKey) === task) this.active.delete(task.fileKey);
       requestAnimationFrame(() => this.processQueue());
     }
   }
 
-  private async createThumbnail(url: string, filePath?: string): Promise<{ dataUrl: string; duration: number }> {
+  private async createThumbnail(task: ThumbnailTask): Promise<{ src: string; duration: number }> {
     if (THUMBNAIL_GENERATOR === 'ffmpeg') {
-      const ffmpegResult = await this.createThumbnailWithFfmpeg(url, filePath);
+      const ffmpegResult = await this.createThumbnailWithFfmpeg(task);
       if (ffmpegResult) return ffmpegResult;
     }
+    if (task.cancelled) throw new CancelledError();
 
-    return await this.createThumbnailInBrowser(url);
+    return await this.createThumbnailInBrowser(task.url);
   }
 
-  private async createThumbnailWithFfmpeg(url: string, filePath?: string) {
+  private async createThumbnailWithFfmpeg(task: ThumbnailTask) {
+    const { url, filePath, fileKey, priority } = task;
     if (!filePath || !window.electronAPI?.createThumbnail) return null;
 
-    const durationPromise = this.getDurationFromMetadata(url);
-
     try {
       const result = await window.electronAPI.createThumbnail(filePath, {
         height: this.TARGET_HEIGHT,
-        quality: 2
+        quality: 2,
+        key: fileKey,
+        priority
       });
-      const duration = typeof result?.duration === 'number' ? result.duration : await durationPromise;
+      if (result?.error === 'cancelled') throw new CancelledError();
+      const src = result?.ok ? result.url || result.dataUrl : undefined;
+      if (!src) return null;
+      // Native extraction reports the duration; only ffmpeg needs the probe.
+      const duration = typeof result.duration === 'number' ? result.duration : await this.getDurationFromMetadata(url);
 
-      if (!result?.ok || !result.dataUrl) return null;
-      return { dataUrl: result.dataUrl, duration };
+      return { src, duration };
     } catch (err) {
+      if (err instanceof CancelledError) throw err;
       console.warn('FFmpeg thumbnail failed', err instanceof Error ? err.message : err);
       return null;
     }
@@ -133,7 +208,7 @@ class ThumbnailService {
     });
   }
 
-  private createThumbnailInBrowser(url: string): Promise<{ dataUrl: string; duration: number }> {
+  private createThumbnailInBrowser(url: string): Promise<{ src: string; duration: number }> {
     return new Promise((resolve, reject) => {
       const video = document.createElement('video');
       video.style.display = 'none';
@@ -190,11 +265,14 @@ class ThumbnailService {
 
         try {
           ctx.drawImage(video, 0, 0, canvas.width, canvas.height);
-          const dataUrl = canvas.toDataURL('image/jpeg', 0.6);
           const duration = video.duration;
-
           cleanup();
-          resolve({ dataUrl, duration });
+          // A WebP blob is a fraction of a base64 JPEG string. Blob URLs are
+          // not revoked: the src stays on the video entry while it is listed.
+          canvas.toBlob(blob => {
+            if (blob) resolve({ src: URL.createObjectURL(blob), duration });
+            else reject(new Error('Encode failed'));
+          }, 'image/webp', 0.6);
         } catch (e) {
           cleanup();
           reject(e);
@@ -208,11 +286,32 @@ class ThumbnailService {
     });
   }
 
+  // Blob URLs from the canvas fallback hold their image until revoked. A tile
+  // still showing one re-requests it if the image fails to load.
+  private forget(fileKey: string) {
+    const entry = this.cache.get(fileKey);
+    if (entry?.src.startsWith('blob:')) URL.revokeObjectURL(entry.src);
+    this.cache.delete(fileKey);
+  }
+
+  // Drops the older half of the data URL cache; called when the addon had to
+  // trim its own memory.
+  trimCache() {
+    let drop = Math.floor(this.cache.size / 2);
+    for (const key of [...this.cache.keys()]) {
+      if (drop-- <= 0) break;
+      this.forget(key);
+    }
+  }
+
   clearCache() {
-    this.cache.clear();
+    for (const key of this.active.keys()) this.cancel(key);
+    for (const key of [...this.cache.keys()]) this.forget(key);
     this.pendingKeys.clear();
     this.queue = [];
   }
 }
 
 export const thumbnailService = new ThumbnailService();
+
+window.electronAPI?.onMemoryPressure?.(() => thumbnailService.trimCache());
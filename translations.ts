@@ -21,6 +21,8 @@ export const translations = {
     sort: "排序:",
     sortByDate: "按日期",
     sortBySize: "按大小",
+    sortByDuration: "按时长",
+    sortByResolution: "按分辨率",
     sortByRandom: "随机",
     localReady: "本地处理已就绪",
     privacyProtected: "隐私安全保护中",
@@ -64,6 +66,8 @@ export const translations = {
     sort: "Sort:",
     sortByDate: "Date",
     sortBySize: "Size",
+    sortByDuration: "Duration",
+    sortByResolution: "Resolution",
     sortByRandom: "Random",
     localReady: "Local processing ready",
     privacyProtected: "Privacy protected",
@@ -9,6 +9,9 @@ export interface VideoItem {
   lastModified: number;
   thumbnail?: string;
   duration?: number;
+  // Display size from the container headers, when probed.
+  width?: number;
+  height?: number;
   isProcessing?: boolean;
 }
 
@@ -16,6 +19,8 @@ export enum SortMode {
   AFTER_CURRENT = 'next',
   NEWEST = 'newest',
   SIZE = 'size',
+  DURATION = 'duration',
+  RESOLUTION = 'resolution',
   RANDOM = 'random'
 }
 